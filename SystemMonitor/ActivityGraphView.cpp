@@ -1,38 +1,85 @@
 #include "ActivityGraphView.h"
-#include <Autolock.h>
 #include <Bitmap.h>
+#include <Catalog.h>
 #include <ControlLook.h>
 #include <Window.h>
-#include <Region.h>
 #include <algorithm>
 #include <new>
 #include <cmath>
+#include <cstring>
+#include "FrameCoordinator.h"
+#include "GraphCrosshair.h"
+#include "GraphSampler.h"
+#include "HistogramToolTip.h"
 #include "Utils.h"
 
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "ActivityGraphView"
+
+
+// The quantiles of the last hour shown in the tooltip
+static const float kQuantiles[] = { 0.50f, 0.95f, 0.99f };
+
+
 ActivityGraphView::ActivityGraphView(const char* name, rgb_color color, color_which systemColor)
 	: BView(name, B_WILL_DRAW | B_FULL_UPDATE_ON_RESIZE | B_FRAME_EVENTS),
 	fColor(color),
 	fSystemColor(systemColor),
-	fOffscreen(NULL),
+	fMetric(-1),
+	fField(0),
+	fHistory(NULL),
+	fFormatter(NULL),
 	fResolution(1000000),
 	fManualScale(false),
 	fManualMin(0),
 	fManualMax(0),
-	fLastMin(0),
-	fLastRange(0),
-	fLastRangeValid(false),
-	fLastRefresh(0),
-	fScrollOffset(0)
+	fFrameMissed(true),
+	fCrosshairTime(kNoCrosshairTime),
+	fInspectEnd(0),
+	fDragging(false),
+	fDragX(0),
+	fDragEnd(0),
+	fTileHistory(NULL),
+	fTileField(0)
 {
-	fPoints.reserve(4096); // Pre-allocate for typical screen widths (including 4K) to avoid reallocations
-	fHistory = new DataHistory(10 * 60000000LL, 1000000);
+	fParams.metric = -1;
+	fParams.history = NULL;
+	fParams.field = 0;
+	fParams.resolution = fResolution;
+	fParams.manualScale = false;
+	fParams.manualMin = 0;
+	fParams.manualMax = 0;
+	fParams.width = 0;
+	fParams.height = 0;
+	fParams.gridSpacing = 0;
+	fParams.background = 0;
+	fParams.grid = 0;
+	fParams.line = 0;
+	fParams.end = 0;
+	fParams.generation = 1;
+
+	for (int32 i = 0; i < 2; i++) {
+		fFrames[i].generation = 0;
+		fFrames[i].width = 0;
+		fFrames[i].height = 0;
+		fFrames[i].resolution = 0;
+		fFrames[i].lastRefresh = 0;
+		fFrames[i].lastEnd = 0;
+		fFrames[i].scrollOffset = 0;
+		fFrames[i].lastMin = 0;
+		fFrames[i].lastRange = 0;
+		fFrames[i].lastTop = 0;
+		fFrames[i].lastLow = 0;
+	}
+
+	fTops.reserve(4096); // Pre-allocate for typical screen widths (including 4K) to avoid reallocations
+	fLows.reserve(4096);
 }
 
 
 ActivityGraphView::~ActivityGraphView()
 {
-	delete fOffscreen;
-	delete fHistory;
+	GraphRenderer::Default().Remove(this);
 }
 
 
@@ -40,7 +87,7 @@ void
 ActivityGraphView::SetAutoScale()
 {
 	fManualScale = false;
-	Invalidate();
+	_RequestFrame();
 }
 
 
@@ -48,16 +95,59 @@ void
 ActivityGraphView::AttachedToWindow()
 {
 	BView::AttachedToWindow();
-	FrameResized(Bounds().Width(), Bounds().Height());
+	FrameCoordinator::Attach(this);
+
+	if (fMetric >= 0)
+		MetricRegistry::Default().StartWatching(fMetric, BMessenger(this));
+
+	GraphCrosshair& crosshair = GraphCrosshair::Default();
+	crosshair.StartWatching(BMessenger(this));
+	fCrosshairTime = crosshair.Time();
+
+	_RequestFrame();
+}
+
+
+void
+ActivityGraphView::DetachedFromWindow()
+{
+	if (fMetric >= 0)
+		MetricRegistry::Default().StopWatching(fMetric, BMessenger(this));
+	GraphCrosshair::Default().StopWatching(BMessenger(this));
+	GraphRenderer::Default().Remove(this);
+	FrameCoordinator::Detach(this);
+
+	BView::DetachedFromWindow();
 }
 
 void
 ActivityGraphView::MessageReceived(BMessage* message)
 {
 	switch (message->what) {
+		case kMsgMetricUpdated:
+			_RequestFrame();
+			// The frozen frame stays, but how long ago it was changes
+			if (fInspectEnd != 0 && FrameCoordinator::IsVisible(this))
+				FrameCoordinator::Invalidate(this);
+			break;
+
+		case kMsgGraphFrameReady:
+			// Shown with the other graphs at the next display frame
+			FrameCoordinator::Invalidate(this);
+			break;
+
+		case kMsgCrosshairMoved:
+			// Only an overlay, the frame is just copied again
+			if (message->FindInt64("time", &fCrosshairTime) != B_OK)
+				fCrosshairTime = kNoCrosshairTime;
+			if (FrameCoordinator::IsVisible(this))
+				FrameCoordinator::Invalidate(this);
+			break;
+
 		case B_MOUSE_WHEEL_CHANGED: {
 			float deltaY;
 			if (message->FindFloat("be:wheel_delta_y", &deltaY) == B_OK) {
+				bigtime_t previousResolution = fResolution;
 				if (deltaY > 0)
 					fResolution *= 2;
 				else
@@ -66,8 +156,14 @@ ActivityGraphView::MessageReceived(BMessage* message)
 				if (fResolution < 10000) fResolution = 10000;
 				if (fResolution > 60000000) fResolution = 60000000;
 
-				fLastRefresh = 0;
-				Invalidate();
+				// While inspecting, zoom around the middle instead of now
+				if (fInspectEnd != 0) {
+					bigtime_t half = (Bounds().IntegerWidth() + 1) / 2;
+					_SetInspectEnd(fInspectEnd - half * previousResolution
+						+ half * fResolution);
+				}
+
+				_RequestFrame();
 			}
 			break;
 		}
@@ -78,370 +174,923 @@ ActivityGraphView::MessageReceived(BMessage* message)
 
 
 void
-ActivityGraphView::FrameResized(float width, float /*height*/)
+ActivityGraphView::FrameResized(float /*width*/, float /*height*/)
 {
-	_UpdateOffscreenBitmap();
+	// Until the frame in the new size is ready, Draw() stretches the last one
+	_RequestFrame();
+}
 
-	// Pre-allocate points vector to avoid frequent reallocations during window growth
-	size_t needed = static_cast<size_t>(width) + 128;
-	if (fPoints.capacity() < needed) {
-		fPoints.reserve(std::max(needed, fPoints.capacity() * 2));
-	}
-	if (fPoints.size() < static_cast<size_t>(needed))
-		fPoints.resize(needed);
+
+void
+ActivityGraphView::SetMetric(metric_id metric, int32 field)
+{
+	MetricRegistry& registry = MetricRegistry::Default();
+	if (Window() != NULL && fMetric >= 0)
+		registry.StopWatching(fMetric, BMessenger(this));
+
+	fMetric = metric;
+	fField = field;
+	// Histories live as long as the registry
+	fHistory = registry.HistoryFor(metric);
+
+	if (Window() != NULL && fMetric >= 0)
+		registry.StartWatching(fMetric, BMessenger(this));
+
+	_RequestFrame();
 }
 
 
 void
-ActivityGraphView::_UpdateOffscreenBitmap()
+ActivityGraphView::SetValueFormatter(value_formatter formatter)
 {
-	BRect bounds = Bounds();
-	bounds.OffsetTo(B_ORIGIN);
-
-	if (fOffscreen != NULL && fOffscreen->Bounds().Contains(bounds)) {
-		BView* view = _OffscreenView();
-		if (view != NULL && view->Bounds() != bounds) {
-			if (fOffscreen->Lock()) {
-				view->ResizeTo(bounds.Width(), bounds.Height());
-				fOffscreen->Unlock();
-			}
-			fLastRefresh = 0;
-		}
-		return;
-	}
+	fFormatter = formatter;
+}
 
-	delete fOffscreen;
-	fOffscreen = NULL;
-	fLastRefresh = 0;
 
-	if (Window() == NULL)
+void
+ActivityGraphView::GetQuantiles(float& p50, float& p95, float& p99) const
+{
+	history_readout readout;
+	fReadout.Read(readout);
+	p50 = readout.quantiles[0];
+	p95 = readout.quantiles[1];
+	p99 = readout.quantiles[2];
+}
+
+
+void
+ActivityGraphView::SetManualScale(float min, float max)
+{
+	fManualScale = true;
+	fManualMin = min;
+	fManualMax = max;
+	_RequestFrame();
+}
+
+
+void
+ActivityGraphView::Draw(BRect updateRect)
+{
+	if (fFrameMissed)
+		_RequestFrame();
+
+	if (fHistory == NULL || !fBuffers.Lock()) {
+		SetLowColor(ui_color(B_PANEL_BACKGROUND_COLOR));
+		FillRect(updateRect, B_SOLID_LOW);
 		return;
+	}
 
-	BAutolock locker(Window());
-	if (!locker.IsLocked())
+	BBitmap* bitmap = fBuffers.Front();
+	const frame_state& frame = fFrames[fBuffers.FrontIndex()];
+	if (bitmap == NULL || frame.generation == 0) {
+		fBuffers.Unlock();
+		SetLowColor(ui_color(B_PANEL_BACKGROUND_COLOR));
+		FillRect(updateRect, B_SOLID_LOW);
 		return;
+	}
 
-	// Over-allocate to avoid frequent recreations during resize
-	BRect bitmapBounds = bounds;
-	bitmapBounds.right += 64;
-	bitmapBounds.bottom += 64;
+	// Scrolling only moves the origin of the ring of columns in the
+	// bitmap, so the image is put together from two parts. A frame from
+	// before a resize is stretched to the new size.
+	BRect bounds = Bounds();
+	int32 origin = frame.rasterizer.Origin();
+	if (origin == 0) {
+		DrawBitmap(bitmap, BRect(0, 0, frame.width - 1, frame.height - 1),
+			bounds);
+	} else {
+		float split = bounds.left + (frame.width - origin)
+			* (bounds.Width() + 1) / frame.width;
+		DrawBitmap(bitmap, BRect(origin, 0, frame.width - 1,
+				frame.height - 1),
+			BRect(bounds.left, bounds.top, split - 1, bounds.bottom));
+		DrawBitmap(bitmap, BRect(0, 0, origin - 1, frame.height - 1),
+			BRect(split, bounds.top, bounds.right, bounds.bottom));
+	}
 
-	fOffscreen = new(std::nothrow) BBitmap(bitmapBounds, B_BITMAP_ACCEPTS_VIEWS,
-		B_RGB32);
-	if (fOffscreen == NULL || fOffscreen->InitCheck() != B_OK) {
-		delete fOffscreen;
-		fOffscreen = NULL;
+	fBuffers.Unlock();
+
+	_DrawCrosshair();
+	if (fInspectEnd != 0)
+		_DrawInspectLabel();
+}
+
+
+void
+ActivityGraphView::MouseDown(BPoint where)
+{
+	int32 clicks = 1;
+	BMessage* message = Window() != NULL ? Window()->CurrentMessage() : NULL;
+	if (message != NULL)
+		message->FindInt32("clicks", &clicks);
+
+	// A double-click goes back to the live graph
+	if (clicks >= 2) {
+		fDragging = false;
+		_SetInspectEnd(0);
 		return;
 	}
 
-	BView* view = new(std::nothrow) BView(bounds, NULL, B_FOLLOW_NONE, 0);
-	if (view == NULL) {
-		delete fOffscreen;
-		fOffscreen = NULL;
-		return;
+	fDragging = true;
+	fDragX = where.x;
+	fDragEnd = fInspectEnd != 0 ? fInspectEnd : system_time();
+	SetMouseEventMask(B_POINTER_EVENTS, B_LOCK_WINDOW_FOCUS);
+}
+
+
+void
+ActivityGraphView::MouseUp(BPoint /*where*/)
+{
+	fDragging = false;
+}
+
+
+void
+ActivityGraphView::MouseMoved(BPoint where, uint32 transit,
+	const BMessage* dragMessage)
+{
+	// Dragging to the right goes back in time
+	if (fDragging) {
+		_SetInspectEnd(fDragEnd - static_cast<bigtime_t>(where.x - fDragX)
+			* fResolution);
 	}
-	fOffscreen->AddChild(view);
+
+	// Every graph shows the time under the mouse
+	GraphCrosshair& crosshair = GraphCrosshair::Default();
+	if (transit == B_EXITED_VIEW || transit == B_OUTSIDE_VIEW)
+		crosshair.SetTime(kNoCrosshairTime);
+	else
+		crosshair.SetTime(GraphCrosshair::TimeAt(where.x, Bounds(),
+			fResolution, fInspectEnd));
+
+	BView::MouseMoved(where, transit, dragMessage);
 }
 
 
-BView*
-ActivityGraphView::_OffscreenView()
+bool
+ActivityGraphView::GetToolTipAt(BPoint point, BToolTip** _tip)
 {
-	if (fOffscreen == NULL)
-		return NULL;
+	history_readout readout;
+	fReadout.Read(readout);
+
+	bigtime_t time;
+	float low, high, min, range;
+	if (fHistory == NULL || readout.end == 0
+		|| !_FrameValuesAt(point.x, time, low, high, min, range)) {
+		return false;
+	}
+
+	bigtime_t ago = std::max((bigtime_t)0, system_time() - time);
+
+	BString value, p50, p95, p99;
+	_FormatValue(value, high);
+	_FormatValue(p50, readout.quantiles[0]);
+	_FormatValue(p95, readout.quantiles[1]);
+	_FormatValue(p99, readout.quantiles[2]);
+
+	BString when;
+	FormatTimeAgo(when, ago);
+
+	BString text;
+	text.SetToFormat(B_TRANSLATE("%s (%s)\nLast hour: p50 %s, p95 %s, p99 %s"),
+		value.String(), when.String(), p50.String(), p95.String(),
+		p99.String());
+
+	HistogramToolTip* tip = dynamic_cast<HistogramToolTip*>(ToolTip());
+	if (tip == NULL) {
+		tip = new(std::nothrow) HistogramToolTip;
+		if (tip == NULL)
+			return false;
+		SetToolTip(tip);
+		tip->ReleaseReference();
+	}
 
-	return fOffscreen->ChildAt(0);
+	BString lowText, highText;
+	_FormatValue(lowText, readout.binLow);
+	_FormatValue(highText, readout.binHigh);
+	rgb_color color = fSystemColor != (color_which)-1
+		? ui_color(fSystemColor) : fColor;
+
+	tip->SetText(text.String());
+	tip->SetHistogram(readout.bins, kToolTipBins, lowText.String(),
+		highText.String(), color);
+	*_tip = tip;
+	return true;
 }
 
 
 void
-ActivityGraphView::AddValue(bigtime_t time, int64 value)
+ActivityGraphView::_DrawCrosshair()
 {
-	fHistory->AddValue(time, value);
-	Invalidate();
+	// Placed by the frame on screen, which may still be from before a
+	// zoom or resize
+	BRect bounds = Bounds();
+	float x, low, high, min, range;
+	if (fCrosshairTime == kNoCrosshairTime || fHistory == NULL
+		|| !_FrameCrosshairAt(fCrosshairTime, x, low, high, min, range)) {
+		return;
+	}
+
+	BString label;
+	_FormatValue(label, high);
+	if (low != high) {
+		BString lowText, highText(label);
+		_FormatValue(lowText, low);
+		label.SetToFormat(B_TRANSLATE("%s – %s"), lowText.String(),
+			highText.String());
+	}
+
+	float y = bounds.top + ValueToY(high, min, range, bounds.Height());
+	GraphCrosshair::Draw(this, bounds, x, y, label.String());
 }
 
 
 void
-ActivityGraphView::SetRefreshInterval(bigtime_t interval)
+ActivityGraphView::_DrawInspectLabel()
 {
-	if (fHistory)
-		fHistory->SetRefreshInterval(interval);
+	// How far back the frozen graph ends, in the top right corner
+	BString when;
+	FormatTimeAgo(when, system_time() - fInspectEnd);
+
+	font_height fontHeight;
+	GetFontHeight(&fontHeight);
+	float height = ceilf(fontHeight.ascent + fontHeight.descent) + 2;
+	float width = ceilf(StringWidth(when.String())) + 6;
+
+	BRect bounds = Bounds();
+	BRect box(bounds.right - 2 - width, bounds.top + 2, bounds.right - 2,
+		bounds.top + 2 + height);
+
+	PushState();
+	SetDrawingMode(B_OP_COPY);
+	SetHighColor(ui_color(B_TOOL_TIP_BACKGROUND_COLOR));
+	FillRect(box);
+	SetHighColor(ui_color(B_TOOL_TIP_TEXT_COLOR));
+	DrawString(when.String(), BPoint(box.left + 3,
+		box.top + 1 + ceilf(fontHeight.ascent)));
+	PopState();
 }
 
 
+/*!	Freezes the graph with its right edge at end, rounded to a column, or
+	makes it live again for 0, or once end reaches the present.
+*/
 void
-ActivityGraphView::SetManualScale(int64 min, int64 max)
+ActivityGraphView::_SetInspectEnd(bigtime_t end)
 {
-	fManualScale = true;
-	fManualMin = min;
-	fManualMax = max;
-	Invalidate();
+	if (end != 0) {
+		bigtime_t now = system_time();
+
+		// Keep at least half of the graph on the recorded history
+		history_readout readout;
+		fReadout.Read(readout);
+		if (readout.end != 0) {
+			bigtime_t oldest = readout.start
+				+ (Bounds().IntegerWidth() + 1) / 2 * fResolution;
+			end = std::max(end, std::min(oldest, now));
+		}
+
+		if (end > now - fResolution)
+			end = 0;
+		else {
+			// Restored history from before a reboot has negative times
+			bigtime_t remainder = end % fResolution;
+			end -= remainder < 0 ? remainder + fResolution : remainder;
+			// 0 is taken for live
+			if (end == 0)
+				end = -fResolution;
+		}
+	}
+
+	if (end == fInspectEnd)
+		return;
+
+	fInspectEnd = end;
+	_RequestFrame();
+}
+
+
+/*!	Looks up the envelope of the column of the frame on screen at x, the
+	time it shows by the frame's own time axis, and the scale it was drawn
+	with. A frame from before a resize is stretched, like Draw() shows it.
+*/
+bool
+ActivityGraphView::_FrameValuesAt(float x, bigtime_t& time, float& low,
+	float& high, float& min, float& range)
+{
+	if (!fBuffers.Lock())
+		return false;
+
+	const frame_state& frame = fFrames[fBuffers.FrontIndex()];
+	int32 width = static_cast<int32>(frame.highs.size());
+	bool found = frame.generation != 0 && width > 0 && width == frame.width
+		&& frame.resolution > 0;
+	if (found) {
+		BRect bounds = Bounds();
+		int32 column = static_cast<int32>((x - bounds.left) * width
+			/ (bounds.Width() + 1));
+		column = std::min(std::max(column, (int32)0), width - 1);
+
+		bigtime_t end = frame.lastEnd != 0 ? frame.lastEnd : frame.lastRefresh;
+		time = end - static_cast<bigtime_t>(width - 1 - column)
+			* frame.resolution;
+		column = (frame.rasterizer.Origin() + column) % width;
+
+		low = frame.lows[column];
+		high = frame.highs[column];
+		min = frame.lastMin;
+		range = frame.lastRange;
+		// Nothing to show from before the history began
+		found = high == high;
+	}
+
+	fBuffers.Unlock();
+	return found;
+}
+
+
+/*!	Looks up the column of the frame on screen that shows time, by the
+	frame's own time axis, where it is in the view, and the values and the
+	scale it was drawn with.
+*/
+bool
+ActivityGraphView::_FrameCrosshairAt(bigtime_t time, float& x, float& low,
+	float& high, float& min, float& range)
+{
+	if (!fBuffers.Lock())
+		return false;
+
+	const frame_state& frame = fFrames[fBuffers.FrontIndex()];
+	int32 width = static_cast<int32>(frame.highs.size());
+	bool found = frame.generation != 0 && width > 0 && width == frame.width
+		&& frame.resolution > 0;
+	if (found) {
+		// Anything within the newest column still belongs to it
+		bigtime_t end = frame.lastEnd != 0 ? frame.lastEnd : frame.lastRefresh;
+		int64 column = width - 1 - (end - time) / frame.resolution;
+		found = column >= 0 && column < width;
+		if (found) {
+			BRect bounds = Bounds();
+			x = floorf(bounds.left + (column + 0.5f)
+				* (bounds.Width() + 1) / width) + 0.5f;
+
+			int32 index = (frame.rasterizer.Origin()
+				+ static_cast<int32>(column)) % width;
+			low = frame.lows[index];
+			high = frame.highs[index];
+			min = frame.lastMin;
+			range = frame.lastRange;
+			found = high == high;
+		}
+	}
+
+	fBuffers.Unlock();
+	return found;
 }
 
 
 void
-ActivityGraphView::Draw(BRect updateRect)
+ActivityGraphView::_FormatValue(BString& text, float value) const
 {
-	_DrawHistory();
+	if (fFormatter != NULL)
+		fFormatter(text, value);
+	else {
+		text.Truncate(0);
+		text << value;
+	}
 }
 
 
 void
-ActivityGraphView::_DrawHistory()
+ActivityGraphView::RenderFrame()
 {
-	if (fOffscreen == NULL)
-		_UpdateOffscreenBitmap();
+	if (!fBuffers.Lock())
+		return;
+	render_params params = fParams;
+	fBuffers.Unlock();
 
-	if (fOffscreen == NULL)
+	if (params.history == NULL || params.width <= 0 || params.height <= 0)
 		return;
 
-	BView* view = _OffscreenView();
-	if (view == NULL)
+	frame_state& frame = fFrames[fBuffers.BackIndex()];
+	BBitmap* bitmap = fBuffers.Back(params.width, params.height);
+	if (bitmap == NULL)
 		return;
 
-	BRect frame = view->Bounds();
+	GraphRasterizer& rasterizer = frame.rasterizer;
+	rasterizer.SetTarget(static_cast<uint32*>(bitmap->Bits()),
+		bitmap->BytesPerRow(), params.width, params.height);
+	rasterizer.SetColors(params.background, params.grid, params.line, 100,
+		params.line);
+	rasterizer.SetLineWidth(1.5f);
 
-	if (fOffscreen->Lock()) {
-		uint32 steps = static_cast<uint32>(frame.Width()) + 1;
-		if (steps > 0) {
-			bigtime_t now = system_time();
-			bigtime_t timeStep = fResolution;
+	MetricRegistry& registry = MetricRegistry::Default();
+	if (!registry.LockMetric(params.metric))
+		return;
 
-			bool fullRedraw = true;
-			int32 pixelsToScroll = 0;
+	_UpdateReadout(params);
 
-			if (fLastRefresh > 0) {
-				bigtime_t delta = now - fLastRefresh;
-				pixelsToScroll = delta / timeStep;
+	// Nothing to do if the frame on screen would look the same. Only the
+	// columns are sampled with the metric locked, so publishing never
+	// waits for them to be drawn.
+	bool sampled = false;
+	column_draw draw;
+	if (_NeedsFrame(params)) {
+		sampled = params.end != 0 ? _SampleInspected(params, frame, draw)
+			: _SampleHistory(params, frame, draw);
+	}
+	registry.UnlockMetric(params.metric);
 
-				if (pixelsToScroll < (int32)steps && pixelsToScroll >= 0)
-					fullRedraw = false;
-			}
+	if (!sampled || !_DrawColumns(params, frame, draw))
+		return;
 
-			rgb_color drawColor = fColor;
-			if (fSystemColor != (color_which)-1) {
-				drawColor = ui_color(fSystemColor);
-			}
+	fBuffers.Swap();
 
-			rgb_color bg = ui_color(B_PANEL_BACKGROUND_COLOR);
-			rgb_color gridColor = tint_color(bg, B_DARKEN_1_TINT);
+	BMessage ready(kMsgGraphFrameReady);
+	BMessenger(this).SendMessage(&ready, (BHandler*)NULL, 0);
+}
 
-			int64 min, max;
-			if (fManualScale) {
-				min = fManualMin;
-				max = fManualMax;
-			} else {
-				min = fHistory->MinimumValue();
-				max = fHistory->MaximumValue();
-			}
-			int64 range = max - min;
 
-			// Force full redraw if scale changed
-			if (!fLastRangeValid || min != fLastMin || range != fLastRange) {
-				fullRedraw = true;
-			}
+void
+ActivityGraphView::_RequestFrame()
+{
+	// While hidden the history just keeps recording, and showing the graph
+	// renders what was missed
+	if (!FrameCoordinator::IsVisible(this)) {
+		fFrameMissed = true;
+		return;
+	}
 
-			if (fullRedraw) {
-				fScrollOffset = 0;
-				fLastRefresh = now;
+	fFrameMissed = false;
+	_UpdateRenderParams();
+	GraphRenderer::Default().Request(this);
+}
 
-				view->SetLowColor(bg);
-				view->FillRect(frame, B_SOLID_LOW);
 
-				// Draw Grid
-				view->SetDrawingMode(B_OP_COPY);
-				view->SetHighColor(gridColor);
-				view->SetPenSize(1.0);
+void
+ActivityGraphView::_UpdateRenderParams()
+{
+	rgb_color drawColor = fColor;
+	if (fSystemColor != (color_which)-1)
+		drawColor = ui_color(fSystemColor);
 
-				// Horizontal lines
-				for (int i = 1; i < 4; i++) {
-					float y = frame.top + frame.Height() * i / 4;
-					view->StrokeLine(BPoint(frame.left, y), BPoint(frame.right, y));
-				}
-				// Vertical lines
-				BFont viewFont;
-				view->GetFont(&viewFont);
-				float gridSpacing = 60.0f * GetScaleFactor(&viewFont);
-				for (float x = 0; x < frame.Width(); x += gridSpacing) {
-					 view->StrokeLine(BPoint(x, frame.top), BPoint(x, frame.bottom));
-				}
+	rgb_color bg = ui_color(B_PANEL_BACKGROUND_COLOR);
+	rgb_color gridColor = tint_color(bg, B_DARKEN_1_TINT);
 
-				// Calculate points for polygon fill and line stroke.
-				// points[0] is the bottom-left corner of the fill.
-				// points[1...steps] are the actual data points.
-				// points[steps+1] is the bottom-right corner of the fill.
-				int32 pointCount = steps + 2;
-
-				try {
-					if (fPoints.capacity() < static_cast<size_t>(pointCount))
-						fPoints.reserve(pointCount + 64);
-					if (fPoints.size() < static_cast<size_t>(pointCount))
-						fPoints.resize(pointCount);
-
-					BPoint* points = fPoints.data();
-
-					// Bottom-left corner for polygon fill
-					points[0] = BPoint(frame.left, frame.bottom);
-
-					int32 searchIndex = 0;
-					for (uint32 i = 0; i < steps; i++) {
-						int64 value = fHistory->ValueAt(now - (steps - 1 - i) * timeStep, &searchIndex);
-						float y;
-						if (range == 0) {
-							if (min == 0) y = frame.Height();
-							else y = frame.Height() / 2;
-						} else
-							y = frame.Height() - (value - min) * frame.Height() / range;
-						// Offset by 1 to leave room for the bottom-left corner at points[0]
-						points[i+1] = BPoint(i, y);
-					}
-					// Bottom-right corner for polygon fill
-					points[pointCount-1] = BPoint(frame.right, frame.bottom);
-
-					// Fill
-					view->SetDrawingMode(B_OP_ALPHA);
-					rgb_color fillColor = drawColor;
-					fillColor.alpha = 100;
-					view->SetHighColor(fillColor);
-					view->FillPolygon(points, pointCount);
-
-					// Stroke Line
-					view->SetDrawingMode(B_OP_COPY);
-					view->SetHighColor(drawColor);
-					view->SetPenSize(1.5);
-
-					if (steps > 1) {
-						view->BeginLineArray(steps - 1);
-						for (uint32 i = 0; i < steps - 1; i++) {
-							view->AddLine(points[i+1], points[i+2], drawColor);
-						}
-						view->EndLineArray();
-					}
-
-					fLastMin = min;
-					fLastRange = range;
-					fLastRangeValid = true;
-				} catch (const std::bad_alloc&) {
-					// Ignore update if memory is low
-				}
-			} else {
-				// Partial or sub-pixel Update
-				int32 redrawWidth = std::max((int32)1, pixelsToScroll);
-
-				if (pixelsToScroll > 0) {
-					// Scroll
-					BRect src(pixelsToScroll, 0, frame.right, frame.bottom);
-					BRect dst(0, 0, frame.right - pixelsToScroll, frame.bottom);
-					view->CopyBits(src, dst);
-
-					BFont viewFont;
-					view->GetFont(&viewFont);
-					float gridSpacing = 60.0f * GetScaleFactor(&viewFont);
-					fScrollOffset += static_cast<float>(pixelsToScroll);
-					while (fScrollOffset >= gridSpacing)
-						fScrollOffset -= gridSpacing;
-					fLastRefresh += static_cast<bigtime_t>(pixelsToScroll) * timeStep;
-				}
+	BFont viewFont;
+	GetFont(&viewFont);
 
-				// New Area (at least the last pixel)
-				BRect newArea(frame.right - redrawWidth, frame.top, frame.right, frame.bottom);
+	BRect bounds = Bounds();
 
-				view->SetLowColor(bg);
-				view->FillRect(newArea, B_SOLID_LOW);
+	render_params params;
+	params.metric = fMetric;
+	params.history = fHistory;
+	params.field = fField;
+	params.resolution = fResolution;
+	params.manualScale = fManualScale;
+	params.manualMin = fManualMin;
+	params.manualMax = fManualMax;
+	params.width = static_cast<int32>(bounds.Width()) + 1;
+	params.height = static_cast<int32>(bounds.Height()) + 1;
+	params.gridSpacing = 60.0f * GetScaleFactor(&viewFont);
+	params.background = GraphRasterizer::MakePixel(bg.red, bg.green,
+		bg.blue);
+	params.grid = GraphRasterizer::MakePixel(gridColor.red, gridColor.green,
+		gridColor.blue);
+	params.line = GraphRasterizer::MakePixel(drawColor.red, drawColor.green,
+		drawColor.blue);
+	params.end = fInspectEnd;
+
+	if (!fBuffers.Lock())
+		return;
 
-				// Draw Grid (New Area)
-				view->SetDrawingMode(B_OP_COPY);
-				view->SetHighColor(gridColor);
-				view->SetPenSize(1.0);
+	// Scale changes and panning are noticed by the render thread itself
+	params.generation = fParams.generation;
+	if (params.history != fParams.history || params.field != fParams.field
+		|| params.resolution != fParams.resolution
+		|| params.width != fParams.width || params.height != fParams.height
+		|| params.gridSpacing != fParams.gridSpacing
+		|| params.background != fParams.background
+		|| params.grid != fParams.grid || params.line != fParams.line) {
+		// Never 0, which marks empty frames
+		if (++params.generation == 0)
+			params.generation = 1;
+	}
 
-				// Horizontal lines
-				for (int i = 1; i < 4; i++) {
-					float y = frame.top + frame.Height() * i / 4;
-					view->StrokeLine(BPoint(newArea.left, y), BPoint(newArea.right, y));
-				}
+	fParams = params;
+	fBuffers.Unlock();
+}
 
-				// Vertical lines
-				BFont viewFont;
-				view->GetFont(&viewFont);
-				float gridSpacing = 60.0f * GetScaleFactor(&viewFont);
-				int64 startK = (int64)ceilf((newArea.left + fScrollOffset) / gridSpacing);
-				for (int64 k = startK; ; k++) {
-					float x = k * gridSpacing - fScrollOffset;
-					if (x > newArea.right) break;
-					view->StrokeLine(BPoint(x, frame.top), BPoint(x, frame.bottom));
-				}
 
-				// Clip drawing to new area to prevent overlap artifacts
-				BRegion clipRegion(newArea);
-				view->ConstrainClippingRegion(&clipRegion);
-
-				int32 startI = static_cast<int32>(newArea.left) - 1;
-				if (startI < 0) startI = 0;
-				int32 endI = steps - 1;
-				int32 count = endI - startI + 1;
-				// points[0] = start-bottom, points[1...count] = data, points[count+1] = end-bottom
-				int32 polyCount = count + 2;
-
-				try {
-					if (fPoints.capacity() < static_cast<size_t>(polyCount))
-						fPoints.reserve(polyCount + 64);
-					if (fPoints.size() < static_cast<size_t>(polyCount))
-						fPoints.resize(polyCount);
-
-					BPoint* points = fPoints.data();
-
-					// Bottom-start corner for partial polygon fill
-					points[0] = BPoint(startI, frame.bottom);
-
-					int32 searchIndex = 0;
-					for (int32 j = 0; j < count; j++) {
-						int32 i = startI + j;
-						// For the very last pixel, use 'now' for maximum smoothness
-						bigtime_t t;
-						if (i == static_cast<int32>(steps) - 1) t = now;
-						else t = fLastRefresh - static_cast<bigtime_t>(steps - 1 - i) * timeStep;
-
-						int64 value = fHistory->ValueAt(t, &searchIndex);
-						float y;
-						if (range == 0) {
-							if (min == 0) y = frame.Height();
-							else y = frame.Height() / 2;
-						} else
-							y = frame.Height() - (value - min) * frame.Height() / range;
-						// Offset by 1 to leave room for the bottom-start corner at points[0]
-						points[j+1] = BPoint(i, y);
-					}
-					// Bottom-end corner for partial polygon fill
-					points[polyCount-1] = BPoint(endI, frame.bottom);
-
-					// Fill
-					view->SetDrawingMode(B_OP_ALPHA);
-					rgb_color fillColor = drawColor;
-					fillColor.alpha = 100;
-					view->SetHighColor(fillColor);
-					view->FillPolygon(points, polyCount);
-
-					// Stroke
-					view->SetDrawingMode(B_OP_COPY);
-					view->SetHighColor(drawColor);
-					view->SetPenSize(1.5);
-					if (count > 1) {
-						view->BeginLineArray(count - 1);
-						for (int32 j = 0; j < count - 1; j++) {
-							view->AddLine(points[j+1], points[j+2], drawColor);
-						}
-						view->EndLineArray();
-					}
-				} catch (const std::bad_alloc&) {
-					// Ignore
-				}
+/*!	Publishes what the tooltips show of the history. Called from the
+	render thread with the metric locked.
+*/
+void
+ActivityGraphView::_UpdateReadout(const render_params& params)
+{
+	const DataHistory<float>* history = params.history;
 
-				view->ConstrainClippingRegion(NULL); // Reset clipping
-			}
+	history_readout readout;
+	readout.start = history->Start();
+	readout.end = history->End();
+	for (int32 i = 0; i < kQuantileCount; i++)
+		readout.quantiles[i] = history->Quantile(kQuantiles[i], params.field);
+	history->GetHistogram(readout.bins, kToolTipBins, readout.binLow,
+		readout.binHigh, params.field);
+
+	fReadout.Write(readout);
+}
+
+
+/*!	Whether the frame on screen differs from what would be rendered now.
+	Called from the render thread with the metric locked.
+*/
+bool
+ActivityGraphView::_NeedsFrame(const render_params& params) const
+{
+	const frame_state& front = fFrames[fBuffers.FrontIndex()];
+	if (front.generation != params.generation || front.lastEnd != params.end)
+		return true;
+
+	if (params.end != 0) {
+		// Frozen, only a new scale changes it
+		float min, range;
+		_GetInspectedScale(params, front, min, range);
+		return min != front.lastMin || range != front.lastRange;
+	}
+
+	// Scrolls by at least a pixel
+	bigtime_t now = system_time();
+	if (now - front.lastRefresh >= params.resolution)
+		return true;
+
+	float min, range;
+	_GetScale(params, min, range);
+	if (min != front.lastMin || range != front.lastRange)
+		return true;
+
+	float low, high;
+	GraphSampler::SampleValues(params.history, params.field, now,
+		params.resolution, 1, &low, &high);
+	float height = static_cast<float>(params.height - 1);
+	return ValueToY(high, min, range, height) != front.lastTop
+		|| ValueToY(low, min, range, height) != front.lastLow;
+}
+
+
+/*!	Brings the frame up to date, sampling only the columns that changed
+	since it was last rendered into. Called from the render thread with the
+	metric locked; returns false if the frame couldn't be updated.
+*/
+bool
+ActivityGraphView::_SampleHistory(const render_params& params,
+	frame_state& frame, column_draw& draw)
+{
+	int32 steps = params.width;
+	int32 height = params.height;
+
+	try {
+		if (fTops.size() < static_cast<size_t>(steps))
+			fTops.resize(steps + 64);
+		if (fLows.size() < static_cast<size_t>(steps))
+			fLows.resize(steps + 64);
+	} catch (const std::bad_alloc&) {
+		// Ignore update if memory is low
+		return false;
+	}
+
+	bigtime_t now = system_time();
+	bigtime_t timeStep = params.resolution;
+	float graphHeight = static_cast<float>(height - 1);
+
+	bool fullRedraw = true;
+	int32 pixelsToScroll = 0;
+
+	if (frame.generation == params.generation && frame.lastEnd == 0) {
+		bigtime_t delta = now - frame.lastRefresh;
+		pixelsToScroll = delta / timeStep;
+
+		if (pixelsToScroll < steps && pixelsToScroll >= 0)
+			fullRedraw = false;
+	}
+
+	float min, range;
+	_GetScale(params, min, range);
+	draw.min = min;
+	draw.range = range;
+
+	// Force full redraw if scale changed
+	if (min != frame.lastMin || range != frame.lastRange)
+		fullRedraw = true;
+
+	if (fullRedraw) {
+		frame.generation = 0;
+		frame.width = steps;
+		frame.height = height;
+		frame.resolution = timeStep;
+		frame.scrollOffset = 0;
+		frame.lastRefresh = now;
+		frame.lastEnd = 0;
+		if (!_ResizeColumns(frame, steps))
+			return false;
+
+		GraphSampler::SampleValues(params.history, params.field,
+			now - (steps - 1) * timeStep, timeStep, steps, fLows.data(),
+			fTops.data());
+		_StoreColumns(frame, 0, steps, fLows.data(), fTops.data());
+
+		draw.firstX = draw.from = 0;
+		draw.count = draw.to = steps;
+
+		frame.generation = params.generation;
+		frame.lastMin = min;
+		frame.lastRange = range;
+		frame.lastTop = ValueToY(fTops[steps - 1], min, range, graphHeight);
+		frame.lastLow = ValueToY(fLows[steps - 1], min, range, graphHeight);
+		return true;
+	}
+
+	// Partial or sub-pixel Update
+	int32 redrawWidth = std::max((int32)1, pixelsToScroll);
+
+	if (pixelsToScroll > 0) {
+		frame.rasterizer.Scroll(pixelsToScroll);
+
+		frame.scrollOffset += static_cast<float>(pixelsToScroll);
+		while (frame.scrollOffset >= params.gridSpacing)
+			frame.scrollOffset -= params.gridSpacing;
+		frame.lastRefresh += static_cast<bigtime_t>(pixelsToScroll) * timeStep;
+	}
+
+	// New columns (at least the last one), and the one before them that
+	// the line has to connect to
+	int32 firstX = steps - 1 - redrawWidth;
+	int32 startI = std::max((int32)0, firstX - 1);
+	int32 count = steps - startI;
+
+	GraphSampler::SampleValues(params.history, params.field,
+		frame.lastRefresh - static_cast<bigtime_t>(steps - 1 - startI)
+			* timeStep, timeStep, count, fLows.data(), fTops.data());
+
+	// For the very last pixel, use 'now' for maximum smoothness
+	GraphSampler::SampleValues(params.history, params.field, now, timeStep,
+		1, fLows.data() + count - 1, fTops.data() + count - 1);
+
+	_StoreColumns(frame, startI, count, fLows.data(), fTops.data());
+
+	draw.firstX = startI;
+	draw.count = count;
+	draw.from = firstX;
+	draw.to = steps;
+
+	// Without scrolling, the newest column may still look the same
+	float newestTop = ValueToY(fTops[count - 1], min, range, graphHeight);
+	float newestLow = ValueToY(fLows[count - 1], min, range, graphHeight);
+	if (pixelsToScroll == 0 && newestTop == frame.lastTop
+		&& newestLow == frame.lastLow) {
+		draw.to = draw.from;
+	}
+	frame.lastTop = newestTop;
+	frame.lastLow = newestLow;
+	return true;
+}
+
+
+/*!	Updates the frame to the inspected range of the past, which doesn't
+	change, so after panning only the columns that came in are sampled,
+	with their neighbours that now connect to them. They come from the
+	tile cache, which only samples the history for what was never shown
+	before. Called from the render thread with the metric locked.
+*/
+bool
+ActivityGraphView::_SampleInspected(const render_params& params,
+	frame_state& frame, column_draw& draw)
+{
+	int32 steps = params.width;
+	int32 height = params.height;
+
+	try {
+		if (fTops.size() < static_cast<size_t>(steps))
+			fTops.resize(steps + 64);
+		if (fLows.size() < static_cast<size_t>(steps))
+			fLows.resize(steps + 64);
+	} catch (const std::bad_alloc&) {
+		return false;
+	}
+
+	if (params.history != fTileHistory || params.field != fTileField) {
+		fTiles.Clear();
+		fTileHistory = params.history;
+		fTileField = params.field;
+	}
+
+	bigtime_t step = params.resolution;
+	int64 lastColumn = params.end / step;
+	int64 shift = lastColumn - frame.lastEnd / step;
+
+	// The image columns [from, to) are drawn
+	int32 from = 0;
+	int32 to = steps;
+	bool fullRedraw = frame.generation != params.generation
+		|| frame.lastEnd == 0 || shift >= steps || -shift >= steps;
+	if (fullRedraw) {
+		frame.generation = 0;
+		frame.width = steps;
+		frame.height = height;
+		frame.resolution = step;
+		frame.scrollOffset = 0;
+		if (!_ResizeColumns(frame, steps))
+			return false;
+	} else if (shift == 0) {
+		// Only a new scale changes anything
+		from = to = 0;
+	} else {
+		// Newer columns come in on the right, older ones on the left
+		frame.rasterizer.Scroll(static_cast<int32>(shift));
+		if (shift > 0)
+			from = steps - 1 - static_cast<int32>(shift);
+		else
+			to = 1 - static_cast<int32>(shift);
+
+		frame.scrollOffset = fmodf(frame.scrollOffset + shift,
+			params.gridSpacing);
+		if (frame.scrollOffset < 0)
+			frame.scrollOffset += params.gridSpacing;
+	}
+
+	// With a neighbour on each side, for the lines to connect to
+	int32 sampleFrom = 0;
+	int32 count = 0;
+	if (to > from) {
+		sampleFrom = std::max((int32)0, from - 1);
+		count = std::min(steps, to + 1) - sampleFrom;
+
+		// Tiles at the ends of the history may still change
+		int64 oldestStable = params.history->Start() / step + 2;
+		int64 newestStable = params.history->End() / step - 2;
+		fTiles.GetColumns(step, lastColumn - (steps - 1) + sampleFrom, count,
+			oldestStable, newestStable, _SampleTile,
+			const_cast<render_params*>(&params), fLows.data(), fTops.data());
+		_StoreColumns(frame, sampleFrom, count, fLows.data(), fTops.data());
+	}
+
+	// Scaled to what is shown, so that a spike that has since left the
+	// live history isn't clipped
+	float min, range;
+	_GetInspectedScale(params, frame, min, range);
+	draw.min = min;
+	draw.range = range;
+
+	if (!fullRedraw && (min != frame.lastMin || range != frame.lastRange)) {
+		// All columns are in the frame already, only drawn anew
+		int32 column = frame.rasterizer.Origin();
+		for (int32 j = 0; j < steps; j++) {
+			fLows[j] = frame.lows[column];
+			fTops[j] = frame.highs[column];
+			if (++column == steps)
+				column = 0;
 		}
-		view->Sync();
-		fOffscreen->Unlock();
+
+		sampleFrom = from = 0;
+		count = to = steps;
 	}
-	DrawBitmap(fOffscreen, frame, Bounds());
+
+	draw.firstX = sampleFrom;
+	draw.count = count;
+	draw.from = from;
+	draw.to = to;
+
+	frame.generation = params.generation;
+	frame.lastEnd = params.end;
+	frame.lastMin = min;
+	frame.lastRange = range;
+	return true;
+}
+
+
+/*!	Draws the columns sampled into the frame, which doesn't need the
+	metric anymore. Returns false if they couldn't be drawn.
+*/
+bool
+ActivityGraphView::_DrawColumns(const render_params& params,
+	frame_state& frame, const column_draw& draw)
+{
+	if (draw.to <= draw.from)
+		return true;
+
+	float graphHeight = static_cast<float>(params.height - 1);
+	for (int32 j = 0; j < draw.count; j++) {
+		fTops[j] = ValueToY(fTops[j], draw.min, draw.range, graphHeight);
+		fLows[j] = ValueToY(fLows[j], draw.min, draw.range, graphHeight);
+	}
+
+	int32 skip = draw.from - draw.firstX;
+	int32 next = draw.to - draw.firstX;
+	frame.rasterizer.SetGrid(4, params.gridSpacing, frame.scrollOffset);
+	if (frame.rasterizer.DrawColumns(draw.from, draw.to - draw.from,
+			fTops.data() + skip, fLows.data() + skip,
+			skip > 0 ? fTops[skip - 1] : NAN,
+			next < draw.count ? fTops[next] : NAN) != B_OK) {
+		// The ring has already moved on
+		frame.generation = 0;
+		return false;
+	}
+
+	return true;
+}
+
+
+/*static*/ bool
+ActivityGraphView::_ResizeColumns(frame_state& frame, int32 width)
+{
+	try {
+		frame.lows.resize(width);
+		frame.highs.resize(width);
+	} catch (const std::bad_alloc&) {
+		frame.lows.clear();
+		frame.highs.clear();
+		return false;
+	}
+	return true;
+}
+
+
+/*!	Keeps the envelopes of the image columns [x, x + count) with the frame,
+	in the buffer columns that show them.
+*/
+/*static*/ void
+ActivityGraphView::_StoreColumns(frame_state& frame, int32 x, int32 count,
+	const float* lows, const float* highs)
+{
+	int32 width = static_cast<int32>(frame.highs.size());
+	if (width == 0)
+		return;
+
+	int32 column = (frame.rasterizer.Origin() + x) % width;
+	for (int32 j = 0; j < count; j++) {
+		frame.lows[column] = lows[j];
+		frame.highs[column] = highs[j];
+		if (++column == width)
+			column = 0;
+	}
+}
+
+
+/*static*/ void
+ActivityGraphView::_SampleTile(void* cookie, bigtime_t start, bigtime_t step,
+	int32 count, float* lows, float* highs)
+{
+	const render_params* params = static_cast<const render_params*>(cookie);
+	GraphSampler::SampleValues(params->history, params->field, start, step,
+		count, lows, highs);
+}
+
+
+/*static*/ void
+ActivityGraphView::_GetScale(const render_params& params, float& min,
+	float& range)
+{
+	float max;
+	if (params.manualScale) {
+		min = params.manualMin;
+		max = params.manualMax;
+	} else {
+		min = params.history->MinimumValue(params.field);
+		max = params.history->MaximumValue(params.field);
+	}
+	range = max - min;
+}
+
+
+/*!	The scale of an inspected frame: unless it is set manually, the
+	envelope of the columns it shows, which came from the tile cache.
+*/
+/*static*/ void
+ActivityGraphView::_GetInspectedScale(const render_params& params,
+	const frame_state& frame, float& min, float& range)
+{
+	if (params.manualScale) {
+		_GetScale(params, min, range);
+		return;
+	}
+
+	// Columns from before the history began are NAN, and left out
+	float max;
+	if (!GraphSampler::GetEnvelope(frame.lows.data(), frame.highs.data(),
+			static_cast<int32>(frame.highs.size()), min, max)) {
+		// Nothing shown yet
+		_GetScale(params, min, range);
+		return;
+	}
+
+	range = max - min;
+}
+
+
+/*static*/ float
+ActivityGraphView::ValueToY(float value, float min, float range, float height)
+{
+	if (range == 0)
+		return min == 0 ? height : height / 2;
+
+	return height - (value - min) * height / range;
 }
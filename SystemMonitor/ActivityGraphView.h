@@ -1,50 +1,213 @@
 #ifndef ACTIVITYGRAPHVIEW_H
 #define ACTIVITYGRAPHVIEW_H
 
+#include <String.h>
 #include <View.h>
 #include <vector>
 #include "DataHistory.h"
+#include "GraphRasterizer.h"
+#include "GraphRenderer.h"
+#include "GraphTileCache.h"
+#include "MetricRegistry.h"
+#include "SeqLock.h"
 
 class BBitmap;
 
-class ActivityGraphView : public BView {
+typedef void (*value_formatter)(BString& text, float value);
+
+// Rendering happens on the GraphRenderer's thread, into the back one of two
+// bitmaps; Draw() only copies the newest finished frame to the screen.
+// The crosshair and the tooltips look up the values kept with that frame,
+// and what the render thread published of the history, so the window
+// thread never has to lock the metric.
+//
+// Dragging the graph pans it into the past, where it stays frozen while the
+// history keeps recording; a double-click goes back to the live graph. The
+// past is sampled in tiles that are kept, so panning back and forth only
+// samples what comes into view for the first time, and only the columns
+// that came in are drawn.
+class ActivityGraphView : public BView, public GraphRenderClient {
 public:
 						ActivityGraphView(const char* name, rgb_color color, color_which systemColor = (color_which)-1);
 	virtual				~ActivityGraphView();
 
 	virtual void		AttachedToWindow();
+	virtual void		DetachedFromWindow();
 	virtual void		MessageReceived(BMessage* message);
 	virtual void		FrameResized(float width, float height);
 	virtual void		Draw(BRect updateRect);
+	virtual void		MouseDown(BPoint where);
+	virtual void		MouseUp(BPoint where);
+	virtual void		MouseMoved(BPoint where, uint32 transit,
+							const BMessage* dragMessage);
+	virtual bool		GetToolTipAt(BPoint point, BToolTip** _tip);
+
+	virtual void		RenderFrame();
 
-			void		AddValue(bigtime_t time, int64 value);
-			void		SetRefreshInterval(bigtime_t interval);
-			void		SetManualScale(int64 min, int64 max);
+			// Shows the given field of a metric from the registry, and
+			// redraws whenever it is published.
+			void		SetMetric(metric_id metric, int32 field = 0);
+			void		SetManualScale(float min, float max);
 			void		SetAutoScale();
+			void		SetValueFormatter(value_formatter formatter);
+
+			// The median, 95th and 99th percentile of the last hour, as of
+			// the last time the graph was rendered.
+			void		GetQuantiles(float& p50, float& p95,
+							float& p99) const;
+
+	static	float		ValueToY(float value, float min, float range,
+							float height);
 
 private:
-			void		_UpdateOffscreenBitmap();
-			BView*		_OffscreenView();
-			void		_DrawHistory();
+	enum {
+		kQuantileCount = 3,
+		kToolTipBins = 24
+	};
+
+	// What the render thread needs from the view, handed over with the
+	// frame buffers locked
+	struct render_params {
+		metric_id		metric;
+		DataHistory<float>*	history;
+		int32			field;
+		bigtime_t		resolution;
+		bool			manualScale;
+		float			manualMin;
+		float			manualMax;
+		int32			width;
+		int32			height;
+		float			gridSpacing;
+		uint32			background;
+		uint32			grid;
+		uint32			line;
+		// The time at the right edge while inspecting the past, 0 while
+		// live
+		bigtime_t		end;
+		// Changes whenever the frames have to be drawn from scratch
+		uint32			generation;
+	};
+
+	// What is in one of the frame buffers, so that the next frame rendered
+	// into it only has to draw what changed since
+	struct frame_state {
+		GraphRasterizer	rasterizer;
+		// 0 until something has been drawn
+		uint32			generation;
+		int32			width;
+		int32			height;
+		// The time between columns, and that of the newest one
+		bigtime_t		resolution;
+		bigtime_t		lastRefresh;
+		// The end of the inspected range, 0 for a live frame
+		bigtime_t		lastEnd;
+		float			scrollOffset;
+		float			lastMin;
+		float			lastRange;
+		// The newest column
+		float			lastTop;
+		float			lastLow;
+		// The envelope of every column, in the same ring as the bitmap,
+		// so that the window thread can look up values without locking
+		// the metric
+		std::vector<float> lows;
+		std::vector<float> highs;
+	};
+
+	// The columns sampled into fLows and fTops with the metric locked,
+	// which are drawn once it is unlocked again
+	struct column_draw {
+		// The image column of the first one sampled, and how many
+		int32			firstX;
+		int32			count;
+		// The image columns [from, to) are drawn; the sampled ones around
+		// them are only there for the line to connect to
+		int32			from;
+		int32			to;
+		float			min;
+		float			range;
+	};
+
+	// What the tooltips show of the whole history, published by the
+	// render thread whenever it looks at the metric
+	struct history_readout {
+		bigtime_t		start;
+		bigtime_t		end;
+		float			quantiles[kQuantileCount];
+		uint32			bins[kToolTipBins];
+		float			binLow;
+		float			binHigh;
+	};
+
+			void		_RequestFrame();
+			void		_UpdateRenderParams();
+			void		_DrawCrosshair();
+			void		_DrawInspectLabel();
+			void		_SetInspectEnd(bigtime_t end);
+			bool		_FrameValuesAt(float x, bigtime_t& time,
+							float& low, float& high, float& min,
+							float& range);
+			bool		_FrameCrosshairAt(bigtime_t time, float& x,
+							float& low, float& high, float& min,
+							float& range);
+			void		_UpdateReadout(const render_params& params);
+			bool		_NeedsFrame(const render_params& params) const;
+			bool		_SampleHistory(const render_params& params,
+							frame_state& frame, column_draw& draw);
+			bool		_SampleInspected(const render_params& params,
+							frame_state& frame, column_draw& draw);
+			bool		_DrawColumns(const render_params& params,
+							frame_state& frame, const column_draw& draw);
+	static	bool		_ResizeColumns(frame_state& frame, int32 width);
+	static	void		_StoreColumns(frame_state& frame, int32 x,
+							int32 count, const float* lows,
+							const float* highs);
+	static	void		_SampleTile(void* cookie, bigtime_t start,
+							bigtime_t step, int32 count, float* lows,
+							float* highs);
+	static	void		_GetScale(const render_params& params, float& min,
+							float& range);
+	static	void		_GetInspectedScale(const render_params& params,
+							const frame_state& frame, float& min,
+							float& range);
+			void		_FormatValue(BString& text, float value) const;
 
 private:
 	rgb_color			fColor;
 	color_which		 fSystemColor;
-	BBitmap*			fOffscreen;
-	DataHistory*		fHistory;
+	metric_id			fMetric;
+	int32				fField;
+	DataHistory<float>*	fHistory;
+	value_formatter		fFormatter;
 	bigtime_t			fResolution;
-	std::vector<BPoint>	fPoints;
 
 	bool				fManualScale;
-	int64				fManualMin;
-	int64				fManualMax;
+	float				fManualMin;
+	float				fManualMax;
+	// Set when a frame was skipped while hidden
+	bool				fFrameMissed;
+	bigtime_t			fCrosshairTime;
 
-	int64				fLastMin;
-	int64				fLastRange;
-	bool				fLastRangeValid;
+	// The time at the right edge, a multiple of fResolution, or 0 while
+	// live
+	bigtime_t			fInspectEnd;
+	bool				fDragging;
+	float				fDragX;
+	bigtime_t			fDragEnd;
 
-	bigtime_t			fLastRefresh;
-	float				fScrollOffset;
+	GraphFrameBuffers	fBuffers;
+	render_params		fParams;
+	// Only touched by the render thread, apart from the front one that is
+	// read by Draw() with the buffers locked
+	frame_state			fFrames[2];
+	SeqLock<history_readout> fReadout;
+	// Top and bottom of each column's envelope, for the render thread
+	std::vector<float>	fTops;
+	std::vector<float>	fLows;
+	// The inspected past, for the render thread
+	GraphTileCache		fTiles;
+	DataHistory<float>*	fTileHistory;
+	int32				fTileField;
 };
 
 #endif // ACTIVITYGRAPHVIEW_H
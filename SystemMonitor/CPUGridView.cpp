@@ -0,0 +1,759 @@
+#include "CPUGridView.h"
+#include <Bitmap.h>
+#include <Catalog.h>
+#include <ControlLook.h>
+#include <Window.h>
+#include <algorithm>
+#include <new>
+#include <cmath>
+#include <string.h>
+#include "FrameCoordinator.h"
+#include "GraphCrosshair.h"
+#include "GraphSampler.h"
+#include "Utils.h"
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "CPUGridView"
+
+
+static const float kMinCellWidth = 50;
+static const float kMinCellHeight = 40;
+
+
+CPUGridView::CPUGridView(const char* name, rgb_color color,
+	color_which systemColor)
+	: BView(name, B_WILL_DRAW | B_FULL_UPDATE_ON_RESIZE | B_FRAME_EVENTS),
+	fColor(color),
+	fSystemColor(systemColor),
+	fMetric(-1),
+	fHistory(NULL),
+	fFormatter(NULL),
+	fResolution(1000000),
+	fManualScale(false),
+	fManualMin(0),
+	fManualMax(0),
+	fFrameMissed(true),
+	fCrosshairTime(kNoCrosshairTime),
+	fCellCount(0),
+	fColumns(1),
+	fRows(0),
+	fSpacing(0),
+	fCellWidth(0),
+	fCellHeight(0)
+{
+	fParams.metric = -1;
+	fParams.history = NULL;
+	fParams.resolution = fResolution;
+	fParams.manualScale = false;
+	fParams.manualMin = 0;
+	fParams.manualMax = 0;
+	fParams.cellCount = 0;
+	fParams.columns = 1;
+	fParams.cellWidth = 0;
+	fParams.cellHeight = 0;
+	fParams.spacing = 0;
+	fParams.width = 0;
+	fParams.height = 0;
+	fParams.gridSpacing = 0;
+	fParams.background = 0;
+	fParams.grid = 0;
+	fParams.line = 0;
+	fParams.generation = 1;
+
+	for (int32 i = 0; i < 2; i++) {
+		fFrames[i].generation = 0;
+		fFrames[i].width = 0;
+		fFrames[i].height = 0;
+		fFrames[i].columns = 1;
+		fFrames[i].cellWidth = 0;
+		fFrames[i].cellHeight = 0;
+		fFrames[i].spacing = 0;
+		fFrames[i].resolution = 0;
+		fFrames[i].lastRefresh = 0;
+		fFrames[i].scrollOffset = 0;
+	}
+}
+
+
+CPUGridView::~CPUGridView()
+{
+	GraphRenderer::Default().Remove(this);
+}
+
+
+void
+CPUGridView::AttachedToWindow()
+{
+	BView::AttachedToWindow();
+	_UpdateLayout();
+	FrameCoordinator::Attach(this);
+
+	if (fMetric >= 0)
+		MetricRegistry::Default().StartWatching(fMetric, BMessenger(this));
+
+	GraphCrosshair& crosshair = GraphCrosshair::Default();
+	crosshair.StartWatching(BMessenger(this));
+	fCrosshairTime = crosshair.Time();
+
+	_RequestFrame();
+}
+
+
+void
+CPUGridView::DetachedFromWindow()
+{
+	if (fMetric >= 0)
+		MetricRegistry::Default().StopWatching(fMetric, BMessenger(this));
+	GraphCrosshair::Default().StopWatching(BMessenger(this));
+	GraphRenderer::Default().Remove(this);
+	FrameCoordinator::Detach(this);
+
+	BView::DetachedFromWindow();
+}
+
+
+void
+CPUGridView::MessageReceived(BMessage* message)
+{
+	switch (message->what) {
+		case kMsgMetricUpdated:
+			// One frame for all cells
+			_RequestFrame();
+			break;
+
+		case kMsgGraphFrameReady:
+			// Shown with the other graphs at the next display frame
+			FrameCoordinator::Invalidate(this);
+			break;
+
+		case kMsgCrosshairMoved:
+			// Only an overlay, the frame is just copied again
+			if (message->FindInt64("time", &fCrosshairTime) != B_OK)
+				fCrosshairTime = kNoCrosshairTime;
+			if (FrameCoordinator::IsVisible(this))
+				FrameCoordinator::Invalidate(this);
+			break;
+
+		case B_MOUSE_WHEEL_CHANGED: {
+			// All cells share the same time axis
+			float deltaY;
+			if (message->FindFloat("be:wheel_delta_y", &deltaY) == B_OK) {
+				if (deltaY > 0)
+					fResolution *= 2;
+				else
+					fResolution /= 2;
+
+				if (fResolution < 10000) fResolution = 10000;
+				if (fResolution > 60000000) fResolution = 60000000;
+
+				_RequestFrame();
+			}
+			break;
+		}
+		default:
+			BView::MessageReceived(message);
+	}
+}
+
+
+void
+CPUGridView::FrameResized(float /*width*/, float /*height*/)
+{
+	// Until the frame in the new size is ready, Draw() stretches the last one
+	_UpdateLayout();
+	_RequestFrame();
+}
+
+
+void
+CPUGridView::SetMetric(metric_id metric)
+{
+	MetricRegistry& registry = MetricRegistry::Default();
+	if (Window() != NULL && fMetric >= 0)
+		registry.StopWatching(fMetric, BMessenger(this));
+
+	fMetric = metric;
+	// Histories live as long as the registry
+	fHistory = registry.HistoryFor(metric);
+	fCellCount = fHistory != NULL ? fHistory->CountFields() : 0;
+
+	if (Window() != NULL && fMetric >= 0)
+		registry.StartWatching(fMetric, BMessenger(this));
+
+	// Roughly square, like a grid of separate graphs would be
+	fColumns = std::max((int32)1, static_cast<int32>(ceil(sqrt(
+		static_cast<double>(fCellCount)))));
+	fRows = (fCellCount + fColumns - 1) / fColumns;
+
+	float spacing = be_control_look->DefaultItemSpacing();
+	SetExplicitMinSize(BSize(
+		fColumns * kMinCellWidth + (fColumns - 1) * spacing,
+		fRows * kMinCellHeight + std::max((int32)0, fRows - 1) * spacing));
+
+	_UpdateLayout();
+	_RequestFrame();
+}
+
+
+void
+CPUGridView::SetManualScale(float min, float max)
+{
+	fManualScale = true;
+	fManualMin = min;
+	fManualMax = max;
+	_RequestFrame();
+}
+
+
+void
+CPUGridView::SetValueFormatter(value_formatter formatter)
+{
+	fFormatter = formatter;
+}
+
+
+void
+CPUGridView::Draw(BRect updateRect)
+{
+	if (fFrameMissed)
+		_RequestFrame();
+
+	if (fHistory == NULL || !fBuffers.Lock()) {
+		SetLowColor(ui_color(B_PANEL_BACKGROUND_COLOR));
+		FillRect(updateRect, B_SOLID_LOW);
+		return;
+	}
+
+	BBitmap* atlas = fBuffers.Front();
+	const frame_state& frame = fFrames[fBuffers.FrontIndex()];
+	int32 origin = frame.rasterizer.Origin();
+	BRect bounds = Bounds();
+	if (atlas != NULL && frame.generation != 0 && origin == 0) {
+		// The whole grid in one go
+		DrawBitmap(atlas, BRect(0, 0, frame.width - 1, frame.height - 1),
+			bounds);
+	} else if (atlas != NULL && frame.generation != 0) {
+		// Every cell is a ring, so it is put together from two parts; a
+		// frame from before a resize is stretched
+		float scaleX = (bounds.Width() + 1) / frame.width;
+		float scaleY = (bounds.Height() + 1) / frame.height;
+		int32 cellWidth = frame.cellWidth;
+		for (int32 i = 0; i < fCellCount; i++) {
+			float left = (i % frame.columns) * (cellWidth + frame.spacing);
+			float top = (i / frame.columns)
+				* (frame.cellHeight + frame.spacing);
+			float bottom = top + frame.cellHeight - 1;
+			if (bottom >= frame.height)
+				break;
+
+			float destinationTop = bounds.top + top * scaleY;
+			float destinationBottom = bounds.top + (bottom + 1) * scaleY - 1;
+			float split = bounds.left + (left + cellWidth - origin) * scaleX;
+			DrawBitmap(atlas, BRect(left + origin, top, left + cellWidth - 1,
+				bottom), BRect(bounds.left + left * scaleX, destinationTop,
+				split - 1, destinationBottom));
+			DrawBitmap(atlas, BRect(left, top, left + origin - 1, bottom),
+				BRect(split, destinationTop,
+					bounds.left + (left + cellWidth) * scaleX - 1,
+					destinationBottom));
+		}
+	} else {
+		SetLowColor(ui_color(B_PANEL_BACKGROUND_COLOR));
+		FillRect(updateRect, B_SOLID_LOW);
+	}
+
+	fBuffers.Unlock();
+
+	// A line in every cell, the values are in the tooltips. All cells
+	// share the time axis of the frame on screen, which may still be from
+	// before a zoom or resize.
+	float position;
+	if (fCrosshairTime != kNoCrosshairTime
+		&& _FrameCrosshairAt(fCrosshairTime, position)) {
+		for (int32 i = 0; i < fCellCount; i++) {
+			BRect cell = _CellFrame(i);
+			GraphCrosshair::Draw(this, cell, floorf(cell.left
+				+ position * (cell.Width() + 1)) + 0.5f, NAN, NULL);
+		}
+	}
+}
+
+
+void
+CPUGridView::MouseMoved(BPoint where, uint32 transit,
+	const BMessage* dragMessage)
+{
+	// Every graph shows the time under the mouse
+	GraphCrosshair& crosshair = GraphCrosshair::Default();
+	if (transit == B_EXITED_VIEW || transit == B_OUTSIDE_VIEW)
+		crosshair.SetTime(kNoCrosshairTime);
+	else {
+		BRect cell = _CellFrame(std::max((int32)0, _CellAt(where)));
+		crosshair.SetTime(GraphCrosshair::TimeAt(where.x, cell, fResolution));
+	}
+
+	BView::MouseMoved(where, transit, dragMessage);
+}
+
+
+bool
+CPUGridView::GetToolTipAt(BPoint point, BToolTip** _tip)
+{
+	int32 index = _CellAt(point);
+	bigtime_t time;
+	float cellValue;
+	if (index < 0 || fHistory == NULL
+		|| !_FrameValueAt(index, point.x, time, cellValue)) {
+		return false;
+	}
+
+	bigtime_t ago = std::max((bigtime_t)0, system_time() - time);
+
+	BString value;
+	_FormatValue(value, cellValue);
+
+	BString when;
+	FormatTimeAgo(when, ago);
+
+	BString text;
+	text.SetToFormat(B_TRANSLATE("CPU %" B_PRId32 ": %s (%s)"), index + 1,
+		value.String(), when.String());
+
+	SetToolTip(text.String());
+	*_tip = ToolTip();
+	return *_tip != NULL;
+}
+
+
+void
+CPUGridView::RenderFrame()
+{
+	if (!fBuffers.Lock())
+		return;
+	render_params params = fParams;
+	fBuffers.Unlock();
+
+	if (params.history == NULL || params.width <= 0 || params.height <= 0)
+		return;
+
+	frame_state& frame = fFrames[fBuffers.BackIndex()];
+	BBitmap* atlas = fBuffers.Back(params.width, params.height);
+	if (atlas == NULL)
+		return;
+
+	// All cells have the same size, so their common origin stays until
+	// the layout changes
+	frame.rasterizer.SetTarget(static_cast<uint32*>(atlas->Bits()),
+		atlas->BytesPerRow(), params.cellWidth, params.cellHeight);
+	frame.rasterizer.SetColors(params.background, params.grid, params.line,
+		100, params.line);
+	frame.rasterizer.SetLineWidth(1.5f);
+
+	MetricRegistry& registry = MetricRegistry::Default();
+	if (!registry.LockMetric(params.metric))
+		return;
+
+	// Drawing doesn't need the metric anymore, so publishing never waits
+	// for it
+	bool sampled = _SampleCells(params, frame);
+	registry.UnlockMetric(params.metric);
+
+	if (!sampled || !_DrawCells(params, frame))
+		return;
+
+	fBuffers.Swap();
+
+	BMessage ready(kMsgGraphFrameReady);
+	BMessenger(this).SendMessage(&ready, (BHandler*)NULL, 0);
+}
+
+
+void
+CPUGridView::_RequestFrame()
+{
+	// While hidden the history just keeps recording, and showing the grid
+	// renders what was missed
+	if (!FrameCoordinator::IsVisible(this)) {
+		fFrameMissed = true;
+		return;
+	}
+
+	fFrameMissed = false;
+	_UpdateRenderParams();
+	GraphRenderer::Default().Request(this);
+}
+
+
+void
+CPUGridView::_UpdateRenderParams()
+{
+	rgb_color drawColor = fColor;
+	if (fSystemColor != (color_which)-1)
+		drawColor = ui_color(fSystemColor);
+
+	rgb_color bg = ui_color(B_PANEL_BACKGROUND_COLOR);
+	rgb_color gridColor = tint_color(bg, B_DARKEN_1_TINT);
+
+	BFont viewFont;
+	GetFont(&viewFont);
+
+	BRect bounds = Bounds();
+
+	render_params params;
+	params.metric = fMetric;
+	params.history = fHistory;
+	params.resolution = fResolution;
+	params.manualScale = fManualScale;
+	params.manualMin = fManualMin;
+	params.manualMax = fManualMax;
+	params.cellCount = fCellCount;
+	params.columns = fColumns;
+	params.cellWidth = fCellWidth;
+	params.cellHeight = fCellHeight;
+	params.spacing = static_cast<int32>(fSpacing);
+	params.width = static_cast<int32>(bounds.Width()) + 1;
+	params.height = static_cast<int32>(bounds.Height()) + 1;
+	params.gridSpacing = 60.0f * GetScaleFactor(&viewFont);
+	params.background = GraphRasterizer::MakePixel(bg.red, bg.green,
+		bg.blue);
+	params.grid = GraphRasterizer::MakePixel(gridColor.red, gridColor.green,
+		gridColor.blue);
+	params.line = GraphRasterizer::MakePixel(drawColor.red, drawColor.green,
+		drawColor.blue);
+
+	if (!fBuffers.Lock())
+		return;
+
+	params.generation = fParams.generation;
+	if (params.cellCount != fParams.cellCount
+		|| params.columns != fParams.columns
+		|| params.cellWidth != fParams.cellWidth
+		|| params.cellHeight != fParams.cellHeight
+		|| params.spacing != fParams.spacing
+		|| params.width != fParams.width || params.height != fParams.height
+		|| params.resolution != fParams.resolution
+		|| params.gridSpacing != fParams.gridSpacing
+		|| params.background != fParams.background
+		|| params.grid != fParams.grid || params.line != fParams.line) {
+		// Never 0, which marks empty frames
+		if (++params.generation == 0)
+			params.generation = 1;
+	}
+
+	fParams = params;
+	fBuffers.Unlock();
+}
+
+
+void
+CPUGridView::_UpdateLayout()
+{
+	BRect bounds = Bounds();
+	fSpacing = be_control_look->DefaultItemSpacing();
+
+	// All cells have the same size, so the rasterizer's cached row pattern
+	// is shared by all of them; what's left over stays on the right
+	int32 width = static_cast<int32>(bounds.Width()) + 1;
+	int32 height = static_cast<int32>(bounds.Height()) + 1;
+	int32 spacing = static_cast<int32>(fSpacing);
+	fCellWidth = fColumns > 0
+		? (width - (fColumns - 1) * spacing) / fColumns : 0;
+	fCellHeight = fRows > 0 ? (height - (fRows - 1) * spacing) / fRows : 0;
+}
+
+
+/*!	Samples the envelopes of the columns that came in since the frame was
+	last rendered into, in every cell, and those of the cells whose scale
+	changed. Called from the render thread with the metric locked; returns
+	false if memory is low.
+*/
+bool
+CPUGridView::_SampleCells(const render_params& params, frame_state& frame)
+{
+	int32 cellWidth = params.cellWidth;
+	int32 cellCount = params.cellCount;
+	if (cellWidth <= 0 || params.cellHeight <= 0) {
+		fDraws.clear();
+		return true;
+	}
+
+	size_t size = static_cast<size_t>(cellWidth) * cellCount;
+	try {
+		if (fTops.size() < size)
+			fTops.resize(size);
+		if (fLows.size() < size)
+			fLows.resize(size);
+		fDraws.resize(cellCount);
+		frame.mins.resize(cellCount);
+		frame.ranges.resize(cellCount);
+		frame.values.resize(size);
+	} catch (const std::bad_alloc&) {
+		// Ignore update if memory is low
+		frame.generation = 0;
+		return false;
+	}
+
+	bigtime_t now = system_time();
+	bigtime_t resolution = params.resolution;
+
+	int32 pixelsToScroll = cellWidth;
+	if (frame.generation == params.generation && now >= frame.lastRefresh) {
+		pixelsToScroll = static_cast<int32>(std::min(
+			(now - frame.lastRefresh) / resolution,
+			static_cast<bigtime_t>(cellWidth)));
+	}
+
+	bool fullRedraw = pixelsToScroll >= cellWidth;
+	if (fullRedraw) {
+		frame.generation = 0;
+		frame.width = params.width;
+		frame.height = params.height;
+		frame.columns = params.columns;
+		frame.cellWidth = cellWidth;
+		frame.cellHeight = params.cellHeight;
+		frame.spacing = params.spacing;
+		frame.resolution = resolution;
+		frame.lastRefresh = now;
+		frame.scrollOffset = 0;
+	} else if (pixelsToScroll > 0) {
+		// Once for all cells
+		frame.rasterizer.Scroll(pixelsToScroll);
+		frame.scrollOffset = fmodf(frame.scrollOffset + pixelsToScroll,
+			params.gridSpacing);
+		frame.lastRefresh += static_cast<bigtime_t>(pixelsToScroll)
+			* resolution;
+	}
+
+	// The new columns (at least the last one), and the one before them
+	// that the line has to connect to
+	int32 redrawWidth = std::max((int32)1, pixelsToScroll);
+	int32 newFrom = std::max((int32)0, cellWidth - 1 - redrawWidth);
+
+	for (int32 i = 0; i < cellCount; i++) {
+		float min, max;
+		if (params.manualScale) {
+			min = params.manualMin;
+			max = params.manualMax;
+		} else {
+			min = params.history->MinimumValue(i);
+			max = params.history->MaximumValue(i);
+		}
+
+		cell_draw& draw = fDraws[i];
+		draw.from = newFrom;
+		draw.to = cellWidth;
+		if (fullRedraw || min != frame.mins[i]
+			|| max - min != frame.ranges[i]) {
+			draw.from = 0;
+			frame.mins[i] = min;
+			frame.ranges[i] = max - min;
+		}
+		draw.firstX = std::max((int32)0, draw.from - 1);
+		draw.count = cellWidth - draw.firstX;
+
+		size_t offset = static_cast<size_t>(i) * cellWidth;
+		float* lows = fLows.data() + offset;
+		float* tops = fTops.data() + offset;
+		GraphSampler::SampleValues(params.history, i, frame.lastRefresh
+			- static_cast<bigtime_t>(cellWidth - 1 - draw.firstX)
+				* resolution, resolution, draw.count, lows, tops);
+
+		// For the very last pixel, use 'now' for maximum smoothness
+		GraphSampler::SampleValues(params.history, i, now, resolution,
+			1, lows + draw.count - 1, tops + draw.count - 1);
+
+		_StoreColumns(frame, i, draw.firstX, draw.count, tops);
+	}
+
+	return true;
+}
+
+
+/*!	Keeps the values of the image columns [x, x + count) of a cell with the
+	frame, in the buffer columns that show them.
+*/
+/*static*/ void
+CPUGridView::_StoreColumns(frame_state& frame, int32 index, int32 x,
+	int32 count, const float* values)
+{
+	int32 width = frame.cellWidth;
+	float* cellValues = frame.values.data()
+		+ static_cast<size_t>(index) * width;
+	int32 column = (frame.rasterizer.Origin() + x) % width;
+	for (int32 i = 0; i < count; i++) {
+		cellValues[column] = values[i];
+		if (++column == width)
+			column = 0;
+	}
+}
+
+
+/*!	Draws the columns _SampleCells() left into every cell of the back
+	buffer, without the metric locked. Returns false if the frame couldn't
+	be drawn.
+*/
+bool
+CPUGridView::_DrawCells(const render_params& params, frame_state& frame)
+{
+	BBitmap* atlas = fBuffers.Back(params.width, params.height);
+	if (atlas == NULL)
+		return false;
+
+	if (frame.generation != params.generation) {
+		// The gaps between the cells never change until the next layout
+		uint32* bits = static_cast<uint32*>(atlas->Bits());
+		size_t count = atlas->BitsLength() / sizeof(uint32);
+		std::fill(bits, bits + count, params.background);
+
+		frame.generation = params.generation;
+		frame.width = params.width;
+		frame.height = params.height;
+	}
+
+	int32 cellWidth = params.cellWidth;
+	int32 cellHeight = params.cellHeight;
+	if (cellWidth <= 0 || cellHeight <= 0)
+		return true;
+
+	// The vertical grid lines move along with the data
+	frame.rasterizer.SetGrid(4, params.gridSpacing, frame.scrollOffset);
+
+	uint8* atlasBits = static_cast<uint8*>(atlas->Bits());
+	int32 bytesPerRow = atlas->BytesPerRow();
+	float height = static_cast<float>(cellHeight - 1);
+
+	for (int32 i = 0; i < params.cellCount; i++) {
+		const cell_draw& draw = fDraws[i];
+		if (draw.to <= draw.from)
+			continue;
+
+		int32 left = (i % params.columns) * (cellWidth + params.spacing);
+		int32 top = (i / params.columns) * (cellHeight + params.spacing);
+		uint8* cellBits = atlasBits + static_cast<size_t>(top) * bytesPerRow
+			+ static_cast<size_t>(left) * sizeof(uint32);
+
+		// Same size every time, so only the target moves, and the origin
+		// stays
+		frame.rasterizer.SetTarget(reinterpret_cast<uint32*>(cellBits),
+			bytesPerRow, cellWidth, cellHeight);
+
+		float* tops = fTops.data() + static_cast<size_t>(i) * cellWidth;
+		float* lows = fLows.data() + static_cast<size_t>(i) * cellWidth;
+		for (int32 j = 0; j < draw.count; j++) {
+			tops[j] = ActivityGraphView::ValueToY(tops[j], frame.mins[i],
+				frame.ranges[i], height);
+			lows[j] = ActivityGraphView::ValueToY(lows[j], frame.mins[i],
+				frame.ranges[i], height);
+		}
+
+		int32 skip = draw.from - draw.firstX;
+		if (frame.rasterizer.DrawColumns(draw.from, draw.to - draw.from,
+				tops + skip, lows + skip, skip > 0 ? tops[skip - 1] : NAN)
+				!= B_OK) {
+			// The ring has already moved on
+			frame.generation = 0;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+BRect
+CPUGridView::_CellFrame(int32 index) const
+{
+	int32 spacing = static_cast<int32>(fSpacing);
+	int32 column = index % fColumns;
+	int32 row = index / fColumns;
+
+	BRect bounds = Bounds();
+	float left = bounds.left + column * (fCellWidth + spacing);
+	float top = bounds.top + row * (fCellHeight + spacing);
+	return BRect(left, top, left + fCellWidth - 1, top + fCellHeight - 1);
+}
+
+
+int32
+CPUGridView::_CellAt(BPoint point) const
+{
+	for (int32 i = 0; i < fCellCount; i++) {
+		if (_CellFrame(i).Contains(point))
+			return i;
+	}
+
+	return -1;
+}
+
+
+/*!	Looks up the value of the column at x of a cell in the frame on
+	screen, and the time it shows by the frame's own time axis. A frame
+	from before a resize is stretched, like Draw() shows it.
+*/
+bool
+CPUGridView::_FrameValueAt(int32 index, float x, bigtime_t& time,
+	float& value)
+{
+	if (!fBuffers.Lock())
+		return false;
+
+	const frame_state& frame = fFrames[fBuffers.FrontIndex()];
+	int32 width = frame.cellWidth;
+	bool found = frame.generation != 0 && width > 0 && frame.resolution > 0
+		&& frame.values.size() >= static_cast<size_t>(width) * (index + 1);
+	if (found) {
+		BRect cell = _CellFrame(index);
+		int32 column = static_cast<int32>((x - cell.left) * width
+			/ (cell.Width() + 1));
+		column = std::min(std::max(column, (int32)0), width - 1);
+
+		time = frame.lastRefresh - static_cast<bigtime_t>(width - 1 - column)
+			* frame.resolution;
+		column = (frame.rasterizer.Origin() + column) % width;
+		value = frame.values[static_cast<size_t>(index) * width + column];
+		// Nothing to show from before the history began
+		found = value == value;
+	}
+
+	fBuffers.Unlock();
+	return found;
+}
+
+
+/*!	Looks up where the column of the frame on screen that shows time is in
+	every cell, by the frame's own time axis, as a fraction of the cell
+	width. A frame from before a resize is stretched, like Draw() shows it.
+*/
+bool
+CPUGridView::_FrameCrosshairAt(bigtime_t time, float& position)
+{
+	if (!fBuffers.Lock())
+		return false;
+
+	const frame_state& frame = fFrames[fBuffers.FrontIndex()];
+	int32 width = frame.cellWidth;
+	bool found = frame.generation != 0 && width > 0 && frame.resolution > 0;
+	if (found) {
+		// Anything within the newest column still belongs to it
+		int64 column = width - 1
+			- (frame.lastRefresh - time) / frame.resolution;
+		found = column >= 0 && column < width;
+		if (found)
+			position = (column + 0.5f) / width;
+	}
+
+	fBuffers.Unlock();
+	return found;
+}
+
+
+void
+CPUGridView::_FormatValue(BString& text, float value) const
+{
+	if (fFormatter != NULL)
+		fFormatter(text, value);
+	else {
+		text.Truncate(0);
+		text << value;
+	}
+}
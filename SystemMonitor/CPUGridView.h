@@ -0,0 +1,164 @@
+#ifndef CPUGRIDVIEW_H
+#define CPUGRIDVIEW_H
+
+#include <String.h>
+#include <View.h>
+#include <vector>
+#include "ActivityGraphView.h"
+#include "DataHistory.h"
+#include "GraphRasterizer.h"
+#include "GraphRenderer.h"
+#include "MetricRegistry.h"
+
+class BBitmap;
+
+// Shows every field of a metric as its own graph, laid out in a grid of
+// cells that looks like one ActivityGraphView per field. All cells are
+// rasterized into one shared bitmap in a single pass and copied to the
+// screen at once, so a machine with many cores costs one view, one bitmap
+// and one redraw per update instead of one of each per core. Like the
+// ActivityGraphView, the atlas is rendered on the GraphRenderer's thread
+// into one of two bitmaps, and Draw() only copies the newest one.
+//
+// Every cell is a ring of columns, and all of them share the origin of
+// their frame's rasterizer: scrolling moves it once for the whole atlas,
+// and only the columns that came in are drawn in each cell. A cell whose
+// scale changed is drawn anew on its own.
+class CPUGridView : public BView, public GraphRenderClient {
+public:
+						CPUGridView(const char* name, rgb_color color,
+							color_which systemColor = (color_which)-1);
+	virtual				~CPUGridView();
+
+	virtual void		AttachedToWindow();
+	virtual void		DetachedFromWindow();
+	virtual void		MessageReceived(BMessage* message);
+	virtual void		FrameResized(float width, float height);
+	virtual void		Draw(BRect updateRect);
+	virtual void		MouseMoved(BPoint where, uint32 transit,
+							const BMessage* dragMessage);
+	virtual bool		GetToolTipAt(BPoint point, BToolTip** _tip);
+
+	virtual void		RenderFrame();
+
+			// One cell per field of the metric; redraws whenever it is
+			// published.
+			void		SetMetric(metric_id metric);
+			void		SetManualScale(float min, float max);
+			void		SetValueFormatter(value_formatter formatter);
+
+private:
+	// What the render thread needs from the view, handed over with the
+	// frame buffers locked
+	struct render_params {
+		metric_id		metric;
+		DataHistory<float>*	history;
+		bigtime_t		resolution;
+		bool			manualScale;
+		float			manualMin;
+		float			manualMax;
+		int32			cellCount;
+		int32			columns;
+		int32			cellWidth;
+		int32			cellHeight;
+		int32			spacing;
+		int32			width;
+		int32			height;
+		float			gridSpacing;
+		uint32			background;
+		uint32			grid;
+		uint32			line;
+		// Changes whenever the space between the cells has to be filled
+		// again, or the cells drawn anew
+		uint32			generation;
+	};
+
+	// What is in one of the frame buffers
+	struct frame_state {
+		// Shared by all cells, which keeps their common origin
+		GraphRasterizer	rasterizer;
+		// 0 until the space between the cells has been filled
+		uint32			generation;
+		int32			width;
+		int32			height;
+		int32			columns;
+		int32			cellWidth;
+		int32			cellHeight;
+		int32			spacing;
+		// The time between columns, and when the newest one was sampled
+		bigtime_t		resolution;
+		bigtime_t		lastRefresh;
+		float			scrollOffset;
+		// The scale every cell was drawn with
+		std::vector<float> mins;
+		std::vector<float> ranges;
+		// The value of every cell's columns, one cell after the other, in
+		// the same ring as the atlas, so that the window thread can look
+		// them up without locking the metric
+		std::vector<float> values;
+	};
+
+	// The columns of a cell sampled into fLows and fTops with the metric
+	// locked, which are drawn once it is unlocked again
+	struct cell_draw {
+		// The image column of the first one sampled, and how many
+		int32			firstX;
+		int32			count;
+		// The image columns [from, to) are drawn; the sampled one before
+		// them is only there for the line to connect to
+		int32			from;
+		int32			to;
+	};
+
+			void		_RequestFrame();
+			void		_UpdateRenderParams();
+			void		_UpdateLayout();
+			bool		_SampleCells(const render_params& params,
+							frame_state& frame);
+	static	void		_StoreColumns(frame_state& frame, int32 index,
+							int32 x, int32 count, const float* values);
+			bool		_DrawCells(const render_params& params,
+							frame_state& frame);
+			BRect		_CellFrame(int32 index) const;
+			int32		_CellAt(BPoint point) const;
+			bool		_FrameValueAt(int32 index, float x, bigtime_t& time,
+							float& value);
+			bool		_FrameCrosshairAt(bigtime_t time, float& position);
+			void		_FormatValue(BString& text, float value) const;
+
+private:
+	rgb_color			fColor;
+	color_which			fSystemColor;
+	metric_id			fMetric;
+	DataHistory<float>*	fHistory;
+	value_formatter		fFormatter;
+	bigtime_t			fResolution;
+
+	bool				fManualScale;
+	float				fManualMin;
+	float				fManualMax;
+	// Set when a frame was skipped while hidden
+	bool				fFrameMissed;
+	bigtime_t			fCrosshairTime;
+
+	int32				fCellCount;
+	int32				fColumns;
+	int32				fRows;
+	float				fSpacing;
+	int32				fCellWidth;
+	int32				fCellHeight;
+
+	// All cells, laid out as in the view; the space between them is
+	// filled once per buffer when the layout changes
+	GraphFrameBuffers	fBuffers;
+	render_params		fParams;
+	frame_state			fFrames[2];
+	// Everything below is only used by the render thread. The envelopes
+	// of all cells are sampled, one cell after the other at a stride of
+	// the cell width, before any is drawn.
+	std::vector<float>	fTops;
+	std::vector<float>	fLows;
+	std::vector<cell_draw> fDraws;
+};
+
+#endif // CPUGRIDVIEW_H
@@ -0,0 +1,680 @@
+#include "CPUHeatmapView.h"
+#include <Bitmap.h>
+#include <Catalog.h>
+#include <Window.h>
+#include <algorithm>
+#include <new>
+#include <cmath>
+#include "GraphRasterizer.h"
+#include "FrameCoordinator.h"
+#include "GraphCrosshair.h"
+#include "Utils.h"
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "CPUHeatmapView"
+
+
+static const bigtime_t kResortInterval = 3000000;
+static const float kMinHeight = 80;
+
+
+static float
+SampleValue(const DataHistory<float>* history, int32 field, bigtime_t time,
+	bigtime_t step, int32 level, int32* hintIndex)
+{
+	// When zoomed out, the peak within the pixel, like the graphs' envelope
+	float low, high;
+	if (level >= 0 && history->EnvelopeAt(level, time - step + 1, time + 1,
+			low, high, hintIndex, field)) {
+		return high;
+	}
+
+	return history->ValueAt(time, level >= 0 ? NULL : hintIndex, field);
+}
+
+
+CPUHeatmapView::CPUHeatmapView(const char* name, rgb_color color,
+	color_which systemColor)
+	: BView(name, B_WILL_DRAW | B_FULL_UPDATE_ON_RESIZE | B_FRAME_EVENTS),
+	fColor(color),
+	fSystemColor(systemColor),
+	fMetric(-1),
+	fHistory(NULL),
+	fFormatter(NULL),
+	fResolution(1000000),
+	fMin(0),
+	fMax(100),
+	fRowCount(0),
+	fOrder(HEATMAP_BY_CORE),
+	fFrameMissed(true),
+	fCrosshairTime(kNoCrosshairTime),
+	fSortOrder(HEATMAP_BY_CORE),
+	fLastSort(0)
+{
+	fParams.metric = -1;
+	fParams.history = NULL;
+	fParams.resolution = fResolution;
+	fParams.width = 0;
+	fParams.rows = 0;
+	fParams.lowPixel = 0;
+	fParams.highPixel = 0;
+	fParams.min = fMin;
+	fParams.max = fMax;
+	fParams.order = fOrder;
+	fParams.generation = 1;
+
+	for (int32 i = 0; i < 2; i++) {
+		fFrames[i].generation = 0;
+		fFrames[i].width = 0;
+		fFrames[i].rows = 0;
+		fFrames[i].resolution = 0;
+		fFrames[i].newestColumn = 0;
+	}
+}
+
+
+CPUHeatmapView::~CPUHeatmapView()
+{
+	GraphRenderer::Default().Remove(this);
+}
+
+
+void
+CPUHeatmapView::AttachedToWindow()
+{
+	BView::AttachedToWindow();
+	FrameCoordinator::Attach(this);
+
+	if (fMetric >= 0)
+		MetricRegistry::Default().StartWatching(fMetric, BMessenger(this));
+
+	GraphCrosshair& crosshair = GraphCrosshair::Default();
+	crosshair.StartWatching(BMessenger(this));
+	fCrosshairTime = crosshair.Time();
+
+	_RequestFrame();
+}
+
+
+void
+CPUHeatmapView::DetachedFromWindow()
+{
+	if (fMetric >= 0)
+		MetricRegistry::Default().StopWatching(fMetric, BMessenger(this));
+	GraphCrosshair::Default().StopWatching(BMessenger(this));
+	GraphRenderer::Default().Remove(this);
+	FrameCoordinator::Detach(this);
+
+	BView::DetachedFromWindow();
+}
+
+
+void
+CPUHeatmapView::MessageReceived(BMessage* message)
+{
+	switch (message->what) {
+		case kMsgMetricUpdated:
+			_RequestFrame();
+			break;
+
+		case kMsgGraphFrameReady:
+			// Shown with the other graphs at the next display frame
+			FrameCoordinator::Invalidate(this);
+			break;
+
+		case kMsgCrosshairMoved:
+			// Only an overlay, the frame is just copied again
+			if (message->FindInt64("time", &fCrosshairTime) != B_OK)
+				fCrosshairTime = kNoCrosshairTime;
+			if (FrameCoordinator::IsVisible(this))
+				FrameCoordinator::Invalidate(this);
+			break;
+
+		case B_MOUSE_WHEEL_CHANGED: {
+			float deltaY;
+			if (message->FindFloat("be:wheel_delta_y", &deltaY) == B_OK) {
+				if (deltaY > 0)
+					fResolution *= 2;
+				else
+					fResolution /= 2;
+
+				if (fResolution < 10000) fResolution = 10000;
+				if (fResolution > 60000000) fResolution = 60000000;
+
+				_RequestFrame();
+			}
+			break;
+		}
+		default:
+			BView::MessageReceived(message);
+	}
+}
+
+
+void
+CPUHeatmapView::FrameResized(float /*width*/, float /*height*/)
+{
+	// Until the frame in the new size is ready, Draw() stretches the last one
+	_RequestFrame();
+}
+
+
+void
+CPUHeatmapView::SetMetric(metric_id metric)
+{
+	MetricRegistry& registry = MetricRegistry::Default();
+	if (Window() != NULL && fMetric >= 0)
+		registry.StopWatching(fMetric, BMessenger(this));
+
+	fMetric = metric;
+	// Histories live as long as the registry
+	fHistory = registry.HistoryFor(metric);
+	fRowCount = fHistory != NULL ? fHistory->CountFields() : 0;
+
+	if (Window() != NULL && fMetric >= 0)
+		registry.StartWatching(fMetric, BMessenger(this));
+
+	// At least a pixel row per core
+	SetExplicitMinSize(BSize(B_SIZE_UNSET,
+		std::max(kMinHeight, static_cast<float>(fRowCount))));
+
+	_RequestFrame();
+}
+
+
+void
+CPUHeatmapView::SetManualScale(float min, float max)
+{
+	fMin = min;
+	fMax = max;
+	_RequestFrame();
+}
+
+
+void
+CPUHeatmapView::SetValueFormatter(value_formatter formatter)
+{
+	fFormatter = formatter;
+}
+
+
+void
+CPUHeatmapView::SetOrder(heatmap_order order)
+{
+	if (order == fOrder)
+		return;
+
+	fOrder = order;
+	_RequestFrame();
+}
+
+
+void
+CPUHeatmapView::Draw(BRect updateRect)
+{
+	if (fFrameMissed)
+		_RequestFrame();
+
+	if (fHistory == NULL || !fBuffers.Lock()) {
+		SetLowColor(ui_color(B_PANEL_BACKGROUND_COLOR));
+		FillRect(updateRect, B_SOLID_LOW);
+		return;
+	}
+
+	BBitmap* bitmap = fBuffers.Front();
+	const frame_state& frame = fFrames[fBuffers.FrontIndex()];
+	if (bitmap == NULL || frame.generation == 0) {
+		fBuffers.Unlock();
+		SetLowColor(ui_color(B_PANEL_BACKGROUND_COLOR));
+		FillRect(updateRect, B_SOLID_LOW);
+		return;
+	}
+
+	// One pixel row per core, stretched to the view; the texture is a
+	// ring of columns, so the image is put together from two parts
+	BRect bounds = Bounds();
+	float bottom = frame.rows - 1;
+	int32 origin = frame.texture.Origin();
+	if (origin == 0) {
+		DrawBitmap(bitmap, BRect(0, 0, frame.width - 1, bottom), bounds);
+	} else {
+		float split = bounds.left + (frame.width - origin)
+			* (bounds.Width() + 1) / frame.width;
+		DrawBitmap(bitmap, BRect(origin, 0, frame.width - 1, bottom),
+			BRect(bounds.left, bounds.top, split - 1, bounds.bottom));
+		DrawBitmap(bitmap, BRect(0, 0, origin - 1, bottom),
+			BRect(split, bounds.top, bounds.right, bounds.bottom));
+	}
+
+	fBuffers.Unlock();
+
+	// Placed by the frame on screen, which may still be from before a
+	// zoom or resize
+	float position;
+	if (fCrosshairTime != kNoCrosshairTime
+		&& _FrameCrosshairAt(fCrosshairTime, position)) {
+		GraphCrosshair::Draw(this, bounds, floorf(bounds.left
+			+ position * (bounds.Width() + 1)) + 0.5f, NAN, NULL);
+	}
+}
+
+
+void
+CPUHeatmapView::MouseMoved(BPoint where, uint32 transit,
+	const BMessage* dragMessage)
+{
+	// Every graph shows the time under the mouse
+	GraphCrosshair& crosshair = GraphCrosshair::Default();
+	if (transit == B_EXITED_VIEW || transit == B_OUTSIDE_VIEW)
+		crosshair.SetTime(kNoCrosshairTime);
+	else
+		crosshair.SetTime(GraphCrosshair::TimeAt(where.x, Bounds(),
+			fResolution));
+
+	BView::MouseMoved(where, transit, dragMessage);
+}
+
+
+bool
+CPUHeatmapView::GetToolTipAt(BPoint point, BToolTip** _tip)
+{
+	// Only what the frame on screen shows, which was drawn from the history
+	BRect bounds = Bounds();
+	if (fHistory == NULL || !bounds.Contains(point) || !fBuffers.Lock())
+		return false;
+
+	const frame_state& frame = fFrames[fBuffers.FrontIndex()];
+	int32 width = frame.width;
+	int32 rows = frame.rows;
+	bool found = frame.generation != 0 && width > 0 && rows > 0
+		&& frame.resolution > 0
+		&& static_cast<int32>(frame.rowCores.size()) == rows
+		&& frame.values.size() >= static_cast<size_t>(width) * rows;
+
+	int32 core = 0;
+	float cellValue = 0;
+	bigtime_t time = 0;
+	if (found) {
+		int32 row = static_cast<int32>((point.y - bounds.top) * rows
+			/ (bounds.Height() + 1));
+		core = frame.rowCores[std::min(std::max(row, (int32)0), rows - 1)];
+
+		int32 column = static_cast<int32>((point.x - bounds.left) * width
+			/ (bounds.Width() + 1));
+		column = std::min(std::max(column, (int32)0), width - 1);
+
+		// By the frame's own time axis
+		time = frame.newestColumn - static_cast<bigtime_t>(width - 1 - column)
+			* frame.resolution;
+		column = (frame.texture.Origin() + column) % width;
+		cellValue = frame.values[static_cast<size_t>(core) * width + column];
+	}
+
+	fBuffers.Unlock();
+	if (!found)
+		return false;
+
+	bigtime_t ago = std::max((bigtime_t)0, system_time() - time);
+
+	BString value;
+	_FormatValue(value, cellValue);
+
+	BString when;
+	FormatTimeAgo(when, ago);
+
+	BString text;
+	text.SetToFormat(B_TRANSLATE("CPU %" B_PRId32 ": %s (%s)"), core + 1,
+		value.String(), when.String());
+
+	SetToolTip(text.String());
+	*_tip = ToolTip();
+	return *_tip != NULL;
+}
+
+
+void
+CPUHeatmapView::RenderFrame()
+{
+	if (!fBuffers.Lock())
+		return;
+	render_params params = fParams;
+	fBuffers.Unlock();
+
+	if (params.history == NULL || params.width <= 0 || params.rows <= 0)
+		return;
+
+	frame_state& frame = fFrames[fBuffers.BackIndex()];
+	BBitmap* bitmap = fBuffers.Back(params.width, params.rows);
+	if (bitmap == NULL)
+		return;
+
+	frame.texture.SetTarget(static_cast<uint32*>(bitmap->Bits()),
+		bitmap->BytesPerRow(), params.width, params.rows);
+	// A new palette or scale means drawing everything anew
+	if (frame.generation != params.generation) {
+		frame.texture.SetPalette(params.lowPixel, params.highPixel,
+			params.min, params.max);
+	}
+
+	MetricRegistry& registry = MetricRegistry::Default();
+	if (!registry.LockMetric(params.metric))
+		return;
+
+	// Nothing to do if the frame on screen would look the same. Only the
+	// columns are sampled with the metric locked, so publishing never
+	// waits for them to be drawn.
+	bigtime_t now = system_time();
+	bool sampled = false;
+	column_draw draw;
+	if (_NeedsFrame(params, now) && _UpdateOrder(params, now))
+		sampled = _SampleFrame(params, frame, now, draw);
+	registry.UnlockMetric(params.metric);
+
+	if (!sampled || !_DrawColumns(params, frame, draw))
+		return;
+
+	fBuffers.Swap();
+
+	BMessage ready(kMsgGraphFrameReady);
+	BMessenger(this).SendMessage(&ready, (BHandler*)NULL, 0);
+}
+
+
+void
+CPUHeatmapView::_RequestFrame()
+{
+	// While hidden the history just keeps recording, and showing the
+	// heatmap renders what was missed
+	if (!FrameCoordinator::IsVisible(this)) {
+		fFrameMissed = true;
+		return;
+	}
+
+	fFrameMissed = false;
+	_UpdateRenderParams();
+	GraphRenderer::Default().Request(this);
+}
+
+
+void
+CPUHeatmapView::_UpdateRenderParams()
+{
+	rgb_color drawColor = fColor;
+	if (fSystemColor != (color_which)-1)
+		drawColor = ui_color(fSystemColor);
+	rgb_color bg = ui_color(B_PANEL_BACKGROUND_COLOR);
+
+	render_params params;
+	params.metric = fMetric;
+	params.history = fHistory;
+	params.resolution = fResolution;
+	params.width = static_cast<int32>(Bounds().Width()) + 1;
+	params.rows = fRowCount;
+	params.lowPixel = GraphRasterizer::MakePixel(bg.red, bg.green, bg.blue);
+	params.highPixel = GraphRasterizer::MakePixel(drawColor.red,
+		drawColor.green, drawColor.blue);
+	params.min = fMin;
+	params.max = fMax;
+	params.order = fOrder;
+
+	if (!fBuffers.Lock())
+		return;
+
+	// A new order only moves the rows that are there
+	params.generation = fParams.generation;
+	if (params.history != fParams.history
+		|| params.resolution != fParams.resolution
+		|| params.width != fParams.width || params.rows != fParams.rows
+		|| params.lowPixel != fParams.lowPixel
+		|| params.highPixel != fParams.highPixel
+		|| params.min != fParams.min || params.max != fParams.max) {
+		// Never 0, which marks empty frames
+		if (++params.generation == 0)
+			params.generation = 1;
+	}
+
+	fParams = params;
+	fBuffers.Unlock();
+}
+
+
+/*!	Whether the frame on screen differs from what would be rendered now.
+	Called from the render thread with the metric locked.
+*/
+bool
+CPUHeatmapView::_NeedsFrame(const render_params& params, bigtime_t now) const
+{
+	// Only a new column, or sorting the rows again, changes anything
+	const frame_state& front = fFrames[fBuffers.FrontIndex()];
+	return front.generation != params.generation
+		|| now - front.newestColumn >= params.resolution
+		|| params.order != fSortOrder
+		|| (params.order == HEATMAP_BY_LOAD
+			&& now - fLastSort >= kResortInterval);
+}
+
+
+/*!	Sorts the rows again if their order changed, or every few seconds by
+	load. Called from the render thread with the metric locked; returns
+	false if memory is low.
+*/
+bool
+CPUHeatmapView::_UpdateOrder(const render_params& params, bigtime_t now)
+{
+	int32 rows = params.rows;
+	if (static_cast<int32>(fRowCores.size()) != rows) {
+		try {
+			fRowCores.resize(rows);
+			fSortedCores.resize(rows);
+			fCoreRows.resize(rows);
+			fPermutation.resize(rows);
+			fLoads.resize(rows);
+		} catch (const std::bad_alloc&) {
+			fRowCores.clear();
+			return false;
+		}
+
+		for (int32 i = 0; i < rows; i++)
+			fRowCores[i] = i;
+		fSortOrder = HEATMAP_BY_CORE;
+		fLastSort = 0;
+	}
+
+	if (params.order == fSortOrder && (params.order == HEATMAP_BY_CORE
+			|| now - fLastSort < kResortInterval)) {
+		return true;
+	}
+
+	for (int32 i = 0; i < rows; i++)
+		fSortedCores[i] = i;
+
+	if (params.order == HEATMAP_BY_LOAD) {
+		for (int32 i = 0; i < rows; i++) {
+			float load = params.history->ValueAt(now, NULL, i);
+			fLoads[i] = load == load ? load : -1;
+		}
+
+		// Ties keep the core order
+		const std::vector<float>& loads = fLoads;
+		std::stable_sort(fSortedCores.begin(), fSortedCores.end(),
+			[&loads](int32 a, int32 b) { return loads[a] > loads[b]; });
+	}
+
+	fRowCores.swap(fSortedCores);
+	fSortOrder = params.order;
+	fLastSort = now;
+	return true;
+}
+
+
+/*!	Brings the frame up to date, sampling only the columns that came in
+	since it was last rendered into. Called from the render thread with the
+	metric locked; returns false if the frame couldn't be updated.
+*/
+bool
+CPUHeatmapView::_SampleFrame(const render_params& params, frame_state& frame,
+	bigtime_t now, column_draw& draw)
+{
+	int32 width = params.width;
+	int32 rows = params.rows;
+	bigtime_t resolution = params.resolution;
+
+	try {
+		if (fSamples.size() < static_cast<size_t>(width) * rows)
+			fSamples.resize(static_cast<size_t>(width) * rows);
+		frame.values.resize(static_cast<size_t>(width) * rows);
+		frame.rowCores.resize(rows);
+	} catch (const std::bad_alloc&) {
+		// Ignore update if memory is low
+		frame.generation = 0;
+		return false;
+	}
+
+	int32 columns = width;
+	if (frame.generation == params.generation && frame.rows == rows
+		&& now >= frame.newestColumn) {
+		columns = static_cast<int32>(std::min((now - frame.newestColumn)
+			/ resolution, static_cast<bigtime_t>(width)));
+	}
+
+	if (columns >= width) {
+		frame.generation = 0;
+		frame.width = width;
+		frame.rows = rows;
+		frame.resolution = resolution;
+		frame.newestColumn = now;
+		frame.rowCores = fRowCores;
+
+		draw.firstX = 0;
+		draw.count = width;
+		draw.permute = false;
+		_SampleRows(params, frame, now - (width - 1) * resolution, 0, width);
+
+		frame.generation = params.generation;
+		return true;
+	}
+
+	// Move the rows already drawn along with their cores
+	draw.permute = frame.rowCores != fRowCores;
+	if (draw.permute) {
+		for (int32 i = 0; i < rows; i++)
+			fCoreRows[frame.rowCores[i]] = i;
+		for (int32 i = 0; i < rows; i++)
+			fPermutation[i] = fCoreRows[fRowCores[i]];
+		frame.rowCores = fRowCores;
+	}
+
+	// Only the columns that came in since the frame was last rendered
+	if (columns > 0) {
+		frame.texture.Scroll(columns);
+		frame.newestColumn += static_cast<bigtime_t>(columns) * resolution;
+	}
+
+	draw.firstX = width - columns;
+	draw.count = columns;
+	_SampleRows(params, frame, frame.newestColumn
+		- static_cast<bigtime_t>(columns - 1) * resolution, draw.firstX,
+		columns);
+	return true;
+}
+
+
+/*!	Samples count columns of every row into fSamples, step apart from
+	start, for the image columns from firstX on. The metric has to be
+	locked.
+*/
+void
+CPUHeatmapView::_SampleRows(const render_params& params, frame_state& frame,
+	bigtime_t start, int32 firstX, int32 count)
+{
+	const DataHistory<float>* history = params.history;
+	bigtime_t resolution = params.resolution;
+	int32 level = history->LevelFor(resolution);
+	int32 width = frame.width;
+
+	for (int32 i = 0; i < params.rows; i++) {
+		int32 core = frame.rowCores[i];
+		float* values = fSamples.data() + static_cast<size_t>(i) * count;
+		if (level < 0) {
+			// At most one sample per pixel, interpolate in one pass
+			history->ResampleRange(start, resolution, count, values, core);
+		} else {
+			int32 hintIndex = 0;
+			for (int32 j = 0; j < count; j++) {
+				values[j] = SampleValue(history, core,
+					start + j * resolution, resolution, level, &hintIndex);
+			}
+		}
+
+		// Kept for the tooltips in the ring of the texture
+		float* coreValues = frame.values.data()
+			+ static_cast<size_t>(core) * width;
+		int32 column = (frame.texture.Origin() + firstX) % width;
+		for (int32 j = 0; j < count; j++) {
+			coreValues[column] = values[j];
+			if (++column == width)
+				column = 0;
+		}
+	}
+}
+
+
+/*!	Draws the columns sampled into the frame, which doesn't need the
+	metric anymore. Returns false if they couldn't be drawn.
+*/
+bool
+CPUHeatmapView::_DrawColumns(const render_params& params, frame_state& frame,
+	const column_draw& draw)
+{
+	if (draw.permute && frame.texture.PermuteRows(fPermutation.data())
+			!= B_OK) {
+		frame.generation = 0;
+		return false;
+	}
+
+	for (int32 i = 0; i < params.rows && draw.count > 0; i++) {
+		frame.texture.DrawRow(i, draw.firstX, draw.count,
+			fSamples.data() + static_cast<size_t>(i) * draw.count);
+	}
+
+	return true;
+}
+
+
+/*!	Looks up where the column of the frame on screen that shows time is, by
+	the frame's own time axis, as a fraction of the width. A frame from
+	before a resize is stretched, like Draw() shows it.
+*/
+bool
+CPUHeatmapView::_FrameCrosshairAt(bigtime_t time, float& position)
+{
+	if (!fBuffers.Lock())
+		return false;
+
+	const frame_state& frame = fFrames[fBuffers.FrontIndex()];
+	int32 width = frame.width;
+	bool found = frame.generation != 0 && width > 0 && frame.resolution > 0;
+	if (found) {
+		// Anything within the newest column still belongs to it
+		int64 column = width - 1
+			- (frame.newestColumn - time) / frame.resolution;
+		found = column >= 0 && column < width;
+		if (found)
+			position = (column + 0.5f) / width;
+	}
+
+	fBuffers.Unlock();
+	return found;
+}
+
+
+void
+CPUHeatmapView::_FormatValue(BString& text, float value) const
+{
+	if (fFormatter != NULL)
+		fFormatter(text, value);
+	else {
+		text.Truncate(0);
+		text << value;
+	}
+}
@@ -0,0 +1,154 @@
+#ifndef CPUHEATMAPVIEW_H
+#define CPUHEATMAPVIEW_H
+
+#include <String.h>
+#include <View.h>
+#include <vector>
+#include "ActivityGraphView.h"
+#include "DataHistory.h"
+#include "GraphRenderer.h"
+#include "HeatmapTexture.h"
+#include "MetricRegistry.h"
+
+class BBitmap;
+
+enum heatmap_order {
+	HEATMAP_BY_CORE = 0,
+	HEATMAP_BY_LOAD
+};
+
+// Shows every field of a metric as one row of a heatmap: time goes from
+// left to right, and the value is the colour. Meant for machines with too
+// many cores for a graph each.
+//
+// The texture has one pixel row per core and is stretched to the view.
+// Every update only draws the new columns, so it costs a pixel per core;
+// everything is only redrawn after a resize or zoom. Like the graphs, it
+// is rendered on the GraphRenderer's thread into the back one of two
+// bitmaps, and Draw() only copies the newest finished frame.
+class CPUHeatmapView : public BView, public GraphRenderClient {
+public:
+						CPUHeatmapView(const char* name, rgb_color color,
+							color_which systemColor = (color_which)-1);
+	virtual				~CPUHeatmapView();
+
+	virtual void		AttachedToWindow();
+	virtual void		DetachedFromWindow();
+	virtual void		MessageReceived(BMessage* message);
+	virtual void		FrameResized(float width, float height);
+	virtual void		Draw(BRect updateRect);
+	virtual void		MouseMoved(BPoint where, uint32 transit,
+							const BMessage* dragMessage);
+	virtual bool		GetToolTipAt(BPoint point, BToolTip** _tip);
+
+	virtual void		RenderFrame();
+
+			// One row per field of the metric; redraws whenever it is
+			// published.
+			void		SetMetric(metric_id metric);
+			void		SetManualScale(float min, float max);
+			void		SetValueFormatter(value_formatter formatter);
+
+			// By load puts the busiest cores on top. The rows are sorted
+			// again every few seconds rather than on every update, so that
+			// they stay put long enough to be read.
+			void		SetOrder(heatmap_order order);
+			heatmap_order Order() const { return fOrder; }
+
+private:
+	// What the render thread needs from the view, handed over with the
+	// frame buffers locked
+	struct render_params {
+		metric_id		metric;
+		DataHistory<float>*	history;
+		bigtime_t		resolution;
+		int32			width;
+		int32			rows;
+		uint32			lowPixel;
+		uint32			highPixel;
+		float			min;
+		float			max;
+		heatmap_order	order;
+		// Changes whenever the frames have to be drawn from scratch
+		uint32			generation;
+	};
+
+	// What is in one of the frame buffers, so that the next frame rendered
+	// into it only has to draw the columns that came in since
+	struct frame_state {
+		HeatmapTexture	texture;
+		// 0 until something has been drawn
+		uint32			generation;
+		int32			width;
+		int32			rows;
+		// The time between columns, and that of the rightmost one
+		bigtime_t		resolution;
+		bigtime_t		newestColumn;
+		// The core shown in each row
+		std::vector<int32> rowCores;
+		// What the texture shows, one core after the other, each in the
+		// same ring as the texture, for the tooltips
+		std::vector<float> values;
+	};
+
+	// The columns sampled into fSamples with the metric locked, which are
+	// drawn once it is unlocked again
+	struct column_draw {
+		int32			firstX;
+		int32			count;
+		// Whether the rows drawn before move to fPermutation first
+		bool			permute;
+	};
+
+			void		_RequestFrame();
+			void		_UpdateRenderParams();
+			bool		_NeedsFrame(const render_params& params,
+							bigtime_t now) const;
+			bool		_UpdateOrder(const render_params& params,
+							bigtime_t now);
+			bool		_SampleFrame(const render_params& params,
+							frame_state& frame, bigtime_t now,
+							column_draw& draw);
+			void		_SampleRows(const render_params& params,
+							frame_state& frame, bigtime_t start,
+							int32 firstX, int32 count);
+			bool		_DrawColumns(const render_params& params,
+							frame_state& frame, const column_draw& draw);
+			bool		_FrameCrosshairAt(bigtime_t time, float& position);
+			void		_FormatValue(BString& text, float value) const;
+
+private:
+	rgb_color			fColor;
+	color_which			fSystemColor;
+	metric_id			fMetric;
+	DataHistory<float>*	fHistory;
+	value_formatter		fFormatter;
+	bigtime_t			fResolution;
+	float				fMin;
+	float				fMax;
+	int32				fRowCount;
+	heatmap_order		fOrder;
+	// Set when a frame was skipped while hidden
+	bool				fFrameMissed;
+	bigtime_t			fCrosshairTime;
+
+	GraphFrameBuffers	fBuffers;
+	render_params		fParams;
+	// Only touched by the render thread, apart from the front one that is
+	// read by Draw() and the tooltips with the buffers locked
+	frame_state			fFrames[2];
+
+	// Everything below is only used by the render thread
+	heatmap_order		fSortOrder;
+	bigtime_t			fLastSort;
+	// The core to show in each row, as last sorted
+	std::vector<int32>	fRowCores;
+	std::vector<int32>	fSortedCores;
+	std::vector<int32>	fCoreRows;
+	std::vector<int32>	fPermutation;
+	std::vector<float>	fLoads;
+	// The sampled columns of every row, one row after the other
+	std::vector<float>	fSamples;
+};
+
+#endif // CPUHEATMAPVIEW_H
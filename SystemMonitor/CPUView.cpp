@@ -1,5 +1,4 @@
 #include "CPUView.h"
-#include <Autolock.h>
 #include <cstdio>
 #include <String.h>
 #include <kernel/OS.h>
@@ -10,24 +9,48 @@
 #include <SpaceLayoutItem.h>
 #include <InterfaceDefs.h>
 #include <Catalog.h>
+#include <MenuField.h>
+#include <MenuItem.h>
+#include <PopUpMenu.h>
 #include "Utils.h"
+#include "SystemInfoCache.h"
 
 #undef B_TRANSLATION_CONTEXT
 #define B_TRANSLATION_CONTEXT "CPUView"
 
+static const uint32 kMsgCoreViewSelected = 'crvw';
+
+enum {
+	kCoreGraphs = 0,
+	kCoreHeatmapById,
+	kCoreHeatmapByLoad,
+	kCoreViewCount
+};
+
+// Above this many cores, a graph each gets too small to read
+static const uint32 kMaxCoreGraphs = 32;
+
 CPUView::CPUView()
-	: BView("CPUView", B_WILL_DRAW | B_PULSE_NEEDED),
+	: BView("CPUView", B_WILL_DRAW),
+	  fCoreGrid(NULL),
+	  fCoreHeatmap(NULL),
+	  fCoreViewField(NULL),
 	  fSpeedValue(NULL),
 	  fProcessesValue(NULL),
 	  fThreadsValue(NULL),
 	  fUptimeValue(NULL),
 	  fCpuCount(0),
+	  fTotalMetric(-1),
+	  fCoreMetric(-1),
 	  fPreviousTimeSnapshot(0),
-	  fCurrentUsage(0.0f),
+	  fRefreshInterval(1000000),
+	  fPerformanceViewVisible(true),
+	  fSnapshotSequence(0),
 	  fLastUsedTeams(-1),
 	  fLastUsedThreads(-1)
 {
 	SetViewColor(ui_color(B_PANEL_BACKGROUND_COLOR));
+	fTotalMetric = MetricRegistry::Default().Register(METRIC_CPU_TOTAL);
 	CreateLayout();
 }
 
@@ -55,25 +78,45 @@ void CPUView::CreateLayout()
 	BStringView* maxUtilLabel = new BStringView("max_util", "100%");
 	maxUtilLabel->SetAlignment(B_ALIGN_RIGHT);
 
-	// Core Graphs Grid
-	BGridLayout* graphGrid = new BGridLayout(B_USE_DEFAULT_SPACING, B_USE_DEFAULT_SPACING);
+	int32 coreView = fCpuCount > kMaxCoreGraphs ? kCoreHeatmapById
+		: kCoreGraphs;
+	const char* coreViewLabels[kCoreViewCount] = {
+		B_TRANSLATE("Graphs"),
+		B_TRANSLATE("Heatmap by core"),
+		B_TRANSLATE("Heatmap by load")
+	};
+	BPopUpMenu* coreViewMenu = new BPopUpMenu("core_view");
+	for (int32 i = 0; i < kCoreViewCount; i++) {
+		BMessage* message = new BMessage(kMsgCoreViewSelected);
+		message->AddInt32("view", i);
+		BMenuItem* item = new BMenuItem(coreViewLabels[i], message);
+		item->SetMarked(i == coreView);
+		coreViewMenu->AddItem(item);
+	}
+	fCoreViewField = new BMenuField("core_view", NULL, coreViewMenu);
+
+	// Core Graphs Grid, all drawn by one view
+	fCoreGrid = new CPUGridView("core_grid", {80, 133, 229, 255},
+		B_NAVIGATION_BASE_COLOR);
+	fCoreGrid->SetManualScale(0, 100);
+	fCoreGrid->SetValueFormatter(FormatGraphPercent);
+
+	// Or a row each in a heatmap, for many cores
+	fCoreHeatmap = new CPUHeatmapView("core_heatmap", {80, 133, 229, 255},
+		B_NAVIGATION_BASE_COLOR);
+	fCoreHeatmap->SetManualScale(0, 100);
+	fCoreHeatmap->SetValueFormatter(FormatGraphPercent);
 
 	if (fCpuCount > 0) {
 		fPreviousActiveTime.resize(fCpuCount, 0);
 		fCpuInfos.resize(fCpuCount);
 		fPerCoreUsage.resize(fCpuCount, 0.0f);
 
-		int cols = static_cast<int>(ceil(sqrt(static_cast<double>(fCpuCount))));
-		if (cols < 1) cols = 1;
-
-		for (uint32 i = 0; i < fCpuCount; ++i) {
-			ActivityGraphView* graph = new ActivityGraphView("core_graph", {80, 133, 229, 255}, B_NAVIGATION_BASE_COLOR);
-			graph->SetExplicitMinSize(BSize(50, 40));
-			graph->SetManualScale(0, 1000);
-			fCoreGraphs.push_back(graph);
-
-			graphGrid->AddView(graph, i % cols, i / cols);
-		}
+		// One field per core, sharing the timestamps
+		fCoreMetric = MetricRegistry::Default().Register(METRIC_CPU_CORE,
+			fCpuCount);
+		fCoreGrid->SetMetric(fCoreMetric);
+		fCoreHeatmap->SetMetric(fCoreMetric);
 
 		if (get_cpu_info(0, fCpuCount, fCpuInfos.data()) == B_OK) {
 			for (uint32 i = 0; i < fCpuCount; ++i) {
@@ -140,27 +183,99 @@ void CPUView::CreateLayout()
 		.End()
 		.AddGroup(B_HORIZONTAL)
 			.Add(utilLabel)
+			.Add(fCoreViewField)
 			.AddGlue()
 			.Add(maxUtilLabel)
 		.End()
-		.Add(graphGrid)
+		.Add(fCoreGrid)
+		.Add(fCoreHeatmap)
 		.Add(infoGrid)
 		.AddGlue();
+
+	// Only one of the two is shown
+	fCoreHeatmap->Hide();
+	_SetCoreView(coreView);
 }
 
 CPUView::~CPUView() {
+	SamplingScheduler::Default().RemoveCollector(this);
 }
 
 void CPUView::AttachedToWindow() {
-	SetFlags(Flags() | B_PULSE_NEEDED);
-	UpdateData(); // Initial data fetch
 	BView::AttachedToWindow();
+
+	// The labels are updated whenever a new sample has been published
+	MetricRegistry::Default().StartWatching(fTotalMetric, BMessenger(this));
+	if (fCoreViewField != NULL)
+		fCoreViewField->Menu()->SetTargetForItems(this);
+
+	SamplingScheduler& scheduler = SamplingScheduler::Default();
+	// Always sampling, so the history has no gaps while hidden
+	scheduler.AddCollector(this, fRefreshInterval);
+	scheduler.Trigger(this);
+}
+
+void CPUView::DetachedFromWindow() {
+	MetricRegistry::Default().StopWatching(fTotalMetric, BMessenger(this));
+	SamplingScheduler::Default().RemoveCollector(this);
+	BView::DetachedFromWindow();
 }
 
-void CPUView::Pulse() {
-	if (IsHidden())
+void CPUView::MessageReceived(BMessage* message) {
+	if (message->what == kMsgMetricUpdated) {
+		if (fPerformanceViewVisible)
+			_UpdateLabels();
 		return;
-	UpdateData();
+	}
+	if (message->what == kMsgCoreViewSelected) {
+		int32 view;
+		if (message->FindInt32("view", &view) == B_OK)
+			_SetCoreView(view);
+		return;
+	}
+	BView::MessageReceived(message);
+}
+
+void CPUView::_SetCoreView(int32 view)
+{
+	// Only their own state, whether or not this view is shown
+	bool heatmap = view != kCoreGraphs;
+	if (heatmap && !fCoreGrid->IsHidden(fCoreGrid)) {
+		fCoreGrid->Hide();
+		fCoreHeatmap->Show();
+	} else if (!heatmap && fCoreGrid->IsHidden(fCoreGrid)) {
+		fCoreHeatmap->Hide();
+		fCoreGrid->Show();
+	}
+
+	fCoreHeatmap->SetOrder(view == kCoreHeatmapByLoad ? HEATMAP_BY_LOAD
+		: HEATMAP_BY_CORE);
+}
+
+void CPUView::Collect(bigtime_t now)
+{
+	cpu_snapshot snapshot;
+	snapshot.time = now;
+	GetCPUUsage(now, snapshot.usage);
+
+	system_info sysInfo;
+	if (SystemInfoCache::Default().GetSystemInfo(sysInfo, now) == B_OK) {
+		snapshot.usedTeams = sysInfo.used_teams;
+		snapshot.usedThreads = sysInfo.used_threads;
+	} else {
+		snapshot.usedTeams = -1;
+		snapshot.usedThreads = -1;
+	}
+
+	// Written before publishing, so the notification finds it
+	fSnapshot.Write(snapshot);
+
+	// The graphs here and in the summary are watching these
+	MetricRegistry& registry = MetricRegistry::Default();
+	if (snapshot.usage >= 0)
+		registry.Publish(fTotalMetric, now, snapshot.usage);
+	if (!fPerCoreUsage.empty())
+		registry.Publish(fCoreMetric, now, fPerCoreUsage.data());
 }
 
 void CPUView::GetCPUUsage(bigtime_t now, float& overallUsage)
@@ -170,38 +285,42 @@ void CPUView::GetCPUUsage(bigtime_t now, float& overallUsage)
 		return;
 	}
 
-	bigtime_t currentTimeSnapshot = now;
+	// The active times are divided by the time between the two reads; the
+	// tick times would be off by however late the collectors ran
+	bigtime_t readTime;
+	if (SystemInfoCache::Default().GetCPUInfo(fCpuInfos.data(), fCpuCount,
+			now, &readTime) != B_OK) {
+		overallUsage = -1.0f;
+		return;
+	}
+
 	if (fPreviousTimeSnapshot == 0) {
-		fPreviousTimeSnapshot = currentTimeSnapshot;
-		// Also update previous active time to avoid spikes on first update
-		if (get_cpu_info(0, fCpuCount, fCpuInfos.data()) == B_OK) {
-			 for (uint32 i = 0; i < fCpuCount; ++i)
-				 fPreviousActiveTime[i] = fCpuInfos[i].active_time;
-		}
+		// Nothing to compare with yet; avoids a spike on the first update
+		fPreviousTimeSnapshot = readTime;
+		for (uint32 i = 0; i < fCpuCount; ++i)
+			fPreviousActiveTime[i] = fCpuInfos[i].active_time;
 	}
-	bigtime_t elapsedWallTime = currentTimeSnapshot - fPreviousTimeSnapshot;
-	fPreviousTimeSnapshot = currentTimeSnapshot;
+	bigtime_t elapsedWallTime = readTime - fPreviousTimeSnapshot;
 
 	if (elapsedWallTime <= 0) {
 		overallUsage = 0.0f;
 		return;
 	}
+	fPreviousTimeSnapshot = readTime;
 
 	float totalDeltaActiveTime = 0;
-	if (get_cpu_info(0, fCpuCount, fCpuInfos.data()) == B_OK) {
-		for (uint32 i = 0; i < fCpuCount; ++i) {
-			bigtime_t delta = fCpuInfos[i].active_time - fPreviousActiveTime[i];
-			if (delta < 0) delta = 0; // Handle time rollover
-
-			float coreUsage = static_cast<float>(delta) / elapsedWallTime * 100.0f;
-			if (coreUsage < 0.0f) coreUsage = 0.0f;
-			if (coreUsage > 100.0f) coreUsage = 100.0f;
-			if (i < fPerCoreUsage.size())
-				fPerCoreUsage[i] = coreUsage;
-
-			totalDeltaActiveTime += delta;
-			fPreviousActiveTime[i] = fCpuInfos[i].active_time;
-		}
+	for (uint32 i = 0; i < fCpuCount; ++i) {
+		bigtime_t delta = fCpuInfos[i].active_time - fPreviousActiveTime[i];
+		if (delta < 0) delta = 0; // Handle time rollover
+
+		float coreUsage = static_cast<float>(delta) / elapsedWallTime * 100.0f;
+		if (coreUsage < 0.0f) coreUsage = 0.0f;
+		if (coreUsage > 100.0f) coreUsage = 100.0f;
+		if (i < fPerCoreUsage.size())
+			fPerCoreUsage[i] = coreUsage;
+
+		totalDeltaActiveTime += delta;
+		fPreviousActiveTime[i] = fCpuInfos[i].active_time;
 	}
 
 	overallUsage = static_cast<float>(totalDeltaActiveTime) / (static_cast<float>(elapsedWallTime) * fCpuCount) * 100.0f;
@@ -210,67 +329,60 @@ void CPUView::GetCPUUsage(bigtime_t now, float& overallUsage)
 	if (overallUsage > 100.0f) overallUsage = 100.0f;
 }
 
-void CPUView::UpdateData()
+void CPUView::_UpdateLabels()
 {
-	fLocker.Lock();
-	const bigtime_t now = system_time();
-
-	float overallUsage;
-	GetCPUUsage(now, overallUsage);
+	cpu_snapshot snapshot;
+	uint32 sequence = fSnapshot.Read(snapshot);
+	if (sequence == fSnapshotSequence)
+		return;
+	fSnapshotSequence = sequence;
 
 	if (fOverallUsageValue) {
-		if (overallUsage >= 0) {
+		if (snapshot.usage >= 0) {
 			BString percentStr;
-			fNumberFormat.FormatPercent(percentStr, overallUsage / 100.0f);
+			fNumberFormat.FormatPercent(percentStr, snapshot.usage / 100.0f);
 			fOverallUsageValue->SetText(percentStr.String());
 		} else {
 			fOverallUsageValue->SetText(B_TRANSLATE("N/A"));
 		}
 	}
 
-	// Update core graphs
-	for (size_t i = 0; i < fCoreGraphs.size(); ++i) {
-		if (i < fPerCoreUsage.size()) {
-			fCoreGraphs[i]->AddValue(now, fPerCoreUsage[i] * 10);
-		}
-	}
-
-	// Update Info
-	system_info sysInfo;
-	if (get_system_info(&sysInfo) == B_OK) {
-		if (fProcessesValue && (int32)sysInfo.used_teams != fLastUsedTeams) {
-			fLastUsedTeams = sysInfo.used_teams;
-			fCachedProcesses.SetToFormat("%" B_PRId32, fLastUsedTeams);
-			fProcessesValue->SetText(fCachedProcesses.String());
-		}
+	if (snapshot.usedTeams < 0)
+		return;
 
-		if (fThreadsValue && (int32)sysInfo.used_threads != fLastUsedThreads) {
-			fLastUsedThreads = sysInfo.used_threads;
-			fCachedThreads.SetToFormat("%" B_PRId32, fLastUsedThreads);
-			fThreadsValue->SetText(fCachedThreads.String());
-		}
+	if (fProcessesValue && snapshot.usedTeams != fLastUsedTeams) {
+		fLastUsedTeams = snapshot.usedTeams;
+		fCachedProcesses.SetToFormat("%" B_PRId32, fLastUsedTeams);
+		fProcessesValue->SetText(fCachedProcesses.String());
+	}
 
-		if (fUptimeValue)
-			fUptimeValue->SetText(::FormatUptime(now).String());
+	if (fThreadsValue && snapshot.usedThreads != fLastUsedThreads) {
+		fLastUsedThreads = snapshot.usedThreads;
+		fCachedThreads.SetToFormat("%" B_PRId32, fLastUsedThreads);
+		fThreadsValue->SetText(fCachedThreads.String());
 	}
 
-	fCurrentUsage = overallUsage;
-	fLocker.Unlock();
+	if (fUptimeValue)
+		fUptimeValue->SetText(::FormatUptime(snapshot.time).String());
 }
 
-float CPUView::GetCurrentUsage()
+void CPUView::SetRefreshInterval(bigtime_t interval)
 {
-	BAutolock locker(fLocker);
-	return fCurrentUsage;
+	fRefreshInterval = interval;
+	SamplingScheduler::Default().SetInterval(this, interval);
+
+	// Keeps the history covering the same time span
+	MetricRegistry& registry = MetricRegistry::Default();
+	registry.SetRefreshInterval(fTotalMetric, interval);
+	registry.SetRefreshInterval(fCoreMetric, interval);
 }
 
-void CPUView::SetRefreshInterval(bigtime_t interval)
+void CPUView::SetPerformanceViewVisible(bool visible)
 {
-	BAutolock locker(fLocker);
-	for (auto* graph : fCoreGraphs) {
-		if (graph)
-			graph->SetRefreshInterval(interval);
-	}
+	// Only the labels wait; the samples keep going into the history
+	fPerformanceViewVisible = visible;
+	if (visible)
+		_UpdateLabels();
 }
 
 void CPUView::Draw(BRect updateRect) {
@@ -6,36 +6,54 @@
 #include <Locker.h>
 #include <NumberFormat.h>
 #include <vector>
-#include "ActivityGraphView.h"
+#include "CPUGridView.h"
+#include "CPUHeatmapView.h"
+#include "SamplingScheduler.h"
+#include "SeqLock.h"
 
 class BBox;
+class BMenuField;
 
-class CPUView : public BView {
+class CPUView : public BView, public SampleCollector {
 public:
 	CPUView();
 	virtual ~CPUView();
 
 	virtual void AttachedToWindow();
-	virtual void Pulse();
+	virtual void DetachedFromWindow();
+	virtual void MessageReceived(BMessage* message);
 	virtual void Draw(BRect updateRect);
 
-	float GetCurrentUsage();
+	virtual void Collect(bigtime_t now);
+
 	void SetRefreshInterval(bigtime_t interval);
-	void UpdateData();
+	void SetPerformanceViewVisible(bool visible);
 
 private:
+	struct cpu_snapshot {
+		bigtime_t	time;
+		float		usage;
+		int32		usedTeams;
+		int32		usedThreads;
+	};
+
 	void CreateLayout();
 	void GetCPUUsage(bigtime_t now, float& overallUsage);
+	void _UpdateLabels();
+	void _SetCoreView(int32 view);
 
 	BStringView* fOverallUsageValue;
 	BStringView* fModelName;
-	std::vector<ActivityGraphView*> fCoreGraphs;
+	CPUGridView* fCoreGrid;
+	CPUHeatmapView* fCoreHeatmap;
+	BMenuField* fCoreViewField;
 
 	BStringView* fSpeedValue;
 	BStringView* fProcessesValue;
 	BStringView* fThreadsValue;
 	BStringView* fUptimeValue;
 
+	// Only used by Collect() once attached
 	std::vector<bigtime_t> fPreviousActiveTime;
 	std::vector<cpu_info> fCpuInfos;
 	uint32 fCpuCount;
@@ -43,9 +61,16 @@ private:
 
 	std::vector<float> fPerCoreUsage;
 
-	BLocker fLocker;
+	metric_id fTotalMetric;
+	metric_id fCoreMetric;
+
 	bigtime_t fPreviousTimeSnapshot;
-	float fCurrentUsage;
+	bigtime_t fRefreshInterval;
+	bool fPerformanceViewVisible;
+
+	// Written by the scheduler thread, read by the window
+	SeqLock<cpu_snapshot> fSnapshot;
+	uint32 fSnapshotSequence;
 
 	int32 fLastUsedTeams;
 	int32 fLastUsedThreads;
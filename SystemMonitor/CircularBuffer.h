@@ -8,12 +8,17 @@
 
 #include <stdlib.h>
 #include <new>
+#include <utility>
 
 #if defined(__HAIKU__) || defined(BEOS)
 #include <OS.h>
 #endif
 
 
+// Storage is rounded up to a power of two so that indices wrap with a mask
+// instead of a division; Size() still reports the requested capacity, and
+// the buffer starts overwriting its oldest item once that many are stored.
+// Items are constructed in place, so Type needs no default constructor.
 template<typename Type>
 class CircularBuffer {
 public:
@@ -22,6 +27,7 @@ public:
 		fFirst(0),
 		fIn(0),
 		fSize(0),
+		fMask(0),
 		fBuffer(NULL)
 	{
 		SetSize(size);
@@ -32,14 +38,27 @@ public:
 		fFirst(0),
 		fIn(0),
 		fSize(0),
+		fMask(0),
 		fBuffer(NULL)
 	{
 		*this = other;
 	}
 
+	CircularBuffer(CircularBuffer&& other) noexcept
+		:
+		fFirst(other.fFirst),
+		fIn(other.fIn),
+		fSize(other.fSize),
+		fMask(other.fMask),
+		fBuffer(other.fBuffer)
+	{
+		other._Forget();
+	}
+
 	~CircularBuffer()
 	{
-		delete[] fBuffer;
+		MakeEmpty();
+		operator delete(fBuffer);
 	}
 
 	CircularBuffer& operator=(const CircularBuffer& other)
@@ -48,8 +67,10 @@ public:
 			return *this;
 
 		Type* newBuffer = NULL;
+		uint32 capacity = 0;
 		if (other.fSize > 0) {
-			newBuffer = new(std::nothrow) Type[other.fSize];
+			capacity = _Capacity(other.fSize);
+			newBuffer = _Allocate(capacity);
 			if (newBuffer == NULL) {
 				// Allocation failed, and we needed a buffer.
 				// Retain old state.
@@ -58,21 +79,42 @@ public:
 
 			// Linearize data from other to newBuffer
 			uint32 count = other.CountItems();
-			for (uint32 i = 0; i < count; i++) {
-				Type* item = other.ItemAt(i);
-				if (item)
-					newBuffer[i] = *item;
+			uint32 i = 0;
+			try {
+				for (; i < count; i++)
+					new(&newBuffer[i]) Type(*other.ItemAt(i));
+			} catch (...) {
+				_Destroy(newBuffer, i);
+				operator delete(newBuffer);
+				throw;
 			}
-			fFirst = 0;
-			fIn = count;
-		} else {
-			fFirst = 0;
-			fIn = 0;
 		}
 
-		delete[] fBuffer;
+		MakeEmpty();
+		operator delete(fBuffer);
 		fBuffer = newBuffer;
+		fFirst = 0;
+		fIn = other.fIn;
 		fSize = other.fSize;
+		fMask = capacity > 0 ? capacity - 1 : 0;
+
+		return *this;
+	}
+
+	CircularBuffer& operator=(CircularBuffer&& other) noexcept
+	{
+		if (this == &other)
+			return *this;
+
+		MakeEmpty();
+		operator delete(fBuffer);
+
+		fFirst = other.fFirst;
+		fIn = other.fIn;
+		fSize = other.fSize;
+		fMask = other.fMask;
+		fBuffer = other.fBuffer;
+		other._Forget();
 
 		return *this;
 	}
@@ -88,48 +130,63 @@ public:
 			return B_OK;
 
 		if (size == 0) {
-			delete[] fBuffer;
+			MakeEmpty();
+			operator delete(fBuffer);
 			fBuffer = NULL;
 			fSize = 0;
-			fFirst = 0;
-			fIn = 0;
+			fMask = 0;
 			return B_OK;
 		}
 
-		Type* newBuffer = new(std::nothrow) Type[size];
+		uint32 capacity = _Capacity(size);
+		if (fBuffer != NULL && capacity == fMask + 1) {
+			// The storage fits already, only drop what no longer does
+			while (fIn > size)
+				_DropFirst();
+			fSize = size;
+			return B_OK;
+		}
+
+		Type* newBuffer = _Allocate(capacity);
 		if (newBuffer == NULL)
 			return B_NO_MEMORY;
 
-		if (fBuffer != NULL && fSize > 0) {
-			// Preserve existing data
-			uint32 itemsToCopy = (fIn < size) ? fIn : size;
-			uint32 sourceIndex = fFirst;
-			// If we are shrinking and have more items than new size, we drop oldest
-			if (fIn > size) {
-				sourceIndex = (fFirst + (fIn - size)) % fSize;
-			}
-
-			for (uint32 i = 0; i < itemsToCopy; i++) {
-				newBuffer[i] = fBuffer[(sourceIndex + i) % fSize];
+		// If we are shrinking and have more items than new size, we drop
+		// the oldest
+		while (fIn > size)
+			_DropFirst();
+
+		// Move the items over; a type that can only be copied falls back
+		// to copying
+		uint32 i = 0;
+		try {
+			for (; i < fIn; i++) {
+				Type* item = &fBuffer[(fFirst + i) & fMask];
+				new(&newBuffer[i]) Type(std::move_if_noexcept(*item));
 			}
-
-			fFirst = 0;
-			fIn = itemsToCopy;
-		} else {
-			fFirst = 0;
-			fIn = 0;
+		} catch (...) {
+			_Destroy(newBuffer, i);
+			operator delete(newBuffer);
+			return B_NO_MEMORY;
 		}
 
-		delete[] fBuffer;
+		uint32 count = fIn;
+		MakeEmpty();
+		operator delete(fBuffer);
+
 		fBuffer = newBuffer;
+		fFirst = 0;
+		fIn = count;
 		fSize = size;
+		fMask = capacity - 1;
 
 		return B_OK;
 	}
 
 	void MakeEmpty()
 	{
-		fIn = 0;
+		while (fIn > 0)
+			_DropFirst();
 		fFirst = 0;
 	}
 
@@ -145,28 +202,52 @@ public:
 
 	Type* ItemAt(uint32 index) const
 	{
-		if (index >= fIn || fBuffer == NULL || fSize == 0)
+		if (index >= fIn)
 			return NULL;
 
-		return &fBuffer[(fFirst + index) % fSize];
+		return &fBuffer[(fFirst + index) & fMask];
 	}
 
 	void AddItem(const Type& item)
+	{
+		EmplaceItem(item);
+	}
+
+	void AddItem(Type&& item)
+	{
+		EmplaceItem(std::move(item));
+	}
+
+	// Constructs the new item in place, replacing the oldest one when the
+	// buffer is full.
+	template<typename... Args>
+	void EmplaceItem(Args&&... args)
 	{
 		if (fSize == 0)
 			return;
 
-		uint32 index;
-		if (fIn < fSize) {
-			index = (fFirst + fIn) % fSize;
-			fIn++;
-		} else {
-			index = fFirst;
-			fFirst = (fFirst + 1) % fSize;
-		}
+		if (fIn == fSize)
+			_DropFirst();
 
-		if (fBuffer != NULL)
-			fBuffer[index] = item;
+		new(&fBuffer[(fFirst + fIn) & fMask]) Type(std::forward<Args>(args)...);
+		fIn++;
+	}
+
+	// Returns the items in order as at most two contiguous runs, for
+	// callers that want to memcpy() or vectorize over them. The second run
+	// is empty unless the items wrap around the end of the storage.
+	void Spans(Type*& first, uint32& firstCount, Type*& second,
+		uint32& secondCount) const
+	{
+		first = fBuffer + fFirst;
+		firstCount = fIn;
+		second = fBuffer;
+		secondCount = 0;
+
+		if (fIn > 0 && fFirst + fIn > fMask + 1) {
+			firstCount = fMask + 1 - fFirst;
+			secondCount = fIn - firstCount;
+		}
 	}
 
 	uint32 Size() const
@@ -174,12 +255,176 @@ public:
 		return fSize;
 	}
 
+private:
+	void _DropFirst()
+	{
+		fBuffer[fFirst].~Type();
+		fFirst = (fFirst + 1) & fMask;
+		fIn--;
+	}
+
+	void _Forget()
+	{
+		fFirst = 0;
+		fIn = 0;
+		fSize = 0;
+		fMask = 0;
+		fBuffer = NULL;
+	}
+
+	static uint32 _Capacity(uint32 size)
+	{
+		uint32 capacity = 1;
+		while (capacity < size)
+			capacity <<= 1;
+		return capacity;
+	}
+
+	static Type* _Allocate(uint32 capacity)
+	{
+		return static_cast<Type*>(operator new(capacity * sizeof(Type),
+			std::nothrow));
+	}
+
+	static void _Destroy(Type* items, uint32 count)
+	{
+		for (uint32 i = 0; i < count; i++)
+			items[i].~Type();
+	}
+
 private:
 	uint32		fFirst;
 	uint32		fIn;
 	uint32		fSize;
+	uint32		fMask;
 	Type*		fBuffer;
 };
 
 
+// Same interface with the storage inline and the capacity fixed at compile
+// time, for histories that are created per CPU and never resized.
+template<typename Type, uint32 kSize>
+class FixedCircularBuffer {
+public:
+	FixedCircularBuffer()
+		:
+		fFirst(0),
+		fIn(0)
+	{
+	}
+
+	FixedCircularBuffer(const FixedCircularBuffer& other)
+		:
+		fFirst(0),
+		fIn(0)
+	{
+		for (uint32 i = 0; i < other.fIn; i++)
+			EmplaceItem(*other.ItemAt(i));
+	}
+
+	~FixedCircularBuffer()
+	{
+		MakeEmpty();
+	}
+
+	FixedCircularBuffer& operator=(const FixedCircularBuffer& other)
+	{
+		if (this == &other)
+			return *this;
+
+		MakeEmpty();
+		for (uint32 i = 0; i < other.fIn; i++)
+			EmplaceItem(*other.ItemAt(i));
+		return *this;
+	}
+
+	void MakeEmpty()
+	{
+		while (fIn > 0)
+			_DropFirst();
+		fFirst = 0;
+	}
+
+	bool IsEmpty() const
+	{
+		return fIn == 0;
+	}
+
+	uint32 CountItems() const
+	{
+		return fIn;
+	}
+
+	Type* ItemAt(uint32 index) const
+	{
+		if (index >= fIn)
+			return NULL;
+
+		return _Items() + ((fFirst + index) & kMask);
+	}
+
+	void AddItem(const Type& item)
+	{
+		EmplaceItem(item);
+	}
+
+	void AddItem(Type&& item)
+	{
+		EmplaceItem(std::move(item));
+	}
+
+	template<typename... Args>
+	void EmplaceItem(Args&&... args)
+	{
+		if (fIn == kSize)
+			_DropFirst();
+
+		new(_Items() + ((fFirst + fIn) & kMask))
+			Type(std::forward<Args>(args)...);
+		fIn++;
+	}
+
+	void Spans(Type*& first, uint32& firstCount, Type*& second,
+		uint32& secondCount) const
+	{
+		first = _Items() + fFirst;
+		firstCount = fIn;
+		second = _Items();
+		secondCount = 0;
+
+		if (fFirst + fIn > kSize) {
+			firstCount = kSize - fFirst;
+			secondCount = fIn - firstCount;
+		}
+	}
+
+	uint32 Size() const
+	{
+		return kSize;
+	}
+
+private:
+	static_assert(kSize > 0 && (kSize & (kSize - 1)) == 0,
+		"FixedCircularBuffer needs a power of two size");
+	static const uint32 kMask = kSize - 1;
+
+	Type* _Items() const
+	{
+		return reinterpret_cast<Type*>(const_cast<unsigned char*>(fStorage));
+	}
+
+	void _DropFirst()
+	{
+		_Items()[fFirst].~Type();
+		fFirst = (fFirst + 1) & kMask;
+		fIn--;
+	}
+
+private:
+	alignas(Type) unsigned char fStorage[kSize * sizeof(Type)];
+	uint32		fFirst;
+	uint32		fIn;
+};
+
+
 #endif	// CIRCULAR_BUFFER_H
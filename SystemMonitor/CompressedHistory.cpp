@@ -0,0 +1,325 @@
+#include "CompressedHistory.h"
+
+#include <algorithm>
+#include <new>
+
+
+// Largest encoding of one sample: two 64 bit varints
+static const size_t kMaxSampleSize = 20;
+
+
+CompressedHistory::CompressedHistory(bigtime_t retention)
+	:
+	fRetention(retention),
+	fDecodedBlock(NULL)
+{
+}
+
+
+CompressedHistory::~CompressedHistory()
+{
+	for (size_t i = 0; i < fBlocks.size(); i++)
+		delete fBlocks[i];
+}
+
+
+void
+CompressedHistory::AddValue(bigtime_t time, int64 value)
+{
+	block* last = fBlocks.empty() ? NULL : fBlocks.back();
+	if (last != NULL && time < last->lastTime)
+		return;
+
+	if (last == NULL || last->size + kMaxSampleSize > kBlockSize) {
+		block* newBlock = _NewBlock(time, value);
+		if (newBlock == NULL)
+			return;
+
+		try {
+			fBlocks.push_back(newBlock);
+		} catch (const std::bad_alloc&) {
+			delete newBlock;
+			return;
+		}
+
+		if (fRetention > 0)
+			DiscardBefore(time - fRetention);
+		return;
+	}
+
+	bigtime_t delta = time - last->lastTime;
+	last->size += _PutVarint(last->data + last->size, delta - last->lastDelta);
+	last->size += _PutVarint(last->data + last->size, value - last->lastValue);
+	last->lastDelta = delta;
+	last->lastTime = time;
+	last->lastValue = value;
+	last->count++;
+	if (value < last->min)
+		last->min = value;
+	if (value > last->max)
+		last->max = value;
+
+	// The cached decoding of this block is now incomplete
+	if (fDecodedBlock == last)
+		fDecodedBlock = NULL;
+}
+
+
+void
+CompressedHistory::DiscardBefore(bigtime_t time)
+{
+	// Only whole blocks are dropped, and never the one being filled
+	while (fBlocks.size() > 1 && fBlocks.front()->lastTime < time) {
+		if (fDecodedBlock == fBlocks.front())
+			fDecodedBlock = NULL;
+		delete fBlocks.front();
+		fBlocks.pop_front();
+	}
+}
+
+
+int64
+CompressedHistory::ValueAt(bigtime_t time) const
+{
+	int32 index = _FindBlock(time);
+	if (index < 0)
+		return 0;
+
+	const block* current = fBlocks[index];
+	if (time >= current->lastTime) {
+		// Between two blocks, or after the last sample
+		if (index + 1 == static_cast<int32>(fBlocks.size())
+			|| time == current->lastTime) {
+			return current->lastValue;
+		}
+
+		const block* next = fBlocks[index + 1];
+		if (next->firstTime <= current->lastTime)
+			return next->firstValue;
+
+		return current->lastValue + static_cast<int64>(
+			static_cast<double>(next->firstValue - current->lastValue)
+				/ (next->firstTime - current->lastTime)
+				* (time - current->lastTime));
+	}
+
+	_Decode(current);
+
+	// The last sample at or before time
+	size_t i = std::upper_bound(fDecodedTimes.begin(), fDecodedTimes.end(),
+		time) - fDecodedTimes.begin() - 1;
+
+	int64 value = fDecodedValues[i];
+	bigtime_t itemTime = fDecodedTimes[i];
+	bigtime_t nextTime = fDecodedTimes[i + 1];
+	if (nextTime > itemTime) {
+		value += static_cast<int64>(
+			static_cast<double>(fDecodedValues[i + 1] - value)
+				/ (nextTime - itemTime) * (time - itemTime));
+	}
+	return value;
+}
+
+
+bool
+CompressedHistory::EnvelopeAt(bigtime_t from, bigtime_t to, int64& min,
+	int64& max) const
+{
+	int32 index = _FindBlock(from);
+	if (index < 0)
+		index = 0;
+
+	bool found = false;
+	for (; index < static_cast<int32>(fBlocks.size()); index++) {
+		const block* current = fBlocks[index];
+		if (current->firstTime >= to)
+			break;
+		if (current->lastTime < from)
+			continue;
+
+		int64 blockMin = 0, blockMax = 0;
+		if (current->firstTime >= from && current->lastTime < to) {
+			// Fully covered, the index is enough
+			blockMin = current->min;
+			blockMax = current->max;
+		} else {
+			_Decode(current);
+
+			bool any = false;
+			for (size_t i = 0; i < fDecodedTimes.size(); i++) {
+				bigtime_t time = fDecodedTimes[i];
+				if (time < from)
+					continue;
+				if (time >= to)
+					break;
+
+				int64 value = fDecodedValues[i];
+				if (!any || value < blockMin)
+					blockMin = value;
+				if (!any || value > blockMax)
+					blockMax = value;
+				any = true;
+			}
+			if (!any)
+				continue;
+		}
+
+		if (!found || blockMin < min)
+			min = blockMin;
+		if (!found || blockMax > max)
+			max = blockMax;
+		found = true;
+	}
+
+	return found;
+}
+
+
+bool
+CompressedHistory::IsEmpty() const
+{
+	return fBlocks.empty();
+}
+
+
+bigtime_t
+CompressedHistory::Start() const
+{
+	return fBlocks.empty() ? 0 : fBlocks.front()->firstTime;
+}
+
+
+bigtime_t
+CompressedHistory::End() const
+{
+	return fBlocks.empty() ? 0 : fBlocks.back()->lastTime;
+}
+
+
+int64
+CompressedHistory::LastValue() const
+{
+	return fBlocks.empty() ? 0 : fBlocks.back()->lastValue;
+}
+
+
+void
+CompressedHistory::SetRetention(bigtime_t retention)
+{
+	fRetention = retention;
+	if (fRetention > 0 && !fBlocks.empty())
+		DiscardBefore(End() - fRetention);
+}
+
+
+uint32
+CompressedHistory::CountSamples() const
+{
+	uint32 count = 0;
+	for (size_t i = 0; i < fBlocks.size(); i++)
+		count += fBlocks[i]->count;
+	return count;
+}
+
+
+size_t
+CompressedHistory::MemoryUsage() const
+{
+	return fBlocks.size() * sizeof(block);
+}
+
+
+CompressedHistory::block*
+CompressedHistory::_NewBlock(bigtime_t time, int64 value)
+{
+	block* newBlock = new(std::nothrow) block;
+	if (newBlock == NULL)
+		return NULL;
+
+	newBlock->firstTime = time;
+	newBlock->lastTime = time;
+	newBlock->lastDelta = 0;
+	newBlock->firstValue = value;
+	newBlock->lastValue = value;
+	newBlock->min = value;
+	newBlock->max = value;
+	newBlock->count = 1;
+	newBlock->size = 0;
+	return newBlock;
+}
+
+
+int32
+CompressedHistory::_FindBlock(bigtime_t time) const
+{
+	// The last block starting at or before time
+	int32 left = 0;
+	int32 right = static_cast<int32>(fBlocks.size());
+	while (left < right) {
+		int32 index = (left + right) / 2;
+		if (fBlocks[index]->firstTime <= time)
+			left = index + 1;
+		else
+			right = index;
+	}
+	return left - 1;
+}
+
+
+void
+CompressedHistory::_Decode(const block* current) const
+{
+	if (fDecodedBlock == current)
+		return;
+
+	fDecodedTimes.resize(current->count);
+	fDecodedValues.resize(current->count);
+
+	bigtime_t time = current->firstTime;
+	bigtime_t delta = 0;
+	int64 value = current->firstValue;
+	fDecodedTimes[0] = time;
+	fDecodedValues[0] = value;
+
+	const uint8* data = current->data;
+	for (uint32 i = 1; i < current->count; i++) {
+		delta += _GetVarint(data);
+		time += delta;
+		value += _GetVarint(data);
+		fDecodedTimes[i] = time;
+		fDecodedValues[i] = value;
+	}
+
+	fDecodedBlock = current;
+}
+
+
+/*static*/ size_t
+CompressedHistory::_PutVarint(uint8* buffer, int64 value)
+{
+	// Zigzag encoding keeps small negative numbers short
+	uint64 bits = (static_cast<uint64>(value) << 1)
+		^ static_cast<uint64>(value >> 63);
+
+	size_t length = 0;
+	while (bits >= 0x80) {
+		buffer[length++] = static_cast<uint8>(bits | 0x80);
+		bits >>= 7;
+	}
+	buffer[length++] = static_cast<uint8>(bits);
+	return length;
+}
+
+
+/*static*/ int64
+CompressedHistory::_GetVarint(const uint8*& buffer)
+{
+	uint64 bits = 0;
+	for (int shift = 0; ; shift += 7) {
+		uint8 byte = *buffer++;
+		bits |= static_cast<uint64>(byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0)
+			break;
+	}
+	return static_cast<int64>(bits >> 1) ^ -static_cast<int64>(bits & 1);
+}
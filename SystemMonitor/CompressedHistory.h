@@ -0,0 +1,72 @@
+#ifndef COMPRESSEDHISTORY_H
+#define COMPRESSEDHISTORY_H
+
+#if defined(__HAIKU__) || defined(BEOS)
+#include <OS.h>
+#endif
+#include <deque>
+#include <vector>
+
+// Long-term, append-only store for samples that fell out of a DataHistory.
+// Samples are packed into fixed size blocks: timestamps as zigzag varint
+// delta-of-deltas, values as zigzag varint deltas. With a steady sampling
+// interval, most samples take 2-3 bytes instead of 24.
+// Every block keeps its time range and min/max in a small index, so range
+// queries only decode the blocks at their edges.
+class CompressedHistory {
+public:
+						CompressedHistory(bigtime_t retention);
+						~CompressedHistory();
+
+			void		AddValue(bigtime_t time, int64 value);
+			void		DiscardBefore(bigtime_t time);
+
+			int64		ValueAt(bigtime_t time) const;
+			bool		EnvelopeAt(bigtime_t from, bigtime_t to,
+							int64& min, int64& max) const;
+
+			bool		IsEmpty() const;
+			bigtime_t	Start() const;
+			bigtime_t	End() const;
+			int64		LastValue() const;
+
+			bigtime_t	Retention() const { return fRetention; }
+			void		SetRetention(bigtime_t retention);
+
+			uint32		CountSamples() const;
+			size_t		MemoryUsage() const;
+
+private:
+	static const size_t kBlockSize = 4096;
+
+	struct block {
+		bigtime_t	firstTime;
+		bigtime_t	lastTime;
+		bigtime_t	lastDelta;
+		int64		firstValue;
+		int64		lastValue;
+		int64		min;
+		int64		max;
+		uint32		count;
+		uint32		size;
+		uint8		data[kBlockSize];
+	};
+
+			block*		_NewBlock(bigtime_t time, int64 value);
+			int32		_FindBlock(bigtime_t time) const;
+			void		_Decode(const block* current) const;
+
+	static	size_t		_PutVarint(uint8* buffer, int64 value);
+	static	int64		_GetVarint(const uint8*& buffer);
+
+private:
+	std::deque<block*>	fBlocks;
+	bigtime_t			fRetention;
+
+	// The most recently decoded block; queries are usually sequential
+	mutable const block* fDecodedBlock;
+	mutable std::vector<bigtime_t> fDecodedTimes;
+	mutable std::vector<int64> fDecodedValues;
+};
+
+#endif // COMPRESSEDHISTORY_H
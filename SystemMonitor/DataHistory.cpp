@@ -1,90 +1,149 @@
 #include "DataHistory.h"
 #include <limits.h>
+#include <string.h>
+#include <algorithm>
+#include <new>
 
-DataHistory::DataHistory(bigtime_t memorize, bigtime_t interval)
+template<typename Value>
+DataHistory<Value>::DataHistory(bigtime_t memorize, bigtime_t interval,
+	int32 fieldCount)
 	:
-	fBuffer(memorize > 0 && interval > 0 ? memorize / interval : 100),
+	fTimes(memorize > 0 && interval > 0 ? memorize / interval : 100),
+	fFields(NULL),
+	fFieldCount(0),
 	fRefreshInterval(interval),
 	fNextSeq(0)
 {
+	fFields = new(std::nothrow) field_state[fieldCount > 0 ? fieldCount : 1];
+	if (fFields == NULL)
+		return;
+
+	fFieldCount = fieldCount > 0 ? fieldCount : 1;
+	for (int32 i = 0; i < fFieldCount; i++) {
+		field_state& field = fFields[i];
+		field.values.SetSize(fTimes.Size());
+		field.minQueue.SetCapacity(fTimes.Size());
+		field.maxQueue.SetCapacity(fTimes.Size());
+		_ResetLevels(field);
+	}
 }
 
 
-DataHistory::~DataHistory()
+template<typename Value>
+DataHistory<Value>::~DataHistory()
 {
+	delete[] fFields;
 }
 
 
+template<typename Value>
+status_t
+DataHistory<Value>::InitCheck() const
+{
+	if (fFields == NULL || fTimes.InitCheck() != B_OK)
+		return B_NO_MEMORY;
+
+	for (int32 i = 0; i < fFieldCount; i++) {
+		if (fFields[i].values.InitCheck() != B_OK)
+			return B_NO_MEMORY;
+	}
+	return B_OK;
+}
+
+
+template<typename Value>
 void
-DataHistory::AddValue(bigtime_t time, int64 value)
+DataHistory<Value>::AddValue(bigtime_t time, Value value)
 {
-	bool full = static_cast<size_t>(fBuffer.CountItems()) == fBuffer.Size();
-	uint64 oldestSeq = 0;
+	if (fFieldCount == 1)
+		AddValues(time, &value);
+}
+
+
+template<typename Value>
+void
+DataHistory<Value>::AddValues(bigtime_t time, const Value* values)
+{
+	if (fFieldCount == 0 || fTimes.Size() == 0)
+		return;
+
+	bool full = fTimes.CountItems() == fTimes.Size();
 	if (full) {
-		data_item* oldest = fBuffer.ItemAt(0);
-		if (oldest != NULL)
-			oldestSeq = oldest->seq;
+		bigtime_t oldest = *fTimes.ItemAt(0);
+		for (int32 i = 0; i < fFieldCount; i++) {
+			field_state& field = fFields[i];
+			if (field.archive != NULL) {
+				field.archive->AddValue(oldest,
+					Traits::ToFixed(*field.values.ItemAt(0)));
+			}
+		}
 	}
 
-	data_item item = {time, value, fNextSeq++};
-	fBuffer.AddItem(item);
+	fTimes.AddItem(time);
+	fNextSeq++;
 
-	// Maintain Min Deque (increasing)
-	while (!fMinDeque.empty() && fMinDeque.back().value >= value) {
-		fMinDeque.pop_back();
-	}
-	fMinDeque.push_back(item);
+	for (int32 i = 0; i < fFieldCount; i++) {
+		field_state& field = fFields[i];
+		Value value = values[i];
+		field.values.AddItem(value);
 
-	// Maintain Max Deque (decreasing)
-	while (!fMaxDeque.empty() && fMaxDeque.back().value <= value) {
-		fMaxDeque.pop_back();
-	}
-	fMaxDeque.push_back(item);
+		_UpdateMinMax(field, value);
 
-	if (full) {
-		if (!fMinDeque.empty() && fMinDeque.front().seq == oldestSeq)
-			fMinDeque.pop_front();
+		lod_item<Value> leaf = {time, time, value, value, value, 1};
+		_AddToLevels(field, leaf);
 
-		if (!fMaxDeque.empty() && fMaxDeque.front().seq == oldestSeq)
-			fMaxDeque.pop_front();
+		field.sketch.AddValue(time, Traits::ToFixed(value));
 	}
 }
 
 
-int64
-DataHistory::ValueAt(bigtime_t time, int32* hintIndex)
+template<typename Value>
+Value
+DataHistory<Value>::ValueAt(bigtime_t time, int32* hintIndex,
+	int32 field) const
 {
+	if (field < 0 || field >= fFieldCount)
+		return 0;
+
+	const field_state& state = fFields[field];
+	if (state.archive != NULL && !state.archive->IsEmpty()) {
+		const bigtime_t* first = fTimes.ItemAt(0);
+		if (first == NULL || time < *first)
+			return _ArchivedValueAt(state, time);
+	}
+
 	int32 left = 0;
 	if (hintIndex != NULL && *hintIndex >= 0)
 		left = *hintIndex;
 
-	int32 right = (int32)fBuffer.CountItems() - 1;
-	data_item* item = NULL;
+	int32 right = (int32)fTimes.CountItems() - 1;
 
 	while (left <= right) {
 		int32 index = (left + right) / 2;
-		item = fBuffer.ItemAt(index);
+		bigtime_t itemTime = *fTimes.ItemAt(index);
 
-		if (item->time > time) {
+		if (itemTime > time) {
 			// search in left part
 			right = index - 1;
 		} else {
-			data_item* nextItem = fBuffer.ItemAt(index + 1);
-			if (nextItem == NULL) {
+			const bigtime_t* nextTime = fTimes.ItemAt(index + 1);
+			Value value = *state.values.ItemAt(index);
+			if (nextTime == NULL) {
 				if (hintIndex != NULL)
 					*hintIndex = index;
-				return item->value;
+				return value;
 			}
-			if (nextItem->time > time) {
+			if (*nextTime > time) {
 				// found item
 				if (hintIndex != NULL)
 					*hintIndex = index;
 
-				int64 value = item->value;
 				// Prevent division by zero if multiple samples have the same timestamp
-				if (nextItem->time > item->time) {
-					value += static_cast<int64>(static_cast<double>(nextItem->value - value)
-						/ (nextItem->time - item->time) * (time - item->time));
+				if (*nextTime > itemTime) {
+					Value nextValue = *state.values.ItemAt(index + 1);
+					value += static_cast<Value>(
+						static_cast<double>(nextValue - value)
+							/ (*nextTime - itemTime) * (time - itemTime));
 				}
 				return value;
 			}
@@ -98,95 +157,559 @@ DataHistory::ValueAt(bigtime_t time, int32* hintIndex)
 }
 
 
-int64
-DataHistory::MaximumValue() const
+template<typename Value>
+void
+DataHistory<Value>::ResampleRange(bigtime_t start, bigtime_t step,
+	int32 count, float* out, int32 field) const
 {
-	if (fMaxDeque.empty())
+	int32 items = static_cast<int32>(fTimes.CountItems());
+	int32 j = 0;
+
+	if (items == 0 || step <= 0 || field < 0 || field >= fFieldCount) {
+		for (; j < count; j++)
+			out[j] = 0;
+		return;
+	}
+
+	const field_state& state = fFields[field];
+
+	// Same as ValueAt(): nothing before the first sample, unless it has
+	// been archived
+	bigtime_t first = *fTimes.ItemAt(0);
+	bool archived = state.archive != NULL && !state.archive->IsEmpty();
+	for (; j < count && start + j * step < first; j++) {
+		out[j] = archived
+			? static_cast<float>(_ArchivedValueAt(state, start + j * step)) : 0;
+	}
+
+	int32 i = 0;
+	while (j < count) {
+		bigtime_t time = start + j * step;
+		while (i + 1 < items && *fTimes.ItemAt(i + 1) <= time)
+			i++;
+
+		bigtime_t itemTime = *fTimes.ItemAt(i);
+		Value value = *state.values.ItemAt(i);
+		if (i + 1 == items) {
+			// Hold the last value
+			_Interpolate(out + j, count - j, value, 0);
+			return;
+		}
+
+		// All outputs up to the next sample lie on the same segment
+		bigtime_t nextTime = *fTimes.ItemAt(i + 1);
+		Value nextValue = *state.values.ItemAt(i + 1);
+		int32 end = (nextTime - start + step - 1) / step;
+		if (end > count)
+			end = count;
+
+		double slope = static_cast<double>(nextValue - value)
+			/ (nextTime - itemTime);
+		_Interpolate(out + j, end - j,
+			value + slope * (time - itemTime), slope * step);
+		j = end;
+	}
+}
+
+
+template<typename Value>
+/*static*/ void
+DataHistory<Value>::_Interpolate(float* out, int32 count, double base,
+	double delta)
+{
+	// Kept free of branches and dependencies between iterations, so that
+	// the compiler can vectorize it.
+	float first = static_cast<float>(base);
+	float increment = static_cast<float>(delta);
+	for (int32 k = 0; k < count; k++)
+		out[k] = first + increment * k;
+}
+
+
+template<typename Value>
+Value
+DataHistory<Value>::MaximumValue(int32 field) const
+{
+	if (field < 0 || field >= fFieldCount || fFields[field].maxQueue.IsEmpty())
 		return 0;
-	return fMaxDeque.front().value;
+	return _ValueOf(fFields[field], fFields[field].maxQueue.Front());
 }
 
 
-int64
-DataHistory::MinimumValue() const
+template<typename Value>
+Value
+DataHistory<Value>::MinimumValue(int32 field) const
 {
-	if (fMinDeque.empty())
+	if (field < 0 || field >= fFieldCount || fFields[field].minQueue.IsEmpty())
 		return 0;
-	return fMinDeque.front().value;
+	return _ValueOf(fFields[field], fFields[field].minQueue.Front());
 }
 
 
+template<typename Value>
+Value
+DataHistory<Value>::Quantile(float q, int32 field) const
+{
+	if (field < 0 || field >= fFieldCount)
+		return 0;
+	return Traits::FromFixed(fFields[field].sketch.Quantile(q));
+}
+
+
+template<typename Value>
+void
+DataHistory<Value>::GetHistogram(uint32* bins, int32 binCount, Value& min,
+	Value& max, int32 field) const
+{
+	if (field < 0 || field >= fFieldCount) {
+		memset(bins, 0, binCount * sizeof(uint32));
+		min = max = 0;
+		return;
+	}
+
+	const QuantileSketch& sketch = fFields[field].sketch;
+	int64 fixedMin = sketch.Quantile(0.0f);
+	int64 fixedMax = sketch.Quantile(1.0f);
+	sketch.GetHistogram(bins, binCount, fixedMin, fixedMax);
+
+	min = Traits::FromFixed(fixedMin);
+	max = Traits::FromFixed(fixedMax);
+}
+
+
+template<typename Value>
 bigtime_t
-DataHistory::Start() const
+DataHistory<Value>::Start() const
 {
-	if (fBuffer.CountItems() == 0)
+	// All fields are archived together
+	if (fFieldCount > 0 && fFields[0].archive != NULL
+		&& !fFields[0].archive->IsEmpty()) {
+		return fFields[0].archive->Start();
+	}
+
+	if (fTimes.CountItems() == 0)
 		return 0;
 
-	return fBuffer.ItemAt(0)->time;
+	return *fTimes.ItemAt(0);
 }
 
 
+template<typename Value>
 bigtime_t
-DataHistory::End() const
+DataHistory<Value>::End() const
 {
-	if (fBuffer.CountItems() == 0)
+	if (fTimes.CountItems() == 0)
 		return 0;
 
-	return fBuffer.ItemAt(fBuffer.CountItems() - 1)->time;
+	return *fTimes.ItemAt(fTimes.CountItems() - 1);
 }
 
 
+template<typename Value>
 void
-DataHistory::SetRefreshInterval(bigtime_t interval)
+DataHistory<Value>::SetRefreshInterval(bigtime_t interval)
 {
-	if (interval <= 0 || interval == fRefreshInterval)
+	if (interval <= 0 || interval == fRefreshInterval || fFieldCount == 0)
 		return;
 
 	// Calculate current duration with old interval
-	bigtime_t duration = fBuffer.Size() * fRefreshInterval;
+	bigtime_t duration = fTimes.Size() * fRefreshInterval;
 
 	// Calculate new size to keep the same duration
 	size_t newSize = duration / interval;
 	if (newSize < 10) newSize = 10;
 
-	if (fBuffer.SetSize(newSize) == B_OK) {
-		fRefreshInterval = interval;
-		// Re-stamp sequence numbers after resize so deque eviction remains correct
-		uint32 count = fBuffer.CountItems();
-		fNextSeq = count;
-		for (uint32 i = 0; i < count; i++) {
-			data_item* item = fBuffer.ItemAt(i);
-			if (item != NULL)
-				item->seq = i;
+	// Don't lose the samples that no longer fit
+	uint32 oldCount = fTimes.CountItems();
+	if (oldCount > newSize) {
+		for (int32 i = 0; i < fFieldCount; i++) {
+			field_state& field = fFields[i];
+			if (field.archive == NULL)
+				continue;
+
+			for (uint32 j = 0; j < oldCount - newSize; j++) {
+				field.archive->AddValue(*fTimes.ItemAt(j),
+					Traits::ToFixed(*field.values.ItemAt(j)));
+			}
 		}
-		_ResetDeques();
+	}
+
+	// The queues hold absolute sample numbers, so they stay valid across the
+	// resize; they only need to be able to hold the whole buffer.
+	for (int32 i = 0; i < fFieldCount; i++) {
+		if (fFields[i].minQueue.SetCapacity(newSize) != B_OK
+			|| fFields[i].maxQueue.SetCapacity(newSize) != B_OK) {
+			return;
+		}
+	}
+
+	if (fTimes.SetSize(newSize) != B_OK)
+		return;
+
+	status_t status = B_OK;
+	for (int32 i = 0; i < fFieldCount && status == B_OK; i++)
+		status = fFields[i].values.SetSize(newSize);
+	if (status != B_OK) {
+		// Keep the columns in step, even if that means losing the samples
+		fTimes.MakeEmpty();
+		for (int32 i = 0; i < fFieldCount; i++)
+			fFields[i].values.MakeEmpty();
+	}
+
+	fRefreshInterval = interval;
+	for (int32 i = 0; i < fFieldCount; i++) {
+		_DropExpired(fFields[i]);
+		_ResetLevels(fFields[i]);
 	}
 }
 
 
+template<typename Value>
 void
-DataHistory::_ResetDeques()
+DataHistory<Value>::SetRetention(bigtime_t retention)
+{
+	bigtime_t archived = retention - fTimes.Size() * fRefreshInterval;
+
+	for (int32 i = 0; i < fFieldCount; i++) {
+		field_state& field = fFields[i];
+		if (archived <= 0) {
+			delete field.archive;
+			field.archive = NULL;
+		} else if (field.archive == NULL)
+			field.archive = new(std::nothrow) CompressedHistory(archived);
+		else
+			field.archive->SetRetention(archived);
+	}
+}
+
+
+template<typename Value>
+bigtime_t
+DataHistory<Value>::Retention() const
 {
-	fMinDeque.clear();
-	fMaxDeque.clear();
+	bigtime_t retention = fTimes.Size() * fRefreshInterval;
+	if (fFieldCount > 0 && fFields[0].archive != NULL)
+		retention += fFields[0].archive->Retention();
+	return retention;
+}
 
-	uint32 count = fBuffer.CountItems();
-	for (uint32 i = 0; i < count; i++) {
-		data_item* item = fBuffer.ItemAt(i);
-		if (item == NULL) continue;
 
-		int64 value = item->value;
+template<typename Value>
+int32
+DataHistory<Value>::CountLevels() const
+{
+	if (fFieldCount == 0)
+		return 1;
+	return static_cast<int32>(fFields[0].levels.size()) + 1;
+}
 
-		// Maintain Min Deque
-		while (!fMinDeque.empty() && fMinDeque.back().value >= value) {
-			fMinDeque.pop_back();
+
+template<typename Value>
+int32
+DataHistory<Value>::LevelFor(bigtime_t timePerPixel) const
+{
+	if (fRefreshInterval <= 0 || timePerPixel < 2 * fRefreshInterval)
+		return -1;
+
+	// Use the coarsest level whose buckets still fit into a pixel, so that
+	// a pixel never touches more than two buckets.
+	int32 level = 0;
+	while (level < CountLevels() - 1
+		&& (fRefreshInterval << (level + 1)) <= timePerPixel) {
+		level++;
+	}
+
+	return level;
+}
+
+
+template<typename Value>
+bool
+DataHistory<Value>::EnvelopeAt(int32 level, bigtime_t from, bigtime_t to,
+	Value& min, Value& max, int32* hintIndex, int32 field) const
+{
+	if (field < 0 || field >= fFieldCount)
+		return false;
+
+	const field_state& state = fFields[field];
+
+	bool found = false;
+	if (state.archive != NULL && !state.archive->IsEmpty()) {
+		const bigtime_t* first = fTimes.ItemAt(0);
+		bigtime_t archiveEnd = first != NULL ? *first : to;
+		int64 archiveMin, archiveMax;
+		if (from < archiveEnd && state.archive->EnvelopeAt(from,
+				std::min(to, archiveEnd), archiveMin, archiveMax)) {
+			min = Traits::FromFixed(archiveMin);
+			max = Traits::FromFixed(archiveMax);
+			found = true;
 		}
-		fMinDeque.push_back(*item);
+	}
+
+	Value bufferMin, bufferMax;
+	if (!_BufferEnvelope(state, level, from, to, bufferMin, bufferMax,
+			hintIndex)) {
+		return found;
+	}
+
+	if (!found || bufferMin < min)
+		min = bufferMin;
+	if (!found || bufferMax > max)
+		max = bufferMax;
+	return true;
+}
+
+
+template<typename Value>
+bool
+DataHistory<Value>::_BufferEnvelope(const field_state& field, int32 level,
+	bigtime_t from, bigtime_t to, Value& min, Value& max,
+	int32* hintIndex) const
+{
+	if (level <= 0 || level > static_cast<int32>(field.levels.size()))
+		return _RawEnvelope(field, from, to, min, max, hintIndex);
+
+	const CircularBuffer<lod_item<Value> >& buffer
+		= field.levels[level - 1].buffer;
+	int32 count = static_cast<int32>(buffer.CountItems());
+
+	// Find the first bucket that ends at or after "from"
+	int32 left = 0;
+	if (hintIndex != NULL && *hintIndex > 0)
+		left = std::min(*hintIndex, count);
+	int32 right = count;
+	while (left < right) {
+		int32 index = (left + right) / 2;
+		if (buffer.ItemAt(index)->end < from)
+			left = index + 1;
+		else
+			right = index;
+	}
+	if (hintIndex != NULL)
+		*hintIndex = left;
+
+	bool found = false;
+	for (int32 i = left; i < count; i++) {
+		const lod_item<Value>* item = buffer.ItemAt(i);
+		if (item->start >= to)
+			return found;
+
+		if (!found || item->min < min)
+			min = item->min;
+		if (!found || item->max > max)
+			max = item->max;
+		found = true;
+	}
+
+	// Samples newer than the last complete bucket are still only in the raw
+	// buffer; there are less than 2^level of them.
+	bigtime_t covered = count > 0 ? buffer.ItemAt(count - 1)->end + 1 : from;
+	Value tailMin, tailMax;
+	if (_RawEnvelope(field, std::max(from, covered), to, tailMin, tailMax,
+			NULL)) {
+		if (!found || tailMin < min)
+			min = tailMin;
+		if (!found || tailMax > max)
+			max = tailMax;
+		found = true;
+	}
+
+	return found;
+}
+
+
+template<typename Value>
+void
+DataHistory<Value>::_UpdateMinMax(field_state& field, Value value)
+{
+	_DropExpired(field);
+
+	// The min queue is increasing, the max queue decreasing, in value
+	while (!field.minQueue.IsEmpty()
+		&& _ValueOf(field, field.minQueue.Back()) >= value) {
+		field.minQueue.PopBack();
+	}
+	field.minQueue.PushBack(fNextSeq - 1);
+
+	while (!field.maxQueue.IsEmpty()
+		&& _ValueOf(field, field.maxQueue.Back()) <= value) {
+		field.maxQueue.PopBack();
+	}
+	field.maxQueue.PushBack(fNextSeq - 1);
+}
+
+
+template<typename Value>
+void
+DataHistory<Value>::_DropExpired(field_state& field)
+{
+	uint64 first = fNextSeq - field.values.CountItems();
+
+	while (!field.minQueue.IsEmpty() && field.minQueue.Front() < first)
+		field.minQueue.PopFront();
+	while (!field.maxQueue.IsEmpty() && field.maxQueue.Front() < first)
+		field.maxQueue.PopFront();
+}
+
 
-		// Maintain Max Deque
-		while (!fMaxDeque.empty() && fMaxDeque.back().value <= value) {
-			fMaxDeque.pop_back();
+template<typename Value>
+Value
+DataHistory<Value>::_ValueOf(const field_state& field, uint64 index) const
+{
+	// Sample number index is at this position in the buffer
+	return *field.values.ItemAt(
+		index - (fNextSeq - field.values.CountItems()));
+}
+
+
+template<typename Value>
+void
+DataHistory<Value>::_ResetLevels(field_state& field)
+{
+	field.levels.clear();
+
+	try {
+		// Every level spans roughly the same time as the raw buffer.
+		for (uint32 size = fTimes.Size() / 2; size >= 2; size /= 2)
+			field.levels.push_back(lod_level(size));
+	} catch (const std::bad_alloc&) {
+		// Keep the levels we got, EnvelopeAt() falls back to the raw
+		// samples for the others.
+	}
+
+	uint32 count = field.values.CountItems();
+	for (uint32 i = 0; i < count; i++) {
+		bigtime_t time = *fTimes.ItemAt(i);
+		Value value = *field.values.ItemAt(i);
+
+		lod_item<Value> leaf = {time, time, value, value, value, 1};
+		_AddToLevels(field, leaf);
+	}
+}
+
+
+template<typename Value>
+void
+DataHistory<Value>::_AddToLevels(field_state& field,
+	const lod_item<Value>& item)
+{
+	// Every level merges two items of the level below into one bucket; a
+	// completed bucket is carried over to the next level.
+	lod_item<Value> carry = item;
+	for (size_t i = 0; i < field.levels.size(); i++) {
+		lod_level& level = field.levels[i];
+		if (level.children == 0)
+			level.pending = carry;
+		else {
+			lod_item<Value>& pending = level.pending;
+			pending.end = carry.end;
+			if (carry.min < pending.min)
+				pending.min = carry.min;
+			if (carry.max > pending.max)
+				pending.max = carry.max;
+			pending.sum += carry.sum;
+			pending.count += carry.count;
 		}
-		fMaxDeque.push_back(*item);
+
+		if (++level.children < 2)
+			return;
+
+		level.children = 0;
+		level.buffer.AddItem(level.pending);
+		carry = level.pending;
 	}
 }
+
+
+template<typename Value>
+Value
+DataHistory<Value>::_ArchivedValueAt(const field_state& field,
+	bigtime_t time) const
+{
+	const bigtime_t* first = fTimes.ItemAt(0);
+	bigtime_t end = field.archive->End();
+	if (time < end || first == NULL || *first <= end)
+		return Traits::FromFixed(field.archive->ValueAt(time));
+
+	// Bridge the gap between the archive and the buffer
+	Value last = Traits::FromFixed(field.archive->LastValue());
+	Value firstValue = *field.values.ItemAt(0);
+	return last + static_cast<Value>(static_cast<double>(firstValue - last)
+		/ (*first - end) * (time - end));
+}
+
+
+template<typename Value>
+bool
+DataHistory<Value>::_RawEnvelope(const field_state& field, bigtime_t from,
+	bigtime_t to, Value& min, Value& max, int32* hintIndex) const
+{
+	int32 count = static_cast<int32>(fTimes.CountItems());
+
+	// Find the first sample at or after "from"
+	int32 left = 0;
+	if (hintIndex != NULL && *hintIndex > 0)
+		left = std::min(*hintIndex, count);
+	int32 right = count;
+	while (left < right) {
+		int32 index = (left + right) / 2;
+		if (*fTimes.ItemAt(index) < from)
+			left = index + 1;
+		else
+			right = index;
+	}
+	if (hintIndex != NULL)
+		*hintIndex = left;
+
+	// And the first one at or after "to"
+	int32 end = left;
+	right = count;
+	while (end < right) {
+		int32 index = (end + right) / 2;
+		if (*fTimes.ItemAt(index) < to)
+			end = index + 1;
+		else
+			right = index;
+	}
+	if (end == left)
+		return false;
+
+	// The values lie in at most two contiguous runs of the buffer, which
+	// are scanned without masking every index
+	Value* first;
+	Value* second;
+	uint32 firstCount, secondCount;
+	field.values.Spans(first, firstCount, second, secondCount);
+
+	int32 split = static_cast<int32>(firstCount);
+	min = max = *field.values.ItemAt(left);
+	if (left < split)
+		_MinMax(first + left, std::min(end, split) - left, min, max);
+	if (end > split) {
+		int32 start = std::max(left, split);
+		_MinMax(second + start - split, end - start, min, max);
+	}
+
+	return true;
+}
+
+
+template<typename Value>
+/*static*/ void
+DataHistory<Value>::_MinMax(const Value* values, int32 count, Value& min,
+	Value& max)
+{
+	// Without branches, so that the compiler can vectorize it
+	Value low = min;
+	Value high = max;
+	for (int32 i = 0; i < count; i++) {
+		low = std::min(low, values[i]);
+		high = std::max(high, values[i]);
+	}
+	min = low;
+	max = high;
+}
+
+
+template class DataHistory<int64>;
+template class DataHistory<float>;
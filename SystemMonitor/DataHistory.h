@@ -1,38 +1,225 @@
 #ifndef DATAHISTORY_H
 #define DATAHISTORY_H
 
+#if defined(__HAIKU__) || defined(BEOS)
 #include <OS.h>
-#include <deque>
+#endif
+#include <new>
+#include <vector>
 #include "CircularBuffer.h"
+#include "CompressedHistory.h"
+#include "QuantileSketch.h"
 
-struct data_item {
-	bigtime_t	time;
-	int64		value;
-	uint64		seq;
+// Conversion of sample values to the int64 representation used by the
+// archive and the quantile sketch. Floating point values are kept with three
+// decimals, which is well below anything a graph can show.
+template<typename Value>
+struct history_value_traits {
+	static int64 ToFixed(Value value) { return value; }
+	static Value FromFixed(int64 value) { return value; }
 };
 
+template<>
+struct history_value_traits<float> {
+	static int64 ToFixed(float value)
+		{ return static_cast<int64>(value * 1000.0 + (value < 0 ? -0.5 : 0.5)); }
+	static float FromFixed(int64 value)
+		{ return static_cast<float>(value / 1000.0); }
+};
+
+// Monotonic queue of absolute sample numbers for the sliding min/max, kept
+// in a ring that only ever grows, so that adding values never allocates.
+class IndexRing {
+public:
+	IndexRing()
+		:
+		fItems(NULL),
+		fCapacity(0),
+		fHead(0),
+		fCount(0)
+	{
+	}
+
+	~IndexRing()
+	{
+		delete[] fItems;
+	}
+
+	status_t SetCapacity(uint32 capacity)
+	{
+		if (capacity <= fCapacity)
+			return B_OK;
+
+		uint64* items = new(std::nothrow) uint64[capacity];
+		if (items == NULL)
+			return B_NO_MEMORY;
+
+		for (uint32 i = 0; i < fCount; i++)
+			items[i] = fItems[(fHead + i) % fCapacity];
+
+		delete[] fItems;
+		fItems = items;
+		fCapacity = capacity;
+		fHead = 0;
+		return B_OK;
+	}
+
+	bool IsEmpty() const { return fCount == 0; }
+	uint64 Front() const { return fItems[fHead]; }
+	uint64 Back() const { return fItems[(fHead + fCount - 1) % fCapacity]; }
+
+	void PushBack(uint64 index)
+	{
+		fItems[(fHead + fCount) % fCapacity] = index;
+		fCount++;
+	}
+
+	void PopBack() { fCount--; }
+
+	void PopFront()
+	{
+		fHead = (fHead + 1) % fCapacity;
+		fCount--;
+	}
+
+private:
+	IndexRing(const IndexRing&);
+	IndexRing& operator=(const IndexRing&);
+
+	uint64*		fItems;
+	uint32		fCapacity;
+	uint32		fHead;
+	uint32		fCount;
+};
+
+// Aggregate of a run of consecutive samples, used by the level of detail
+// pyramid.
+template<typename Value>
+struct lod_item {
+	bigtime_t	start;
+	bigtime_t	end;
+	Value		min;
+	Value		max;
+	Value		sum;
+	uint32		count;
+};
+
+// A history can hold several fields per sample, like the user and kernel
+// time of a CPU; they share the timestamps, and every query takes the
+// field to look at. Instantiated for int64 and float.
+template<typename Value>
 class DataHistory {
 public:
-						DataHistory(bigtime_t memorize, bigtime_t interval);
+						DataHistory(bigtime_t memorize, bigtime_t interval,
+							int32 fieldCount = 1);
 						~DataHistory();
 
-			void		AddValue(bigtime_t time, int64 value);
+			status_t	InitCheck() const;
+			int32		CountFields() const { return fFieldCount; }
+
+			// AddValue() is for single field histories, AddValues() takes
+			// one value per field.
+			void		AddValue(bigtime_t time, Value value);
+			void		AddValues(bigtime_t time, const Value* values);
 
-			int64		ValueAt(bigtime_t time, int32* hintIndex = NULL);
-			int64		MaximumValue() const;
-			int64		MinimumValue() const;
+			Value		ValueAt(bigtime_t time, int32* hintIndex = NULL,
+							int32 field = 0) const;
+			// Writes the interpolated values at start, start + step, ...
+			// into out, walking the buffer only once.
+			void		ResampleRange(bigtime_t start, bigtime_t step,
+							int32 count, float* out, int32 field = 0) const;
+			Value		MaximumValue(int32 field = 0) const;
+			Value		MinimumValue(int32 field = 0) const;
+			// Quantile of the values added during the last hour
+			Value		Quantile(float q, int32 field = 0) const;
+			// Spreads the same values over binCount bins between their
+			// smallest and largest one, which are returned in min and max.
+			void		GetHistogram(uint32* bins, int32 binCount, Value& min,
+							Value& max, int32 field = 0) const;
+			const QuantileSketch& Sketch(int32 field = 0) const
+							{ return fFields[field].sketch; }
 			bigtime_t	Start() const;
 			bigtime_t	End() const;
 
 			void		SetRefreshInterval(bigtime_t interval);
 
+			// Samples older than the in-memory buffer are kept compressed
+			// until they are older than the retention.
+			void		SetRetention(bigtime_t retention);
+			bigtime_t	Retention() const;
+
+			// Level 0 are the raw samples, every following level halves the
+			// resolution of the previous one. LevelFor() returns -1 when
+			// there is less than two samples per pixel, and point sampling
+			// with ValueAt() should be used instead.
+			int32		CountLevels() const;
+			int32		LevelFor(bigtime_t timePerPixel) const;
+			bool		EnvelopeAt(int32 level, bigtime_t from, bigtime_t to,
+							Value& min, Value& max, int32* hintIndex = NULL,
+							int32 field = 0) const;
+
 private:
-			void		_ResetDeques();
+	typedef history_value_traits<Value> Traits;
+
+	struct lod_level {
+							lod_level(uint32 size)
+								:
+								buffer(size),
+								pending(),
+								children(0)
+							{
+							}
+
+		CircularBuffer<lod_item<Value> > buffer;
+		lod_item<Value>		pending;
+		uint32				children;
+	};
+
+	struct field_state {
+							field_state()
+								:
+								values(0),
+								archive(NULL)
+							{
+							}
+							~field_state()
+							{
+								delete archive;
+							}
+
+		CircularBuffer<Value> values;
+		IndexRing			minQueue;
+		IndexRing			maxQueue;
+		std::vector<lod_level> levels;
+		QuantileSketch		sketch;
+		CompressedHistory*	archive;
+	};
+
+			void		_UpdateMinMax(field_state& field, Value value);
+			void		_DropExpired(field_state& field);
+			Value		_ValueOf(const field_state& field,
+							uint64 index) const;
+			bool		_BufferEnvelope(const field_state& field,
+							int32 level, bigtime_t from, bigtime_t to,
+							Value& min, Value& max,
+							int32* hintIndex) const;
+			Value		_ArchivedValueAt(const field_state& field,
+							bigtime_t time) const;
+			void		_ResetLevels(field_state& field);
+			void		_AddToLevels(field_state& field,
+							const lod_item<Value>& item);
+			bool		_RawEnvelope(const field_state& field,
+							bigtime_t from, bigtime_t to, Value& min,
+							Value& max, int32* hintIndex) const;
+	static	void		_Interpolate(float* out, int32 count, double base,
+							double delta);
+	static	void		_MinMax(const Value* values, int32 count,
+							Value& min, Value& max);
 
 private:
-	CircularBuffer<data_item> fBuffer;
-	std::deque<data_item> fMinDeque;
-	std::deque<data_item> fMaxDeque;
+	CircularBuffer<bigtime_t> fTimes;
+	field_state*		fFields;
+	int32				fFieldCount;
 	bigtime_t			fRefreshInterval;
 	uint64				fNextSeq;
 };
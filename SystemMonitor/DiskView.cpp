@@ -34,16 +34,12 @@ const float kBaseDiskPercentWidth = 80;
 
 DiskView::DiskView()
 	: BView("DiskView", B_WILL_DRAW),
-	  fUpdateThread(-1),
-	  fScanSem(-1),
-	  fTerminated(false),
 	  fPerformanceViewVisible(true),
 	  fRefreshInterval(1000000),
 	  fSortMode(SORT_DISK_BY_PERCENT),
 	  fListGeneration(0)
 {
 	SetViewColor(ui_color(B_PANEL_BACKGROUND_COLOR));
-	fScanSem = create_sem(0, "disk scan sem");
 
 	fDiskInfoBox = new BBox("DiskInfoBox");
 	fDiskInfoBox->SetLabel(B_TRANSLATE("Disk Volumes"));
@@ -108,12 +104,7 @@ DiskView::DiskView()
 
 DiskView::~DiskView()
 {
-	fTerminated = true;
-	if (fScanSem >= 0) delete_sem(fScanSem);
-	if (fUpdateThread >= 0) {
-		status_t dummy;
-		wait_for_thread(fUpdateThread, &dummy);
-	}
+	SamplingScheduler::Default().RemoveCollector(this);
 
 	// fDiskListView owns the items? No, BListView doesn't own items by default unless we iterate.
 	// However, if we empty it, we lose the pointers to items that are also in the map.
@@ -131,33 +122,20 @@ DiskView::~DiskView()
 void DiskView::AttachedToWindow()
 {
 	BView::AttachedToWindow();
-	fTerminated = false;
-
-	if (fScanSem < 0)
-		fScanSem = create_sem(0, "disk scan sem");
 
 	BVolumeRoster().StartWatching(BMessenger(this));
 	// Initial scan to populate cache
 	_ScanVolumes();
 
-	fUpdateThread = spawn_thread(UpdateThread, "DiskView Update", B_NORMAL_PRIORITY, this);
-	if (fUpdateThread >= 0)
-		resume_thread(fUpdateThread);
+	// A slow volume must not hold up CPU and memory sampling
+	SamplingScheduler::Default().AddCollector(this, fRefreshInterval,
+		fPerformanceViewVisible, kSamplingLaneSlow);
 }
 
 void DiskView::DetachedFromWindow()
 {
-	fTerminated = true;
 	stop_watching(BMessenger(this));
-	if (fScanSem >= 0) {
-		delete_sem(fScanSem);
-		fScanSem = -1;
-	}
-	if (fUpdateThread >= 0) {
-		status_t dummy;
-		wait_for_thread(fUpdateThread, &dummy);
-		fUpdateThread = -1;
-	}
+	SamplingScheduler::Default().RemoveCollector(this);
 	BView::DetachedFromWindow();
 }
 
@@ -205,8 +183,18 @@ void DiskView::MessageReceived(BMessage* message)
 void DiskView::SetRefreshInterval(bigtime_t interval)
 {
 	fRefreshInterval = interval;
-	if (fScanSem >= 0)
-		release_sem(fScanSem);
+	SamplingScheduler::Default().SetInterval(this, interval);
+}
+
+void DiskView::SetPerformanceViewVisible(bool visible)
+{
+	// Disks have no history to keep up, only the list, so sampling can
+	// stop while hidden and catch up once shown
+	fPerformanceViewVisible = visible;
+	SamplingScheduler& scheduler = SamplingScheduler::Default();
+	scheduler.SetEnabled(this, visible);
+	if (visible)
+		scheduler.Trigger(this);
 }
 
 status_t DiskView::GetDiskInfo(BVolume& volume, DiskInfo& info) {
@@ -247,82 +235,63 @@ status_t DiskView::GetDiskInfo(BVolume& volume, DiskInfo& info) {
 	return B_OK;
 }
 
-int32 DiskView::UpdateThread(void* data)
+void DiskView::Collect(bigtime_t /*now*/)
 {
-	DiskView* view = static_cast<DiskView*>(data);
-	BMessenger target(view);
-
-	while (!view->fTerminated) {
-		status_t err = acquire_sem_etc(view->fScanSem, 1, B_RELATIVE_TIMEOUT, view->fRefreshInterval);
-		if (err != B_OK && err != B_TIMED_OUT && err != B_INTERRUPTED)
-			break;
-
-		if (view->fTerminated) break;
-
-		if (!view->fPerformanceViewVisible)
-			continue;
-
-		// Drain the semaphore if we were woken up explicitly (e.g. interval change)
-		if (err == B_OK) {
-			int32 count;
-			if (get_sem_count(view->fScanSem, &count) == B_OK && count > 0)
-				acquire_sem_etc(view->fScanSem, count, B_RELATIVE_TIMEOUT, 0);
-		}
+	BMessenger target(this);
 
-		BMessage updateMsg(kMsgDiskDataUpdate);
+	BMessage updateMsg(kMsgDiskDataUpdate);
 
-		std::vector<DiskInfo> volumesToPoll;
-		if (view->fLocker.Lock()) {
-			for (auto const& pair : view->fVolumeCache) {
-				 volumesToPoll.push_back(pair.second);
-			}
-			view->fLocker.Unlock();
+	std::vector<DiskInfo> volumesToPoll;
+	if (fLocker.Lock()) {
+		for (auto const& pair : fVolumeCache) {
+			 volumesToPoll.push_back(pair.second);
 		}
+		fLocker.Unlock();
+	}
 
-		for (auto& info : volumesToPoll) {
-			 fs_info fsInfo;
-			 if (fs_stat_dev(info.deviceID, &fsInfo) != B_OK) {
-				 info.totalSize = 0; // Mark as invalid
-				 continue;
-			 }
+	for (auto& info : volumesToPoll) {
+		 fs_info fsInfo;
+		 if (fs_stat_dev(info.deviceID, &fsInfo) != B_OK) {
+			 info.totalSize = 0; // Mark as invalid
+			 continue;
+		 }
+
+		 // Update dynamic info
+		 info.totalSize = static_cast<uint64>(fsInfo.total_blocks) * fsInfo.block_size;
+		 info.freeSize = static_cast<uint64>(fsInfo.free_blocks) * fsInfo.block_size;
+
+		 // Update name dynamically
+		 if (strlen(fsInfo.volume_name) > 0) {
+			 info.deviceName = fsInfo.volume_name;
+		 } else {
+			 info.deviceName = fsInfo.device_name;
+		 }
+	}
 
-			 // Update dynamic info
-			 info.totalSize = static_cast<uint64>(fsInfo.total_blocks) * fsInfo.block_size;
-			 info.freeSize = static_cast<uint64>(fsInfo.free_blocks) * fsInfo.block_size;
+	if (fLocker.Lock()) {
+		for (const auto& info : volumesToPoll) {
+			 if (info.totalSize == 0) continue;
 
-			 // Update name dynamically
-			 if (strlen(fsInfo.volume_name) > 0) {
-				 info.deviceName = fsInfo.volume_name;
-			 } else {
-				 info.deviceName = fsInfo.device_name;
+			 // Update cache
+			 if (fVolumeCache.count(info.deviceID)) {
+				 fVolumeCache[info.deviceID] = info;
 			 }
-		}
-
-		if (view->fLocker.Lock()) {
-			for (const auto& info : volumesToPoll) {
-				 if (info.totalSize == 0) continue;
 
-				 // Update cache
-				 if (view->fVolumeCache.count(info.deviceID)) {
-					 view->fVolumeCache[info.deviceID] = info;
-				 }
+			 BMessage volMsg;
+			 volMsg.AddInt32("device_id", info.deviceID);
+			 volMsg.AddString("device_name", info.deviceName);
+			 volMsg.AddString("mount_point", info.mountPoint);
+			 volMsg.AddString("fs_type", info.fileSystemType);
+			 volMsg.AddUInt64("total_size", info.totalSize);
+			 volMsg.AddUInt64("free_size", info.freeSize);
 
-				 BMessage volMsg;
-				 volMsg.AddInt32("device_id", info.deviceID);
-				 volMsg.AddString("device_name", info.deviceName);
-				 volMsg.AddString("mount_point", info.mountPoint);
-				 volMsg.AddString("fs_type", info.fileSystemType);
-				 volMsg.AddUInt64("total_size", info.totalSize);
-				 volMsg.AddUInt64("free_size", info.freeSize);
-
-				 updateMsg.AddMessage("volume", &volMsg);
-			}
-			view->fLocker.Unlock();
+			 updateMsg.AddMessage("volume", &volMsg);
 		}
-
-		target.SendMessage(&updateMsg);
+		fLocker.Unlock();
 	}
-	return B_OK;
+
+	// Never block on the window, it might be waiting for the scheduler
+	target.SendMessage(&updateMsg, (BHandler*)NULL, 0);
 }
 
 void DiskView::UpdateData(BMessage* message)
@@ -8,10 +8,11 @@
 #include <unordered_map>
 #include <vector>
 #include <set>
-#include <atomic>
 #include <Font.h>
 #include <NodeMonitor.h>
 
+#include "SamplingScheduler.h"
+
 class BBox;
 class BListView;
 class BListItem;
@@ -39,7 +40,7 @@ enum DiskSortMode {
 	SORT_DISK_BY_PERCENT
 };
 
-class DiskView : public BView {
+class DiskView : public BView, public SampleCollector {
 public:
 	DiskView();
 	virtual ~DiskView();
@@ -49,8 +50,10 @@ public:
 	virtual void MessageReceived(BMessage* message);
 	virtual void Draw(BRect updateRect);
 
+	virtual void Collect(bigtime_t now);
+
 	void SetRefreshInterval(bigtime_t interval);
-	void SetPerformanceViewVisible(bool visible) { fPerformanceViewVisible = visible; }
+	void SetPerformanceViewVisible(bool visible);
 
 	float DeviceWidth() const { return fDeviceWidth; }
 	float MountWidth() const { return fMountWidth; }
@@ -61,7 +64,6 @@ public:
 	float PercentWidth() const { return fPercentWidth; }
 
 private:
-	static int32 UpdateThread(void* data);
 	void UpdateData(BMessage* message);
 	status_t GetDiskInfo(BVolume& volume, DiskInfo& info);
 
@@ -74,11 +76,8 @@ private:
 
 	BFont fCachedFont;
 
-	thread_id fUpdateThread;
-	sem_id fScanSem;
-	std::atomic<bool> fTerminated;
-	std::atomic<bool> fPerformanceViewVisible;
-	std::atomic<bigtime_t> fRefreshInterval;
+	bool fPerformanceViewVisible;
+	bigtime_t fRefreshInterval;
 	int32 fListGeneration;
 
 	float fDeviceWidth;
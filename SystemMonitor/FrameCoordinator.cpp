@@ -0,0 +1,212 @@
+#include "FrameCoordinator.h"
+#include <MessageRunner.h>
+#include <Messenger.h>
+#include <Screen.h>
+#include <View.h>
+#include <Window.h>
+#include <algorithm>
+#include <new>
+
+
+static const uint32 kMsgFlushFrame = 'frfl';
+static const bigtime_t kDefaultFrameInterval = 1000000 / 60;
+// Enough to catch the rest of a burst of samples from the same tick
+static const int32 kMaxIdleFrames = 3;
+
+
+FrameCoordinator::FrameCoordinator(BWindow* window)
+	: BHandler("frame coordinator"),
+	fFrameInterval(kDefaultFrameInterval),
+	fFrameRunner(NULL),
+	fIdleFrames(0)
+{
+	// Flush in step with the display, if it tells its refresh rate
+	BScreen screen(window);
+	display_mode mode;
+	if (screen.IsValid() && screen.GetMode(&mode) == B_OK
+		&& mode.timing.pixel_clock > 0 && mode.timing.h_total > 0
+		&& mode.timing.v_total > 0) {
+		double refresh = static_cast<double>(mode.timing.pixel_clock) * 1000.0
+			/ (static_cast<double>(mode.timing.h_total) * mode.timing.v_total);
+		if (refresh >= 20 && refresh <= 500)
+			fFrameInterval = static_cast<bigtime_t>(1000000 / refresh);
+	}
+}
+
+
+FrameCoordinator::~FrameCoordinator()
+{
+	delete fFrameRunner;
+}
+
+
+/*static*/ void
+FrameCoordinator::Attach(BView* view)
+{
+	FrameCoordinator* coordinator = _ForWindow(view->Window());
+	if (coordinator == NULL)
+		return;
+
+	try {
+		if (std::find(coordinator->fViews.begin(), coordinator->fViews.end(),
+				view) == coordinator->fViews.end()) {
+			coordinator->fViews.push_back(view);
+		}
+	} catch (const std::bad_alloc&) {
+		// Invalidate() falls back to invalidating right away
+	}
+}
+
+
+/*static*/ void
+FrameCoordinator::Detach(BView* view)
+{
+	BWindow* window = view->Window();
+	FrameCoordinator* coordinator = _Find(window);
+	if (coordinator == NULL)
+		return;
+
+	// The view may be deleted before the next frame
+	std::vector<BView*>& views = coordinator->fViews;
+	views.erase(std::remove(views.begin(), views.end(), view), views.end());
+	std::vector<BView*>& dirty = coordinator->fDirty;
+	dirty.erase(std::remove(dirty.begin(), dirty.end(), view), dirty.end());
+
+	// A pending flush finds the handler gone, and is dropped
+	if (views.empty()) {
+		window->RemoveHandler(coordinator);
+		delete coordinator;
+	}
+}
+
+
+/*static*/ void
+FrameCoordinator::Invalidate(BView* view)
+{
+	FrameCoordinator* coordinator = _Find(view->Window());
+	if (coordinator != NULL)
+		coordinator->_MarkDirty(view);
+	else
+		view->Invalidate();
+}
+
+
+/*static*/ bool
+FrameCoordinator::IsVisible(BView* view)
+{
+	BWindow* window = view->Window();
+	return window != NULL && !view->IsHidden() && !window->IsMinimized();
+}
+
+
+void
+FrameCoordinator::MessageReceived(BMessage* message)
+{
+	if (message->what == kMsgFlushFrame) {
+		_Flush();
+		return;
+	}
+
+	BHandler::MessageReceived(message);
+}
+
+
+/*static*/ FrameCoordinator*
+FrameCoordinator::_Find(BWindow* window)
+{
+	if (window == NULL)
+		return NULL;
+
+	for (int32 i = 0; i < window->CountHandlers(); i++) {
+		FrameCoordinator* coordinator
+			= dynamic_cast<FrameCoordinator*>(window->HandlerAt(i));
+		if (coordinator != NULL)
+			return coordinator;
+	}
+
+	return NULL;
+}
+
+
+/*static*/ FrameCoordinator*
+FrameCoordinator::_ForWindow(BWindow* window)
+{
+	if (window == NULL)
+		return NULL;
+
+	FrameCoordinator* coordinator = _Find(window);
+	if (coordinator != NULL)
+		return coordinator;
+
+	coordinator = new(std::nothrow) FrameCoordinator(window);
+	if (coordinator != NULL)
+		window->AddHandler(coordinator);
+	return coordinator;
+}
+
+
+void
+FrameCoordinator::_MarkDirty(BView* view)
+{
+	if (std::find(fViews.begin(), fViews.end(), view) == fViews.end()) {
+		view->Invalidate();
+		return;
+	}
+	if (std::find(fDirty.begin(), fDirty.end(), view) != fDirty.end())
+		return;
+
+	try {
+		fDirty.push_back(view);
+	} catch (const std::bad_alloc&) {
+		view->Invalidate();
+		return;
+	}
+
+	if (!_StartFrames())
+		_Flush();
+}
+
+
+/*!	Makes sure the frames are coming. The runner is kept for as long as
+	views become dirty, so that a frame costs a message, and not a new
+	runner registered with the registrar each time.
+*/
+bool
+FrameCoordinator::_StartFrames()
+{
+	fIdleFrames = 0;
+	if (fFrameRunner != NULL)
+		return true;
+
+	BMessage flush(kMsgFlushFrame);
+	fFrameRunner = new(std::nothrow) BMessageRunner(BMessenger(this), &flush,
+		fFrameInterval);
+	if (fFrameRunner != NULL && fFrameRunner->InitCheck() != B_OK) {
+		delete fFrameRunner;
+		fFrameRunner = NULL;
+	}
+	return fFrameRunner != NULL;
+}
+
+
+void
+FrameCoordinator::_Flush()
+{
+	if (fDirty.empty()) {
+		// Stop the frames after a few without anything to draw
+		if (fFrameRunner != NULL && ++fIdleFrames >= kMaxIdleFrames) {
+			delete fFrameRunner;
+			fFrameRunner = NULL;
+		}
+		return;
+	}
+	fIdleFrames = 0;
+
+	// All of them within one message, so the window draws them in one
+	// update. Those hidden since are drawn when they are shown again.
+	for (size_t i = 0; i < fDirty.size(); i++) {
+		if (IsVisible(fDirty[i]))
+			fDirty[i]->Invalidate();
+	}
+	fDirty.clear();
+}
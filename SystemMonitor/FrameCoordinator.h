@@ -0,0 +1,62 @@
+#ifndef FRAMECOORDINATOR_H
+#define FRAMECOORDINATOR_H
+
+#include <Handler.h>
+#include <vector>
+
+class BMessageRunner;
+class BView;
+class BWindow;
+
+// Collects the views of a window that need to be redrawn, and invalidates
+// them all together at the next display frame. Samples that are published
+// one after the other in the same scheduler tick then end up in a single
+// update of the window, instead of one each.
+//
+// Views that aren't on screen are skipped; they draw everything they
+// missed in one go once they are shown again, which their history makes
+// cheap.
+//
+// There is one coordinator per window, living as a handler of its looper
+// for as long as any of its views are attached. All of it has to be used
+// with the window locked. Its frames come from a single message runner
+// that keeps running while views become dirty, and is stopped after a few
+// frames without any, so that a sample arriving once a second costs about
+// one wakeup instead of one every frame.
+class FrameCoordinator : public BHandler {
+public:
+	// Called from the view's AttachedToWindow() and DetachedFromWindow().
+	static	void			Attach(BView* view);
+	static	void			Detach(BView* view);
+
+	// Invalidates the view at the next frame; right away if it isn't
+	// attached to a coordinator.
+	static	void			Invalidate(BView* view);
+
+	// Whether the view is on screen: attached, neither it nor any of its
+	// parents hidden (like the views of unselected tabs), and the window
+	// not minimized.
+	static	bool			IsVisible(BView* view);
+
+	virtual	void			MessageReceived(BMessage* message);
+
+private:
+							FrameCoordinator(BWindow* window);
+	virtual					~FrameCoordinator();
+
+	static	FrameCoordinator* _Find(BWindow* window);
+	static	FrameCoordinator* _ForWindow(BWindow* window);
+			void			_MarkDirty(BView* view);
+			bool			_StartFrames();
+			void			_Flush();
+
+private:
+			std::vector<BView*>	fViews;
+			std::vector<BView*>	fDirty;
+			bigtime_t		fFrameInterval;
+			BMessageRunner*	fFrameRunner;
+			// Frames in a row without anything to redraw
+			int32			fIdleFrames;
+};
+
+#endif // FRAMECOORDINATOR_H
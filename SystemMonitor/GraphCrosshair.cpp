@@ -0,0 +1,151 @@
+#include "GraphCrosshair.h"
+
+#include <Autolock.h>
+#include <InterfaceDefs.h>
+#include <View.h>
+
+#include <algorithm>
+#include <cmath>
+#include <new>
+
+
+GraphCrosshair::GraphCrosshair()
+	:
+	fLock("graph crosshair"),
+	fTime(kNoCrosshairTime)
+{
+}
+
+
+/*static*/ GraphCrosshair&
+GraphCrosshair::Default()
+{
+	static GraphCrosshair sDefault;
+	return sDefault;
+}
+
+
+status_t
+GraphCrosshair::StartWatching(BMessenger target)
+{
+	BAutolock locker(fLock);
+
+	if (std::find(fWatchers.begin(), fWatchers.end(), target)
+			!= fWatchers.end()) {
+		return B_OK;
+	}
+
+	try {
+		fWatchers.push_back(target);
+	} catch (const std::bad_alloc&) {
+		return B_NO_MEMORY;
+	}
+	return B_OK;
+}
+
+
+void
+GraphCrosshair::StopWatching(BMessenger target)
+{
+	BAutolock locker(fLock);
+
+	fWatchers.erase(std::remove(fWatchers.begin(), fWatchers.end(), target),
+		fWatchers.end());
+}
+
+
+void
+GraphCrosshair::SetTime(bigtime_t time)
+{
+	BAutolock locker(fLock);
+	if (time == fTime)
+		return;
+	fTime = time;
+
+	BMessage message(kMsgCrosshairMoved);
+	message.AddInt64("time", time);
+
+	// The hovering window is one of them, and other windows may be busy
+	for (size_t i = 0; i < fWatchers.size(); i++)
+		fWatchers[i].SendMessage(&message, (BHandler*)NULL, 0);
+}
+
+
+bigtime_t
+GraphCrosshair::Time() const
+{
+	BAutolock locker(fLock);
+	return fTime;
+}
+
+
+/*static*/ bigtime_t
+GraphCrosshair::TimeAt(float x, BRect frame, bigtime_t resolution,
+	bigtime_t end)
+{
+	if (end == 0)
+		end = system_time();
+
+	float pixels = std::max(0.0f, frame.right - x);
+	return end - static_cast<bigtime_t>(pixels * resolution);
+}
+
+
+/*static*/ float
+GraphCrosshair::PositionOf(bigtime_t time, BRect frame, bigtime_t resolution,
+	bigtime_t end)
+{
+	if (time == kNoCrosshairTime || resolution <= 0)
+		return NAN;
+	if (end == 0)
+		end = system_time();
+
+	float x = frame.right - static_cast<float>(end - time) / resolution;
+	if (x < frame.left || x > frame.right)
+		return NAN;
+	return floorf(x) + 0.5f;
+}
+
+
+/*static*/ void
+GraphCrosshair::Draw(BView* view, BRect frame, float x, float y,
+	const char* label)
+{
+	if (x != x)
+		return;
+
+	view->PushState();
+	view->SetDrawingMode(B_OP_COPY);
+	view->SetPenSize(1);
+
+	rgb_color text = ui_color(B_PANEL_TEXT_COLOR);
+	view->SetHighColor(text);
+	view->StrokeLine(BPoint(x, frame.top), BPoint(x, frame.bottom));
+	if (y == y && y >= frame.top && y <= frame.bottom)
+		view->StrokeLine(BPoint(frame.left, y), BPoint(frame.right, y));
+
+	if (label != NULL && label[0] != '\0') {
+		font_height fontHeight;
+		view->GetFontHeight(&fontHeight);
+		float height = ceilf(fontHeight.ascent + fontHeight.descent) + 2;
+		float width = ceilf(view->StringWidth(label)) + 6;
+
+		// Next to the line, on whichever side has room
+		float left = x + 4;
+		if (left + width > frame.right)
+			left = x - 4 - width;
+		float top = y == y ? y - height / 2 : frame.top + 2;
+		top = std::max(frame.top, std::min(top, frame.bottom - height));
+
+		BRect box(left, top, left + width, top + height);
+		view->SetHighColor(ui_color(B_TOOL_TIP_BACKGROUND_COLOR));
+		view->FillRect(box);
+		view->SetHighColor(text);
+		view->StrokeRect(box);
+		view->SetHighColor(ui_color(B_TOOL_TIP_TEXT_COLOR));
+		view->DrawString(label, BPoint(box.left + 3,
+			box.top + 1 + ceilf(fontHeight.ascent)));
+	}
+
+	view->PopState();
+}
@@ -0,0 +1,62 @@
+#ifndef GRAPHCROSSHAIR_H
+#define GRAPHCROSSHAIR_H
+
+#include <Locker.h>
+#include <Messenger.h>
+#include <Rect.h>
+#include <vector>
+
+class BView;
+
+
+// Sent to the watchers whenever the hovered time changes; contains the
+// "time" (int64), which is kNoCrosshairTime once no graph is hovered
+// anymore.
+const uint32 kMsgCrosshairMoved = 'crsh';
+
+// Restored history from before a reboot has negative times, so no real
+// time can mark the crosshair as hidden.
+const bigtime_t kNoCrosshairTime = B_INFINITE_TIMEOUT;
+
+
+// The time under the mouse in whichever graph it hovers, shared by all
+// graphs of the application, so that they all show a crosshair at the same
+// moment, and a CPU spike can be lined up with the traffic next to it.
+//
+// The crosshair is drawn over the finished frame in Draw(), so moving it
+// only copies the frame to the screen again and never renders anything.
+class GraphCrosshair {
+public:
+	static	GraphCrosshair&	Default();
+
+			status_t		StartWatching(BMessenger target);
+			void			StopWatching(BMessenger target);
+
+			// Called by the hovered graph; kNoCrosshairTime hides the
+			// crosshair.
+			void			SetTime(bigtime_t time);
+			bigtime_t		Time() const;
+
+			// The time at x in a graph whose right edge is at end, or now
+			// if it is 0, and the other way round; the latter is NAN
+			// outside the frame.
+	static	bigtime_t		TimeAt(float x, BRect frame,
+								bigtime_t resolution, bigtime_t end = 0);
+	static	float			PositionOf(bigtime_t time, BRect frame,
+								bigtime_t resolution, bigtime_t end = 0);
+
+			// Draws the vertical line at x over the frame, and the label
+			// next to it at y, if there is one.
+	static	void			Draw(BView* view, BRect frame, float x, float y,
+								const char* label);
+
+private:
+							GraphCrosshair();
+
+private:
+	mutable	BLocker			fLock;
+			bigtime_t		fTime;
+			std::vector<BMessenger> fWatchers;
+};
+
+#endif // GRAPHCROSSHAIR_H
@@ -0,0 +1,497 @@
+#include "GraphRasterizer.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <new>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+GraphRasterizer::GraphRasterizer()
+	:
+	fBits(NULL),
+	fBytesPerRow(0),
+	fWidth(0),
+	fHeight(0),
+	fOrigin(0),
+	fBackground(MakePixel(255, 255, 255)),
+	fGrid(MakePixel(192, 192, 192)),
+	fFill(MakePixel(0, 0, 0)),
+	fFillAlpha(100),
+	fLine(MakePixel(0, 0, 0)),
+	fGridRows(4),
+	fGridSpacing(60.0f),
+	fGridOffset(0.0f),
+	fLineWidth(1.5f),
+	fPatternValid(false),
+	fPatternLength(0),
+	fLayerCount(0)
+{
+}
+
+
+void
+GraphRasterizer::SetTarget(uint32* bits, int32 bytesPerRow, int32 width,
+	int32 height)
+{
+	if (width < 0)
+		width = 0;
+	if (height < 0)
+		height = 0;
+
+	if (width != fWidth || height != fHeight) {
+		fPatternValid = false;
+		fOrigin = 0;
+	}
+
+	fBits = bits;
+	fBytesPerRow = bytesPerRow;
+	fWidth = width;
+	fHeight = height;
+}
+
+
+void
+GraphRasterizer::SetColors(uint32 background, uint32 grid, uint32 fill,
+	uint8 fillAlpha, uint32 line)
+{
+	if (background != fBackground || grid != fGrid || fill != fFill
+		|| fillAlpha != fFillAlpha) {
+		fPatternValid = false;
+	}
+
+	fBackground = background;
+	fGrid = grid;
+	fFill = fill;
+	fFillAlpha = fillAlpha;
+	fLine = line;
+}
+
+
+void
+GraphRasterizer::SetGrid(int32 rows, float spacing, float offset)
+{
+	if (rows != fGridRows || spacing != fGridSpacing)
+		fPatternValid = false;
+
+	// The pattern covers one extra grid period, so the offset only picks
+	// where to start reading it
+	fGridRows = rows;
+	fGridSpacing = spacing;
+	fGridOffset = offset;
+}
+
+
+void
+GraphRasterizer::SetLineWidth(float width)
+{
+	fLineWidth = width;
+}
+
+
+status_t
+GraphRasterizer::SetLayers(int32 count, const uint32* fills,
+	const uint32* lines)
+{
+	if (count < 0 || (count > 0 && (fills == NULL || lines == NULL)))
+		return B_BAD_VALUE;
+
+	try {
+		fLayerFills.assign(fills, fills + count);
+		fLayerLines.assign(lines, lines + count);
+	} catch (const std::bad_alloc&) {
+		fLayerFills.clear();
+		fLayerLines.clear();
+		fLayerCount = 0;
+		return B_NO_MEMORY;
+	}
+
+	fLayerCount = count;
+	fPatternValid = false;
+	return B_OK;
+}
+
+
+void
+GraphRasterizer::Scroll(int32 pixels)
+{
+	if (pixels == 0 || fWidth <= 0)
+		return;
+
+	fOrigin = (fOrigin + pixels % fWidth) % fWidth;
+	if (fOrigin < 0)
+		fOrigin += fWidth;
+}
+
+
+status_t
+GraphRasterizer::DrawColumns(int32 firstX, int32 count, const float* tops,
+	const float* lows, float previousTop, float nextTop)
+{
+	if (fBits == NULL || tops == NULL || lows == NULL)
+		return B_OK;
+
+	if (firstX < 0) {
+		count += firstX;
+		tops -= firstX;
+		lows -= firstX;
+		firstX = 0;
+		previousTop = NAN;
+	}
+	if (firstX + count > fWidth) {
+		count = fWidth - firstX;
+		nextTop = NAN;
+	}
+	if (count <= 0 || fHeight <= 0)
+		return B_OK;
+
+	status_t status = _UpdatePattern();
+	if (status != B_OK)
+		return status;
+
+	int32* fillStart = fFillStart.data() + firstX;
+	_FillStarts(tops, count, fillStart);
+
+	// The columns may wrap around the end of the buffer
+	int32 column = _BufferColumn(firstX);
+	int32 firstCount = std::min(count, fWidth - column);
+
+	int32 patternStart = firstX + _PatternOffset();
+	for (int32 y = 0; y < fHeight; y++) {
+		bool gridRow = fIsGridRow[y];
+		const uint32* background = (gridRow ? fGridBackgroundRow
+			: fBackgroundRow).data() + patternStart;
+		const uint32* fill = (gridRow ? fGridFillRow : fFillRow).data()
+			+ patternStart;
+		uint32* row = _Row(y);
+		SelectRow(row + column, background, fill, fillStart, y, firstCount);
+		if (firstCount < count) {
+			SelectRow(row, background + firstCount, fill + firstCount,
+				fillStart + firstCount, y, count - firstCount);
+		}
+	}
+
+	_DrawLines(firstX, count, tops, lows, previousTop, nextTop, fLine);
+	return B_OK;
+}
+
+
+status_t
+GraphRasterizer::DrawStackedColumns(int32 firstX, int32 count,
+	const float* const* tops, const float* previousTops)
+{
+	if (fBits == NULL || tops == NULL || fLayerCount == 0)
+		return B_OK;
+
+	int32 skip = 0;
+	if (firstX < 0) {
+		count += firstX;
+		skip = -firstX;
+		firstX = 0;
+		previousTops = NULL;
+	}
+	if (firstX + count > fWidth)
+		count = fWidth - firstX;
+	if (count <= 0 || fHeight <= 0)
+		return B_OK;
+
+	status_t status = _UpdatePattern();
+	if (status != B_OK)
+		return status;
+
+	int32 layers = fLayerCount;
+	for (int32 k = 0; k < layers; k++) {
+		_FillStarts(tops[k] + skip, count,
+			fLayerStarts.data() + k * fWidth + firstX);
+	}
+
+	// The columns may wrap around the end of the buffer
+	int32 column = _BufferColumn(firstX);
+	int32 firstCount = std::min(count, fWidth - column);
+
+	int32 patternStart = firstX + _PatternOffset();
+	for (int32 y = 0; y < fHeight; y++) {
+		bool gridRow = fIsGridRow[y];
+		const uint32* background = (gridRow ? fGridBackgroundRow
+			: fBackgroundRow).data() + patternStart;
+		const uint32* fills = (gridRow ? fLayerGridRows : fLayerRows).data()
+			+ patternStart;
+		uint32* row = _Row(y);
+
+		// The top layer goes over the background, every one below it over
+		// what the layers above left in the row, as it reaches further down
+		for (int32 k = layers - 1; k >= 0; k--) {
+			const uint32* fill = fills + k * fPatternLength;
+			const int32* starts = fLayerStarts.data() + k * fWidth + firstX;
+			bool top = k == layers - 1;
+
+			SelectRow(row + column, top ? background : row + column, fill,
+				starts, y, firstCount);
+			if (firstCount < count) {
+				SelectRow(row, top ? background + firstCount : row,
+					fill + firstCount, starts + firstCount, y,
+					count - firstCount);
+			}
+		}
+	}
+
+	for (int32 k = 0; k < layers; k++) {
+		_DrawLines(firstX, count, tops[k] + skip, NULL,
+			previousTops != NULL ? previousTops[k] : NAN, NAN,
+			fLayerLines[k]);
+	}
+
+	return B_OK;
+}
+
+
+/*static*/ uint32
+GraphRasterizer::MakePixel(uint8 red, uint8 green, uint8 blue)
+{
+	return 0xff000000 | (static_cast<uint32>(red) << 16)
+		| (static_cast<uint32>(green) << 8) | blue;
+}
+
+
+/*static*/ uint32
+GraphRasterizer::Blend(uint32 under, uint32 over, uint32 alpha)
+{
+	if (alpha >= 255)
+		return over | 0xff000000;
+
+	// Red and blue are blended together, with room for the product in
+	// between them; 0..255 is stretched to 0..256 so a shift can divide
+	uint32 weight = alpha + (alpha >> 7);
+	uint32 redBlue = ((over & 0xff00ff) * weight
+		+ (under & 0xff00ff) * (256 - weight)) >> 8;
+	uint32 green = ((over & 0x00ff00) * weight
+		+ (under & 0x00ff00) * (256 - weight)) >> 8;
+	return 0xff000000 | (redBlue & 0xff00ff) | (green & 0x00ff00);
+}
+
+
+/*static*/ void
+GraphRasterizer::SelectRow(uint32* destination, const uint32* background,
+	const uint32* fill, const int32* fillStart, int32 y, int32 count)
+{
+#if defined(__SSE2__)
+	int32 x = 0;
+	__m128i row = _mm_set1_epi32(y);
+	for (; x + 4 <= count; x += 4) {
+		__m128i start = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(fillStart + x));
+		// All ones where the fill starts below this row
+		__m128i above = _mm_cmpgt_epi32(start, row);
+		__m128i back = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(background + x));
+		__m128i front = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(fill + x));
+		__m128i pixels = _mm_or_si128(_mm_and_si128(above, back),
+			_mm_andnot_si128(above, front));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + x), pixels);
+	}
+
+	if (x < count) {
+		SelectRowScalar(destination + x, background + x, fill + x,
+			fillStart + x, y, count - x);
+	}
+#else
+	SelectRowScalar(destination, background, fill, fillStart, y, count);
+#endif
+}
+
+
+/*static*/ void
+GraphRasterizer::SelectRowScalar(uint32* destination,
+	const uint32* background, const uint32* fill, const int32* fillStart,
+	int32 y, int32 count)
+{
+	for (int32 x = 0; x < count; x++)
+		destination[x] = fillStart[x] <= y ? fill[x] : background[x];
+}
+
+
+status_t
+GraphRasterizer::_UpdatePattern()
+{
+	if (fPatternValid)
+		return B_OK;
+
+	// One extra grid period, so that scrolling only moves the start
+	int32 period = fGridSpacing >= 1.0f
+		? static_cast<int32>(ceilf(fGridSpacing)) : 0;
+	size_t length = fWidth + period + 1;
+
+	try {
+		fBackgroundRow.resize(length);
+		fFillRow.resize(length);
+		fGridBackgroundRow.resize(length);
+		fGridFillRow.resize(length);
+		fIsGridRow.assign(fHeight, false);
+		fFillStart.resize(fWidth);
+		fLayerRows.resize(length * fLayerCount);
+		fLayerGridRows.resize(length * fLayerCount);
+		fLayerStarts.resize(static_cast<size_t>(fWidth) * fLayerCount);
+	} catch (const std::bad_alloc&) {
+		return B_NO_MEMORY;
+	}
+	fPatternLength = length;
+
+	uint32 background = fBackground | 0xff000000;
+	uint32 grid = fGrid | 0xff000000;
+	uint32 fillOverBackground = Blend(fBackground, fFill, fFillAlpha);
+	uint32 fillOverGrid = Blend(fGrid, fFill, fFillAlpha);
+
+	for (size_t x = 0; x < length; x++) {
+		fBackgroundRow[x] = background;
+		fFillRow[x] = fillOverBackground;
+		fGridBackgroundRow[x] = grid;
+		fGridFillRow[x] = fillOverGrid;
+	}
+
+	if (period > 0) {
+		for (int32 k = 0; ; k++) {
+			int32 x = static_cast<int32>(floorf(k * fGridSpacing + 0.5f));
+			if (x >= static_cast<int32>(length))
+				break;
+			fBackgroundRow[x] = grid;
+			fFillRow[x] = fillOverGrid;
+		}
+	}
+
+	// The vertical grid lines show through every layer
+	for (int32 k = 0; k < fLayerCount; k++) {
+		uint32* fill = fLayerRows.data() + k * length;
+		uint32* gridFill = fLayerGridRows.data() + k * length;
+		for (size_t x = 0; x < length; x++) {
+			fill[x] = Blend(fBackgroundRow[x], fLayerFills[k], fFillAlpha);
+			gridFill[x] = Blend(fGridBackgroundRow[x], fLayerFills[k],
+				fFillAlpha);
+		}
+	}
+
+	for (int32 i = 1; i < fGridRows; i++) {
+		int32 y = static_cast<int32>(floorf(
+			static_cast<float>(fHeight - 1) * i / fGridRows + 0.5f));
+		if (y >= 0 && y < fHeight)
+			fIsGridRow[y] = true;
+	}
+
+	fPatternValid = true;
+	return B_OK;
+}
+
+
+int32
+GraphRasterizer::_PatternOffset() const
+{
+	if (fGridSpacing < 1.0f)
+		return 0;
+
+	float offset = fmodf(fGridOffset, fGridSpacing);
+	if (offset < 0)
+		offset += fGridSpacing;
+	return std::min(static_cast<int32>(floorf(offset + 0.5f)),
+		static_cast<int32>(ceilf(fGridSpacing)));
+}
+
+
+int32
+GraphRasterizer::_BufferColumn(int32 x) const
+{
+	x += fOrigin;
+	return x < fWidth ? x : x - fWidth;
+}
+
+
+uint32*
+GraphRasterizer::_Row(int32 y) const
+{
+	return reinterpret_cast<uint32*>(reinterpret_cast<uint8*>(fBits)
+		+ static_cast<size_t>(y) * fBytesPerRow);
+}
+
+
+void
+GraphRasterizer::_FillStarts(const float* tops, int32 count,
+	int32* starts) const
+{
+	// Keeps the row loops sane for values far outside the graph, or NaN
+	float maxY = static_cast<float>(fHeight);
+	for (int32 j = 0; j < count; j++) {
+		float top = tops[j];
+		if (!(top >= 0.0f))
+			top = top < 0.0f ? 0.0f : maxY;
+		starts[j] = std::min(fHeight,
+			static_cast<int32>(ceilf(std::min(top, maxY))));
+	}
+}
+
+
+/*!	The line reaches halfway to each neighbour, and down to the bottom of
+	the column's envelope, if there are lows.
+*/
+void
+GraphRasterizer::_DrawLines(int32 firstX, int32 count, const float* tops,
+	const float* lows, float previousTop, float nextTop, uint32 color)
+{
+	float maxY = static_cast<float>(fHeight);
+	for (int32 j = 0; j < count; j++) {
+		if (tops[j] != tops[j])
+			continue;
+		float top = std::max(-1.0f, std::min(tops[j], maxY));
+		float low = lows != NULL ? lows[j] : top;
+		float bottom = low == low ? std::max(top, std::min(low, maxY)) : top;
+
+		float previous = j > 0 ? tops[j - 1] : previousTop;
+		float next = j < count - 1 ? tops[j + 1] : nextTop;
+		if (previous == previous) {
+			float middle = (top + std::max(-1.0f, std::min(previous, maxY)))
+				/ 2;
+			top = std::min(top, middle);
+			bottom = std::max(bottom, middle);
+		}
+		if (next == next) {
+			float middle = (top + std::max(-1.0f, std::min(next, maxY))) / 2;
+			top = std::min(top, middle);
+			bottom = std::max(bottom, middle);
+		}
+
+		_DrawLine(_BufferColumn(firstX + j), top, bottom, color);
+	}
+}
+
+
+void
+GraphRasterizer::_DrawLine(int32 x, float top, float bottom, uint32 color)
+{
+	// Each pixel row covers [y - 0.5, y + 0.5]; blend by how much of it the
+	// line covers
+	float halfWidth = fLineWidth / 2;
+	top -= halfWidth;
+	bottom += halfWidth;
+
+	int32 first = std::max(0, static_cast<int32>(floorf(top + 0.5f)));
+	int32 last = std::min(fHeight - 1,
+		static_cast<int32>(floorf(bottom + 0.5f)));
+
+	uint8* pixels = reinterpret_cast<uint8*>(_Row(0) + x);
+	for (int32 y = first; y <= last; y++) {
+		uint32* pixel = reinterpret_cast<uint32*>(pixels + y * fBytesPerRow);
+
+		// Only the end rows can be partially covered
+		float coverage = 1.0f;
+		if (y == first || y == last)
+			coverage = std::min(bottom, y + 0.5f) - std::max(top, y - 0.5f);
+
+		if (coverage >= 1.0f)
+			*pixel = color | 0xff000000;
+		else if (coverage > 0.0f) {
+			*pixel = Blend(*pixel, color,
+				static_cast<uint32>(coverage * 255.0f + 0.5f));
+		}
+	}
+}
@@ -0,0 +1,142 @@
+#ifndef GRAPHRASTERIZER_H
+#define GRAPHRASTERIZER_H
+
+#if defined(__HAIKU__) || defined(BEOS)
+#include <SupportDefs.h>
+#endif
+
+#include <math.h>
+#include <vector>
+
+
+// Draws activity graphs straight into a 32 bit pixel buffer (B_RGB32, so
+// 0xAARRGGBB in native byte order) instead of going through a BView. Each
+// pixel column gets the top of its value, and the bottom of its min/max
+// envelope; everything below the top is filled.
+//
+// The background with its grid, and the same with the fill blended over
+// it, are kept as a cached row pattern. Rows are then written by picking
+// per pixel between the two patterns, which is a branch-free select that
+// runs four pixels at a time with SSE2. The line is anti-aliased and drawn
+// column by column on top.
+//
+// A stacked graph has several layers, each filled up to its own top with
+// its own colour. All layers of a row are selected one after the other
+// while the row is in the cache, so the image is still written in a single
+// pass, however many layers there are.
+//
+// The buffer is used as a ring of columns: scrolling only moves the origin,
+// the column where the image starts, so its cost doesn't depend on the
+// width. Whoever shows the buffer has to copy it in two parts, split at
+// the origin.
+class GraphRasterizer {
+public:
+							GraphRasterizer();
+
+			void			SetTarget(uint32* bits, int32 bytesPerRow,
+								int32 width, int32 height);
+			// fillAlpha is the opacity of the fill over the background.
+			void			SetColors(uint32 background, uint32 grid,
+								uint32 fill, uint8 fillAlpha, uint32 line);
+			// Splits the height into rows by horizontal lines, and draws
+			// vertical lines every spacing pixels, shifted left by offset.
+			void			SetGrid(int32 rows, float spacing, float offset);
+			void			SetLineWidth(float width);
+			// The colours of the layers of a stacked graph, from the bottom
+			// up; the fill alpha from SetColors() applies to all of them.
+			status_t		SetLayers(int32 count, const uint32* fills,
+								const uint32* lines);
+			int32			CountLayers() const { return fLayerCount; }
+
+			// Moves the whole image left by moving the origin; the columns
+			// that come in on the right have to be drawn. Negative pixels
+			// move it right, and those coming in on the left are drawn.
+			void			Scroll(int32 pixels);
+			// The buffer column that holds column 0 of the image.
+			int32			Origin() const { return fOrigin; }
+
+			// Draws the columns [firstX, firstX + count) from scratch. The
+			// tops and lows are y coordinates with 0 at the top row. The
+			// previous top is that of column firstX - 1, so that the line
+			// connects to it; pass NAN if there is none. The next top is
+			// that of the column after the last one, for when columns are
+			// drawn in front of others that stay.
+			status_t		DrawColumns(int32 firstX, int32 count,
+								const float* tops, const float* lows,
+								float previousTop, float nextTop = NAN);
+			// The same for all layers of a stacked graph at once. tops[k]
+			// are the tops of layer k with all layers below it added, so
+			// they never lie below those of layer k - 1. Each layer's top
+			// gets a line in its colour. previousTops has the tops of
+			// column firstX - 1 for every layer, or is NULL.
+			status_t		DrawStackedColumns(int32 firstX, int32 count,
+								const float* const* tops,
+								const float* previousTops);
+
+	static	uint32			MakePixel(uint8 red, uint8 green, uint8 blue);
+	static	uint32			Blend(uint32 under, uint32 over, uint32 alpha);
+
+			// Writes fill[x] where fillStart[x] <= y, background[x]
+			// elsewhere.
+	static	void			SelectRow(uint32* destination,
+								const uint32* background, const uint32* fill,
+								const int32* fillStart, int32 y, int32 count);
+	static	void			SelectRowScalar(uint32* destination,
+								const uint32* background, const uint32* fill,
+								const int32* fillStart, int32 y, int32 count);
+
+private:
+			status_t		_UpdatePattern();
+			int32			_PatternOffset() const;
+			int32			_BufferColumn(int32 x) const;
+			uint32*			_Row(int32 y) const;
+			void			_FillStarts(const float* tops, int32 count,
+								int32* starts) const;
+			void			_DrawLines(int32 firstX, int32 count,
+								const float* tops, const float* lows,
+								float previousTop, float nextTop,
+								uint32 color);
+			void			_DrawLine(int32 x, float top, float bottom,
+								uint32 color);
+
+private:
+			uint32*			fBits;
+			int32			fBytesPerRow;
+			int32			fWidth;
+			int32			fHeight;
+			int32			fOrigin;
+
+			uint32			fBackground;
+			uint32			fGrid;
+			uint32			fFill;
+			uint8			fFillAlpha;
+			uint32			fLine;
+
+			int32			fGridRows;
+			float			fGridSpacing;
+			float			fGridOffset;
+			float			fLineWidth;
+
+			bool			fPatternValid;
+			// For rows without a horizontal grid line
+			std::vector<uint32>	fBackgroundRow;
+			std::vector<uint32>	fFillRow;
+			// For rows with one
+			std::vector<uint32>	fGridBackgroundRow;
+			std::vector<uint32>	fGridFillRow;
+			std::vector<bool>	fIsGridRow;
+			size_t			fPatternLength;
+
+			std::vector<int32>	fFillStart;
+
+			int32			fLayerCount;
+			std::vector<uint32>	fLayerFills;
+			std::vector<uint32>	fLayerLines;
+			// The fill rows of every layer, one after the other
+			std::vector<uint32>	fLayerRows;
+			std::vector<uint32>	fLayerGridRows;
+			// fWidth per layer
+			std::vector<int32>	fLayerStarts;
+};
+
+#endif // GRAPHRASTERIZER_H
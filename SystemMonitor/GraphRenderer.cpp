@@ -0,0 +1,211 @@
+#include "GraphRenderer.h"
+
+#include <Autolock.h>
+#include <Bitmap.h>
+
+#include <algorithm>
+#include <new>
+
+
+GraphFrameBuffers::GraphFrameBuffers()
+	:
+	fLock("graph frame buffers"),
+	fFront(0)
+{
+	fBitmaps[0] = NULL;
+	fBitmaps[1] = NULL;
+}
+
+
+GraphFrameBuffers::~GraphFrameBuffers()
+{
+	delete fBitmaps[0];
+	delete fBitmaps[1];
+}
+
+
+BBitmap*
+GraphFrameBuffers::Back(int32 width, int32 height)
+{
+	BBitmap*& bitmap = fBitmaps[BackIndex()];
+	if (bitmap != NULL && bitmap->Bounds().IntegerWidth() + 1 >= width
+		&& bitmap->Bounds().IntegerHeight() + 1 >= height) {
+		return bitmap;
+	}
+
+	// Not shown, so it can go without the lock
+	delete bitmap;
+
+	// Over-allocate to avoid frequent recreations during resize; the
+	// graph is rasterized directly into the bitmap, so it needs no view
+	bitmap = new(std::nothrow) BBitmap(BRect(0, 0, width + 63, height + 63),
+		0, B_RGB32);
+	if (bitmap != NULL && bitmap->InitCheck() != B_OK) {
+		delete bitmap;
+		bitmap = NULL;
+	}
+	return bitmap;
+}
+
+
+void
+GraphFrameBuffers::Swap()
+{
+	BAutolock locker(fLock);
+	fFront = BackIndex();
+}
+
+
+GraphRenderer::GraphRenderer()
+	:
+	fLock("graph renderer"),
+	fRunLock("graph renderer run"),
+	fThread(-1),
+	fWakeSem(-1),
+	fQuitting(false)
+{
+}
+
+
+GraphRenderer::~GraphRenderer()
+{
+	fLock.Lock();
+	fQuitting = true;
+	thread_id thread = fThread;
+	if (fWakeSem >= 0) {
+		delete_sem(fWakeSem);
+		fWakeSem = -1;
+	}
+	fLock.Unlock();
+
+	if (thread >= 0) {
+		status_t result;
+		wait_for_thread(thread, &result);
+	}
+}
+
+
+/*static*/ GraphRenderer&
+GraphRenderer::Default()
+{
+	static GraphRenderer sDefault;
+	return sDefault;
+}
+
+
+void
+GraphRenderer::Request(GraphRenderClient* client)
+{
+	if (client == NULL)
+		return;
+
+	fLock.Lock();
+	status_t status = _StartThread();
+	if (status == B_OK && std::find(fPending.begin(), fPending.end(), client)
+			== fPending.end()) {
+		try {
+			fPending.push_back(client);
+			release_sem(fWakeSem);
+		} catch (const std::bad_alloc&) {
+			status = B_NO_MEMORY;
+		}
+	}
+	fLock.Unlock();
+
+	if (status != B_OK)
+		client->RenderFrame();
+}
+
+
+void
+GraphRenderer::Remove(GraphRenderClient* client)
+{
+	fLock.Lock();
+	fPending.erase(std::remove(fPending.begin(), fPending.end(), client),
+		fPending.end());
+	bool isRenderThread = find_thread(NULL) == fThread;
+	fLock.Unlock();
+
+	// Wait until a frame that may still be rendering it is done
+	if (!isRenderThread) {
+		fRunLock.Lock();
+		fRunLock.Unlock();
+	}
+}
+
+
+status_t
+GraphRenderer::_StartThread()
+{
+	if (fThread >= 0)
+		return B_OK;
+	if (fQuitting)
+		return B_NOT_ALLOWED;
+
+	if (fWakeSem < 0) {
+		fWakeSem = create_sem(0, "graph renderer wake");
+		if (fWakeSem < 0)
+			return fWakeSem;
+	}
+
+	// Below the window threads, so that rendering never delays input
+	fThread = spawn_thread(_RenderThread, "graph renderer",
+		B_NORMAL_PRIORITY, this);
+	if (fThread < 0) {
+		status_t status = fThread;
+		fThread = -1;
+		return status;
+	}
+
+	resume_thread(fThread);
+	return B_OK;
+}
+
+
+/*static*/ status_t
+GraphRenderer::_RenderThread(void* data)
+{
+	static_cast<GraphRenderer*>(data)->_Run();
+	return B_OK;
+}
+
+
+void
+GraphRenderer::_Run()
+{
+	while (true) {
+		if (!fLock.Lock())
+			break;
+		if (fQuitting) {
+			fLock.Unlock();
+			break;
+		}
+		sem_id wakeSem = fWakeSem;
+		fLock.Unlock();
+
+		status_t status = acquire_sem(wakeSem);
+		if (status == B_INTERRUPTED)
+			continue;
+		if (status != B_OK)
+			break;
+
+		// One client at a time, so that one being removed in the meantime
+		// is never called
+		fRunLock.Lock();
+		while (true) {
+			fLock.Lock();
+			GraphRenderClient* client = NULL;
+			if (!fPending.empty()) {
+				client = fPending.front();
+				fPending.erase(fPending.begin());
+			}
+			fLock.Unlock();
+
+			if (client == NULL)
+				break;
+
+			client->RenderFrame();
+		}
+		fRunLock.Unlock();
+	}
+}
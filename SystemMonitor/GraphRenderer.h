@@ -0,0 +1,90 @@
+#ifndef GRAPHRENDERER_H
+#define GRAPHRENDERER_H
+
+#include <Locker.h>
+#include <OS.h>
+#include <vector>
+
+class BBitmap;
+
+
+// Sent by a view's RenderFrame() to itself once a new frame is ready to be
+// drawn.
+const uint32 kMsgGraphFrameReady = 'gfrd';
+
+
+// Implemented by views whose graphs are rendered off the window thread.
+class GraphRenderClient {
+public:
+	virtual				~GraphRenderClient() {}
+
+	// Called from the render thread, without the window locked: everything
+	// it needs from the view has to be handed over under a lock beforehand,
+	// and messages to the view must be sent with a timeout.
+	virtual	void		RenderFrame() = 0;
+};
+
+
+// Two bitmaps a graph is rendered into in turn. The render thread draws
+// into the back one while the window copies the front one to the screen,
+// and then swaps them; only the swap and the copy need the lock.
+class GraphFrameBuffers {
+public:
+							GraphFrameBuffers();
+							~GraphFrameBuffers();
+
+			// For the render thread, which owns the back buffer. Back() is
+			// at least width by height pixels, or NULL if out of memory.
+			BBitmap*		Back(int32 width, int32 height);
+			int32			BackIndex() const { return 1 - fFront; }
+			void			Swap();
+
+			// For the window, with the buffers locked
+			bool			Lock() { return fLock.Lock(); }
+			void			Unlock() { fLock.Unlock(); }
+			BBitmap*		Front() const { return fBitmaps[fFront]; }
+			int32			FrontIndex() const { return fFront; }
+
+private:
+			BLocker			fLock;
+			BBitmap*		fBitmaps[2];
+			int32			fFront;
+};
+
+
+// Renders the graphs of all windows on a single background thread, so the
+// window threads only copy finished frames to the screen and stay free for
+// input and list updates while dozens of graphs animate. Requests for a
+// client that is still waiting are merged into one frame.
+class GraphRenderer {
+public:
+	static	GraphRenderer&	Default();
+
+			// If the thread can't be started, the frame is rendered right
+			// away on the calling thread.
+			void			Request(GraphRenderClient* client);
+			// Once this returns, the client is no longer rendering and won't
+			// be called again until it is requested anew.
+			void			Remove(GraphRenderClient* client);
+
+private:
+							GraphRenderer();
+							~GraphRenderer();
+
+			status_t		_StartThread();
+
+	static	status_t		_RenderThread(void* data);
+			void			_Run();
+
+private:
+			BLocker			fLock;
+			// Held while a frame renders, so that removing its client can
+			// wait for it
+			BLocker			fRunLock;
+			std::vector<GraphRenderClient*> fPending;
+			thread_id		fThread;
+			sem_id			fWakeSem;
+			bool			fQuitting;
+};
+
+#endif // GRAPHRENDERER_H
@@ -0,0 +1,78 @@
+#include "GraphSampler.h"
+#include <math.h>
+#include <string.h>
+
+
+/*static*/ void
+GraphSampler::SampleValues(const DataHistory<float>* history, int32 field,
+	bigtime_t start, bigtime_t step, int32 count, float* lows, float* highs)
+{
+	// Nothing is known before the oldest sample; an empty history keeps
+	// showing 0, like its value
+	int32 empty = 0;
+	if (history->End() != 0) {
+		bigtime_t oldest = history->Start();
+		while (empty < count && start + empty * step < oldest) {
+			lows[empty] = highs[empty] = NAN;
+			empty++;
+		}
+	}
+
+	start += empty * step;
+	count -= empty;
+	lows += empty;
+	highs += empty;
+
+	// When zoomed out, draw the min/max envelope of each pixel from
+	// the history's level of detail pyramid instead of sampling.
+	int32 level = history->LevelFor(step);
+	if (level >= 0) {
+		int32 searchIndex = 0;
+		for (int32 j = 0; j < count; j++) {
+			_ColumnRange(history, field, start + j * step, step, level,
+				&searchIndex, lows[j], highs[j]);
+		}
+		return;
+	}
+
+	// Zoomed in: at most one sample per pixel, interpolate all columns in
+	// one pass over the history.
+	history->ResampleRange(start, step, count, highs, field);
+	memcpy(lows, highs, count * sizeof(float));
+}
+
+
+/*static*/ bool
+GraphSampler::GetEnvelope(const float* lows, const float* highs, int32 count,
+	float& min, float& max)
+{
+	bool found = false;
+	for (int32 j = 0; j < count; j++) {
+		// NAN never compares
+		if (!(lows[j] == lows[j]) || !(highs[j] == highs[j]))
+			continue;
+
+		if (!found || lows[j] < min)
+			min = lows[j];
+		if (!found || highs[j] > max)
+			max = highs[j];
+		found = true;
+	}
+
+	return found;
+}
+
+
+/*static*/ void
+GraphSampler::_ColumnRange(const DataHistory<float>* history, int32 field,
+	bigtime_t time, bigtime_t step, int32 level, int32* searchIndex,
+	float& low, float& high)
+{
+	if (history->EnvelopeAt(level, time - step + 1, time + 1, low, high,
+			searchIndex, field)) {
+		return;
+	}
+
+	// No sample within this pixel, interpolate instead
+	low = high = history->ValueAt(time, NULL, field);
+}
@@ -0,0 +1,34 @@
+#ifndef GRAPHSAMPLER_H
+#define GRAPHSAMPLER_H
+
+#include "DataHistory.h"
+
+
+// Samples a history into the columns of a graph. Each column gets the
+// envelope of the samples within it, or the interpolated value at its end
+// when zoomed in so far that there is at most one sample per column.
+// Columns from before the oldest sample, archived ones included, show
+// nothing and are NAN, so that they neither get drawn nor pull the scale
+// down to 0.
+class GraphSampler {
+public:
+			// Fills lows and highs with the envelopes of count columns,
+			// step apart from start. The metric has to be locked.
+	static	void		SampleValues(const DataHistory<float>* history,
+							int32 field, bigtime_t start, bigtime_t step,
+							int32 count, float* lows, float* highs);
+
+			// The smallest low and the largest high of count columns,
+			// leaving out those that are NAN. Returns false if all of
+			// them are.
+	static	bool		GetEnvelope(const float* lows, const float* highs,
+							int32 count, float& min, float& max);
+
+private:
+	static	void		_ColumnRange(const DataHistory<float>* history,
+							int32 field, bigtime_t time, bigtime_t step,
+							int32 level, int32* searchIndex, float& low,
+							float& high);
+};
+
+#endif // GRAPHSAMPLER_H
@@ -0,0 +1,132 @@
+#include "GraphTileCache.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <new>
+
+
+GraphTileCache::GraphTileCache(int32 capacity)
+	:
+	fCapacity(std::max((int32)1, capacity)),
+	fUseCount(0)
+{
+}
+
+
+void
+GraphTileCache::Clear()
+{
+	fTiles.clear();
+	fValues.clear();
+	fUseCount = 0;
+}
+
+
+void
+GraphTileCache::GetColumns(bigtime_t step, int64 first, int32 count,
+	int64 oldestStable, int64 newestStable, tile_sampler sampler,
+	void* cookie, float* lows, float* highs)
+{
+	int32 done = 0;
+	while (done < count) {
+		int64 column = first + done;
+		int64 index = _TileIndex(column);
+		int64 tileFirst = index * kTileWidth;
+		int32 offset = static_cast<int32>(column - tileFirst);
+		int32 length = std::min(count - done, kTileWidth - offset);
+
+		int32 slot = -1;
+		if (tileFirst >= oldestStable
+			&& tileFirst + kTileWidth - 1 <= newestStable) {
+			slot = _Find(step, index);
+			if (slot < 0) {
+				slot = _Add(step, index);
+				if (slot >= 0) {
+					sampler(cookie, tileFirst * step, step, kTileWidth,
+						_Lows(slot), _Highs(slot));
+				}
+			}
+		}
+
+		if (slot >= 0) {
+			memcpy(lows + done, _Lows(slot) + offset,
+				length * sizeof(float));
+			memcpy(highs + done, _Highs(slot) + offset,
+				length * sizeof(float));
+		} else {
+			// Not settled yet, or no memory to keep it
+			sampler(cookie, column * step, step, length, lows + done,
+				highs + done);
+		}
+
+		done += length;
+	}
+}
+
+
+int32
+GraphTileCache::_Find(bigtime_t step, int64 index)
+{
+	for (size_t i = 0; i < fTiles.size(); i++) {
+		if (fTiles[i].index == index && fTiles[i].step == step) {
+			fTiles[i].lastUse = ++fUseCount;
+			return static_cast<int32>(i);
+		}
+	}
+	return -1;
+}
+
+
+/*!	Makes room for a tile, dropping the least recently used one if the
+	cache is full. Returns the slot to fill in, or -1 without memory.
+*/
+int32
+GraphTileCache::_Add(bigtime_t step, int64 index)
+{
+	int32 slot;
+	if (static_cast<int32>(fTiles.size()) < fCapacity) {
+		try {
+			fValues.resize((fTiles.size() + 1) * 2 * kTileWidth);
+			fTiles.push_back(tile());
+		} catch (const std::bad_alloc&) {
+			return -1;
+		}
+		slot = static_cast<int32>(fTiles.size()) - 1;
+	} else {
+		slot = 0;
+		for (size_t i = 1; i < fTiles.size(); i++) {
+			if (fTiles[i].lastUse < fTiles[slot].lastUse)
+				slot = static_cast<int32>(i);
+		}
+	}
+
+	fTiles[slot].step = step;
+	fTiles[slot].index = index;
+	fTiles[slot].lastUse = ++fUseCount;
+	return slot;
+}
+
+
+float*
+GraphTileCache::_Lows(int32 slot)
+{
+	return fValues.data() + static_cast<size_t>(slot) * 2 * kTileWidth;
+}
+
+
+float*
+GraphTileCache::_Highs(int32 slot)
+{
+	return _Lows(slot) + kTileWidth;
+}
+
+
+/*static*/ int64
+GraphTileCache::_TileIndex(int64 column)
+{
+	// Rounds down for negative columns too
+	if (column >= 0)
+		return column / kTileWidth;
+	return -((-column + kTileWidth - 1) / kTileWidth);
+}
@@ -0,0 +1,68 @@
+#ifndef GRAPHTILECACHE_H
+#define GRAPHTILECACHE_H
+
+#if defined(__HAIKU__) || defined(BEOS)
+#include <SupportDefs.h>
+#endif
+
+#include <vector>
+
+
+// Fills lows and highs with the envelopes of count columns, step apart,
+// the first of which ends at start.
+typedef void (*tile_sampler)(void* cookie, bigtime_t start, bigtime_t step,
+	int32 count, float* lows, float* highs);
+
+
+// Keeps the envelopes of graph columns that have been sampled before, in
+// tiles of kTileWidth columns, so that panning through the past only
+// samples the columns that come into view for the first time, and going
+// back to a range that was already looked at costs nothing.
+//
+// Column c of a step ends at c * step, so tiles line up however far the
+// graph is panned. They are kept per step, so zooming back finds them
+// again; once the cache is full, the least recently used one is dropped.
+// The values are kept rather than pixels, so a new scale or size doesn't
+// throw anything away.
+class GraphTileCache {
+public:
+	enum {
+		kTileWidth = 256
+	};
+
+						GraphTileCache(int32 capacity = 64);
+
+			void		Clear();
+			int32		CountTiles() const { return fTiles.size(); }
+
+			// Fills lows and highs with the columns [first, first + count)
+			// of step. Only tiles that lie within the columns [oldestStable,
+			// newestStable] are kept; the others can still change, as
+			// samples arrive or are dropped, and are sampled every time.
+			void		GetColumns(bigtime_t step, int64 first, int32 count,
+							int64 oldestStable, int64 newestStable,
+							tile_sampler sampler, void* cookie, float* lows,
+							float* highs);
+
+private:
+	struct tile {
+		bigtime_t		step;
+		int64			index;
+		uint32			lastUse;
+	};
+
+			int32		_Find(bigtime_t step, int64 index);
+			int32		_Add(bigtime_t step, int64 index);
+			float*		_Lows(int32 slot);
+			float*		_Highs(int32 slot);
+	static	int64		_TileIndex(int64 column);
+
+private:
+	int32				fCapacity;
+	uint32				fUseCount;
+	std::vector<tile>	fTiles;
+	// The lows and then the highs of every tile, one after the other
+	std::vector<float>	fValues;
+};
+
+#endif // GRAPHTILECACHE_H
@@ -0,0 +1,175 @@
+#include "HeatmapTexture.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <new>
+
+#include "GraphRasterizer.h"
+
+
+HeatmapTexture::HeatmapTexture()
+	:
+	fBits(NULL),
+	fBytesPerRow(0),
+	fWidth(0),
+	fRows(0),
+	fOrigin(0),
+	fMin(0),
+	fScale(0)
+{
+	SetPalette(GraphRasterizer::MakePixel(255, 255, 255),
+		GraphRasterizer::MakePixel(0, 0, 0), 0, 1);
+}
+
+
+void
+HeatmapTexture::SetTarget(uint32* bits, int32 bytesPerRow, int32 width,
+	int32 rows)
+{
+	if (width < 0)
+		width = 0;
+	if (rows < 0)
+		rows = 0;
+
+	if (width != fWidth || rows != fRows)
+		fOrigin = 0;
+
+	fBits = bits;
+	fBytesPerRow = bytesPerRow;
+	fWidth = width;
+	fRows = rows;
+}
+
+
+void
+HeatmapTexture::SetPalette(uint32 low, uint32 high, float min, float max)
+{
+	for (uint32 i = 0; i < 256; i++)
+		fPalette[i] = GraphRasterizer::Blend(low, high, i);
+
+	fMin = min;
+	fScale = max > min ? 255.0f / (max - min) : 0;
+}
+
+
+void
+HeatmapTexture::Scroll(int32 pixels)
+{
+	if (pixels <= 0 || fWidth <= 0)
+		return;
+
+	fOrigin = (fOrigin + pixels % fWidth) % fWidth;
+}
+
+
+void
+HeatmapTexture::DrawColumn(int32 x, const float* values)
+{
+	if (fBits == NULL || values == NULL || x < 0 || x >= fWidth)
+		return;
+
+	uint8* pixels = reinterpret_cast<uint8*>(_Row(0) + _BufferColumn(x));
+	for (int32 row = 0; row < fRows; row++) {
+		*reinterpret_cast<uint32*>(pixels + static_cast<size_t>(row)
+			* fBytesPerRow) = PixelFor(values[row]);
+	}
+}
+
+
+void
+HeatmapTexture::DrawRow(int32 row, int32 firstX, int32 count,
+	const float* values)
+{
+	if (fBits == NULL || values == NULL || row < 0 || row >= fRows)
+		return;
+
+	if (firstX < 0) {
+		count += firstX;
+		values -= firstX;
+		firstX = 0;
+	}
+	if (firstX + count > fWidth)
+		count = fWidth - firstX;
+
+	// The columns may wrap around the end of the buffer
+	uint32* pixels = _Row(row);
+	int32 column = _BufferColumn(firstX);
+	for (int32 j = 0; j < count; j++) {
+		pixels[column] = PixelFor(values[j]);
+		if (++column == fWidth)
+			column = 0;
+	}
+}
+
+
+status_t
+HeatmapTexture::PermuteRows(const int32* order)
+{
+	if (fBits == NULL || order == NULL || fRows <= 1)
+		return B_OK;
+
+	// Follow each cycle of the permutation with a single spare row, rather
+	// than copying the whole image
+	std::vector<uint32> spare;
+	std::vector<bool> done;
+	try {
+		spare.resize(fWidth);
+		done.assign(fRows, false);
+	} catch (const std::bad_alloc&) {
+		return B_NO_MEMORY;
+	}
+
+	size_t rowBytes = static_cast<size_t>(fWidth) * sizeof(uint32);
+	for (int32 start = 0; start < fRows; start++) {
+		if (done[start] || order[start] == start) {
+			done[start] = true;
+			continue;
+		}
+
+		memcpy(spare.data(), _Row(start), rowBytes);
+		int32 row = start;
+		while (true) {
+			done[row] = true;
+			int32 source = order[row];
+			if (source == start) {
+				memcpy(_Row(row), spare.data(), rowBytes);
+				break;
+			}
+			memcpy(_Row(row), _Row(source), rowBytes);
+			row = source;
+		}
+	}
+
+	return B_OK;
+}
+
+
+uint32
+HeatmapTexture::PixelFor(float value) const
+{
+	float index = (value - fMin) * fScale;
+	// Also catches NaN
+	if (!(index > 0.0f))
+		return fPalette[0];
+	if (index >= 255.0f)
+		return fPalette[255];
+
+	return fPalette[static_cast<int32>(index + 0.5f)];
+}
+
+
+int32
+HeatmapTexture::_BufferColumn(int32 x) const
+{
+	x += fOrigin;
+	return x < fWidth ? x : x - fWidth;
+}
+
+
+uint32*
+HeatmapTexture::_Row(int32 row) const
+{
+	return reinterpret_cast<uint32*>(reinterpret_cast<uint8*>(fBits)
+		+ static_cast<size_t>(row) * fBytesPerRow);
+}
@@ -0,0 +1,63 @@
+#ifndef HEATMAPTEXTURE_H
+#define HEATMAPTEXTURE_H
+
+#if defined(__HAIKU__) || defined(BEOS)
+#include <SupportDefs.h>
+#endif
+
+#include <vector>
+
+
+// Draws a heatmap straight into a 32 bit pixel buffer (B_RGB32): one pixel
+// row per series, one pixel column per point in time, and the value as the
+// colour, looked up in a palette that blends from a low to a high colour.
+//
+// Like GraphRasterizer the buffer is a ring of columns, so scrolling only
+// moves the origin and adding a point in time writes a single column: the
+// cost of an update is one pixel per row. Whoever shows the buffer has to
+// copy it in two parts, split at the origin.
+class HeatmapTexture {
+public:
+						HeatmapTexture();
+
+			void		SetTarget(uint32* bits, int32 bytesPerRow,
+							int32 width, int32 rows);
+			// Values at or below min get the low colour, at or above max the
+			// high one; NaN, for no data, gets the low colour as well.
+			void		SetPalette(uint32 low, uint32 high, float min,
+							float max);
+
+			// Moves the whole image left by moving the origin; the columns
+			// that come in on the right have to be drawn.
+			void		Scroll(int32 pixels);
+			// The buffer column that holds column 0 of the image.
+			int32		Origin() const { return fOrigin; }
+
+			// Draws column x of the image, with values[row] for each row.
+			void		DrawColumn(int32 x, const float* values);
+			// Draws the columns [firstX, firstX + count) of a single row.
+			void		DrawRow(int32 row, int32 firstX, int32 count,
+							const float* values);
+			// Reorders the rows, so that row i ends up with what row
+			// order[i] had before. order has to be a permutation.
+			status_t	PermuteRows(const int32* order);
+
+			uint32		PixelFor(float value) const;
+
+private:
+			int32		_BufferColumn(int32 x) const;
+			uint32*		_Row(int32 row) const;
+
+private:
+			uint32*		fBits;
+			int32		fBytesPerRow;
+			int32		fWidth;
+			int32		fRows;
+			int32		fOrigin;
+
+			float		fMin;
+			float		fScale;
+			uint32		fPalette[256];
+};
+
+#endif // HEATMAPTEXTURE_H
@@ -0,0 +1,250 @@
+#include "HistogramToolTip.h"
+
+#include <InterfaceDefs.h>
+#include <View.h>
+
+#include <algorithm>
+#include <math.h>
+#include <new>
+#include <string.h>
+#include <vector>
+
+
+static const float kInset = 4;
+
+
+class HistogramToolTip::HistogramView : public BView {
+public:
+							HistogramView();
+
+	virtual	void			AttachedToWindow();
+	virtual	void			Draw(BRect updateRect);
+	virtual	BSize			MinSize();
+	virtual	BSize			MaxSize();
+	virtual	BSize			PreferredSize();
+
+			void			SetText(const char* text);
+			void			SetHistogram(const uint32* bins, int32 count,
+								const char* minLabel, const char* maxLabel,
+								rgb_color color);
+
+private:
+			float			_LineHeight();
+			float			_ChartHeight();
+
+private:
+			std::vector<BString> fLines;
+			uint32			fBins[kMaxBins];
+			int32			fBinCount;
+			BString			fMinLabel;
+			BString			fMaxLabel;
+			rgb_color		fColor;
+};
+
+
+HistogramToolTip::HistogramView::HistogramView()
+	:
+	BView("histogram tool tip", B_WILL_DRAW),
+	fBinCount(0)
+{
+	memset(fBins, 0, sizeof(fBins));
+	fColor = ui_color(B_TOOL_TIP_TEXT_COLOR);
+}
+
+
+void
+HistogramToolTip::HistogramView::AttachedToWindow()
+{
+	BView::AttachedToWindow();
+	SetViewUIColor(B_TOOL_TIP_BACKGROUND_COLOR);
+	SetLowUIColor(B_TOOL_TIP_BACKGROUND_COLOR);
+	SetHighUIColor(B_TOOL_TIP_TEXT_COLOR);
+}
+
+
+void
+HistogramToolTip::HistogramView::Draw(BRect updateRect)
+{
+	font_height fontHeight;
+	GetFontHeight(&fontHeight);
+	float lineHeight = _LineHeight();
+	BRect bounds = Bounds();
+
+	SetHighUIColor(B_TOOL_TIP_TEXT_COLOR);
+	float y = kInset + ceilf(fontHeight.ascent);
+	for (size_t i = 0; i < fLines.size(); i++) {
+		DrawString(fLines[i].String(), BPoint(kInset, y));
+		y += lineHeight;
+	}
+
+	if (fBinCount == 0)
+		return;
+
+	uint32 largest = *std::max_element(fBins, fBins + fBinCount);
+	BRect chart(kInset, y - ceilf(fontHeight.ascent) + kInset,
+		bounds.right - kInset, 0);
+	chart.bottom = chart.top + _ChartHeight() - 1;
+
+	SetHighColor(fColor);
+	float binWidth = chart.Width() / fBinCount;
+	for (int32 i = 0; i < fBinCount && largest > 0; i++) {
+		if (fBins[i] == 0)
+			continue;
+		// Even a single value shows up
+		float height = std::max(1.0f,
+			roundf(chart.Height() * fBins[i] / largest));
+		BRect bar(floorf(chart.left + i * binWidth), chart.bottom - height + 1,
+			floorf(chart.left + (i + 1) * binWidth) - 1, chart.bottom);
+		FillRect(bar);
+	}
+
+	SetHighUIColor(B_TOOL_TIP_TEXT_COLOR);
+	StrokeLine(BPoint(chart.left, chart.bottom + 1),
+		BPoint(chart.right, chart.bottom + 1));
+
+	y = chart.bottom + 2 + ceilf(fontHeight.ascent);
+	DrawString(fMinLabel.String(), BPoint(chart.left, y));
+	DrawString(fMaxLabel.String(),
+		BPoint(chart.right - StringWidth(fMaxLabel.String()), y));
+}
+
+
+BSize
+HistogramToolTip::HistogramView::MinSize()
+{
+	return PreferredSize();
+}
+
+
+BSize
+HistogramToolTip::HistogramView::MaxSize()
+{
+	return PreferredSize();
+}
+
+
+BSize
+HistogramToolTip::HistogramView::PreferredSize()
+{
+	float width = 0;
+	for (size_t i = 0; i < fLines.size(); i++)
+		width = std::max(width, StringWidth(fLines[i].String()));
+
+	float height = fLines.size() * _LineHeight();
+	if (fBinCount > 0) {
+		BFont font;
+		GetFont(&font);
+		width = std::max(width, std::max(font.Size() * 12,
+			StringWidth(fMinLabel.String()) + StringWidth(fMaxLabel.String())
+				+ font.Size()));
+		height += kInset + _ChartHeight() + 2 + _LineHeight();
+	}
+
+	return BSize(ceilf(width + 2 * kInset) - 1, ceilf(height + 2 * kInset) - 1);
+}
+
+
+void
+HistogramToolTip::HistogramView::SetText(const char* text)
+{
+	fLines.clear();
+	try {
+		const char* start = text;
+		while (true) {
+			const char* end = strchr(start, '\n');
+			if (end == NULL) {
+				fLines.push_back(BString(start));
+				break;
+			}
+			fLines.push_back(BString(start, end - start));
+			start = end + 1;
+		}
+	} catch (const std::bad_alloc&) {
+		// Shows the lines there was room for
+	}
+}
+
+
+void
+HistogramToolTip::HistogramView::SetHistogram(const uint32* bins, int32 count,
+	const char* minLabel, const char* maxLabel, rgb_color color)
+{
+	fBinCount = std::max((int32)0, std::min(count, (int32)kMaxBins));
+	memcpy(fBins, bins, fBinCount * sizeof(uint32));
+	fMinLabel = minLabel;
+	fMaxLabel = maxLabel;
+	fColor = color;
+}
+
+
+float
+HistogramToolTip::HistogramView::_LineHeight()
+{
+	font_height fontHeight;
+	GetFontHeight(&fontHeight);
+	return ceilf(fontHeight.ascent + fontHeight.descent + fontHeight.leading);
+}
+
+
+float
+HistogramToolTip::HistogramView::_ChartHeight()
+{
+	return ceilf(_LineHeight() * 2.5f);
+}
+
+
+// #pragma mark -
+
+
+HistogramToolTip::HistogramToolTip()
+	:
+	fView(new HistogramView)
+{
+}
+
+
+HistogramToolTip::~HistogramToolTip()
+{
+	delete fView;
+}
+
+
+BView*
+HistogramToolTip::View() const
+{
+	return fView;
+}
+
+
+void
+HistogramToolTip::SetText(const char* text)
+{
+	// Only locks while shown, the view is in the tooltip's window then
+	bool locked = Lock();
+	fView->SetText(text);
+	if (locked) {
+		_Changed();
+		Unlock();
+	}
+}
+
+
+void
+HistogramToolTip::SetHistogram(const uint32* bins, int32 count,
+	const char* minLabel, const char* maxLabel, rgb_color color)
+{
+	bool locked = Lock();
+	fView->SetHistogram(bins, count, minLabel, maxLabel, color);
+	if (locked) {
+		_Changed();
+		Unlock();
+	}
+}
+
+
+void
+HistogramToolTip::_Changed()
+{
+	fView->InvalidateLayout();
+	fView->Invalidate();
+}
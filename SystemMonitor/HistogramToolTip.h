@@ -0,0 +1,38 @@
+#ifndef HISTOGRAMTOOLTIP_H
+#define HISTOGRAMTOOLTIP_H
+
+#include <String.h>
+#include <ToolTip.h>
+
+
+// A tooltip with a few lines of text over a bar chart of how a metric's
+// values were distributed during the last hour, as its QuantileSketch
+// has them. Graphs keep one and update it for every GetToolTipAt().
+class HistogramToolTip : public BToolTip {
+public:
+	enum {
+		kMaxBins = 32
+	};
+
+							HistogramToolTip();
+	virtual					~HistogramToolTip();
+
+	virtual	BView*			View() const;
+
+			void			SetText(const char* text);
+			// The bins are spread evenly between the values of the two
+			// labels; a count of 0 shows no chart.
+			void			SetHistogram(const uint32* bins, int32 count,
+								const char* minLabel, const char* maxLabel,
+								rgb_color color);
+
+private:
+	class HistogramView;
+
+			void			_Changed();
+
+private:
+			HistogramView*	fView;
+};
+
+#endif // HISTOGRAMTOOLTIP_H
@@ -0,0 +1,390 @@
+#include "HistoryFile.h"
+
+#include <Directory.h>
+#include <FindDirectory.h>
+#include <Path.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+
+static const uint32 kHistoryFileMagic = 'SMhf';
+static const uint32 kHistoryFileVersion = 4;
+
+
+HistoryFile::HistoryFile()
+	:
+	fFD(-1),
+	fHeader(NULL),
+	fRecords(NULL),
+	fMappedSize(0),
+	fHead(0),
+	fClockOffset(0)
+{
+}
+
+
+HistoryFile::~HistoryFile()
+{
+	Close();
+}
+
+
+status_t
+HistoryFile::Open(const char* name, int32 fieldCount, uint32 capacity)
+{
+	Close();
+
+	if (name == NULL || name[0] == '\0' || fieldCount <= 0 || capacity == 0)
+		return B_BAD_VALUE;
+
+	BPath path;
+	status_t status = find_directory(B_USER_SETTINGS_DIRECTORY, &path, true);
+	if (status != B_OK)
+		return status;
+
+	path.Append("SysMonTask/history");
+	status = create_directory(path.Path(), 0755);
+	if (status != B_OK)
+		return status;
+	path.Append(name);
+
+	fFD = open(path.Path(), O_RDWR | O_CREAT, 0644);
+	if (fFD < 0)
+		return errno;
+
+	// Keep what an earlier refresh rate has sized the file for
+	struct stat st;
+	file_header header;
+	if (fstat(fFD, &st) == 0
+		&& pread(fFD, &header, sizeof(header), 0) == sizeof(header)
+		&& _IsValid(&header, fieldCount, header.capacity)
+		&& st.st_size == (off_t)_FileSize(fieldCount, header.capacity)) {
+		capacity = header.capacity;
+	}
+
+	size_t size = _FileSize(fieldCount, capacity);
+	bool resized = false;
+	if (fstat(fFD, &st) != 0 || st.st_size != (off_t)size) {
+		if (ftruncate(fFD, size) != 0) {
+			status = errno;
+			Close();
+			return status;
+		}
+		resized = true;
+	}
+
+	status = _Map(size);
+	if (status != B_OK) {
+		Close();
+		return status;
+	}
+
+	fClockOffset = real_time_clock_usecs() - system_time();
+
+	if (resized || !_IsValid(fHeader, fieldCount, capacity)) {
+		fHeader->fieldCount = fieldCount;
+		_Initialize(capacity);
+	} else
+		_FindHead();
+
+	return B_OK;
+}
+
+
+void
+HistoryFile::Close()
+{
+	_Unmap();
+
+	if (fFD >= 0)
+		close(fFD);
+	fFD = -1;
+}
+
+
+int32
+HistoryFile::CountFields() const
+{
+	return fHeader != NULL ? static_cast<int32>(fHeader->fieldCount) : 0;
+}
+
+
+uint32
+HistoryFile::Capacity() const
+{
+	return fHeader != NULL ? fHeader->capacity : 0;
+}
+
+
+status_t
+HistoryFile::SetCapacity(uint32 capacity)
+{
+	if (fHeader == NULL)
+		return B_NO_INIT;
+	if (capacity == 0)
+		return B_BAD_VALUE;
+	if (capacity == fHeader->capacity)
+		return B_OK;
+
+	int32 fieldCount = fHeader->fieldCount;
+	size_t recordSize = fHeader->recordSize;
+	uint32 count = CountRecords();
+	uint32 kept = std::min(count, capacity);
+	std::vector<uint8> records;
+	try {
+		records.reserve(kept * recordSize);
+	} catch (const std::bad_alloc&) {
+		return B_NO_MEMORY;
+	}
+
+	for (uint32 index = count - kept; index < count; index++) {
+		uint64 sequence = fHead - count + index;
+		const file_record* record = _RecordAt(sequence);
+		if (_IsValid(record, sequence)) {
+			const uint8* bytes = reinterpret_cast<const uint8*>(record);
+			records.insert(records.end(), bytes, bytes + recordSize);
+		}
+	}
+
+	_Unmap();
+
+	size_t size = _FileSize(fieldCount, capacity);
+	status_t status = B_OK;
+	if (ftruncate(fFD, size) != 0)
+		status = errno;
+	else
+		status = _Map(size);
+	if (status != B_OK) {
+		Close();
+		return status;
+	}
+
+	_Initialize(capacity);
+	for (size_t offset = 0; offset < records.size(); offset += recordSize) {
+		const file_record* record
+			= reinterpret_cast<const file_record*>(&records[offset]);
+		_Append(record->time, _Values(record));
+	}
+
+	return B_OK;
+}
+
+
+void
+HistoryFile::AddValues(bigtime_t time, const float* values)
+{
+	if (fHeader == NULL)
+		return;
+
+	_Append(time + fClockOffset, values);
+}
+
+
+uint32
+HistoryFile::CountRecords() const
+{
+	if (fHeader == NULL)
+		return 0;
+
+	if (fHead < fHeader->capacity)
+		return static_cast<uint32>(fHead);
+	return fHeader->capacity;
+}
+
+
+bool
+HistoryFile::RecordAt(uint32 index, bigtime_t& time, float* values) const
+{
+	uint32 count = CountRecords();
+	if (index >= count)
+		return false;
+
+	uint64 sequence = fHead - count + index;
+	const file_record* record = _RecordAt(sequence);
+	if (!_IsValid(record, sequence))
+		return false;
+
+	time = record->time - fClockOffset;
+	memcpy(values, _Values(record), fHeader->fieldCount * sizeof(float));
+	return true;
+}
+
+
+/*static*/ size_t
+HistoryFile::RecordSize(int32 fieldCount)
+{
+	// Padded to keep the times of the next record aligned
+	size_t size = sizeof(file_record) + fieldCount * sizeof(float);
+	return (size + sizeof(uint64) - 1) & ~(sizeof(uint64) - 1);
+}
+
+
+status_t
+HistoryFile::_Map(size_t size)
+{
+	void* address = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fFD,
+		0);
+	if (address == MAP_FAILED)
+		return errno;
+
+	fHeader = static_cast<file_header*>(address);
+	fRecords = reinterpret_cast<uint8*>(fHeader + 1);
+	fMappedSize = size;
+	return B_OK;
+}
+
+
+void
+HistoryFile::_Unmap()
+{
+	if (fHeader != NULL)
+		munmap(fHeader, fMappedSize);
+
+	fHeader = NULL;
+	fRecords = NULL;
+	fMappedSize = 0;
+}
+
+
+/*!	Expects the field count to be set already, as it is kept across
+	capacity changes.
+*/
+void
+HistoryFile::_Initialize(uint32 capacity)
+{
+	fHeader->magic = kHistoryFileMagic;
+	fHeader->version = kHistoryFileVersion;
+	fHeader->capacity = capacity;
+	fHeader->recordSize = RecordSize(fHeader->fieldCount);
+	fHeader->checksum = _HeaderChecksum(fHeader);
+
+	// Records left over from before would be taken for new ones
+	memset(fRecords, 0, capacity * fHeader->recordSize);
+	fHead = 0;
+}
+
+
+void
+HistoryFile::_Append(bigtime_t wallTime, const float* values)
+{
+	file_record* record = _RecordAt(fHead);
+	record->time = wallTime;
+	record->sequence = fHead;
+	memcpy(_Values(record), values, fHeader->fieldCount * sizeof(float));
+	record->check = _RecordCheck(record);
+
+	fHead++;
+}
+
+
+/*!	The ring continues after the newest intact record. A record torn by a
+	crash is left out, and the slots around it are still found by their own
+	sequence numbers.
+*/
+void
+HistoryFile::_FindHead()
+{
+	uint32 capacity = fHeader->capacity;
+	fHead = 0;
+	for (uint32 i = 0; i < capacity; i++) {
+		const file_record* record = _RecordAt(i);
+		if (record->sequence % capacity == i
+			&& record->check == _RecordCheck(record)
+			&& record->sequence >= fHead) {
+			fHead = record->sequence + 1;
+		}
+	}
+}
+
+
+HistoryFile::file_record*
+HistoryFile::_RecordAt(uint64 sequence) const
+{
+	size_t slot = sequence % fHeader->capacity;
+	return reinterpret_cast<file_record*>(
+		fRecords + slot * fHeader->recordSize);
+}
+
+
+bool
+HistoryFile::_IsValid(const file_record* record, uint64 sequence) const
+{
+	return record->sequence == sequence
+		&& record->check == _RecordCheck(record);
+}
+
+
+uint64
+HistoryFile::_RecordCheck(const file_record* record) const
+{
+	// Starting from the sequence number rather than zero keeps a slot that
+	// was never written, all zeros, from passing.
+	uint64 hash = (record->sequence + 1) * 0x9e3779b97f4a7c15ULL;
+	hash = (hash ^ static_cast<uint64>(record->time)) * 0xbf58476d1ce4e5b9ULL;
+
+	const float* values = _Values(record);
+	for (uint32 i = 0; i < fHeader->fieldCount; i++) {
+		uint32 valueBits;
+		memcpy(&valueBits, &values[i], sizeof(valueBits));
+		hash = (hash ^ valueBits) * 0x94d049bb133111ebULL;
+	}
+	return hash ^ (hash >> 31);
+}
+
+
+/*static*/ size_t
+HistoryFile::_FileSize(int32 fieldCount, uint32 capacity)
+{
+	return sizeof(file_header) + capacity * RecordSize(fieldCount);
+}
+
+
+/*static*/ bool
+HistoryFile::_IsValid(const file_header* header, int32 fieldCount,
+	uint32 capacity)
+{
+	return header->magic == kHistoryFileMagic
+		&& header->version == kHistoryFileVersion
+		&& header->capacity == capacity && capacity > 0
+		&& header->fieldCount == static_cast<uint32>(fieldCount)
+		&& header->recordSize == RecordSize(fieldCount)
+		&& header->checksum == _HeaderChecksum(header);
+}
+
+
+/*static*/ uint32
+HistoryFile::_HeaderChecksum(const file_header* header)
+{
+	// FNV-1a over everything but the checksum itself
+	const uint8* bytes = reinterpret_cast<const uint8*>(header);
+	uint32 hash = 2166136261U;
+	for (size_t i = 0; i < offsetof(file_header, checksum); i++) {
+		hash ^= bytes[i];
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+
+/*static*/ float*
+HistoryFile::_Values(file_record* record)
+{
+	return reinterpret_cast<float*>(record + 1);
+}
+
+
+/*static*/ const float*
+HistoryFile::_Values(const file_record* record)
+{
+	return reinterpret_cast<const float*>(record + 1);
+}
@@ -0,0 +1,89 @@
+#ifndef HISTORYFILE_H
+#define HISTORYFILE_H
+
+#include <OS.h>
+
+
+// A fixed size ring of samples in a memory mapped file, so graphs come back
+// populated after a restart. Samples are written through as they arrive;
+// records store wall clock times since system_time() starts over on boot.
+// All fields of a sample share one record, so a metric with many fields
+// needs a single file and a single time stamp per sample.
+// The header carries a version and checksum, and every record its own
+// sequence number and check value, so a torn write or an old format is
+// dropped instead of read. Only records are written once the file is set
+// up; where the ring continues is found again from them on opening.
+class HistoryFile {
+public:
+						HistoryFile();
+						~HistoryFile();
+
+			// An intact file keeps the capacity it was created with; only
+			// new or damaged ones, or ones with another field count, get
+			// the one given.
+			status_t	Open(const char* name, int32 fieldCount,
+							uint32 capacity);
+			void		Close();
+			bool		IsOpen() const { return fHeader != NULL; }
+
+			int32		CountFields() const;
+			uint32		Capacity() const;
+			// Keeps the newest records that still fit.
+			status_t	SetCapacity(uint32 capacity);
+
+			void		AddValues(bigtime_t time, const float* values);
+
+			// Records are returned oldest first, with their time converted
+			// back to system_time(). Returns false for damaged records.
+			uint32		CountRecords() const;
+			bool		RecordAt(uint32 index, bigtime_t& time,
+							float* values) const;
+
+	static	size_t		RecordSize(int32 fieldCount);
+
+private:
+	struct file_header {
+		uint32		magic;
+		uint32		version;
+		uint32		capacity;
+		uint32		recordSize;
+		uint32		fieldCount;
+		uint32		checksum;
+	};
+
+	// Followed by the values of all fields
+	struct file_record {
+		bigtime_t	time;
+		// Counts all records ever appended, so slot i holds a sequence
+		// with sequence % capacity == i
+		uint64		sequence;
+		uint64		check;
+	};
+
+			status_t	_Map(size_t size);
+			void		_Unmap();
+			void		_Initialize(uint32 capacity);
+			void		_Append(bigtime_t wallTime, const float* values);
+			void		_FindHead();
+			file_record* _RecordAt(uint64 sequence) const;
+			bool		_IsValid(const file_record* record,
+							uint64 sequence) const;
+			uint64		_RecordCheck(const file_record* record) const;
+	static	size_t		_FileSize(int32 fieldCount, uint32 capacity);
+	static	bool		_IsValid(const file_header* header,
+							int32 fieldCount, uint32 capacity);
+	static	uint32		_HeaderChecksum(const file_header* header);
+	static	float*		_Values(file_record* record);
+	static	const float* _Values(const file_record* record);
+
+private:
+	int					fFD;
+	file_header*		fHeader;
+	uint8*				fRecords;
+	size_t				fMappedSize;
+	// The sequence number of the next record
+	uint64				fHead;
+	bigtime_t			fClockOffset;
+};
+
+#endif // HISTORYFILE_H
@@ -1,9 +1,9 @@
 #include "MemView.h"
 #include "Utils.h"
+#include "SystemInfoCache.h"
 #include <Box.h>
 #include <GridLayout.h>
 #include <GroupLayoutBuilder.h>
-#include <Autolock.h>
 #include <SpaceLayoutItem.h>
 #include <StringView.h>
 #include <cstdio>
@@ -17,17 +17,21 @@
 #undef B_TRANSLATION_CONTEXT
 #define B_TRANSLATION_CONTEXT "MemView"
 
-
 // MemView Implementation
 MemView::MemView()
-	: BView("MemoryView", B_WILL_DRAW | B_PULSE_NEEDED),
-	  fCacheGraphView(NULL),
-	  fCurrentUsage(0.0f),
+	: BView("MemoryView", B_WILL_DRAW),
+	  fMemoryGraph(NULL),
+	  fMetric(-1),
+	  fRefreshInterval(1000000),
+	  fPerformanceViewVisible(true),
+	  fSnapshotSequence(0),
 	  fLastUsedBytes(0),
 	  fLastFreeBytes(0),
 	  fLastCachedBytes(0)
 {
 	SetViewColor(ui_color(B_PANEL_BACKGROUND_COLOR));
+	fMetric = MetricRegistry::Default().Register(METRIC_MEMORY,
+		kMemoryFieldCount);
 
 	BBox* statsBox = new BBox("MemoryStatsBox");
 	statsBox->SetLabel(B_TRANSLATE("Memory Statistics"));
@@ -64,21 +68,29 @@ MemView::MemView()
 	gridLayout->SetColumnWeight(2, 1.0f);
 	statsBox->SetLayout(gridLayout);
 
-	fCacheGraphView = new ActivityGraphView("cacheGraph", {0, 0, 0, 0}, B_MENU_SELECTION_BACKGROUND_COLOR);
-	fCacheGraphView->SetExplicitMinSize(BSize(0, 60));
-	fCacheGraphView->SetExplicitMaxSize(BSize(B_SIZE_UNLIMITED, 100));
-	fCacheGraphView->SetManualScale(0, 1000);
+	// Used and cached memory stacked, what's left above them is free
+	fMemoryGraph = new StackedGraphView("memoryGraph");
+	fMemoryGraph->SetExplicitMinSize(BSize(0, 60));
+	fMemoryGraph->SetExplicitMaxSize(BSize(B_SIZE_UNLIMITED, 100));
+	fMemoryGraph->SetManualScale(100);
+	fMemoryGraph->SetMetric(fMetric);
+	fMemoryGraph->AddLayer(kMemoryUsedField, B_TRANSLATE("Used"),
+		B_MENU_SELECTION_BACKGROUND_COLOR);
+	fMemoryGraph->AddLayer(kMemoryCacheField, B_TRANSLATE("Cached"),
+		B_SUCCESS_COLOR);
+	fMemoryGraph->SetValueFormatter(FormatGraphPercent);
 
 	BLayoutBuilder::Group<>(this, B_VERTICAL, B_USE_DEFAULT_SPACING)
 		.SetInsets(B_USE_DEFAULT_SPACING)
 		.Add(statsBox)
-		.Add(fCacheGraphView)
+		.Add(fMemoryGraph)
 		.AddGlue();
 }
 
 MemView::~MemView()
 {
 	// Child views are deleted automatically
+	SamplingScheduler::Default().RemoveCollector(this);
 }
 
 void MemView::AttachedToWindow()
@@ -96,28 +108,80 @@ void MemView::AttachedToWindow()
 		fTotalMemValue->SetText(B_TRANSLATE("Error"));
 	}
 
-	UpdateData();
+	// The labels are updated whenever a new sample has been published
+	MetricRegistry::Default().StartWatching(fMetric, BMessenger(this));
+
+	SamplingScheduler& scheduler = SamplingScheduler::Default();
+	// Always sampling, so the history has no gaps while hidden
+	scheduler.AddCollector(this, fRefreshInterval);
+	scheduler.Trigger(this);
 }
 
-void MemView::Pulse()
+void MemView::DetachedFromWindow()
 {
-	if (IsHidden())
-		return;
-	UpdateData();
+	MetricRegistry::Default().StopWatching(fMetric, BMessenger(this));
+	SamplingScheduler::Default().RemoveCollector(this);
+	BView::DetachedFromWindow();
 }
 
-void MemView::UpdateData()
+void MemView::MessageReceived(BMessage* message)
 {
-	fLocker.Lock();
+	if (message->what == kMsgMetricUpdated) {
+		if (fPerformanceViewVisible)
+			_UpdateLabels();
+		return;
+	}
+	BView::MessageReceived(message);
+}
 
-	uint64 usedBytes, totalBytes, physical;
-	GetMemoryUsage(usedBytes, totalBytes, physical);
+void MemView::Collect(bigtime_t now)
+{
+	memory_snapshot snapshot;
+	uint64 physical;
+	GetMemoryUsage(snapshot.used, snapshot.total, physical, now);
 
 	system_info sysInfo;
-	if (totalBytes > 0 && get_system_info(&sysInfo) == B_OK) {
-		uint64 freeBytes = totalBytes - usedBytes;
+	snapshot.valid = snapshot.total > 0
+		&& SystemInfoCache::Default().GetSystemInfo(sysInfo, now) == B_OK;
+	snapshot.cached = snapshot.valid ? GetCachedMemoryBytes(sysInfo) : 0;
+
+	// Written before publishing, so the notification finds it
+	fSnapshot.Write(snapshot);
+
+	if (!snapshot.valid) {
+		// Nothing gets published, let the labels show the error directly.
+		// Never block on the window, it might be waiting for the scheduler.
+		BMessage message(kMsgMetricUpdated);
+		BMessenger(this).SendMessage(&message, (BHandler*)NULL, 0);
+		return;
+	}
+
+	float values[kMemoryFieldCount];
+	float& usedPercent = values[kMemoryUsedField];
+	usedPercent = static_cast<float>(snapshot.used) / snapshot.total * 100.0f;
+	if (usedPercent < 0.0f) usedPercent = 0.0f;
+	if (usedPercent > 100.0f) usedPercent = 100.0f;
+
+	float& cachePercent = values[kMemoryCacheField];
+	cachePercent = static_cast<float>(snapshot.cached) / snapshot.total * 100.0f;
+	if (cachePercent < 0.0f) cachePercent = 0.0f;
+	if (cachePercent > 100.0f) cachePercent = 100.0f;
+	MetricRegistry::Default().Publish(fMetric, now, values);
+}
 
-		uint64 cachedBytes = GetCachedMemoryBytes(sysInfo);
+void MemView::_UpdateLabels()
+{
+	memory_snapshot snapshot;
+	uint32 sequence = fSnapshot.Read(snapshot);
+	if (sequence == fSnapshotSequence)
+		return;
+	fSnapshotSequence = sequence;
+
+	if (snapshot.valid) {
+		uint64 usedBytes = snapshot.used;
+		uint64 totalBytes = snapshot.total;
+		uint64 freeBytes = totalBytes - usedBytes;
+		uint64 cachedBytes = snapshot.cached;
 
 		// Total memory is set in AttachedToWindow
 		if (usedBytes != fLastUsedBytes) {
@@ -142,38 +206,27 @@ void MemView::UpdateData()
 			::FormatBytes(fCachedCachedStr, cachedBytes);
 			fCachedMemValue->SetText(fCachedCachedStr.String());
 		}
-
-		if (totalBytes > 0) {
-			float usedPercent = static_cast<float>(usedBytes) / totalBytes * 100.0f;
-			if (usedPercent < 0.0f) usedPercent = 0.0f;
-			if (usedPercent > 100.0f) usedPercent = 100.0f;
-			fCurrentUsage = usedPercent;
-
-			float cachePercent = static_cast<float>(cachedBytes) / totalBytes * 100.0f;
-			if (cachePercent < 0.0f) cachePercent = 0.0f;
-			if (cachePercent > 100.0f) cachePercent = 100.0f;
-			fCacheGraphView->AddValue(system_time(), cachePercent * 10);
-		}
-
 	} else {
 		// fTotalMemValue is handled in AttachedToWindow or stays as is
 		fUsedMemValue->SetText(B_TRANSLATE("Error"));
 		fFreeMemValue->SetText(B_TRANSLATE("Error"));
 		fCachedMemValue->SetText(B_TRANSLATE("Error"));
 	}
-
-	fLocker.Unlock();
 }
 
-float MemView::GetCurrentUsage()
+void MemView::SetRefreshInterval(bigtime_t interval)
 {
-	BAutolock locker(fLocker);
-	return fCurrentUsage;
+	fRefreshInterval = interval;
+	SamplingScheduler::Default().SetInterval(this, interval);
+
+	// Keeps the history covering the same time span
+	MetricRegistry::Default().SetRefreshInterval(fMetric, interval);
 }
 
-void MemView::SetRefreshInterval(bigtime_t interval)
+void MemView::SetPerformanceViewVisible(bool visible)
 {
-	BAutolock locker(fLocker);
-	if (fCacheGraphView)
-		fCacheGraphView->SetRefreshInterval(interval);
+	// Only the labels wait; the samples keep going into the history
+	fPerformanceViewVisible = visible;
+	if (visible)
+		_UpdateLabels();
 }
@@ -3,25 +3,36 @@
 
 #include <View.h>
 #include <StringView.h>
-#include <Locker.h>
 #include <NumberFormat.h>
-#include "ActivityGraphView.h"
+#include "SamplingScheduler.h"
+#include "SeqLock.h"
+#include "StackedGraphView.h"
 
 class BBox;
 
-class MemView : public BView {
+class MemView : public BView, public SampleCollector {
 public:
 	MemView();
 	virtual ~MemView();
 
 	virtual void AttachedToWindow();
-	virtual void Pulse();
+	virtual void DetachedFromWindow();
+	virtual void MessageReceived(BMessage* message);
+
+	virtual void Collect(bigtime_t now);
 
-	float GetCurrentUsage();
 	void SetRefreshInterval(bigtime_t interval);
-	void UpdateData();
+	void SetPerformanceViewVisible(bool visible);
 
 private:
+	struct memory_snapshot {
+		uint64		used;
+		uint64		total;
+		uint64		cached;
+		bool		valid;
+	};
+
+	void _UpdateLabels();
 
 	BStringView* fTotalMemLabel;
 	BStringView* fTotalMemValue;
@@ -32,10 +43,15 @@ private:
 	BStringView* fCachedMemLabel;
 	BStringView* fCachedMemValue;
 
-	ActivityGraphView* fCacheGraphView;
+	StackedGraphView* fMemoryGraph;
+	metric_id fMetric;
+
+	bigtime_t fRefreshInterval;
+	bool fPerformanceViewVisible;
 
-	BLocker fLocker;
-	float fCurrentUsage;
+	// Written by the scheduler thread, read by the window
+	SeqLock<memory_snapshot> fSnapshot;
+	uint32 fSnapshotSequence;
 
 	uint64 fLastUsedBytes;
 	uint64 fLastFreeBytes;
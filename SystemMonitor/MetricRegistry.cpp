@@ -0,0 +1,317 @@
+#include "MetricRegistry.h"
+
+#include <Autolock.h>
+
+#include <algorithm>
+#include <new>
+
+#include "HistoryFile.h"
+
+
+static const bigtime_t kDefaultMemorize = 10 * 60000000LL;
+static const bigtime_t kDefaultInterval = 1000000;
+static const bigtime_t kDefaultRetention = 24 * 60 * 60 * 1000000LL;
+// How much of the history is persisted, at whichever refresh rate. Metrics
+// with many fields, like the per core CPU usage, keep less than that rather
+// than growing past the size limit.
+static const bigtime_t kHistoryFileDuration = 60 * 60 * 1000000LL;
+static const size_t kHistoryFileMaxSize = 4 * 1024 * 1024;
+
+
+static uint32
+history_file_capacity(bigtime_t interval, int32 fieldCount)
+{
+	if (interval <= 0)
+		interval = kDefaultInterval;
+
+	bigtime_t capacity = (kHistoryFileDuration + interval - 1) / interval;
+	bigtime_t maxCapacity = kHistoryFileMaxSize
+		/ HistoryFile::RecordSize(fieldCount);
+	return static_cast<uint32>(std::max((bigtime_t)1,
+		std::min(capacity, maxCapacity)));
+}
+
+
+MetricRegistry::metric::metric()
+	:
+	historyLock("metric history"),
+	publishLock("metric publish"),
+	history(NULL),
+	file(NULL)
+{
+}
+
+
+MetricRegistry::MetricRegistry()
+	:
+	fLock("metric registry")
+{
+}
+
+
+MetricRegistry::~MetricRegistry()
+{
+	for (size_t i = 0; i < fMetrics.size(); i++) {
+		metric* current = fMetrics[i];
+		delete current->file;
+		delete current->history;
+		delete current;
+	}
+}
+
+
+/*static*/ MetricRegistry&
+MetricRegistry::Default()
+{
+	static MetricRegistry sDefault;
+	return sDefault;
+}
+
+
+metric_id
+MetricRegistry::Register(const char* name, int32 fieldCount)
+{
+	if (name == NULL || fieldCount < 1)
+		return B_BAD_VALUE;
+
+	BAutolock locker(fLock);
+
+	metric_id id = Find(name);
+	if (id >= 0) {
+		if (fMetrics[id]->history->CountFields() != fieldCount)
+			return B_MISMATCHED_VALUES;
+		return id;
+	}
+
+	metric* newMetric = new(std::nothrow) metric;
+	if (newMetric == NULL)
+		return B_NO_MEMORY;
+
+	newMetric->history = new(std::nothrow) DataHistory<float>(
+		kDefaultMemorize, kDefaultInterval, fieldCount);
+	if (newMetric->history == NULL
+		|| newMetric->history->InitCheck() != B_OK) {
+		delete newMetric->history;
+		delete newMetric;
+		return B_NO_MEMORY;
+	}
+
+	try {
+		newMetric->name = name;
+		newMetric->last.resize(fieldCount, 0.0f);
+		fMetrics.push_back(newMetric);
+	} catch (const std::bad_alloc&) {
+		delete newMetric->history;
+		delete newMetric;
+		return B_NO_MEMORY;
+	}
+
+	newMetric->history->SetRetention(kDefaultRetention);
+	_Restore(newMetric);
+
+	return static_cast<metric_id>(fMetrics.size() - 1);
+}
+
+
+metric_id
+MetricRegistry::Find(const char* name) const
+{
+	BAutolock locker(fLock);
+
+	for (size_t i = 0; i < fMetrics.size(); i++) {
+		if (fMetrics[i]->name == name)
+			return static_cast<metric_id>(i);
+	}
+	return B_NAME_NOT_FOUND;
+}
+
+
+void
+MetricRegistry::Publish(metric_id id, bigtime_t time, float value)
+{
+	Publish(id, time, &value);
+}
+
+
+void
+MetricRegistry::Publish(metric_id id, bigtime_t time, const float* values)
+{
+	metric* target = _MetricAt(id);
+	if (target == NULL)
+		return;
+
+	// Readers only wait while the values are added in memory
+	if (target->historyLock.Lock()) {
+		target->history->AddValues(time, values);
+		for (size_t i = 0; i < target->last.size(); i++)
+			target->last[i] = values[i];
+		target->historyLock.Unlock();
+	}
+
+	BAutolock locker(target->publishLock);
+
+	if (target->file != NULL)
+		target->file->AddValues(time, values);
+
+	if (target->watchers.empty())
+		return;
+
+	BMessage message(kMsgMetricUpdated);
+	message.AddInt32("metric", id);
+	message.AddInt64("when", time);
+
+	// Never wait on a busy window; it will pick up the values with the
+	// next update it gets.
+	for (size_t i = 0; i < target->watchers.size(); i++)
+		target->watchers[i].SendMessage(&message, (BHandler*)NULL, 0);
+}
+
+
+float
+MetricRegistry::LastValue(metric_id id, int32 field) const
+{
+	metric* target = _MetricAt(id);
+	if (target == NULL)
+		return 0.0f;
+
+	BAutolock locker(target->historyLock);
+	if (field < 0 || field >= static_cast<int32>(target->last.size()))
+		return 0.0f;
+
+	return target->last[field];
+}
+
+
+void
+MetricRegistry::SetRefreshInterval(metric_id id, bigtime_t interval)
+{
+	metric* target = _MetricAt(id);
+	if (target == NULL)
+		return;
+
+	if (target->historyLock.Lock()) {
+		target->history->SetRefreshInterval(interval);
+		target->historyLock.Unlock();
+	}
+
+	// Keep persisting the same time span
+	BAutolock locker(target->publishLock);
+	if (target->file != NULL) {
+		target->file->SetCapacity(history_file_capacity(interval,
+			target->file->CountFields()));
+	}
+}
+
+
+status_t
+MetricRegistry::StartWatching(metric_id id, BMessenger target)
+{
+	metric* watched = _MetricAt(id);
+	if (watched == NULL)
+		return B_BAD_VALUE;
+
+	BAutolock locker(watched->publishLock);
+
+	if (std::find(watched->watchers.begin(), watched->watchers.end(),
+			target) != watched->watchers.end()) {
+		return B_OK;
+	}
+
+	try {
+		watched->watchers.push_back(target);
+	} catch (const std::bad_alloc&) {
+		return B_NO_MEMORY;
+	}
+	return B_OK;
+}
+
+
+void
+MetricRegistry::StopWatching(metric_id id, BMessenger target)
+{
+	metric* watched = _MetricAt(id);
+	if (watched == NULL)
+		return;
+
+	BAutolock locker(watched->publishLock);
+
+	watched->watchers.erase(std::remove(watched->watchers.begin(),
+		watched->watchers.end(), target), watched->watchers.end());
+}
+
+
+bool
+MetricRegistry::LockMetric(metric_id id)
+{
+	metric* target = _MetricAt(id);
+	return target != NULL && target->historyLock.Lock();
+}
+
+
+void
+MetricRegistry::UnlockMetric(metric_id id)
+{
+	metric* target = _MetricAt(id);
+	if (target != NULL)
+		target->historyLock.Unlock();
+}
+
+
+DataHistory<float>*
+MetricRegistry::HistoryFor(metric_id id) const
+{
+	metric* target = _MetricAt(id);
+	return target != NULL ? target->history : NULL;
+}
+
+
+MetricRegistry::metric*
+MetricRegistry::_MetricAt(metric_id id) const
+{
+	// Metrics are never removed, so they stay valid after unlocking
+	BAutolock locker(fLock);
+	if (id < 0 || id >= static_cast<metric_id>(fMetrics.size()))
+		return NULL;
+	return fMetrics[id];
+}
+
+
+void
+MetricRegistry::_Restore(metric* target)
+{
+	int32 fieldCount = target->history->CountFields();
+	HistoryFile* file = new(std::nothrow) HistoryFile;
+	if (file == NULL || file->Open(target->name.String(), fieldCount,
+			history_file_capacity(kDefaultInterval, fieldCount)) != B_OK) {
+		delete file;
+		return;
+	}
+	target->file = file;
+
+	std::vector<float> values;
+	try {
+		values.resize(fieldCount);
+	} catch (const std::bad_alloc&) {
+		return;
+	}
+
+	// Replay the previous session; skip anything that doesn't fit in before
+	// now, in case the clock has been changed in the meantime. Records from
+	// before a reboot have negative times, which the history keeps as they
+	// are.
+	bigtime_t now = system_time();
+	bigtime_t last = 0;
+	bool restored = false;
+	uint32 count = file->CountRecords();
+	for (uint32 record = 0; record < count; record++) {
+		bigtime_t time;
+		if (!file->RecordAt(record, time, values.data())
+			|| (restored && time < last) || time > now) {
+			continue;
+		}
+
+		target->history->AddValues(time, values.data());
+		last = time;
+		restored = true;
+	}
+}
@@ -0,0 +1,102 @@
+#ifndef METRICREGISTRY_H
+#define METRICREGISTRY_H
+
+#include <Locker.h>
+#include <Messenger.h>
+#include <String.h>
+#include <vector>
+
+#include "DataHistory.h"
+
+class HistoryFile;
+
+
+typedef int32 metric_id;
+
+// Sent to watchers after new values have been published; contains the
+// "metric" (int32) and its "when" (int64).
+const uint32 kMsgMetricUpdated = 'mtup';
+
+// Metrics published by the performance views. Publishers and watchers both
+// register them; registering an existing name returns the same id.
+#define METRIC_CPU_TOTAL		"cpu_total"
+#define METRIC_CPU_CORE			"cpu_core"
+#define METRIC_MEMORY			"memory"
+#define METRIC_NETWORK			"network"
+
+enum {
+	kMemoryUsedField = 0,
+	kMemoryCacheField,
+	kMemoryFieldCount
+};
+
+enum {
+	kNetworkDownloadField = 0,
+	kNetworkUploadField,
+	kNetworkTotalField,
+	kNetworkFieldCount
+};
+
+
+// Shared store of named time series. Collectors publish every sample once,
+// and all graphs and labels showing that metric read the same history, so
+// a new view costs nothing extra to collect. Histories are persisted and
+// live as long as the application.
+//
+// Every metric has its own locks: one that is only held while values are
+// added to its history or read from it, and one for writing them to the
+// history files and telling the watchers. Readers of one metric therefore
+// never wait for another, nor for the disk.
+class MetricRegistry {
+public:
+	static	MetricRegistry& Default();
+
+			// Returns the id of the metric, or an error code when an
+			// existing metric of that name has a different field count.
+			metric_id	Register(const char* name, int32 fieldCount = 1);
+			metric_id	Find(const char* name) const;
+
+			void		Publish(metric_id id, bigtime_t time, float value);
+			void		Publish(metric_id id, bigtime_t time,
+							const float* values);
+			float		LastValue(metric_id id, int32 field = 0) const;
+
+			void		SetRefreshInterval(metric_id id,
+							bigtime_t interval);
+
+			status_t	StartWatching(metric_id id, BMessenger target);
+			void		StopWatching(metric_id id, BMessenger target);
+
+			// The metric must stay locked while its history is in use.
+			bool		LockMetric(metric_id id);
+			void		UnlockMetric(metric_id id);
+			DataHistory<float>* HistoryFor(metric_id id) const;
+
+private:
+						MetricRegistry();
+						~MetricRegistry();
+
+	struct metric {
+							metric();
+
+		// Guards the history and the last values
+		BLocker				historyLock;
+		// Guards the files and the watchers
+		BLocker				publishLock;
+		BString				name;
+		DataHistory<float>*	history;
+		HistoryFile*		file;
+		std::vector<float>	last;
+		std::vector<BMessenger> watchers;
+	};
+
+			metric*		_MetricAt(metric_id id) const;
+			void		_Restore(metric* target);
+
+private:
+	// Only guards the list of metrics
+	mutable BLocker		fLock;
+	std::vector<metric*> fMetrics;
+};
+
+#endif // METRICREGISTRY_H
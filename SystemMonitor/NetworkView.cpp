@@ -12,7 +12,7 @@
 #include <Alert.h>
 #include <cstring>
 #include <net/if.h>
-#include "ActivityGraphView.h"
+#include "StackedGraphView.h"
 #include "InterfaceListItem.h"
 #include <Messenger.h>
 #include <Catalog.h>
@@ -32,21 +32,16 @@ const float kBaseNetRxSpeedWidth = 90;
 
 NetworkView::NetworkView()
 	: BView("NetworkView", B_WILL_DRAW),
-	fDownloadGraph(NULL),
-	fUploadGraph(NULL),
-	fUploadSpeed(0.0f),
-	fDownloadSpeed(0.0f),
+	fTrafficGraph(NULL),
+	fMetric(-1),
+	fCollectGeneration(0),
 	fLastTotalUpdateTime(0),
-	fUpdateThread(-1),
-	fScanSem(-1),
-	fTerminated(false),
 	fPerformanceViewVisible(true),
 	fRefreshInterval(1000000),
 	fSortMode(SORT_NET_BY_TX_SPEED),
 	fListGeneration(0)
 {
 	SetViewColor(ui_color(B_PANEL_BACKGROUND_COLOR));
-	fScanSem = create_sem(0, "network scan sem");
 
 	auto* netBox = new BBox("NetworkInterfacesBox");
 	netBox->SetLabel(B_TRANSLATE("Network Interfaces"));
@@ -94,25 +89,28 @@ NetworkView::NetworkView()
 		.Add(headerView)
 		.Add(netScrollView);
 
-	fDownloadGraph = new ActivityGraphView("download_graph", {0, 0, 0, 0}, B_MENU_SELECTION_BACKGROUND_COLOR);
-	fUploadGraph = new ActivityGraphView("upload_graph", {0, 0, 0, 0}, B_FAILURE_COLOR);
+	// Sent traffic stacked on received, scaled to the peak of both
+	fMetric = MetricRegistry::Default().Register(METRIC_NETWORK,
+		kNetworkFieldCount);
+	fTrafficGraph = new StackedGraphView("traffic_graph");
+	fTrafficGraph->SetMetric(fMetric);
+	fTrafficGraph->AddLayer(kNetworkDownloadField, B_TRANSLATE("Received"),
+		B_MENU_SELECTION_BACKGROUND_COLOR);
+	fTrafficGraph->AddLayer(kNetworkUploadField, B_TRANSLATE("Sent"),
+		B_FAILURE_COLOR);
+	fTrafficGraph->SetScaleField(kNetworkTotalField);
+	fTrafficGraph->SetValueFormatter(FormatGraphRate);
 
 	BLayoutBuilder::Group<>(this, B_VERTICAL, B_USE_DEFAULT_SPACING)
 		.SetInsets(B_USE_DEFAULT_SPACING)
 		.Add(netBox)
-		.Add(fDownloadGraph)
-		.Add(fUploadGraph)
+		.Add(fTrafficGraph)
 	.End();
 }
 
 NetworkView::~NetworkView()
 {
-	fTerminated = true;
-	if (fScanSem >= 0) delete_sem(fScanSem);
-	if (fUpdateThread >= 0) {
-		status_t dummy;
-		wait_for_thread(fUpdateThread, &dummy);
-	}
+	SamplingScheduler::Default().RemoveCollector(this);
 
 	fInterfaceListView->MakeEmpty();
 	for (auto& pair : fInterfaceItemMap) {
@@ -124,28 +122,14 @@ NetworkView::~NetworkView()
 void NetworkView::AttachedToWindow()
 {
 	BView::AttachedToWindow();
-	fTerminated = false;
-
-	if (fScanSem < 0)
-		fScanSem = create_sem(0, "network scan sem");
 
-	fUpdateThread = spawn_thread(UpdateThread, "NetworkView Update", B_NORMAL_PRIORITY, this);
-	if (fUpdateThread >= 0)
-		resume_thread(fUpdateThread);
+	// Always sampling, so the history has no gaps while hidden
+	SamplingScheduler::Default().AddCollector(this, fRefreshInterval);
 }
 
 void NetworkView::DetachedFromWindow()
 {
-	fTerminated = true;
-	if (fScanSem >= 0) {
-		delete_sem(fScanSem);
-		fScanSem = -1;
-	}
-	if (fUpdateThread >= 0) {
-		status_t dummy;
-		wait_for_thread(fUpdateThread, &dummy);
-		fUpdateThread = -1;
-	}
+	SamplingScheduler::Default().RemoveCollector(this);
 	BView::DetachedFromWindow();
 }
 
@@ -178,9 +162,11 @@ void NetworkView::UpdateData(BMessage* message)
 	}
 
 	fListGeneration++;
-	bigtime_t currentTime = system_time();
-	uint64 totalSentDelta = 0;
-	uint64 totalReceivedDelta = 0;
+	// Sampled on the scheduler's tick, so the rates line up with the other
+	// metrics
+	bigtime_t currentTime;
+	if (message->FindInt64("when", &currentTime) != B_OK)
+		currentTime = system_time();
 
 	int32 count = 0;
 	type_code type;
@@ -241,11 +227,6 @@ void NetworkView::UpdateData(BMessage* message)
 					// Convert to Bytes/sec for SpeedField
 					sendSpeedBytes = sentDelta * 1000000 / dt;
 					recvSpeedBytes = recvDelta * 1000000 / dt;
-
-					if (!info->isLoopback) {
-						totalSentDelta += sentDelta;
-						totalReceivedDelta += recvDelta;
-					}
 				}
 			}
 
@@ -292,109 +273,107 @@ void NetworkView::UpdateData(BMessage* message)
 
 	fInterfaceListView->Invalidate();
 
-	// Update graphs
-	if (fUploadGraph && fDownloadGraph) {
-		bigtime_t dt = currentTime - fLastTotalUpdateTime;
-		if (dt <= 0)
-			dt = 1000000;
-
-		fUploadSpeed = totalSentDelta * 1000000.0 / dt;
-		fDownloadSpeed = totalReceivedDelta * 1000000.0 / dt;
-
-		fUploadGraph->AddValue(currentTime, fUploadSpeed);
-		fDownloadGraph->AddValue(currentTime, fDownloadSpeed);
-		fLastTotalUpdateTime = currentTime;
-	}
-
 	fLocker.Unlock();
 }
 
-int32 NetworkView::UpdateThread(void* data)
+void NetworkView::Collect(bigtime_t now)
 {
-	NetworkView* view = static_cast<NetworkView*>(data);
-	BMessenger target(view);
-
-	while (!view->fTerminated) {
-		status_t err = acquire_sem_etc(view->fScanSem, 1, B_RELATIVE_TIMEOUT, view->fRefreshInterval);
-		if (err != B_OK && err != B_TIMED_OUT && err != B_INTERRUPTED)
-			break;
-
-		if (view->fTerminated) break;
-
-		if (!view->fPerformanceViewVisible)
-			continue;
+	BMessenger target(this);
 
-		// Drain the semaphore if we were woken up explicitly (e.g. interval change)
-		if (err == B_OK) {
-			int32 count;
-			if (get_sem_count(view->fScanSem, &count) == B_OK && count > 0)
-				acquire_sem_etc(view->fScanSem, count, B_RELATIVE_TIMEOUT, 0);
+	BMessage updateMsg(kMsgNetworkDataUpdate);
+	updateMsg.AddInt64("when", now);
+	bool visible = fPerformanceViewVisible;
+	uint64 totalSentDelta = 0;
+	uint64 totalReceivedDelta = 0;
+	fCollectGeneration++;
+
+	BNetworkRoster& roster = BNetworkRoster::Default();
+	uint32 cookie = 0;
+	BNetworkInterface interface;
+
+	while (roster.GetNextInterface(&cookie, interface) == B_OK) {
+		NetworkInfo info;
+		strlcpy(info.name, interface.Name(), sizeof(info.name));
+
+		// Determine Type
+		BString typeStr = B_TRANSLATE("Ethernet");
+		info.isLoopback = (interface.Flags() & IFF_LOOPBACK) != 0;
+		if (info.isLoopback) {
+			typeStr = B_TRANSLATE("Loopback");
+		} else if (interface.Flags() & IFF_POINTOPOINT) {
+			typeStr = B_TRANSLATE("Point-to-Point");
 		}
-
-		BMessage updateMsg(kMsgNetworkDataUpdate);
-		BNetworkRoster& roster = BNetworkRoster::Default();
-		uint32 cookie = 0;
-		BNetworkInterface interface;
-
-		while (roster.GetNextInterface(&cookie, interface) == B_OK) {
-			NetworkInfo info;
-			strlcpy(info.name, interface.Name(), sizeof(info.name));
-
-			// Determine Type
-			BString typeStr = B_TRANSLATE("Ethernet");
-			info.isLoopback = (interface.Flags() & IFF_LOOPBACK) != 0;
-			if (info.isLoopback) {
-				typeStr = B_TRANSLATE("Loopback");
-			} else if (interface.Flags() & IFF_POINTOPOINT) {
-				typeStr = B_TRANSLATE("Point-to-Point");
-			}
-			strlcpy(info.typeStr, typeStr.String(), sizeof(info.typeStr));
-
-			// Determine Address
-			BString addressStr = B_TRANSLATE("N/A");
-			for (int32 i = 0; i < interface.CountAddresses(); ++i) {
-				BNetworkInterfaceAddress ifaceAddr;
-				if (interface.GetAddressAt(i, ifaceAddr) == B_OK) {
-					BNetworkAddress addr = ifaceAddr.Address();
-					if (addr.Family() == AF_INET || addr.Family() == AF_INET6) {
-						addressStr = addr.ToString();
-						break;
-					}
+		strlcpy(info.typeStr, typeStr.String(), sizeof(info.typeStr));
+
+		// Determine Address
+		BString addressStr = B_TRANSLATE("N/A");
+		for (int32 i = 0; i < interface.CountAddresses(); ++i) {
+			BNetworkInterfaceAddress ifaceAddr;
+			if (interface.GetAddressAt(i, ifaceAddr) == B_OK) {
+				BNetworkAddress addr = ifaceAddr.Address();
+				if (addr.Family() == AF_INET || addr.Family() == AF_INET6) {
+					addressStr = addr.ToString();
+					break;
 				}
 			}
-			strlcpy(info.addressStr, addressStr.String(), sizeof(info.addressStr));
-
-			// Get Stats
-			ifreq_stats stats;
-			status_t status = interface.GetStats(stats);
-			if (status == B_OK) {
-				info.bytesSent = stats.send.bytes;
-				info.bytesReceived = stats.receive.bytes;
-				info.hasStats = true;
-			} else {
-				info.bytesSent = 0;
-				info.bytesReceived = 0;
-				info.hasStats = false;
-			}
+		}
+		strlcpy(info.addressStr, addressStr.String(), sizeof(info.addressStr));
+
+		// Get Stats
+		ifreq_stats stats;
+		status_t status = interface.GetStats(stats);
+		if (status == B_OK) {
+			info.bytesSent = stats.send.bytes;
+			info.bytesReceived = stats.receive.bytes;
+			info.hasStats = true;
+		} else {
+			info.bytesSent = 0;
+			info.bytesReceived = 0;
+			info.hasStats = false;
+		}
 
-			updateMsg.AddData("net_info", B_RAW_TYPE, &info, sizeof(NetworkInfo));
+		// Interfaces only count from their second sample on, so that one
+		// coming up doesn't show its whole byte count as a burst
+		if (info.hasStats) {
+			InterfaceStatsRecord& rec = fCollectedStatsMap[info.name];
+			if (rec.generation > 0 && !info.isLoopback) {
+				if (info.bytesSent > rec.bytesSent)
+					totalSentDelta += info.bytesSent - rec.bytesSent;
+				if (info.bytesReceived > rec.bytesReceived)
+					totalReceivedDelta += info.bytesReceived - rec.bytesReceived;
+			}
+			rec.bytesSent = info.bytesSent;
+			rec.bytesReceived = info.bytesReceived;
+			rec.generation = fCollectGeneration;
 		}
 
-		target.SendMessage(&updateMsg);
+		if (visible)
+			updateMsg.AddData("net_info", B_RAW_TYPE, &info, sizeof(NetworkInfo));
 	}
-	return B_OK;
-}
 
-float NetworkView::GetUploadSpeed()
-{
-	BAutolock locker(fLocker);
-	return fUploadSpeed;
-}
+	for (auto it = fCollectedStatsMap.begin(); it != fCollectedStatsMap.end();) {
+		if (it->second.generation != fCollectGeneration)
+			it = fCollectedStatsMap.erase(it);
+		else
+			++it;
+	}
 
-float NetworkView::GetDownloadSpeed()
-{
-	BAutolock locker(fLocker);
-	return fDownloadSpeed;
+	// The graphs are fed from here, whether or not the list is shown
+	bigtime_t dt = now - fLastTotalUpdateTime;
+	if (dt <= 0)
+		dt = 1000000;
+
+	float values[kNetworkFieldCount];
+	values[kNetworkUploadField] = totalSentDelta * 1000000.0 / dt;
+	values[kNetworkDownloadField] = totalReceivedDelta * 1000000.0 / dt;
+	values[kNetworkTotalField] = values[kNetworkUploadField]
+		+ values[kNetworkDownloadField];
+	MetricRegistry::Default().Publish(fMetric, now, values);
+	fLastTotalUpdateTime = now;
+
+	// Never block on the window, it might be waiting for the scheduler
+	if (visible)
+		target.SendMessage(&updateMsg, (BHandler*)NULL, 0);
 }
 
 void NetworkView::_SortItems()
@@ -414,14 +393,17 @@ void NetworkView::_SortItems()
 void NetworkView::SetRefreshInterval(bigtime_t interval)
 {
 	fRefreshInterval = interval;
-	if (fScanSem >= 0)
-		release_sem(fScanSem);
-
-	BAutolock locker(fLocker);
-	if (fUploadGraph)
-		fUploadGraph->SetRefreshInterval(interval);
-	if (fDownloadGraph)
-		fDownloadGraph->SetRefreshInterval(interval);
+	SamplingScheduler::Default().SetInterval(this, interval);
+
+	MetricRegistry::Default().SetRefreshInterval(fMetric, interval);
+}
+
+void NetworkView::SetPerformanceViewVisible(bool visible)
+{
+	// The list catches up right away; the history never stops
+	fPerformanceViewVisible = visible;
+	if (visible)
+		SamplingScheduler::Default().Trigger(this);
 }
 
 void NetworkView::_RestoreSelection(const BString& selectedName)
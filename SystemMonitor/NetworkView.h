@@ -10,13 +10,14 @@
 #include <set>
 #include <atomic>
 #include <Font.h>
-#include "ActivityGraphView.h"
+#include "StackedGraphView.h"
+#include "SamplingScheduler.h"
 
 class BListView;
 class BListItem;
 class ClickableHeaderView;
 class InterfaceListItem; // Forward declaration
-class ActivityGraphView;
+class StackedGraphView;
 
 struct InterfaceStatsRecord {
 	uint64 bytesSent = 0;
@@ -47,7 +48,7 @@ enum NetworkSortMode {
 	SORT_NET_BY_RX_SPEED
 };
 
-class NetworkView : public BView {
+class NetworkView : public BView, public SampleCollector {
 public:
 	NetworkView();
 	virtual ~NetworkView();
@@ -56,10 +57,10 @@ public:
 	virtual void DetachedFromWindow();
 	virtual void MessageReceived(BMessage* message);
 
-	float GetUploadSpeed();
-	float GetDownloadSpeed();
+	virtual void Collect(bigtime_t now);
+
 	void SetRefreshInterval(bigtime_t interval);
-	void SetPerformanceViewVisible(bool visible) { fPerformanceViewVisible = visible; }
+	void SetPerformanceViewVisible(bool visible);
 
 	float NameWidth() const { return fNameWidth; }
 	float TypeWidth() const { return fTypeWidth; }
@@ -70,13 +71,12 @@ public:
 	float RxSpeedWidth() const { return fRxSpeedWidth; }
 
 private:
-	static int32 UpdateThread(void* data);
 	void UpdateData(BMessage* message);
 
 	BListView* fInterfaceListView;
 	std::vector<ClickableHeaderView*> fHeaders;
-	ActivityGraphView* fDownloadGraph;
-	ActivityGraphView* fUploadGraph;
+	StackedGraphView* fTrafficGraph;
+	metric_id fMetric;
 
 	BLocker fLocker;
 
@@ -93,17 +93,18 @@ private:
 
 	std::unordered_map<BString, InterfaceStatsRecord, BStringHash> fPreviousStatsMap;
 	std::unordered_map<BString, InterfaceListItem*, BStringHash> fInterfaceItemMap;
+
+	// Only used by Collect(), which records the totals even while the
+	// list isn't shown
+	std::unordered_map<BString, InterfaceStatsRecord, BStringHash> fCollectedStatsMap;
+	int32 fCollectGeneration;
 	bigtime_t fLastTotalUpdateTime;
-	float fUploadSpeed;
-	float fDownloadSpeed;
 
 	BFont fCachedFont;
 
-	thread_id fUpdateThread;
-	sem_id fScanSem;
-	std::atomic<bool> fTerminated;
+	// Read by Collect() to skip updating the list
 	std::atomic<bool> fPerformanceViewVisible;
-	std::atomic<bigtime_t> fRefreshInterval;
+	bigtime_t fRefreshInterval;
 	int32 fListGeneration;
 
 	float fNameWidth;
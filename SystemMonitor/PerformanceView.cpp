@@ -13,6 +13,9 @@
 #include "DiskView.h"
 #include "GPUView.h"
 #include "ActivityGraphView.h"
+#include "SamplingScheduler.h"
+#include "SamplingSettings.h"
+#include "Utils.h"
 
 #undef B_TRANSLATION_CONTEXT
 #define B_TRANSLATION_CONTEXT "PerformanceView"
@@ -24,50 +27,103 @@
 
 class SummaryView : public BView {
 public:
-	SummaryView(SystemStats* stats)
-		: BView("SummaryView", B_WILL_DRAW), fStats(stats)
+	SummaryView()
+		: BView("SummaryView", B_WILL_DRAW)
 	{
 		SetViewColor(ui_color(B_PANEL_BACKGROUND_COLOR));
 
+		// The same series the detail views publish, registered here too
+		// since this view is created first
+		MetricRegistry& registry = MetricRegistry::Default();
+		fCpuMetric = registry.Register(METRIC_CPU_TOTAL);
+		fMemMetric = registry.Register(METRIC_MEMORY, kMemoryFieldCount);
+		fNetMetric = registry.Register(METRIC_NETWORK, kNetworkFieldCount);
+
 		fCpuGraph = new ActivityGraphView("cpu_summary_graph",
 			{0, 0, 0, 0}, B_SUCCESS_COLOR);
 		fCpuGraph->SetExplicitMinSize(BSize(B_SIZE_UNSET, 60));
-		fCpuGraph->SetManualScale(0, 1000);
+		fCpuGraph->SetManualScale(0, 100);
+		fCpuGraph->SetMetric(fCpuMetric);
+		fCpuGraph->SetValueFormatter(FormatGraphPercent);
 
 		fMemGraph = new ActivityGraphView("mem_summary_graph",
 			{0, 0, 0, 0}, B_MENU_SELECTION_BACKGROUND_COLOR);
 		fMemGraph->SetExplicitMinSize(BSize(B_SIZE_UNSET, 60));
-		fMemGraph->SetManualScale(0, 1000);
+		fMemGraph->SetManualScale(0, 100);
+		fMemGraph->SetMetric(fMemMetric, kMemoryUsedField);
+		fMemGraph->SetValueFormatter(FormatGraphPercent);
 
 		fNetGraph = new ActivityGraphView("net_summary_graph",
 			{0, 0, 0, 0}, B_FAILURE_COLOR);
 		fNetGraph->SetExplicitMinSize(BSize(B_SIZE_UNSET, 60));
+		fNetGraph->SetMetric(fNetMetric, kNetworkTotalField);
+		fNetGraph->SetValueFormatter(FormatGraphRate);
+
+		fCpuPercentile = new BStringView("cpu_p95", "");
+		fMemPercentile = new BStringView("mem_p95", "");
+		fNetPercentile = new BStringView("net_p95", "");
 
 		BLayoutBuilder::Group<>(this, B_VERTICAL, B_USE_DEFAULT_SPACING)
 			.SetInsets(B_USE_DEFAULT_SPACING)
-			.Add(_CreateCard(B_TRANSLATE("CPU"), fCpuGraph))
-			.Add(_CreateCard(B_TRANSLATE("Memory"), fMemGraph))
-			.Add(_CreateCard(B_TRANSLATE("Network"), fNetGraph))
+			.Add(_CreateCard(B_TRANSLATE("CPU"), fCpuGraph, fCpuPercentile))
+			.Add(_CreateCard(B_TRANSLATE("Memory"), fMemGraph, fMemPercentile))
+			.Add(_CreateCard(B_TRANSLATE("Network"), fNetGraph, fNetPercentile))
 			.AddGlue();
 	}
 
-	void SetRefreshInterval(bigtime_t interval) {
-		if (fCpuGraph) fCpuGraph->SetRefreshInterval(interval);
-		if (fMemGraph) fMemGraph->SetRefreshInterval(interval);
-		if (fNetGraph) fNetGraph->SetRefreshInterval(interval);
+	virtual void AttachedToWindow() {
+		BView::AttachedToWindow();
+
+		MetricRegistry& registry = MetricRegistry::Default();
+		registry.StartWatching(fCpuMetric, BMessenger(this));
+		registry.StartWatching(fMemMetric, BMessenger(this));
+		registry.StartWatching(fNetMetric, BMessenger(this));
+	}
+
+	virtual void DetachedFromWindow() {
+		MetricRegistry& registry = MetricRegistry::Default();
+		registry.StopWatching(fCpuMetric, BMessenger(this));
+		registry.StopWatching(fMemMetric, BMessenger(this));
+		registry.StopWatching(fNetMetric, BMessenger(this));
+
+		BView::DetachedFromWindow();
 	}
 
-	void UpdateData() {
-		if (fStats) {
-			const bigtime_t now = system_time();
-			fCpuGraph->AddValue(now, fStats->cpuUsage * 10);
-			fMemGraph->AddValue(now, fStats->memoryUsage * 10);
-			fNetGraph->AddValue(now, fStats->uploadSpeed + fStats->downloadSpeed);
+	virtual void MessageReceived(BMessage* message) {
+		if (message->what != kMsgMetricUpdated) {
+			BView::MessageReceived(message);
+			return;
 		}
+
+		metric_id metric;
+		if (message->FindInt32("metric", &metric) != B_OK)
+			return;
+
+		if (metric == fCpuMetric)
+			_UpdatePercentile(fCpuPercentile, fCpuGraph, FormatGraphPercent);
+		else if (metric == fMemMetric)
+			_UpdatePercentile(fMemPercentile, fMemGraph, FormatGraphPercent);
+		else if (metric == fNetMetric)
+			_UpdatePercentile(fNetPercentile, fNetGraph, FormatGraphRate);
 	}
 
 private:
-	BView* _CreateCard(const char* label, BView* content) {
+	void _UpdatePercentile(BStringView* view, ActivityGraphView* graph,
+		value_formatter formatter) {
+		// As of the graph's last frame; the hour hardly moves meanwhile
+		float p50, p95, p99;
+		graph->GetQuantiles(p50, p95, p99);
+
+		BString value;
+		formatter(value, p95);
+
+		BString text;
+		text.SetToFormat(B_TRANSLATE("p95 (last hour): %s"), value.String());
+		if (text != view->Text())
+			view->SetText(text.String());
+	}
+
+	BView* _CreateCard(const char* label, BView* content, BView* footer) {
 		BBox* card = new BBox(B_FANCY_BORDER, NULL);
 		BStringView* labelView = new BStringView(NULL, label);
 		BFont font(be_bold_font);
@@ -77,14 +133,20 @@ private:
 			.SetInsets(B_USE_DEFAULT_SPACING / 2)
 			.Add(labelView)
 			.AddStrut(5)
-			.Add(content);
+			.Add(content)
+			.Add(footer);
 		return card;
 	}
 
 	ActivityGraphView*	fCpuGraph;
 	ActivityGraphView*	fMemGraph;
 	ActivityGraphView*	fNetGraph;
-	SystemStats*		fStats;
+	BStringView*		fCpuPercentile;
+	BStringView*		fMemPercentile;
+	BStringView*		fNetPercentile;
+	metric_id			fCpuMetric;
+	metric_id			fMemMetric;
+	metric_id			fNetMetric;
 };
 
 
@@ -93,14 +155,14 @@ private:
 // ---------------------------------------------------------------------------
 
 PerformanceView::PerformanceView()
-	: BView("PerformanceView", B_WILL_DRAW | B_PULSE_NEEDED)
+	: BView("PerformanceView", B_WILL_DRAW)
 {
 	SetViewColor(ui_color(B_PANEL_BACKGROUND_COLOR));
 
 	BSplitView* splitView = new BSplitView(B_HORIZONTAL, B_USE_DEFAULT_SPACING);
 	splitView->SetInsets(B_USE_DEFAULT_SPACING);
 
-	fSummaryView = new SummaryView(&fStats);
+	fSummaryView = new SummaryView();
 
 	BTabView* tabView = new BTabView("tab_view", B_WIDTH_FROM_WIDEST);
 	fRightPane = tabView;
@@ -141,28 +203,15 @@ PerformanceView::AttachedToWindow()
 }
 
 
-void
-PerformanceView::Pulse()
-{
-	if (IsHidden()) return;
-
-	if (!fCPUView->IsHidden()) fCPUView->UpdateData();
-	if (!fMemView->IsHidden()) fMemView->UpdateData();
-
-	fStats.cpuUsage      = fCPUView->GetCurrentUsage();
-	fStats.memoryUsage   = fMemView->GetCurrentUsage();
-	fStats.uploadSpeed   = fNetworkView->GetUploadSpeed();
-	fStats.downloadSpeed = fNetworkView->GetDownloadSpeed();
-
-	if (fSummaryView)
-		fSummaryView->UpdateData();
-}
-
-
 void
 PerformanceView::Hide()
 {
 	BView::Hide();
+	// CPU, memory and network keep sampling into their histories while
+	// hidden, and only stop updating what they show. The disks have no
+	// history, so their collector pauses until shown again.
+	fCPUView->SetPerformanceViewVisible(false);
+	fMemView->SetPerformanceViewVisible(false);
 	fNetworkView->SetPerformanceViewVisible(false);
 	fDiskView->SetPerformanceViewVisible(false);
 }
@@ -172,20 +221,35 @@ void
 PerformanceView::Show()
 {
 	BView::Show();
+	fCPUView->SetPerformanceViewVisible(true);
+	fMemView->SetPerformanceViewVisible(true);
 	fNetworkView->SetPerformanceViewVisible(true);
 	fDiskView->SetPerformanceViewVisible(true);
 }
 
 
 void
-PerformanceView::SetRefreshInterval(bigtime_t interval)
+PerformanceView::SetSamplingSettings(const SamplingSettings& settings)
+{
+	if (fCPUView)
+		fCPUView->SetRefreshInterval(settings.Interval(kCPUSampling));
+	if (fMemView)
+		fMemView->SetRefreshInterval(settings.Interval(kMemorySampling));
+	if (fNetworkView)
+		fNetworkView->SetRefreshInterval(settings.Interval(kNetworkSampling));
+	if (fDiskView)
+		fDiskView->SetRefreshInterval(settings.Interval(kDiskSampling));
+}
+
+
+void
+PerformanceView::GetSampleCosts(bigtime_t* costs) const
 {
-	if (fSummaryView)  fSummaryView->SetRefreshInterval(interval);
-	if (fCPUView)      fCPUView->SetRefreshInterval(interval);
-	if (fMemView)      fMemView->SetRefreshInterval(interval);
-	if (fNetworkView)  fNetworkView->SetRefreshInterval(interval);
-	if (fDiskView)     fDiskView->SetRefreshInterval(interval);
-	if (fGPUView)      fGPUView->SetRefreshInterval(interval);
+	SamplingScheduler& scheduler = SamplingScheduler::Default();
+	costs[kCPUSampling] = scheduler.AverageCost(fCPUView);
+	costs[kMemorySampling] = scheduler.AverageCost(fMemView);
+	costs[kNetworkSampling] = scheduler.AverageCost(fNetworkView);
+	costs[kDiskSampling] = scheduler.AverageCost(fDiskView);
 }
 
 
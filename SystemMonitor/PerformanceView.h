@@ -5,7 +5,7 @@
 #include <SplitView.h>
 #include <Message.h>
 
-#include "SystemStats.h"
+class SamplingSettings;
 
 class CPUView;
 class MemView;
@@ -18,10 +18,11 @@ class PerformanceView : public BView {
 public:
 						PerformanceView();
 	virtual void		AttachedToWindow();
-	virtual void		Pulse();
 	virtual void		Hide();
 	virtual void		Show();
-	void				SetRefreshInterval(bigtime_t interval);
+	void				SetSamplingSettings(const SamplingSettings& settings);
+	// Fills in the measured cost of the sources sampled here
+	void				GetSampleCosts(bigtime_t* costs) const;
 
 	void				SaveState(BMessage& state);
 	void				LoadState(const BMessage& state);
@@ -31,7 +32,6 @@ private:
 	SummaryView*		fSummaryView;
 	BView*				fRightPane;
 
-	SystemStats			fStats;
 	CPUView*			fCPUView;
 	MemView*			fMemView;
 	NetworkView*		fNetworkView;
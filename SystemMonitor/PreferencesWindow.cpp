@@ -0,0 +1,211 @@
+#include "PreferencesWindow.h"
+
+#include <Catalog.h>
+#include <LayoutBuilder.h>
+#include <MenuField.h>
+#include <MenuItem.h>
+#include <MessageRunner.h>
+#include <PopUpMenu.h>
+#include <StringView.h>
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+#include "SystemInfoCache.h"
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "PreferencesWindow"
+
+
+static const uint32 kMsgIntervalSelected = 'intv';
+static const uint32 kMsgUpdateSharing = 'shar';
+
+static const bigtime_t kIntervalChoices[] = {
+	100000, 250000, 500000, 1000000, 2000000, 5000000, 10000000, 30000000,
+	60000000
+};
+
+
+static void
+FormatInterval(BString& out, bigtime_t interval)
+{
+	if (interval < 1000000) {
+		out.SetToFormat(B_TRANSLATE("%d ms"),
+			static_cast<int>(interval / 1000));
+	} else if (interval % 1000000 == 0) {
+		out.SetToFormat(B_TRANSLATE("%d s"),
+			static_cast<int>(interval / 1000000));
+	} else
+		out.SetToFormat(B_TRANSLATE("%.2f s"), interval / 1000000.0);
+}
+
+
+static void
+FormatLoad(BString& out, float load)
+{
+	out.SetToFormat("%.2f%%", load * 100.0f);
+}
+
+
+PreferencesWindow::PreferencesWindow(const SamplingSettings& settings,
+	const bigtime_t* costs, BMessenger target)
+	:
+	BWindow(BRect(0, 0, 300, 200), B_TRANSLATE("Sampling intervals"),
+		B_TITLED_WINDOW, B_NOT_RESIZABLE | B_NOT_ZOOMABLE
+			| B_AUTO_UPDATE_SIZE_LIMITS | B_CLOSE_ON_ESCAPE),
+	fSettings(settings),
+	fTarget(target),
+	fSharingRunner(NULL)
+{
+	for (int32 i = 0; i < kSamplingSourceCount; i++)
+		fCosts[i] = costs != NULL ? costs[i] : 0;
+
+	BStringView* description = new BStringView("description",
+		B_TRANSLATE("How often each kind of data is sampled:"));
+
+	fEstimateView = new BStringView("estimate", "");
+	BFont font(be_bold_font);
+	fEstimateView->SetFont(&font);
+
+	fSharingView = new BStringView("sharing", "");
+
+	BLayoutBuilder::Grid<> grid(B_USE_DEFAULT_SPACING, B_USE_SMALL_SPACING);
+	const char* labels[kSamplingSourceCount] = {
+		B_TRANSLATE("CPU:"),
+		B_TRANSLATE("Memory:"),
+		B_TRANSLATE("Network:"),
+		B_TRANSLATE("Disks:"),
+		B_TRANSLATE("Processes:"),
+		B_TRANSLATE("System summary:")
+	};
+	for (int32 i = 0; i < kSamplingSourceCount; i++) {
+		BMenuField* field = _CreateIntervalField(
+			static_cast<sampling_source>(i), labels[i]);
+		fSourceLoadViews[i] = new BStringView(NULL, "");
+		fSourceLoadViews[i]->SetAlignment(B_ALIGN_RIGHT);
+
+		grid.AddMenuField(field, 0, i)
+			.Add(fSourceLoadViews[i], 2, i);
+	}
+
+	BLayoutBuilder::Group<>(this, B_VERTICAL, B_USE_DEFAULT_SPACING)
+		.SetInsets(B_USE_DEFAULT_SPACING)
+		.Add(description)
+		.Add(grid.View())
+		.Add(fEstimateView)
+		.Add(fSharingView)
+		.End();
+
+	_UpdateEstimate();
+	_UpdateSharing();
+	CenterOnScreen();
+
+	BMessage update(kMsgUpdateSharing);
+	fSharingRunner = new(std::nothrow) BMessageRunner(BMessenger(this),
+		&update, 1000000);
+}
+
+
+PreferencesWindow::~PreferencesWindow()
+{
+	delete fSharingRunner;
+}
+
+
+void
+PreferencesWindow::MessageReceived(BMessage* message)
+{
+	switch (message->what) {
+		case kMsgIntervalSelected:
+		{
+			int32 source;
+			bigtime_t interval;
+			if (message->FindInt32("source", &source) != B_OK
+				|| message->FindInt64("interval", &interval) != B_OK) {
+				break;
+			}
+
+			fSettings.SetInterval(static_cast<sampling_source>(source),
+				interval);
+			_UpdateEstimate();
+
+			BMessage changed(kMsgSamplingSettingsChanged);
+			fSettings.SaveState(changed);
+			fTarget.SendMessage(&changed);
+			break;
+		}
+
+		case kMsgUpdateSharing:
+			_UpdateSharing();
+			break;
+
+		default:
+			BWindow::MessageReceived(message);
+			break;
+	}
+}
+
+
+BMenuField*
+PreferencesWindow::_CreateIntervalField(sampling_source source,
+	const char* label)
+{
+	BPopUpMenu* menu = new BPopUpMenu("interval");
+
+	std::vector<bigtime_t> choices(kIntervalChoices, kIntervalChoices
+		+ sizeof(kIntervalChoices) / sizeof(kIntervalChoices[0]));
+
+	// Keep an interval from older settings that isn't one of the choices
+	bigtime_t current = fSettings.Interval(source);
+	if (std::find(choices.begin(), choices.end(), current) == choices.end()) {
+		choices.push_back(current);
+		std::sort(choices.begin(), choices.end());
+	}
+
+	for (size_t i = 0; i < choices.size(); i++) {
+		BString text;
+		FormatInterval(text, choices[i]);
+
+		BMessage* message = new BMessage(kMsgIntervalSelected);
+		message->AddInt32("source", source);
+		message->AddInt64("interval", choices[i]);
+
+		BMenuItem* item = new BMenuItem(text.String(), message);
+		item->SetMarked(choices[i] == current);
+		menu->AddItem(item);
+	}
+
+	return new BMenuField(NULL, label, menu);
+}
+
+
+void
+PreferencesWindow::_UpdateEstimate()
+{
+	BString text;
+	for (int32 i = 0; i < kSamplingSourceCount; i++) {
+		FormatLoad(text, fSettings.EstimatedLoad(
+			static_cast<sampling_source>(i), fCosts[i]));
+		fSourceLoadViews[i]->SetText(text.String());
+	}
+
+	BString load;
+	FormatLoad(load, fSettings.EstimatedLoad(fCosts));
+	text.SetToFormat(B_TRANSLATE("Estimated cost: %s of one CPU"),
+		load.String());
+	fEstimateView->SetText(text.String());
+}
+
+
+void
+PreferencesWindow::_UpdateSharing()
+{
+	// Sources sampled on the same tick share one system_info
+	SystemInfoCache& cache = SystemInfoCache::Default();
+	int64 avoided = cache.KernelCallsAvoided();
+	BString text;
+	text.SetToFormat(B_TRANSLATE("Kernel calls avoided by sharing: %" B_PRId64
+		" of %" B_PRId64), avoided, avoided + cache.KernelCalls());
+	fSharingView->SetText(text.String());
+}
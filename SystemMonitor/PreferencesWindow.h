@@ -0,0 +1,45 @@
+#ifndef PREFERENCESWINDOW_H
+#define PREFERENCESWINDOW_H
+
+#include <Messenger.h>
+#include <Window.h>
+
+#include "SamplingSettings.h"
+
+class BMenuField;
+class BMessageRunner;
+class BStringView;
+
+
+// Sent to the target whenever an interval changes; contains the complete
+// settings as written by SamplingSettings::SaveState().
+const uint32 kMsgSamplingSettingsChanged = 'smch';
+
+
+class PreferencesWindow : public BWindow {
+public:
+							PreferencesWindow(const SamplingSettings& settings,
+								const bigtime_t* costs, BMessenger target);
+	virtual					~PreferencesWindow();
+
+	virtual	void			MessageReceived(BMessage* message);
+
+private:
+			BMenuField*		_CreateIntervalField(sampling_source source,
+								const char* label);
+			void			_UpdateEstimate();
+			void			_UpdateSharing();
+
+private:
+			SamplingSettings fSettings;
+			bigtime_t		fCosts[kSamplingSourceCount];
+			BMessenger		fTarget;
+
+			BStringView*	fSourceLoadViews[kSamplingSourceCount];
+			BStringView*	fEstimateView;
+			BStringView*	fSharingView;
+			// Keeps the kernel call counts live while the window is open
+			BMessageRunner*	fSharingRunner;
+};
+
+#endif // PREFERENCESWINDOW_H
@@ -0,0 +1,411 @@
+#include "ProcessImageCache.h"
+
+#include <Autolock.h>
+#include <Bitmap.h>
+#include <Entry.h>
+#include <NodeInfo.h>
+#include <AppFileInfo.h>
+#include <File.h>
+#include <kernel/image.h>
+#include <cstring>
+#include <algorithm>
+#include <new>
+
+
+// How many images without teams are kept
+static const size_t kUnusedImageCount = 64;
+
+
+ProcessImageCache::ProcessImageCache()
+	:
+	fLock("ProcessImageCache"),
+	fQueueSem(-1),
+	fResolverThread(-1),
+	fTerminated(false)
+{
+}
+
+
+ProcessImageCache::~ProcessImageCache()
+{
+	Stop();
+
+	for (auto& pair : fImagesByPath) {
+		delete pair.second->icon;
+		delete pair.second;
+	}
+}
+
+
+status_t
+ProcessImageCache::Start()
+{
+	if (fResolverThread >= 0)
+		return B_OK;
+
+	fTerminated = false;
+	fQueueSem = create_sem(0, "image resolver queue");
+	if (fQueueSem < 0)
+		return fQueueSem;
+
+	fResolverThread = spawn_thread(_ResolverThread, "image resolver",
+		B_LOW_PRIORITY, this);
+	if (fResolverThread < 0) {
+		delete_sem(fQueueSem);
+		fQueueSem = -1;
+		return fResolverThread;
+	}
+
+	resume_thread(fResolverThread);
+	return B_OK;
+}
+
+
+void
+ProcessImageCache::Stop()
+{
+	fTerminated = true;
+	if (fQueueSem >= 0) {
+		delete_sem(fQueueSem);
+		fQueueSem = -1;
+	}
+	if (fResolverThread >= 0) {
+		status_t ret;
+		wait_for_thread(fResolverThread, &ret);
+		fResolverThread = -1;
+	}
+
+	BAutolock locker(fLock);
+	fQueue.clear();
+
+	// Requests that were still queued will never be answered; drop their
+	// placeholders so they are queued again after a restart.
+	for (auto it = fTeams.begin(); it != fTeams.end();) {
+		if (it->second.image == NULL)
+			it = fTeams.erase(it);
+		else
+			++it;
+	}
+}
+
+
+bool
+ProcessImageCache::Lookup(team_id team, const char* args, int32 generation,
+	char* name, size_t nameSize)
+{
+	TeamKey key = { team, _HashArgs(args) };
+
+	BAutolock locker(fLock);
+
+	auto result = fTeams.emplace(key, TeamEntry{ NULL, generation });
+	TeamEntry& entry = result.first->second;
+	entry.generation = generation;
+
+	if (entry.image == NULL && result.second) {
+		// First sighting: a team started by the same absolute path as a
+		// binary we already know about can share its entry right away.
+		BString argv0 = _Argv0(args);
+		auto imageIt = argv0.ByteAt(0) == '/'
+			? fImagesByArgv0.find(argv0) : fImagesByArgv0.end();
+		if (imageIt != fImagesByArgv0.end()) {
+			_Bind(entry, imageIt->second);
+		} else if (fQueueSem >= 0) {
+			fQueue.push_back(Request{ key, argv0 });
+			release_sem_etc(fQueueSem, 1, B_DO_NOT_RESCHEDULE);
+		}
+	}
+
+	if (entry.image != NULL) {
+		strlcpy(name, entry.image->name, nameSize);
+		return true;
+	}
+
+	_GuessName(args, name, nameSize);
+	return false;
+}
+
+
+void
+ProcessImageCache::Prune(int32 generation)
+{
+	BAutolock locker(fLock);
+
+	for (auto it = fTeams.begin(); it != fTeams.end();) {
+		if (it->second.generation != generation) {
+			if (it->second.image != NULL)
+				_Release(it->second.image);
+			it = fTeams.erase(it);
+		} else
+			++it;
+	}
+}
+
+
+status_t
+ProcessImageCache::GetImage(team_id team, const char* args, BString& path,
+	BString& signature)
+{
+	BAutolock locker(fLock);
+
+	ImageEntry* image = _FindImage(team, args);
+	if (image == NULL)
+		return B_BUSY;
+	if (image->guessed)
+		return B_ENTRY_NOT_FOUND;
+
+	path = image->path;
+	signature = image->signature;
+	return B_OK;
+}
+
+
+status_t
+ProcessImageCache::CopyIcon(team_id team, const char* args, BBitmap* target)
+{
+	if (target == NULL)
+		return B_BAD_VALUE;
+
+	BAutolock locker(fLock);
+
+	ImageEntry* image = _FindImage(team, args);
+	if (image == NULL)
+		return B_BUSY;
+	if (image->icon == NULL)
+		return B_ENTRY_NOT_FOUND;
+
+	return target->ImportBits(image->icon);
+}
+
+
+int32
+ProcessImageCache::_ResolverThread(void* data)
+{
+	ProcessImageCache* cache = static_cast<ProcessImageCache*>(data);
+
+	while (!cache->fTerminated) {
+		status_t err = acquire_sem(cache->fQueueSem);
+		if (err != B_OK && err != B_INTERRUPTED)
+			break;
+
+		while (!cache->fTerminated) {
+			Request request;
+			{
+				BAutolock locker(cache->fLock);
+				if (cache->fQueue.empty())
+					break;
+				request = cache->fQueue.front();
+				cache->fQueue.pop_front();
+			}
+			cache->_Resolve(request.key, request.argv0);
+		}
+	}
+
+	return B_OK;
+}
+
+
+void
+ProcessImageCache::_Resolve(const TeamKey& key, const BString& argv0)
+{
+	// The first image of a team is its executable.
+	image_info info;
+	int32 cookie = 0;
+	bool found = get_next_image_info(key.team, &cookie, &info) == B_OK;
+
+	BString path;
+	ImageEntry* created = NULL;
+	if (found) {
+		path = info.name;
+
+		bool known;
+		{
+			BAutolock locker(fLock);
+			known = fImagesByPath.find(path) != fImagesByPath.end();
+		}
+
+		// Read the signature and icon outside of the lock.
+		if (!known)
+			created = _CreateImage(path.String());
+	}
+
+	BAutolock locker(fLock);
+
+	ImageEntry* image = NULL;
+	auto teamIt = fTeams.find(key);
+	if (teamIt != fTeams.end() && teamIt->second.image == NULL && found) {
+		auto imageIt = fImagesByPath.find(path);
+		if (imageIt != fImagesByPath.end())
+			image = imageIt->second;
+		else if (created != NULL) {
+			fImagesByPath[path] = created;
+			image = created;
+			created = NULL;
+		}
+	}
+
+	if (created != NULL) {
+		// The team went away, or someone else resolved the same binary in
+		// the meantime.
+		delete created->icon;
+		delete created;
+	}
+
+	if (teamIt == fTeams.end() || teamIt->second.image != NULL)
+		return;
+
+	if (image == NULL) {
+		// The team has no image (or is already gone); remember the guess so
+		// we don't ask again.
+		image = new(std::nothrow) ImageEntry;
+		if (image == NULL)
+			return;
+		_GuessName(argv0.String(), image->name, sizeof(image->name));
+		image->signature[0] = '\0';
+		image->icon = NULL;
+		image->refCount = 0;
+		image->guessed = true;
+		image->path.SetToFormat("<team %" B_PRId32 ">", key.team);
+		fImagesByPath[image->path] = image;
+	} else if (argv0.ByteAt(0) == '/') {
+		// A relative argv[0] like "./run" says nothing about the binary
+		// the next team started that way runs, so only the path is shared
+		fImagesByArgv0.emplace(argv0, image);
+	}
+
+	_Bind(teamIt->second, image);
+}
+
+
+ProcessImageCache::ImageEntry*
+ProcessImageCache::_CreateImage(const char* path)
+{
+	ImageEntry* image = new(std::nothrow) ImageEntry;
+	if (image == NULL)
+		return NULL;
+
+	image->path = path;
+	image->refCount = 0;
+	image->guessed = false;
+	image->signature[0] = '\0';
+	image->icon = NULL;
+
+	const char* leafName = strrchr(path, '/');
+	strlcpy(image->name, leafName != NULL ? leafName + 1 : path,
+		sizeof(image->name));
+
+	BFile file(path, B_READ_ONLY);
+	BAppFileInfo appInfo;
+	if (file.InitCheck() == B_OK && appInfo.SetTo(&file) == B_OK)
+		appInfo.GetSignature(image->signature);
+
+	entry_ref ref;
+	if (get_ref_for_path(path, &ref) == B_OK) {
+		BBitmap* icon = new(std::nothrow) BBitmap(BRect(0, 0, 15, 15),
+			B_RGBA32);
+		if (icon != NULL && icon->InitCheck() == B_OK
+			&& BNodeInfo::GetTrackerIcon(&ref, icon, B_MINI_ICON) == B_OK) {
+			image->icon = icon;
+		} else
+			delete icon;
+	}
+
+	return image;
+}
+
+
+void
+ProcessImageCache::_Bind(TeamEntry& entry, ImageEntry* image)
+{
+	entry.image = image;
+	if (image->refCount++ == 0) {
+		fUnusedImages.erase(std::remove(fUnusedImages.begin(),
+			fUnusedImages.end(), image), fUnusedImages.end());
+	}
+}
+
+
+void
+ProcessImageCache::_Release(ImageEntry* image)
+{
+	if (--image->refCount > 0)
+		return;
+
+	// Team IDs aren't reused any time soon
+	if (image->guessed) {
+		_Delete(image);
+		return;
+	}
+
+	try {
+		fUnusedImages.push_back(image);
+	} catch (const std::bad_alloc&) {
+		_Delete(image);
+		return;
+	}
+
+	if (fUnusedImages.size() > kUnusedImageCount) {
+		ImageEntry* oldest = fUnusedImages.front();
+		fUnusedImages.pop_front();
+		_Delete(oldest);
+	}
+}
+
+
+void
+ProcessImageCache::_Delete(ImageEntry* image)
+{
+	fImagesByPath.erase(image->path);
+	for (auto it = fImagesByArgv0.begin(); it != fImagesByArgv0.end();) {
+		if (it->second == image)
+			it = fImagesByArgv0.erase(it);
+		else
+			++it;
+	}
+
+	delete image->icon;
+	delete image;
+}
+
+
+ProcessImageCache::ImageEntry*
+ProcessImageCache::_FindImage(team_id team, const char* args)
+{
+	TeamKey key = { team, _HashArgs(args) };
+	auto it = fTeams.find(key);
+	return it != fTeams.end() ? it->second.image : NULL;
+}
+
+
+uint64
+ProcessImageCache::_HashArgs(const char* args)
+{
+	// FNV-1a over the (at most 64 byte) argument string
+	uint64 hash = 0xcbf29ce484222325ULL;
+	for (size_t i = 0; i < 64 && args[i] != '\0'; i++) {
+		hash ^= static_cast<uint8>(args[i]);
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+
+void
+ProcessImageCache::_GuessName(const char* args, char* name, size_t nameSize)
+{
+	BString argv0 = _Argv0(args);
+	const char* leafName = strrchr(argv0.String(), '/');
+	strlcpy(name, leafName != NULL ? leafName + 1 : argv0.String(), nameSize);
+	if (name[0] == '\0')
+		strlcpy(name, "system_daemon", nameSize);
+}
+
+
+BString
+ProcessImageCache::_Argv0(const char* args)
+{
+	size_t length = strnlen(args, 64);
+	const char* space = static_cast<const char*>(memchr(args, ' ', length));
+	if (space != NULL)
+		length = space - args;
+	return BString(args, length);
+}
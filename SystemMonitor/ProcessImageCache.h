@@ -0,0 +1,121 @@
+#ifndef PROCESSIMAGECACHE_H
+#define PROCESSIMAGECACHE_H
+
+#include <OS.h>
+#include <Locker.h>
+#include <Mime.h>
+#include <String.h>
+#include <unordered_map>
+#include <deque>
+#include <atomic>
+
+class BBitmap;
+
+
+// Resolves the executable image of a team (leaf name, full path, app
+// signature and mini icon) on a low-priority background thread.
+// Resolved images are shared between all teams running the same binary, so
+// the sampling thread only ever does a hash lookup. Images no team uses
+// anymore are kept for a while, so a binary that is started over and over
+// is only resolved once.
+class ProcessImageCache {
+public:
+						ProcessImageCache();
+						~ProcessImageCache();
+
+			status_t	Start();
+			void		Stop();
+
+			// Returns true if the team's image has been resolved. On a miss
+			// the team is queued for resolution and name is set to a
+			// best-effort guess derived from its args.
+			bool		Lookup(team_id team, const char* args,
+							int32 generation, char* name, size_t nameSize);
+			void		Prune(int32 generation);
+
+			// Both take the args the team was looked up with, and return
+			// B_BUSY while its image is still being resolved.
+			status_t	GetImage(team_id team, const char* args,
+							BString& path, BString& signature);
+			// Returns B_ENTRY_NOT_FOUND if the image has no icon.
+			status_t	CopyIcon(team_id team, const char* args,
+							BBitmap* target);
+
+private:
+	struct ImageEntry {
+		char		name[B_OS_NAME_LENGTH];
+		BString		path;
+		char		signature[B_MIME_TYPE_LENGTH];
+		BBitmap*	icon;
+		int32		refCount;
+		// A placeholder for a team without image, never shared
+		bool		guessed;
+	};
+
+	struct TeamKey {
+		team_id		team;
+		uint64		argsHash;
+
+		bool operator==(const TeamKey& other) const
+		{
+			return team == other.team && argsHash == other.argsHash;
+		}
+	};
+
+	struct TeamKeyHash {
+		size_t operator()(const TeamKey& key) const
+		{
+			return static_cast<size_t>(key.argsHash
+				^ (static_cast<uint64>(key.team) * 0x9e3779b97f4a7c15ULL));
+		}
+	};
+
+	struct TeamEntry {
+		ImageEntry*	image;
+		int32		generation;
+	};
+
+	struct BStringHash {
+		size_t operator()(const BString& s) const {
+			size_t hash = 5381;
+			const char* str = s.String();
+			int c;
+			while ((c = *str++))
+				hash = ((hash << 5) + hash) + c;
+			return hash;
+		}
+	};
+
+	static	int32		_ResolverThread(void* data);
+			void		_Resolve(const TeamKey& key, const BString& argv0);
+			ImageEntry*	_CreateImage(const char* path);
+			void		_Bind(TeamEntry& entry, ImageEntry* image);
+			void		_Release(ImageEntry* image);
+			void		_Delete(ImageEntry* image);
+			ImageEntry*	_FindImage(team_id team, const char* args);
+
+	static	uint64		_HashArgs(const char* args);
+	static	void		_GuessName(const char* args, char* name,
+							size_t nameSize);
+	static	BString		_Argv0(const char* args);
+
+	BLocker				fLock;
+	std::unordered_map<TeamKey, TeamEntry, TeamKeyHash> fTeams;
+	std::unordered_map<BString, ImageEntry*, BStringHash> fImagesByPath;
+	// Only absolute argv[0]s, relative ones may name different binaries
+	std::unordered_map<BString, ImageEntry*, BStringHash> fImagesByArgv0;
+	// Images without teams, least recently used first
+	std::deque<ImageEntry*> fUnusedImages;
+
+	struct Request {
+		TeamKey		key;
+		BString		argv0;
+	};
+	std::deque<Request>	fQueue;
+
+	sem_id				fQueueSem;
+	thread_id			fResolverThread;
+	std::atomic<bool>	fTerminated;
+};
+
+#endif // PROCESSIMAGECACHE_H
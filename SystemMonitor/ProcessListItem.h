@@ -1,24 +1,42 @@
 #ifndef PROCESSLISTITEM_H
 #define PROCESSLISTITEM_H
 
+#include <Bitmap.h>
 #include <ListItem.h>
 #include <String.h>
 #include <Font.h>
 #include <View.h>
 #include <InterfaceDefs.h>
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include "ProcessView.h"
 #include "Utils.h"
 
 class ProcessListItem : public BListItem {
 public:
+	// Room for the mini icon in front of the name
+	static const int32 kIconSpace = B_MINI_ICON + 4;
+
 	ProcessListItem(const ProcessInfo& info, const char* stateStr,
 		const BFont* font, ProcessView* view)
-		: BListItem(), fGeneration(0), fView(view)
+		: BListItem(), fIcon(NULL), fIconPending(true), fGeneration(0),
+		  fView(view)
 	{
 		Update(info, stateStr, font, true);
 	}
 
+	virtual ~ProcessListItem() { delete fIcon; }
+
+	// Asked for until the team's image has been resolved
+	bool IconPending() const { return fIconPending; }
+	void SetIcon(BBitmap* icon)
+	{
+		delete fIcon;
+		fIcon = icon;
+		fIconPending = false;
+	}
+
 	void SetGeneration(int32 generation) { fGeneration = generation; }
 	int32 Generation() const { return fGeneration; }
 
@@ -42,7 +60,7 @@ public:
 			if (font && fView) {
 				fTruncatedName = fInfo.name;
 				font->TruncateString(&fTruncatedName, B_TRUNCATE_END,
-					fView->NameWidth() - 10);
+					fView->NameWidth() - 10 - kIconSpace);
 			} else {
 				fTruncatedName = fInfo.name;
 			}
@@ -92,7 +110,17 @@ public:
 		float y = itemRect.bottom - fh.descent;
 
 		owner->DrawString(fCachedPID.String(),    BPoint(x, y)); x += fView->PIDWidth();
-		owner->DrawString(fTruncatedName.String(), BPoint(x, y)); x += fView->NameWidth();
+		if (fIcon != NULL) {
+			// Shrunk to fit with small fonts
+			float size = std::min((float)B_MINI_ICON, itemRect.Height());
+			float top = itemRect.top + floorf((itemRect.Height() - size) / 2);
+			owner->SetDrawingMode(B_OP_ALPHA);
+			owner->DrawBitmap(fIcon, fIcon->Bounds(),
+				BRect(x, top, x + size - 1, top + size - 1));
+			owner->SetDrawingMode(B_OP_COPY);
+		}
+		owner->DrawString(fTruncatedName.String(), BPoint(x + kIconSpace, y));
+		x += fView->NameWidth();
 		owner->DrawString(fCachedState.String(),   BPoint(x, y)); x += fView->StateWidth();
 		owner->DrawString(fCachedCPU.String(),     BPoint(x, y)); x += fView->CPUWidth();
 		owner->DrawString(fCachedMem.String(),     BPoint(x, y)); x += fView->MemWidth();
@@ -152,6 +180,8 @@ public:
 
 private:
 	ProcessInfo	fInfo;
+	BBitmap*	fIcon;
+	bool		fIconPending;
 	BString		fCachedPID;
 	BString		fCachedState;
 	BString		fCachedCPU;
@@ -16,6 +16,7 @@
 #include <cstring>
 #include <MenuItem.h>
 #include <Font.h>
+#include <new>
 #include <vector>
 #include <unordered_set>
 #include <Window.h>
@@ -25,6 +26,7 @@
 #include <ScrollView.h>
 #include <Autolock.h>
 #include "ProcessListItem.h"
+#include "SystemInfoCache.h"
 
 #undef B_TRANSLATION_CONTEXT
 #define B_TRANSLATION_CONTEXT "ProcessView"
@@ -58,9 +60,6 @@ ProcessView::ProcessView()
 	  fFilterArgs(""),
 	  fLastSystemTime(0),
 	  fRefreshInterval(1000000),
-	  fUpdateThread(B_ERROR),
-	  fQuitSem(-1),
-	  fTerminated(false),
 	  fIsHidden(false),
 	  fSortMode(SORT_BY_CPU),
 	  fCurrentGeneration(0),
@@ -68,7 +67,11 @@ ProcessView::ProcessView()
 {
 	SetViewColor(ui_color(B_PANEL_BACKGROUND_COLOR));
 
-	fQuitSem = create_sem(0, "ProcessView Quit");
+	fProcessList.reserve(128);
+
+	long bufSize = sysconf(_SC_GETPW_R_SIZE_MAX);
+	if (bufSize == -1) bufSize = 16384;
+	fPasswordBuffer.resize(bufSize);
 
 	fSearchControl = new BTextControl("Search", B_TRANSLATE("Search:"), "", new BMessage(MSG_SEARCH_UPDATED));
 	fSearchControl->SetModificationMessage(new BMessage(MSG_SEARCH_UPDATED));
@@ -137,13 +140,7 @@ ProcessView::ProcessView()
 
 ProcessView::~ProcessView()
 {
-	fTerminated = true;
-	if (fQuitSem >= 0)
-		delete_sem(fQuitSem);
-	if (fUpdateThread != B_ERROR) {
-		status_t ret;
-		wait_for_thread(fUpdateThread, &ret);
-	}
+	SamplingScheduler::Default().RemoveCollector(this);
 	delete fContextMenu;
 
 	fProcessListView->MakeEmpty(); // Just clears pointers
@@ -157,34 +154,27 @@ ProcessView::~ProcessView()
 void ProcessView::AttachedToWindow()
 {
 	BView::AttachedToWindow();
-	fTerminated = false;
 	fProcessListView->SetTarget(this);
 	fSearchControl->SetTarget(this);
 	fLastSystemTime = system_time();
 
-	if (fQuitSem < 0)
-		fQuitSem = create_sem(0, "ProcessView Quit");
-
 	fThreadTimeMap.clear();
 	fCachedTeamInfo.clear();
-
-	fUpdateThread = spawn_thread(UpdateThread, "Process Update", B_NORMAL_PRIORITY, this);
-	if (fUpdateThread >= 0)
-		resume_thread(fUpdateThread);
+	fImageCache.Start();
+
+	// The first pass only fills the caches, so get it over with right away.
+	// Scanning every team takes a while, so CPU and memory sampling must
+	// not wait for it.
+	SamplingScheduler& scheduler = SamplingScheduler::Default();
+	scheduler.AddCollector(this, fRefreshInterval, !fIsHidden,
+		kSamplingLaneSlow);
+	scheduler.Trigger(this);
 }
 
 void ProcessView::DetachedFromWindow()
 {
-	fTerminated = true;
-	if (fQuitSem >= 0) {
-		delete_sem(fQuitSem);
-		fQuitSem = -1;
-	}
-	if (fUpdateThread != B_ERROR) {
-		status_t ret;
-		wait_for_thread(fUpdateThread, &ret);
-		fUpdateThread = B_ERROR;
-	}
+	SamplingScheduler::Default().RemoveCollector(this);
+	fImageCache.Stop();
 }
 
 void ProcessView::MessageReceived(BMessage* message)
@@ -263,12 +253,14 @@ void ProcessView::KeyDown(const char* bytes, int32 numBytes)
 void ProcessView::Hide()
 {
 	fIsHidden = true;
+	SamplingScheduler::Default().SetEnabled(this, false);
 	BView::Hide();
 }
 
 void ProcessView::Show()
 {
 	fIsHidden = false;
+	SamplingScheduler::Default().SetEnabled(this, true);
 	BView::Show();
 }
 
@@ -301,6 +293,29 @@ void ProcessView::ShowContextMenu(BPoint screenPoint) {
 	fContextMenu->Go(screenPoint, true, true, true);
 }
 
+void ProcessView::_UpdateIcon(ProcessListItem* item, const ProcessInfo& info)
+{
+	BBitmap* icon = new(std::nothrow) BBitmap(BRect(0, 0, B_MINI_ICON - 1,
+		B_MINI_ICON - 1), B_RGBA32);
+	if (icon == NULL || icon->InitCheck() != B_OK) {
+		delete icon;
+		return;
+	}
+
+	status_t status = fImageCache.CopyIcon(info.id, info.args, icon);
+	if (status == B_BUSY) {
+		// Not resolved yet, ask again with the next update
+		delete icon;
+		return;
+	}
+
+	if (status != B_OK) {
+		delete icon;
+		icon = NULL;
+	}
+	item->SetIcon(icon);
+}
+
 void ProcessView::KillSelectedProcess() {
 	int32 selection = fProcessListView->CurrentSelection();
 	if (selection < 0) return;
@@ -313,6 +328,14 @@ void ProcessView::KillSelectedProcess() {
 	BString alertMsg;
 	alertMsg.SetToFormat(B_TRANSLATE("Are you sure you want to kill process %d (%s)?"),
 						 static_cast<int>(team), item->Name());
+
+	// Tell apart teams of the same name
+	BString path, signature;
+	if (fImageCache.GetImage(team, item->Info().args, path, signature) == B_OK) {
+		alertMsg << "\n\n" << path;
+		if (signature.Length() > 0)
+			alertMsg << "\n" << signature;
+	}
 	BAlert* confirmAlert = new BAlert(B_TRANSLATE("Confirm Kill"), alertMsg.String(), B_TRANSLATE("Kill"), B_TRANSLATE("Cancel"),
 									  NULL, B_WIDTH_AS_USUAL, B_WARNING_ALERT);
 
@@ -354,8 +377,7 @@ void ProcessView::SetSelectedProcessPriority(int32 priority) {
 void ProcessView::SetRefreshInterval(bigtime_t interval)
 {
 	fRefreshInterval = interval;
-	if (fQuitSem >= 0)
-		release_sem(fQuitSem);
+	SamplingScheduler::Default().SetInterval(this, interval);
 }
 
 void ProcessView::_SortItems()
@@ -506,6 +528,7 @@ void ProcessView::Update(BMessage* message)
 		if (result.second) {
 			item = new ProcessListItem(info, stateStr, &font, this);
 			result.first->second = item;
+			_UpdateIcon(item, info);
 
 			if (match) {
 				fProcessListView->AddItem(item);
@@ -514,6 +537,8 @@ void ProcessView::Update(BMessage* message)
 		} else {
 			item = result.first->second;
 			item->Update(info, stateStr, &font, fontChanged);
+			if (item->IconPending())
+				_UpdateIcon(item, info);
 
 			if (match) {
 				if (fVisibleItems.insert(item).second)
@@ -547,248 +572,217 @@ void ProcessView::Update(BMessage* message)
 	fProcessListView->Invalidate();
 }
 
-int32 ProcessView::UpdateThread(void* data)
+void ProcessView::Collect(bigtime_t now)
 {
-	// Implementation remains largely same, just logic to fetch data
-	ProcessView* view = static_cast<ProcessView*>(data);
-	BMessenger target(view);
+	BMessenger target(this);
 
-	std::vector<ProcessInfo> procList;
-	procList.reserve(128);
+	fCurrentGeneration++;
+	fProcessList.clear();
 
-	long bufSize = sysconf(_SC_GETPW_R_SIZE_MAX);
-	if (bufSize == -1) bufSize = 16384;
-	std::vector<char> pwdBuffer(bufSize);
+	bigtime_t systemTimeDelta = now - fLastSystemTime;
+	if (systemTimeDelta <= 0) systemTimeDelta = 1;
+	fLastSystemTime = now;
 
-	while (!view->fTerminated) {
-		if (view->fIsHidden) {
-			status_t err = acquire_sem_etc(view->fQuitSem, 1, B_RELATIVE_TIMEOUT, view->fRefreshInterval);
-			if (err != B_OK && err != B_TIMED_OUT && err != B_INTERRUPTED) break;
-			continue;
-		}
+	system_info sysInfo;
+	SystemInfoCache::Default().GetSystemInfo(sysInfo, now);
+	float totalPossibleCoreTime = sysInfo.cpu_count * systemTimeDelta;
+	if (totalPossibleCoreTime <= 0) totalPossibleCoreTime = 1.0f;
 
-		view->fCurrentGeneration++;
-		procList.clear();
-
-		bigtime_t currentSystemTime = system_time();
-		bigtime_t systemTimeDelta = currentSystemTime - view->fLastSystemTime;
-		if (systemTimeDelta <= 0) systemTimeDelta = 1;
-		view->fLastSystemTime = currentSystemTime;
-
-		system_info sysInfo;
-		get_system_info(&sysInfo);
-		float totalPossibleCoreTime = sysInfo.cpu_count * systemTimeDelta;
-		if (totalPossibleCoreTime <= 0) totalPossibleCoreTime = 1.0f;
-
-		int32 cookie = 0;
-		team_info teamInfo;
-		while (get_next_team_info(&cookie, &teamInfo) == B_OK) {
-			ProcessInfo currentProc;
-			currentProc.id = teamInfo.team;
-			currentProc.userID = teamInfo.uid;
-
-			CachedTeamInfo* cachedInfo = nullptr;
-			bool cached = false;
-			bool memoryNeedsUpdate = true;
-			auto it = view->fCachedTeamInfo.find(teamInfo.team);
-			if (it != view->fCachedTeamInfo.end()) {
-				cachedInfo = &it->second;
-				if (teamInfo.uid == cachedInfo->uid
-					&& strncmp(teamInfo.args, cachedInfo->args, 64) == 0) {
-					cached = true;
-					strlcpy(currentProc.name, cachedInfo->name, B_OS_NAME_LENGTH);
-					strlcpy(currentProc.userName, cachedInfo->userName, B_OS_NAME_LENGTH);
-					strlcpy(currentProc.args, cachedInfo->args, sizeof(currentProc.args));
-					cachedInfo->generation = view->fCurrentGeneration;
-
-					// Update user generation even if process is cached
-					auto userIt = view->fUserNameCache.find(teamInfo.uid);
-					if (userIt != view->fUserNameCache.end())
-						userIt->second.generation = view->fCurrentGeneration;
-
-					// Optimize memory calculation
-					if (cachedInfo->cachedAreaCount == teamInfo.area_count
-						&& (view->fCurrentGeneration - cachedInfo->memoryGeneration < kMemoryCacheGenerations)) {
-						memoryNeedsUpdate = false;
-						currentProc.memoryUsageBytes = cachedInfo->memoryUsage;
-					}
+	int32 cookie = 0;
+	team_info teamInfo;
+	while (get_next_team_info(&cookie, &teamInfo) == B_OK) {
+		ProcessInfo currentProc;
+		currentProc.id = teamInfo.team;
+		currentProc.userID = teamInfo.uid;
+
+		CachedTeamInfo* cachedInfo = nullptr;
+		bool cached = false;
+		bool memoryNeedsUpdate = true;
+		auto it = fCachedTeamInfo.find(teamInfo.team);
+		if (it != fCachedTeamInfo.end()) {
+			cachedInfo = &it->second;
+			if (teamInfo.uid == cachedInfo->uid
+				&& strncmp(teamInfo.args, cachedInfo->args, 64) == 0) {
+				cached = true;
+				// Keeps the image entry alive, and picks up the real name
+				// once the background resolver has finished.
+				fImageCache.Lookup(teamInfo.team, teamInfo.args,
+					fCurrentGeneration, cachedInfo->name, B_OS_NAME_LENGTH);
+				strlcpy(currentProc.name, cachedInfo->name, B_OS_NAME_LENGTH);
+				strlcpy(currentProc.userName, cachedInfo->userName, B_OS_NAME_LENGTH);
+				strlcpy(currentProc.args, cachedInfo->args, sizeof(currentProc.args));
+				cachedInfo->generation = fCurrentGeneration;
+
+				// Update user generation even if process is cached
+				auto userIt = fUserNameCache.find(teamInfo.uid);
+				if (userIt != fUserNameCache.end())
+					userIt->second.generation = fCurrentGeneration;
+
+				// Optimize memory calculation
+				if (cachedInfo->cachedAreaCount == teamInfo.area_count
+					&& (fCurrentGeneration - cachedInfo->memoryGeneration < kMemoryCacheGenerations)) {
+					memoryNeedsUpdate = false;
+					currentProc.memoryUsageBytes = cachedInfo->memoryUsage;
 				}
 			}
+		}
 
-			if (!cached) {
-				image_info imgInfo;
-				int32 imgCookie = 0;
-				if (get_next_image_info(teamInfo.team, &imgCookie, &imgInfo) == B_OK) {
-					const char* leafName = strrchr(imgInfo.name, '/');
-					if (leafName != NULL)
-						strlcpy(currentProc.name, leafName + 1, B_OS_NAME_LENGTH);
-					else
-						strlcpy(currentProc.name, imgInfo.name, B_OS_NAME_LENGTH);
-				} else {
-					strlcpy(currentProc.name, teamInfo.args, B_OS_NAME_LENGTH);
-					if (strlen(currentProc.name) == 0)
-						strlcpy(currentProc.name, "system_daemon", B_OS_NAME_LENGTH);
-				}
-
-				BString userName = view->GetUserName(currentProc.userID, pwdBuffer);
-				strlcpy(currentProc.userName, userName.String(), B_OS_NAME_LENGTH);
-
-				strlcpy(currentProc.args, teamInfo.args, sizeof(currentProc.args));
-
-				CachedTeamInfo info;
-				strlcpy(info.name, currentProc.name, B_OS_NAME_LENGTH);
-				strlcpy(info.userName, currentProc.userName, B_OS_NAME_LENGTH);
-				strlcpy(info.args, teamInfo.args, 64);
-				info.uid = teamInfo.uid;
-				info.generation = view->fCurrentGeneration;
-				// Initialization for new cache entry (memory updated later)
-				info.memoryUsage = 0;
-				info.cachedAreaCount = -1;
-				info.memoryGeneration = 0;
-				info.cpuTime = 0;
-				info.lastRunningThread = -1;
-
-				if (cachedInfo != nullptr) {
-					*cachedInfo = info;
-				} else {
-					auto result = view->fCachedTeamInfo.emplace(teamInfo.team, info);
-					cachedInfo = &result.first->second;
-				}
+		if (!cached) {
+			// Only a hash lookup; unknown images are resolved in the background
+			fImageCache.Lookup(teamInfo.team, teamInfo.args,
+				fCurrentGeneration, currentProc.name, B_OS_NAME_LENGTH);
+
+			BString userName = GetUserName(currentProc.userID, fPasswordBuffer);
+			strlcpy(currentProc.userName, userName.String(), B_OS_NAME_LENGTH);
+
+			strlcpy(currentProc.args, teamInfo.args, sizeof(currentProc.args));
+
+			CachedTeamInfo info;
+			strlcpy(info.name, currentProc.name, B_OS_NAME_LENGTH);
+			strlcpy(info.userName, currentProc.userName, B_OS_NAME_LENGTH);
+			strlcpy(info.args, teamInfo.args, 64);
+			info.uid = teamInfo.uid;
+			info.generation = fCurrentGeneration;
+			// Initialization for new cache entry (memory updated later)
+			info.memoryUsage = 0;
+			info.cachedAreaCount = -1;
+			info.memoryGeneration = 0;
+			info.cpuTime = 0;
+			info.lastRunningThread = -1;
+
+			if (cachedInfo != nullptr) {
+				*cachedInfo = info;
+			} else {
+				auto result = fCachedTeamInfo.emplace(teamInfo.team, info);
+				cachedInfo = &result.first->second;
 			}
+		}
 
-			currentProc.threadCount = teamInfo.thread_count;
-			currentProc.areaCount = teamInfo.area_count;
+		currentProc.threadCount = teamInfo.thread_count;
+		currentProc.areaCount = teamInfo.area_count;
 
-			int32 threadCookie = 0;
-			thread_info tInfo;
-			bigtime_t teamActiveTimeDelta = 0;
+		int32 threadCookie = 0;
+		thread_info tInfo;
+		bigtime_t teamActiveTimeDelta = 0;
 
-			bool isRunning = false;
-			bool isReady = false;
+		bool isRunning = false;
+		bool isReady = false;
 
-			if (teamInfo.team == 1) { // Kernel team: use thread iteration
-				while (get_next_thread_info(teamInfo.team, &threadCookie, &tInfo) == B_OK) {
-					bigtime_t threadTime = tInfo.user_time + tInfo.kernel_time;
+		if (teamInfo.team == 1) { // Kernel team: use thread iteration
+			while (get_next_thread_info(teamInfo.team, &threadCookie, &tInfo) == B_OK) {
+				bigtime_t threadTime = tInfo.user_time + tInfo.kernel_time;
 
-					if (tInfo.state == B_THREAD_RUNNING) isRunning = true;
-					if (tInfo.state == B_THREAD_READY) isReady = true;
+				if (tInfo.state == B_THREAD_RUNNING) isRunning = true;
+				if (tInfo.state == B_THREAD_READY) isReady = true;
 
-					auto result = view->fThreadTimeMap.emplace(tInfo.thread,
-						ThreadState{threadTime, view->fCurrentGeneration});
-					if (!result.second) {
-						bigtime_t threadTimeDelta = threadTime - result.first->second.time;
-						if (threadTimeDelta < 0) threadTimeDelta = 0;
+				auto result = fThreadTimeMap.emplace(tInfo.thread,
+					ThreadState{threadTime, fCurrentGeneration});
+				if (!result.second) {
+					bigtime_t threadTimeDelta = threadTime - result.first->second.time;
+					if (threadTimeDelta < 0) threadTimeDelta = 0;
 
-						if (strstr(tInfo.name, "idle thread") == NULL) {
-							teamActiveTimeDelta += threadTimeDelta;
-						}
-						result.first->second.time = threadTime;
-						result.first->second.generation = view->fCurrentGeneration;
+					if (strstr(tInfo.name, "idle thread") == NULL) {
+						teamActiveTimeDelta += threadTimeDelta;
 					}
+					result.first->second.time = threadTime;
+					result.first->second.generation = fCurrentGeneration;
+				}
+			}
+		} else { // Regular teams: use bulk API and optimized state check
+			team_usage_info usageInfo;
+			bool skipThreadScan = false;
+			if (get_team_usage_info(teamInfo.team, B_TEAM_USAGE_SELF, &usageInfo) == B_OK) {
+				bigtime_t currentTeamTime = usageInfo.user_time + usageInfo.kernel_time;
+				if (cached) {
+					teamActiveTimeDelta = currentTeamTime - cachedInfo->cpuTime;
+					if (teamActiveTimeDelta < 0) teamActiveTimeDelta = 0;
 				}
-			} else { // Regular teams: use bulk API and optimized state check
-				team_usage_info usageInfo;
-				bool skipThreadScan = false;
-				if (get_team_usage_info(teamInfo.team, B_TEAM_USAGE_SELF, &usageInfo) == B_OK) {
-					bigtime_t currentTeamTime = usageInfo.user_time + usageInfo.kernel_time;
-					if (cached) {
-						teamActiveTimeDelta = currentTeamTime - cachedInfo->cpuTime;
-						if (teamActiveTimeDelta < 0) teamActiveTimeDelta = 0;
+				cachedInfo->cpuTime = currentTeamTime;
+			}
+
+			if (!skipThreadScan) {
+				// Optimization: Check the last known running thread first
+				if (cached && cachedInfo->lastRunningThread != -1) {
+					thread_info lastInfo;
+					if (get_thread_info(cachedInfo->lastRunningThread, &lastInfo) == B_OK
+						&& lastInfo.team == teamInfo.team
+						&& lastInfo.state == B_THREAD_RUNNING) {
+						isRunning = true;
+						skipThreadScan = true;
 					}
-					cachedInfo->cpuTime = currentTeamTime;
 				}
 
 				if (!skipThreadScan) {
-					// Optimization: Check the last known running thread first
-					if (cached && cachedInfo->lastRunningThread != -1) {
-						thread_info lastInfo;
-						if (get_thread_info(cachedInfo->lastRunningThread, &lastInfo) == B_OK
-							&& lastInfo.team == teamInfo.team
-							&& lastInfo.state == B_THREAD_RUNNING) {
+					while (get_next_thread_info(teamInfo.team, &threadCookie, &tInfo) == B_OK) {
+						if (tInfo.state == B_THREAD_RUNNING) {
 							isRunning = true;
-							skipThreadScan = true;
-						}
-					}
-
-					if (!skipThreadScan) {
-						while (get_next_thread_info(teamInfo.team, &threadCookie, &tInfo) == B_OK) {
-							if (tInfo.state == B_THREAD_RUNNING) {
-								isRunning = true;
-								cachedInfo->lastRunningThread = tInfo.thread;
-								break; // Found running, can stop scanning
-							}
-							if (tInfo.state == B_THREAD_READY) isReady = true;
+							cachedInfo->lastRunningThread = tInfo.thread;
+							break; // Found running, can stop scanning
 						}
+						if (tInfo.state == B_THREAD_READY) isReady = true;
 					}
 				}
 			}
+		}
 
-			if (isRunning) currentProc.state = PROCESS_STATE_RUNNING;
-			else if (isReady) currentProc.state = PROCESS_STATE_READY;
-			else currentProc.state = PROCESS_STATE_SLEEPING;
-
-			float teamCpuPercent = static_cast<float>(teamActiveTimeDelta) / totalPossibleCoreTime * 100.0f;
-			if (teamCpuPercent < 0.0f) teamCpuPercent = 0.0f;
-			if (teamCpuPercent > 100.0f) teamCpuPercent = 100.0f;
-			currentProc.cpuUsage = teamCpuPercent;
-
-			if (memoryNeedsUpdate) {
-				currentProc.memoryUsageBytes = 0;
-				area_info areaInfo;
-				ssize_t areaCookie = 0;
-				while (get_next_area_info(teamInfo.team, &areaCookie, &areaInfo) == B_OK) {
-					currentProc.memoryUsageBytes += areaInfo.ram_size;
-				}
-
-				// Update cache
-				if (cachedInfo != nullptr) {
-					cachedInfo->memoryUsage = currentProc.memoryUsageBytes;
-					cachedInfo->cachedAreaCount = teamInfo.area_count;
-					cachedInfo->memoryGeneration = view->fCurrentGeneration;
-				}
+		if (isRunning) currentProc.state = PROCESS_STATE_RUNNING;
+		else if (isReady) currentProc.state = PROCESS_STATE_READY;
+		else currentProc.state = PROCESS_STATE_SLEEPING;
+
+		float teamCpuPercent = static_cast<float>(teamActiveTimeDelta) / totalPossibleCoreTime * 100.0f;
+		if (teamCpuPercent < 0.0f) teamCpuPercent = 0.0f;
+		if (teamCpuPercent > 100.0f) teamCpuPercent = 100.0f;
+		currentProc.cpuUsage = teamCpuPercent;
+
+		if (memoryNeedsUpdate) {
+			currentProc.memoryUsageBytes = 0;
+			area_info areaInfo;
+			ssize_t areaCookie = 0;
+			while (get_next_area_info(teamInfo.team, &areaCookie, &areaInfo) == B_OK) {
+				currentProc.memoryUsageBytes += areaInfo.ram_size;
 			}
 
-			procList.push_back(currentProc);
-		}
-
-		for (auto it = view->fThreadTimeMap.begin(); it != view->fThreadTimeMap.end();) {
-			if (it->second.generation != view->fCurrentGeneration)
-				it = view->fThreadTimeMap.erase(it);
-			else
-				++it;
+			// Update cache
+			if (cachedInfo != nullptr) {
+				cachedInfo->memoryUsage = currentProc.memoryUsageBytes;
+				cachedInfo->cachedAreaCount = teamInfo.area_count;
+				cachedInfo->memoryGeneration = fCurrentGeneration;
+			}
 		}
 
-		for (auto it = view->fCachedTeamInfo.begin(); it != view->fCachedTeamInfo.end();) {
-			if (it->second.generation != view->fCurrentGeneration)
-				it = view->fCachedTeamInfo.erase(it);
-			else
-				++it;
-		}
+		fProcessList.push_back(currentProc);
+	}
 
-		for (auto it = view->fUserNameCache.begin(); it != view->fUserNameCache.end();) {
-			if (it->second.generation != view->fCurrentGeneration)
-				it = view->fUserNameCache.erase(it);
-			else
-				++it;
-		}
+	for (auto it = fThreadTimeMap.begin(); it != fThreadTimeMap.end();) {
+		if (it->second.generation != fCurrentGeneration)
+			it = fThreadTimeMap.erase(it);
+		else
+			++it;
+	}
 
-		if (!procList.empty()) {
-			BMessage msg(MSG_PROCESS_DATA_UPDATE);
-			msg.AddData("procs", B_RAW_TYPE, procList.data(), procList.size() * sizeof(ProcessInfo));
-			target.SendMessage(&msg);
-		}
+	for (auto it = fCachedTeamInfo.begin(); it != fCachedTeamInfo.end();) {
+		if (it->second.generation != fCurrentGeneration)
+			it = fCachedTeamInfo.erase(it);
+		else
+			++it;
+	}
 
-		status_t err = acquire_sem_etc(view->fQuitSem, 1, B_RELATIVE_TIMEOUT, view->fRefreshInterval);
-		if (err == B_OK) {
-			int32 count;
-			if (get_sem_count(view->fQuitSem, &count) == B_OK && count > 0)
-				acquire_sem_etc(view->fQuitSem, count, B_RELATIVE_TIMEOUT, 0);
-		} else if (err != B_TIMED_OUT && err != B_INTERRUPTED) {
-			break;
-		}
+	for (auto it = fUserNameCache.begin(); it != fUserNameCache.end();) {
+		if (it->second.generation != fCurrentGeneration)
+			it = fUserNameCache.erase(it);
+		else
+			++it;
 	}
 
-	return B_OK;
+	fImageCache.Prune(fCurrentGeneration);
+
+	if (!fProcessList.empty()) {
+		BMessage msg(MSG_PROCESS_DATA_UPDATE);
+		msg.AddData("procs", B_RAW_TYPE, fProcessList.data(), fProcessList.size() * sizeof(ProcessInfo));
+		// Never block on the window, it might be waiting for the
+		// scheduler
+		target.SendMessage(&msg, (BHandler*)NULL, 0);
+	}
 }
 
 void ProcessView::SaveState(BMessage& state)
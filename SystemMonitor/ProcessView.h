@@ -11,9 +11,10 @@
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
-#include <atomic>
 #include <kernel/OS.h>
 #include <Font.h>
+#include "ProcessImageCache.h"
+#include "SamplingScheduler.h"
 
 class BListView;
 class BMenuItem;
@@ -58,7 +59,7 @@ enum ProcessSortMode {
 
 class ProcessListItem; // Forward declaration
 
-class ProcessView : public BView {
+class ProcessView : public BView, public SampleCollector {
 public:
 	ProcessView();
 	virtual ~ProcessView();
@@ -70,6 +71,8 @@ public:
 	virtual void Hide();
 	virtual void Show();
 
+	virtual void Collect(bigtime_t now);
+
 	void SaveState(BMessage& state);
 	void LoadState(const BMessage& state);
 	void SetRefreshInterval(bigtime_t interval);
@@ -83,12 +86,12 @@ public:
 	float UserWidth() const { return fUserWidth; }
 
 private:
-	static int32 UpdateThread(void* data);
 	void Update(BMessage* message);
 	void FilterRows();
 	void _SortItems();
 	void _RestoreSelection(team_id selectedID);
 	bool _MatchesFilter(const ProcessInfo& info, const char* searchText);
+	void _UpdateIcon(ProcessListItem* item, const ProcessInfo& info);
 
 	void KillSelectedProcess();
 	void SuspendSelectedProcess();
@@ -141,14 +144,16 @@ private:
 	BString fFilterArgs; // Buffer for args filtering
 
 	std::unordered_map<uid_t, CachedUser> fUserNameCache;
+	ProcessImageCache fImageCache;
 	std::vector<ClickableHeaderView*> fHeaders;
 	bigtime_t fLastSystemTime;
-	std::atomic<bigtime_t> fRefreshInterval;
+	bigtime_t fRefreshInterval;
+
+	// Only used by Collect()
+	std::vector<ProcessInfo> fProcessList;
+	std::vector<char> fPasswordBuffer;
 
-	thread_id fUpdateThread;
-	sem_id fQuitSem;
-	std::atomic<bool> fTerminated;
-	std::atomic<bool> fIsHidden;
+	bool fIsHidden;
 
 	ProcessSortMode fSortMode;
 	BFont fCachedFont;
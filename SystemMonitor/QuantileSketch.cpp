@@ -0,0 +1,172 @@
+#include "QuantileSketch.h"
+
+#include <math.h>
+#include <string.h>
+
+
+// Values below this get a bucket of their own
+static const int64 kLinearLimit = 16;
+// Growth factor of the log buckets: 240 of them reach past 1e11
+static const double kGamma = 1.1;
+
+
+QuantileSketch::QuantileSketch(bigtime_t window)
+	:
+	fSlotDuration(window > kSlotCount ? window / kSlotCount : 1),
+	fCurrentSlot(0),
+	fStarted(false)
+{
+	MakeEmpty();
+}
+
+
+void
+QuantileSketch::AddValue(bigtime_t time, int64 value)
+{
+	_Advance(time);
+
+	int32 bucket = BucketFor(value);
+	uint16& slotCount = fSlots[_SlotIndex(fCurrentSlot)][bucket];
+	if (slotCount == 0xffff)
+		return;
+
+	slotCount++;
+	fTotal[bucket]++;
+	fCount++;
+}
+
+
+void
+QuantileSketch::MakeEmpty()
+{
+	memset(fSlots, 0, sizeof(fSlots));
+	memset(fTotal, 0, sizeof(fTotal));
+	fCount = 0;
+	fCurrentSlot = 0;
+	fStarted = false;
+}
+
+
+int64
+QuantileSketch::Quantile(float q) const
+{
+	if (fCount == 0)
+		return 0;
+
+	if (q < 0)
+		q = 0;
+	if (q > 1)
+		q = 1;
+
+	// The rank of the requested value, 1-based
+	uint32 rank = static_cast<uint32>(ceilf(q * fCount));
+	if (rank == 0)
+		rank = 1;
+
+	uint32 seen = 0;
+	for (int32 bucket = 0; bucket < kBucketCount; bucket++) {
+		seen += fTotal[bucket];
+		if (seen >= rank)
+			return BucketValue(bucket);
+	}
+
+	return BucketValue(kBucketCount - 1);
+}
+
+
+void
+QuantileSketch::GetHistogram(uint32* bins, int32 binCount, int64 min,
+	int64 max) const
+{
+	if (binCount <= 0)
+		return;
+
+	memset(bins, 0, binCount * sizeof(uint32));
+	double binWidth = max > min ? static_cast<double>(max - min) / binCount : 1;
+
+	for (int32 bucket = 0; bucket < kBucketCount; bucket++) {
+		if (fTotal[bucket] == 0)
+			continue;
+
+		int64 bin = static_cast<int64>((BucketValue(bucket) - min) / binWidth);
+		if (bin < 0)
+			bin = 0;
+		if (bin >= binCount)
+			bin = binCount - 1;
+		bins[bin] += fTotal[bucket];
+	}
+}
+
+
+/*static*/ int32
+QuantileSketch::BucketFor(int64 value)
+{
+	if (value < kLinearLimit)
+		return value > 0 ? static_cast<int32>(value) : 0;
+
+	int32 bucket = kLinearLimit + static_cast<int32>(
+		log(static_cast<double>(value) / kLinearLimit) / log(kGamma));
+	return bucket < kBucketCount ? bucket : kBucketCount - 1;
+}
+
+
+/*static*/ int64
+QuantileSketch::BucketValue(int32 bucket)
+{
+	if (bucket < kLinearLimit)
+		return bucket;
+
+	// Geometric middle of the bucket
+	return static_cast<int64>(kLinearLimit
+		* pow(kGamma, bucket - kLinearLimit + 0.5));
+}
+
+
+void
+QuantileSketch::_Advance(bigtime_t time)
+{
+	// Times from before a reboot are negative, so round down
+	int64 slot = time / fSlotDuration;
+	if (time % fSlotDuration < 0)
+		slot--;
+
+	if (!fStarted) {
+		fCurrentSlot = slot;
+		fStarted = true;
+		return;
+	}
+	if (slot <= fCurrentSlot)
+		return;
+
+	// Expire every slot that has left the window
+	if (slot - fCurrentSlot >= kSlotCount) {
+		MakeEmpty();
+		fCurrentSlot = slot;
+		fStarted = true;
+		return;
+	}
+
+	while (fCurrentSlot < slot) {
+		fCurrentSlot++;
+		_ClearSlot(_SlotIndex(fCurrentSlot));
+	}
+}
+
+
+/*static*/ int32
+QuantileSketch::_SlotIndex(int64 slot)
+{
+	int32 index = static_cast<int32>(slot % kSlotCount);
+	return index < 0 ? index + kSlotCount : index;
+}
+
+
+void
+QuantileSketch::_ClearSlot(int32 slot)
+{
+	for (int32 bucket = 0; bucket < kBucketCount; bucket++) {
+		fTotal[bucket] -= fSlots[slot][bucket];
+		fCount -= fSlots[slot][bucket];
+	}
+	memset(fSlots[slot], 0, sizeof(fSlots[slot]));
+}
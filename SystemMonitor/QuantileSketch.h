@@ -0,0 +1,53 @@
+#ifndef QUANTILESKETCH_H
+#define QUANTILESKETCH_H
+
+#if defined(__HAIKU__) || defined(BEOS)
+#include <OS.h>
+#endif
+
+
+// Streaming quantiles over a sliding time window in constant memory.
+// Values go into a fixed log-scale histogram: exact below 16, about 5%
+// relative error above, and negative values count as 0. The window is
+// split into slots, each with its own histogram; a slot leaving the window
+// is subtracted from the running total, so adding a value is O(1) and a
+// quantile query walks the buckets once.
+class QuantileSketch {
+public:
+						QuantileSketch(bigtime_t window = 3600000000LL);
+
+			void		AddValue(bigtime_t time, int64 value);
+			void		MakeEmpty();
+
+			// q is in [0, 1]; returns 0 if the window is empty.
+			int64		Quantile(float q) const;
+			uint32		CountValues() const { return fCount; }
+			bigtime_t	Window() const { return fSlotDuration * kSlotCount; }
+
+			// Spreads the window's values over binCount linear bins in
+			// [min, max]; values outside are counted in the first/last bin.
+			void		GetHistogram(uint32* bins, int32 binCount, int64 min,
+							int64 max) const;
+
+	static	int32		BucketFor(int64 value);
+	static	int64		BucketValue(int32 bucket);
+
+private:
+			void		_Advance(bigtime_t time);
+			void		_ClearSlot(int32 slot);
+	static	int32		_SlotIndex(int64 slot);
+
+public:
+	static const int32	kBucketCount = 256;
+	static const int32	kSlotCount = 30;
+
+private:
+	uint16				fSlots[kSlotCount][kBucketCount];
+	uint32				fTotal[kBucketCount];
+	uint32				fCount;
+	bigtime_t			fSlotDuration;
+	int64				fCurrentSlot;
+	bool				fStarted;
+};
+
+#endif // QUANTILESKETCH_H
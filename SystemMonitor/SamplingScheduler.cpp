@@ -0,0 +1,362 @@
+#include "SamplingScheduler.h"
+
+#include <Autolock.h>
+
+#include <new>
+
+
+SamplingScheduler::SamplingScheduler()
+	:
+	fLock("sampling scheduler"),
+	fQuitting(false)
+{
+	for (int32 i = 0; i < kSamplingLaneCount; i++) {
+		fLanes[i].scheduler = this;
+		fLanes[i].lane = static_cast<sampling_lane>(i);
+		fLanes[i].thread = -1;
+		fLanes[i].wakeSem = -1;
+	}
+}
+
+
+SamplingScheduler::~SamplingScheduler()
+{
+	fLock.Lock();
+	fQuitting = true;
+	thread_id threads[kSamplingLaneCount];
+	for (int32 i = 0; i < kSamplingLaneCount; i++) {
+		threads[i] = fLanes[i].thread;
+		if (fLanes[i].wakeSem >= 0) {
+			delete_sem(fLanes[i].wakeSem);
+			fLanes[i].wakeSem = -1;
+		}
+	}
+	fLock.Unlock();
+
+	for (int32 i = 0; i < kSamplingLaneCount; i++) {
+		if (threads[i] >= 0) {
+			status_t result;
+			wait_for_thread(threads[i], &result);
+		}
+	}
+}
+
+
+/*static*/ SamplingScheduler&
+SamplingScheduler::Default()
+{
+	static SamplingScheduler sDefault;
+	return sDefault;
+}
+
+
+status_t
+SamplingScheduler::AddCollector(SampleCollector* collector,
+	bigtime_t interval, bool enabled, sampling_lane lane)
+{
+	if (collector == NULL || lane < 0 || lane >= kSamplingLaneCount)
+		return B_BAD_VALUE;
+
+	BAutolock locker(fLock);
+
+	collector_entry* entry = _EntryFor(collector);
+	if (entry != NULL) {
+		entry->ticks = TicksFor(interval);
+		entry->enabled = enabled;
+		_Wake(entry->lane);
+		return B_OK;
+	}
+
+	collector_entry newEntry;
+	newEntry.collector = collector;
+	newEntry.lane = lane;
+	newEntry.ticks = TicksFor(interval);
+	newEntry.enabled = enabled;
+	newEntry.triggered = false;
+	newEntry.cost = 0;
+
+	try {
+		fEntries.push_back(newEntry);
+		// The threads must not allocate while collecting
+		fLanes[lane].due.reserve(fEntries.size());
+	} catch (const std::bad_alloc&) {
+		if (!fEntries.empty() && fEntries.back().collector == collector)
+			fEntries.pop_back();
+		return B_NO_MEMORY;
+	}
+
+	status_t status = _StartThread(fLanes[lane]);
+	if (status != B_OK) {
+		fEntries.pop_back();
+		return status;
+	}
+
+	_Wake(lane);
+	return B_OK;
+}
+
+
+void
+SamplingScheduler::RemoveCollector(SampleCollector* collector)
+{
+	fLock.Lock();
+	lane_state* lane = NULL;
+	for (size_t i = 0; i < fEntries.size(); i++) {
+		if (fEntries[i].collector == collector) {
+			lane = &fLanes[fEntries[i].lane];
+			fEntries.erase(fEntries.begin() + i);
+			break;
+		}
+	}
+	bool isLaneThread = lane != NULL && find_thread(NULL) == lane->thread;
+	fLock.Unlock();
+
+	// Wait until a pass that may still call it is done
+	if (lane != NULL && !isLaneThread) {
+		lane->runLock.Lock();
+		lane->runLock.Unlock();
+	}
+}
+
+
+void
+SamplingScheduler::SetInterval(SampleCollector* collector, bigtime_t interval)
+{
+	BAutolock locker(fLock);
+
+	collector_entry* entry = _EntryFor(collector);
+	if (entry == NULL)
+		return;
+
+	uint32 ticks = TicksFor(interval);
+	if (entry->ticks != ticks) {
+		entry->ticks = ticks;
+		_Wake(entry->lane);
+	}
+}
+
+
+bigtime_t
+SamplingScheduler::Interval(SampleCollector* collector) const
+{
+	BAutolock locker(fLock);
+
+	const collector_entry* entry = _EntryFor(collector);
+	return entry != NULL ? entry->ticks * kSamplingTick : 0;
+}
+
+
+void
+SamplingScheduler::SetEnabled(SampleCollector* collector, bool enabled)
+{
+	BAutolock locker(fLock);
+
+	collector_entry* entry = _EntryFor(collector);
+	if (entry == NULL || entry->enabled == enabled)
+		return;
+
+	entry->enabled = enabled;
+	_Wake(entry->lane);
+}
+
+
+void
+SamplingScheduler::Trigger(SampleCollector* collector)
+{
+	BAutolock locker(fLock);
+
+	collector_entry* entry = _EntryFor(collector);
+	if (entry == NULL || entry->triggered)
+		return;
+
+	entry->triggered = true;
+	_Wake(entry->lane);
+}
+
+
+bigtime_t
+SamplingScheduler::AverageCost(SampleCollector* collector) const
+{
+	BAutolock locker(fLock);
+
+	const collector_entry* entry = _EntryFor(collector);
+	return entry != NULL ? entry->cost : 0;
+}
+
+
+/*static*/ uint32
+SamplingScheduler::TicksFor(bigtime_t interval)
+{
+	bigtime_t ticks = (interval + kSamplingTick / 2) / kSamplingTick;
+	if (ticks < 1)
+		return 1;
+	if (ticks > 0xffffffffLL)
+		return 0xffffffff;
+	return static_cast<uint32>(ticks);
+}
+
+
+SamplingScheduler::collector_entry*
+SamplingScheduler::_EntryFor(SampleCollector* collector)
+{
+	for (size_t i = 0; i < fEntries.size(); i++) {
+		if (fEntries[i].collector == collector)
+			return &fEntries[i];
+	}
+	return NULL;
+}
+
+
+const SamplingScheduler::collector_entry*
+SamplingScheduler::_EntryFor(SampleCollector* collector) const
+{
+	return const_cast<SamplingScheduler*>(this)->_EntryFor(collector);
+}
+
+
+/*!	Returns the first tick after \a tick on which an enabled collector of
+	the lane is due, or -1 if there is none.
+*/
+int64
+SamplingScheduler::_NextTick(sampling_lane lane, int64 tick) const
+{
+	int64 next = -1;
+	for (size_t i = 0; i < fEntries.size(); i++) {
+		const collector_entry& entry = fEntries[i];
+		if (!entry.enabled || entry.lane != lane)
+			continue;
+
+		int64 due = (tick / entry.ticks + 1) * entry.ticks;
+		if (next < 0 || due < next)
+			next = due;
+	}
+	return next;
+}
+
+
+status_t
+SamplingScheduler::_StartThread(lane_state& lane)
+{
+	if (lane.thread >= 0)
+		return B_OK;
+
+	if (lane.wakeSem < 0) {
+		lane.wakeSem = create_sem(0, "sampling scheduler wake");
+		if (lane.wakeSem < 0)
+			return lane.wakeSem;
+	}
+
+	lane.thread = spawn_thread(_SchedulerThread,
+		lane.lane == kSamplingLaneFast
+			? "sampling scheduler" : "sampling scheduler slow lane",
+		B_NORMAL_PRIORITY, &lane);
+	if (lane.thread < 0) {
+		status_t status = lane.thread;
+		lane.thread = -1;
+		return status;
+	}
+
+	resume_thread(lane.thread);
+	return B_OK;
+}
+
+
+void
+SamplingScheduler::_Wake(sampling_lane lane)
+{
+	if (fLanes[lane].wakeSem >= 0)
+		release_sem(fLanes[lane].wakeSem);
+}
+
+
+/*static*/ status_t
+SamplingScheduler::_SchedulerThread(void* data)
+{
+	lane_state* lane = static_cast<lane_state*>(data);
+	lane->scheduler->_Run(*lane);
+	return B_OK;
+}
+
+
+void
+SamplingScheduler::_Run(lane_state& lane)
+{
+	while (true) {
+		if (!fLock.Lock())
+			break;
+		if (fQuitting) {
+			fLock.Unlock();
+			break;
+		}
+
+		bool triggered = false;
+		for (size_t i = 0; i < fEntries.size() && !triggered; i++) {
+			triggered = fEntries[i].lane == lane.lane
+				&& fEntries[i].enabled && fEntries[i].triggered;
+		}
+
+		int64 tick = -1;
+		if (!triggered)
+			tick = _NextTick(lane.lane, system_time() / kSamplingTick);
+		sem_id wakeSem = lane.wakeSem;
+		fLock.Unlock();
+
+		if (!triggered) {
+			status_t status;
+			if (tick < 0) {
+				status = acquire_sem(wakeSem);
+			} else {
+				status = acquire_sem_etc(wakeSem, 1, B_ABSOLUTE_TIMEOUT,
+					tick * kSamplingTick);
+			}
+
+			// Woken up early since the collectors changed; start over
+			if (status == B_OK || status == B_INTERRUPTED)
+				continue;
+			if (status != B_TIMED_OUT)
+				break;
+		}
+
+		// The one time stamp for everything sampled on this tick
+		bigtime_t now = system_time();
+
+		lane.runLock.Lock();
+
+		fLock.Lock();
+		lane.due.clear();
+		for (size_t i = 0; i < fEntries.size(); i++) {
+			collector_entry& entry = fEntries[i];
+			if (!entry.enabled || entry.lane != lane.lane)
+				continue;
+
+			if (entry.triggered || (tick >= 0 && tick % entry.ticks == 0))
+				lane.due.push_back(entry.collector);
+			entry.triggered = false;
+		}
+		fLock.Unlock();
+
+		for (size_t i = 0; i < lane.due.size(); i++) {
+			// Skip collectors that have been removed in the meantime
+			fLock.Lock();
+			bool registered = _EntryFor(lane.due[i]) != NULL;
+			fLock.Unlock();
+
+			if (!registered)
+				continue;
+
+			bigtime_t start = system_time();
+			lane.due[i]->Collect(now);
+			bigtime_t cost = system_time() - start;
+
+			fLock.Lock();
+			collector_entry* entry = _EntryFor(lane.due[i]);
+			if (entry != NULL) {
+				entry->cost = entry->cost == 0
+					? cost : (entry->cost * 7 + cost) / 8;
+			}
+			fLock.Unlock();
+		}
+
+		lane.runLock.Unlock();
+	}
+}
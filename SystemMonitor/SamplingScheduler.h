@@ -0,0 +1,109 @@
+#ifndef SAMPLINGSCHEDULER_H
+#define SAMPLINGSCHEDULER_H
+
+#include <Locker.h>
+#include <OS.h>
+#include <vector>
+
+
+// Implemented by everything that periodically samples the system.
+class SampleCollector {
+public:
+	virtual				~SampleCollector() {}
+
+	// Called from the thread of the collector's lane; all collectors of a
+	// lane that are due on the same tick get the same time. Views may call
+	// into the scheduler while this runs, so messages to them must be sent
+	// with a timeout.
+	virtual	void		Collect(bigtime_t now) = 0;
+};
+
+
+// Every interval is a multiple of this
+const bigtime_t kSamplingTick = 50000;
+
+
+// Each lane has a thread of its own, so that a slow collector can't hold
+// back the others.
+enum sampling_lane {
+	// Cheap counters behind the graphs
+	kSamplingLaneFast = 0,
+	// Scans over every team, area or volume
+	kSamplingLaneSlow,
+
+	kSamplingLaneCount
+};
+
+
+// Runs the collectors of each lane from a thread of its own, all on a
+// shared grid of ticks that are aligned to multiples of kSamplingTick in
+// system time. A collector sampling every n ticks fires on the ticks
+// divisible by n, so collectors with related intervals sample at exactly
+// the same instants, and a thread only wakes up for ticks where something
+// is due.
+class SamplingScheduler {
+public:
+	static	SamplingScheduler& Default();
+
+			// The interval is rounded to the nearest multiple of the tick.
+			status_t	AddCollector(SampleCollector* collector,
+							bigtime_t interval, bool enabled = true,
+							sampling_lane lane = kSamplingLaneFast);
+			// Once this returns, the collector is no longer running and won't
+			// be called again.
+			void		RemoveCollector(SampleCollector* collector);
+
+			void		SetInterval(SampleCollector* collector,
+							bigtime_t interval);
+			bigtime_t	Interval(SampleCollector* collector) const;
+			void		SetEnabled(SampleCollector* collector, bool enabled);
+
+			// Lets the collector run as soon as possible, outside the grid.
+			void		Trigger(SampleCollector* collector);
+
+			// Moving average of the time a Collect() call takes, or 0 if the
+			// collector hasn't run yet.
+			bigtime_t	AverageCost(SampleCollector* collector) const;
+
+	static	uint32		TicksFor(bigtime_t interval);
+
+private:
+							SamplingScheduler();
+							~SamplingScheduler();
+
+	struct collector_entry {
+		SampleCollector*	collector;
+		sampling_lane		lane;
+		uint32				ticks;
+		bool				enabled;
+		bool				triggered;
+		bigtime_t			cost;
+	};
+
+	struct lane_state {
+		SamplingScheduler*	scheduler;
+		sampling_lane		lane;
+		// Held while collectors run, so that removing one can wait for it
+		BLocker				runLock;
+		std::vector<SampleCollector*> due;
+		thread_id			thread;
+		sem_id				wakeSem;
+	};
+
+			collector_entry* _EntryFor(SampleCollector* collector);
+			const collector_entry* _EntryFor(SampleCollector* collector) const;
+			int64		_NextTick(sampling_lane lane, int64 tick) const;
+			status_t	_StartThread(lane_state& lane);
+			void		_Wake(sampling_lane lane);
+
+	static	status_t	_SchedulerThread(void* data);
+			void		_Run(lane_state& lane);
+
+private:
+	mutable BLocker		fLock;
+	std::vector<collector_entry> fEntries;
+	lane_state			fLanes[kSamplingLaneCount];
+	bool				fQuitting;
+};
+
+#endif // SAMPLINGSCHEDULER_H
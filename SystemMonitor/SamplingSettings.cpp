@@ -0,0 +1,140 @@
+#include "SamplingSettings.h"
+
+#include "SamplingScheduler.h"
+
+
+static const char* const kIntervalKeys[kSamplingSourceCount] = {
+	"sampling_cpu",
+	"sampling_memory",
+	"sampling_network",
+	"sampling_disks",
+	"sampling_processes",
+	"sampling_summary"
+};
+
+
+SamplingSettings::SamplingSettings()
+{
+	for (int32 i = 0; i < kSamplingSourceCount; i++)
+		fIntervals[i] = DefaultInterval(static_cast<sampling_source>(i));
+}
+
+
+bigtime_t
+SamplingSettings::Interval(sampling_source source) const
+{
+	if (source < 0 || source >= kSamplingSourceCount)
+		return 0;
+	return fIntervals[source];
+}
+
+
+void
+SamplingSettings::SetInterval(sampling_source source, bigtime_t interval)
+{
+	if (source < 0 || source >= kSamplingSourceCount)
+		return;
+
+	if (interval < kMinSamplingInterval)
+		interval = kMinSamplingInterval;
+	if (interval > kMaxSamplingInterval)
+		interval = kMaxSamplingInterval;
+
+	fIntervals[source] = SamplingScheduler::TicksFor(interval) * kSamplingTick;
+}
+
+
+void
+SamplingSettings::SaveState(BMessage& state) const
+{
+	for (int32 i = 0; i < kSamplingSourceCount; i++)
+		state.AddInt64(kIntervalKeys[i], fIntervals[i]);
+}
+
+
+void
+SamplingSettings::LoadState(const BMessage& state)
+{
+	// Older versions had a single rate for everything
+	bigtime_t legacyRate;
+	bool hasLegacyRate = state.FindInt64("pulse_rate", &legacyRate) == B_OK;
+
+	for (int32 i = 0; i < kSamplingSourceCount; i++) {
+		sampling_source source = static_cast<sampling_source>(i);
+
+		bigtime_t interval;
+		if (state.FindInt64(kIntervalKeys[i], &interval) == B_OK)
+			SetInterval(source, interval);
+		else if (hasLegacyRate)
+			SetInterval(source, legacyRate);
+	}
+}
+
+
+float
+SamplingSettings::EstimatedLoad(const bigtime_t* costs) const
+{
+	float load = 0.0f;
+	for (int32 i = 0; i < kSamplingSourceCount; i++) {
+		load += EstimatedLoad(static_cast<sampling_source>(i),
+			costs != NULL ? costs[i] : 0);
+	}
+	return load;
+}
+
+
+float
+SamplingSettings::EstimatedLoad(sampling_source source, bigtime_t cost) const
+{
+	if (source < 0 || source >= kSamplingSourceCount)
+		return 0.0f;
+
+	if (cost <= 0)
+		cost = TypicalCost(source);
+	return static_cast<float>(cost) / fIntervals[source];
+}
+
+
+/*static*/ bigtime_t
+SamplingSettings::DefaultInterval(sampling_source source)
+{
+	switch (source) {
+		case kCPUSampling:
+			return 500000;
+		case kMemorySampling:
+		case kNetworkSampling:
+		case kSummarySampling:
+			return 1000000;
+		case kProcessSampling:
+			return 2000000;
+		case kDiskSampling:
+			return 10000000;
+		default:
+			return 1000000;
+	}
+}
+
+
+/*!	Rough time in microseconds one sample takes on a typical machine, used
+	until the scheduler has measured the real thing.
+*/
+/*static*/ bigtime_t
+SamplingSettings::TypicalCost(sampling_source source)
+{
+	switch (source) {
+		case kCPUSampling:
+			return 50;
+		case kMemorySampling:
+			return 50;
+		case kNetworkSampling:
+			return 300;
+		case kDiskSampling:
+			return 300;
+		case kProcessSampling:
+			return 5000;
+		case kSummarySampling:
+			return 2000;
+		default:
+			return 0;
+	}
+}
@@ -0,0 +1,51 @@
+#ifndef SAMPLINGSETTINGS_H
+#define SAMPLINGSETTINGS_H
+
+#include <Message.h>
+
+
+enum sampling_source {
+	kCPUSampling = 0,
+	kMemorySampling,
+	kNetworkSampling,
+	kDiskSampling,
+	kProcessSampling,
+	kSummarySampling,
+	kSamplingSourceCount
+};
+
+const bigtime_t kMinSamplingInterval = 100000;
+const bigtime_t kMaxSamplingInterval = 60000000;
+
+
+// How often each kind of data is sampled. Cheap sources can be polled fast
+// for smooth graphs while expensive ones like the process table are polled
+// less often.
+class SamplingSettings {
+public:
+							SamplingSettings();
+
+			bigtime_t		Interval(sampling_source source) const;
+			// Clamped to the supported range, and rounded to the scheduler's
+			// tick.
+			void			SetInterval(sampling_source source,
+								bigtime_t interval);
+
+			void			SaveState(BMessage& state) const;
+			void			LoadState(const BMessage& state);
+
+			// Fraction of one CPU spent on sampling with these intervals.
+			// The costs are the time a single sample of each source takes;
+			// sources without a measured cost use a typical value.
+			float			EstimatedLoad(const bigtime_t* costs = NULL) const;
+			float			EstimatedLoad(sampling_source source,
+								bigtime_t cost) const;
+
+	static	bigtime_t		DefaultInterval(sampling_source source);
+	static	bigtime_t		TypicalCost(sampling_source source);
+
+private:
+			bigtime_t		fIntervals[kSamplingSourceCount];
+};
+
+#endif // SAMPLINGSETTINGS_H
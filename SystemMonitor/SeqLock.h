@@ -0,0 +1,81 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+
+#include <atomic>
+#include <string.h>
+#include <type_traits>
+
+#if defined(__HAIKU__) || defined(BEOS)
+#include <OS.h>
+#endif
+
+
+// Publishes a small value from a single writer to any number of readers
+// without locking. The writer never waits; a reader that overlaps a write
+// simply copies the value again. The value is stored as relaxed atomic
+// words, so Type must be trivially copyable.
+template<typename Type>
+class SeqLock {
+public:
+	SeqLock()
+		:
+		fSequence(0)
+	{
+		for (size_t i = 0; i < kWordCount; i++)
+			fWords[i].store(0, std::memory_order_relaxed);
+	}
+
+	// Must only be called from one thread at a time.
+	void Write(const Type& value)
+	{
+		uint64 words[kWordCount] = {};
+		memcpy(words, &value, sizeof(Type));
+
+		uint32 sequence = fSequence.load(std::memory_order_relaxed);
+		fSequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		for (size_t i = 0; i < kWordCount; i++)
+			fWords[i].store(words[i], std::memory_order_relaxed);
+
+		fSequence.store(sequence + 2, std::memory_order_release);
+	}
+
+	// Returns the sequence number of the value read; it changes with every
+	// write, so readers can tell whether there is anything new.
+	uint32 Read(Type& value) const
+	{
+		uint64 words[kWordCount];
+		uint32 before;
+		uint32 after;
+		do {
+			before = fSequence.load(std::memory_order_acquire);
+			for (size_t i = 0; i < kWordCount; i++)
+				words[i] = fWords[i].load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			after = fSequence.load(std::memory_order_relaxed);
+		} while ((before & 1) != 0 || before != after);
+
+		memcpy(&value, words, sizeof(Type));
+		return before;
+	}
+
+	uint32 Sequence() const
+	{
+		return fSequence.load(std::memory_order_acquire);
+	}
+
+private:
+	static_assert(std::is_trivially_copyable<Type>::value,
+		"SeqLock needs a trivially copyable type");
+
+	static const size_t kWordCount
+		= (sizeof(Type) + sizeof(uint64) - 1) / sizeof(uint64);
+
+	std::atomic<uint64>	fWords[kWordCount];
+	std::atomic<uint32>	fSequence;
+};
+
+
+#endif	// SEQLOCK_H
@@ -0,0 +1,868 @@
+#include "StackedGraphView.h"
+#include <Bitmap.h>
+#include <Catalog.h>
+#include <ControlLook.h>
+#include <Window.h>
+#include <algorithm>
+#include <new>
+#include <cmath>
+#include <string.h>
+#include "FrameCoordinator.h"
+#include "GraphCrosshair.h"
+#include "Utils.h"
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "StackedGraphView"
+
+
+// The quantiles of the last hour shown in the tooltip
+static const float kQuantiles[] = { 0.50f, 0.95f, 0.99f };
+
+
+StackedGraphView::StackedGraphView(const char* name)
+	: BView(name, B_WILL_DRAW | B_FULL_UPDATE_ON_RESIZE | B_FRAME_EVENTS),
+	fMetric(-1),
+	fHistory(NULL),
+	fFormatter(NULL),
+	fResolution(1000000),
+	fLayerCount(0),
+	fManualScale(false),
+	fManualMax(0),
+	fScaleField(-1),
+	fFrameMissed(true),
+	fCrosshairTime(kNoCrosshairTime)
+{
+	fParams.metric = -1;
+	fParams.history = NULL;
+	fParams.layerCount = 0;
+	fParams.resolution = fResolution;
+	fParams.manualScale = false;
+	fParams.manualMax = 0;
+	fParams.scaleField = -1;
+	fParams.width = 0;
+	fParams.height = 0;
+	fParams.gridSpacing = 0;
+	fParams.background = 0;
+	fParams.grid = 0;
+	fParams.generation = 1;
+
+	for (int32 i = 0; i < 2; i++) {
+		fFrames[i].generation = 0;
+		fFrames[i].width = 0;
+		fFrames[i].height = 0;
+		fFrames[i].resolution = 0;
+		fFrames[i].lastRefresh = 0;
+		fFrames[i].scrollOffset = 0;
+		fFrames[i].lastMax = 0;
+	}
+}
+
+
+StackedGraphView::~StackedGraphView()
+{
+	GraphRenderer::Default().Remove(this);
+}
+
+
+void
+StackedGraphView::AttachedToWindow()
+{
+	BView::AttachedToWindow();
+	FrameCoordinator::Attach(this);
+
+	if (fMetric >= 0)
+		MetricRegistry::Default().StartWatching(fMetric, BMessenger(this));
+
+	GraphCrosshair& crosshair = GraphCrosshair::Default();
+	crosshair.StartWatching(BMessenger(this));
+	fCrosshairTime = crosshair.Time();
+
+	_RequestFrame();
+}
+
+
+void
+StackedGraphView::DetachedFromWindow()
+{
+	if (fMetric >= 0)
+		MetricRegistry::Default().StopWatching(fMetric, BMessenger(this));
+	GraphCrosshair::Default().StopWatching(BMessenger(this));
+	GraphRenderer::Default().Remove(this);
+	FrameCoordinator::Detach(this);
+
+	BView::DetachedFromWindow();
+}
+
+
+void
+StackedGraphView::MessageReceived(BMessage* message)
+{
+	switch (message->what) {
+		case kMsgMetricUpdated:
+			_RequestFrame();
+			break;
+
+		case kMsgGraphFrameReady:
+			// Shown with the other graphs at the next display frame
+			FrameCoordinator::Invalidate(this);
+			break;
+
+		case kMsgCrosshairMoved:
+			// Only an overlay, the frame is just copied again
+			if (message->FindInt64("time", &fCrosshairTime) != B_OK)
+				fCrosshairTime = kNoCrosshairTime;
+			if (FrameCoordinator::IsVisible(this))
+				FrameCoordinator::Invalidate(this);
+			break;
+
+		case B_MOUSE_WHEEL_CHANGED: {
+			float deltaY;
+			if (message->FindFloat("be:wheel_delta_y", &deltaY) == B_OK) {
+				if (deltaY > 0)
+					fResolution *= 2;
+				else
+					fResolution /= 2;
+
+				if (fResolution < 10000) fResolution = 10000;
+				if (fResolution > 60000000) fResolution = 60000000;
+
+				_RequestFrame();
+			}
+			break;
+		}
+		default:
+			BView::MessageReceived(message);
+	}
+}
+
+
+void
+StackedGraphView::FrameResized(float /*width*/, float /*height*/)
+{
+	// Until the frame in the new size is ready, Draw() stretches the last one
+	_RequestFrame();
+}
+
+
+void
+StackedGraphView::SetMetric(metric_id metric)
+{
+	MetricRegistry& registry = MetricRegistry::Default();
+	if (Window() != NULL && fMetric >= 0)
+		registry.StopWatching(fMetric, BMessenger(this));
+
+	fMetric = metric;
+	// Histories live as long as the registry
+	fHistory = registry.HistoryFor(metric);
+
+	if (Window() != NULL && fMetric >= 0)
+		registry.StartWatching(fMetric, BMessenger(this));
+
+	_RequestFrame();
+}
+
+
+status_t
+StackedGraphView::AddLayer(int32 field, const char* label, color_which color)
+{
+	if (fLayerCount >= kMaxLayers || field < 0)
+		return B_BAD_VALUE;
+
+	fFields[fLayerCount] = field;
+	fLabels[fLayerCount] = label;
+	fColors[fLayerCount] = color;
+	fLayerCount++;
+
+	_RequestFrame();
+	return B_OK;
+}
+
+
+void
+StackedGraphView::SetManualScale(float max)
+{
+	fManualScale = true;
+	fManualMax = max;
+	_RequestFrame();
+}
+
+
+void
+StackedGraphView::SetScaleField(int32 field)
+{
+	fScaleField = field;
+	_RequestFrame();
+}
+
+
+void
+StackedGraphView::SetValueFormatter(value_formatter formatter)
+{
+	fFormatter = formatter;
+}
+
+
+void
+StackedGraphView::Draw(BRect updateRect)
+{
+	if (fFrameMissed)
+		_RequestFrame();
+
+	if (fHistory == NULL || !fBuffers.Lock()) {
+		SetLowColor(ui_color(B_PANEL_BACKGROUND_COLOR));
+		FillRect(updateRect, B_SOLID_LOW);
+		return;
+	}
+
+	BBitmap* bitmap = fBuffers.Front();
+	const frame_state& frame = fFrames[fBuffers.FrontIndex()];
+	if (bitmap == NULL || frame.generation == 0) {
+		fBuffers.Unlock();
+		SetLowColor(ui_color(B_PANEL_BACKGROUND_COLOR));
+		FillRect(updateRect, B_SOLID_LOW);
+		return;
+	}
+
+	// Put together from the two parts of the ring of columns, and
+	// stretched if it is from before a resize
+	BRect bounds = Bounds();
+	int32 origin = frame.rasterizer.Origin();
+	if (origin == 0) {
+		DrawBitmap(bitmap, BRect(0, 0, frame.width - 1, frame.height - 1),
+			bounds);
+	} else {
+		float split = bounds.left + (frame.width - origin)
+			* (bounds.Width() + 1) / frame.width;
+		DrawBitmap(bitmap, BRect(origin, 0, frame.width - 1,
+				frame.height - 1),
+			BRect(bounds.left, bounds.top, split - 1, bounds.bottom));
+		DrawBitmap(bitmap, BRect(0, 0, origin - 1, frame.height - 1),
+			BRect(split, bounds.top, bounds.right, bounds.bottom));
+	}
+
+	fBuffers.Unlock();
+
+	_DrawCrosshair();
+}
+
+
+void
+StackedGraphView::MouseMoved(BPoint where, uint32 transit,
+	const BMessage* dragMessage)
+{
+	// Every graph shows the time under the mouse
+	GraphCrosshair& crosshair = GraphCrosshair::Default();
+	if (transit == B_EXITED_VIEW || transit == B_OUTSIDE_VIEW)
+		crosshair.SetTime(kNoCrosshairTime);
+	else
+		crosshair.SetTime(GraphCrosshair::TimeAt(where.x, Bounds(),
+			fResolution));
+
+	BView::MouseMoved(where, transit, dragMessage);
+}
+
+
+bool
+StackedGraphView::GetToolTipAt(BPoint point, BToolTip** _tip)
+{
+	history_readout readout;
+	fReadout.Read(readout);
+
+	bigtime_t time;
+	float values[kMaxLayers];
+	float max;
+	if (fHistory == NULL || fLayerCount == 0 || readout.end == 0
+		|| !_FrameValuesAt(point.x, time, values, max)) {
+		return false;
+	}
+
+	bigtime_t ago = std::max((bigtime_t)0, system_time() - time);
+
+	// From the top layer down, as they are shown
+	BString text;
+	for (int32 k = fLayerCount - 1; k >= 0; k--) {
+		BString value, p50, p95, p99;
+		_FormatValue(value, values[k]);
+		_FormatValue(p50, readout.quantiles[k][0]);
+		_FormatValue(p95, readout.quantiles[k][1]);
+		_FormatValue(p99, readout.quantiles[k][2]);
+
+		BString line;
+		line.SetToFormat(
+			B_TRANSLATE("%s: %s (last hour: p50 %s, p95 %s, p99 %s)"),
+			fLabels[k].String(), value.String(), p50.String(), p95.String(),
+			p99.String());
+		text << line << "\n";
+	}
+
+	BString when;
+	FormatTimeAgo(when, ago);
+	text << when;
+
+	SetToolTip(text.String());
+	*_tip = ToolTip();
+	return *_tip != NULL;
+}
+
+
+void
+StackedGraphView::RenderFrame()
+{
+	if (!fBuffers.Lock())
+		return;
+	render_params params = fParams;
+	fBuffers.Unlock();
+
+	if (params.history == NULL || params.layerCount == 0
+		|| params.width <= 0 || params.height <= 0) {
+		return;
+	}
+
+	frame_state& frame = fFrames[fBuffers.BackIndex()];
+	BBitmap* bitmap = fBuffers.Back(params.width, params.height);
+	if (bitmap == NULL)
+		return;
+
+	GraphRasterizer& rasterizer = frame.rasterizer;
+	rasterizer.SetTarget(static_cast<uint32*>(bitmap->Bits()),
+		bitmap->BytesPerRow(), params.width, params.height);
+	// Only the fill alpha applies to the layers
+	rasterizer.SetColors(params.background, params.grid, params.background,
+		100, params.background);
+	rasterizer.SetLineWidth(1.5f);
+	if (rasterizer.SetLayers(params.layerCount, params.fills,
+			params.fills) != B_OK) {
+		return;
+	}
+
+	MetricRegistry& registry = MetricRegistry::Default();
+	if (!registry.LockMetric(params.metric))
+		return;
+
+	_UpdateReadout(params);
+
+	// Nothing to do if the frame on screen would look the same. Only the
+	// columns are sampled with the metric locked, so publishing never
+	// waits for them to be drawn.
+	bool sampled = false;
+	column_draw draw;
+	if (_NeedsFrame(params))
+		sampled = _SampleFrame(params, frame, draw);
+	registry.UnlockMetric(params.metric);
+
+	if (!sampled || !_DrawColumns(params, frame, draw))
+		return;
+
+	fBuffers.Swap();
+
+	BMessage ready(kMsgGraphFrameReady);
+	BMessenger(this).SendMessage(&ready, (BHandler*)NULL, 0);
+}
+
+
+void
+StackedGraphView::_RequestFrame()
+{
+	// While hidden the history just keeps recording, and showing the graph
+	// renders what was missed
+	if (!FrameCoordinator::IsVisible(this)) {
+		fFrameMissed = true;
+		return;
+	}
+
+	fFrameMissed = false;
+	_UpdateRenderParams();
+	GraphRenderer::Default().Request(this);
+}
+
+
+void
+StackedGraphView::_UpdateRenderParams()
+{
+	rgb_color bg = ui_color(B_PANEL_BACKGROUND_COLOR);
+	rgb_color gridColor = tint_color(bg, B_DARKEN_1_TINT);
+
+	BFont viewFont;
+	GetFont(&viewFont);
+
+	BRect bounds = Bounds();
+
+	render_params params;
+	params.metric = fMetric;
+	params.history = fHistory;
+	params.layerCount = fLayerCount;
+	for (int32 k = 0; k < fLayerCount; k++) {
+		rgb_color color = ui_color(fColors[k]);
+		params.fields[k] = fFields[k];
+		params.fills[k] = GraphRasterizer::MakePixel(color.red, color.green,
+			color.blue);
+	}
+	params.resolution = fResolution;
+	params.manualScale = fManualScale;
+	params.manualMax = fManualMax;
+	params.scaleField = fScaleField;
+	params.width = static_cast<int32>(bounds.Width()) + 1;
+	params.height = static_cast<int32>(bounds.Height()) + 1;
+	params.gridSpacing = 60.0f * GetScaleFactor(&viewFont);
+	params.background = GraphRasterizer::MakePixel(bg.red, bg.green,
+		bg.blue);
+	params.grid = GraphRasterizer::MakePixel(gridColor.red, gridColor.green,
+		gridColor.blue);
+
+	if (!fBuffers.Lock())
+		return;
+
+	// Scale changes are noticed by the render thread itself
+	bool changed = params.history != fParams.history
+		|| params.layerCount != fParams.layerCount
+		|| params.resolution != fParams.resolution
+		|| params.width != fParams.width || params.height != fParams.height
+		|| params.gridSpacing != fParams.gridSpacing
+		|| params.background != fParams.background
+		|| params.grid != fParams.grid;
+	for (int32 k = 0; k < params.layerCount && !changed; k++) {
+		changed = params.fields[k] != fParams.fields[k]
+			|| params.fills[k] != fParams.fills[k];
+	}
+
+	params.generation = fParams.generation;
+	if (changed) {
+		// Never 0, which marks empty frames
+		if (++params.generation == 0)
+			params.generation = 1;
+	}
+
+	fParams = params;
+	fBuffers.Unlock();
+}
+
+
+/*!	Publishes what the tooltips show of the history. Called from the
+	render thread with the metric locked.
+*/
+void
+StackedGraphView::_UpdateReadout(const render_params& params)
+{
+	history_readout readout;
+	memset(&readout, 0, sizeof(readout));
+	readout.end = params.history->End();
+	for (int32 k = 0; k < params.layerCount; k++) {
+		for (int32 i = 0; i < kQuantileCount; i++) {
+			readout.quantiles[k][i] = params.history->Quantile(kQuantiles[i],
+				params.fields[k]);
+		}
+	}
+
+	fReadout.Write(readout);
+}
+
+
+/*!	Whether the frame on screen differs from what would be rendered now.
+	Called from the render thread with the metric locked.
+*/
+bool
+StackedGraphView::_NeedsFrame(const render_params& params) const
+{
+	const frame_state& front = fFrames[fBuffers.FrontIndex()];
+	if (front.generation != params.generation)
+		return true;
+
+	// Scrolls by at least a pixel
+	bigtime_t now = system_time();
+	if (now - front.lastRefresh >= params.resolution)
+		return true;
+
+	float max = _ScaleMax(params);
+	if (max != front.lastMax)
+		return true;
+
+	float tops[kMaxLayers];
+	_SampleLayers(params, now, 1, tops, 1);
+	_LayersToY(params, 1, max, tops, 1);
+	for (int32 k = 0; k < params.layerCount; k++) {
+		if (tops[k] != front.lastTops[k])
+			return true;
+	}
+	return false;
+}
+
+
+/*!	Brings the frame up to date, sampling only the columns that changed
+	since it was last rendered into. Called from the render thread with the
+	metric locked; returns false if the frame couldn't be updated.
+*/
+bool
+StackedGraphView::_SampleFrame(const render_params& params,
+	frame_state& frame, column_draw& draw)
+{
+	int32 steps = params.width;
+	int32 height = params.height;
+	int32 layers = params.layerCount;
+
+	size_t stride = static_cast<size_t>(steps) + 64;
+	try {
+		if (fTops.size() < stride * layers) {
+			fTops.resize(stride * kMaxLayers);
+			fValues.resize(stride * kMaxLayers);
+		}
+	} catch (const std::bad_alloc&) {
+		// Ignore update if memory is low
+		return false;
+	}
+
+	bigtime_t now = system_time();
+	bigtime_t timeStep = params.resolution;
+
+	float max = _ScaleMax(params);
+	draw.max = max;
+	draw.stride = stride;
+
+	bool fullRedraw = true;
+	int32 pixelsToScroll = 0;
+	if (frame.generation == params.generation && max == frame.lastMax) {
+		pixelsToScroll = (now - frame.lastRefresh) / timeStep;
+		if (pixelsToScroll < steps && pixelsToScroll >= 0)
+			fullRedraw = false;
+	}
+
+	if (fullRedraw) {
+		frame.generation = 0;
+		frame.width = steps;
+		frame.height = height;
+		frame.resolution = timeStep;
+		frame.scrollOffset = 0;
+		frame.lastRefresh = now;
+		try {
+			frame.values.resize(static_cast<size_t>(steps) * layers);
+		} catch (const std::bad_alloc&) {
+			frame.values.clear();
+			return false;
+		}
+
+		_SampleLayers(params, now - (steps - 1) * timeStep, steps,
+			fTops.data(), stride, fValues.data());
+		_StoreColumns(frame, layers, 0, steps, fValues.data(), stride);
+
+		draw.firstX = draw.from = 0;
+		draw.count = steps;
+
+		float newest[kMaxLayers];
+		for (int32 k = 0; k < layers; k++)
+			newest[k] = fTops[k * stride + steps - 1];
+		_LayersToY(params, 1, max, newest, 1);
+
+		frame.generation = params.generation;
+		frame.lastMax = max;
+		for (int32 k = 0; k < layers; k++)
+			frame.lastTops[k] = newest[k];
+		return true;
+	}
+
+	int32 redrawWidth = std::max((int32)1, pixelsToScroll);
+
+	if (pixelsToScroll > 0) {
+		frame.rasterizer.Scroll(pixelsToScroll);
+
+		frame.scrollOffset += static_cast<float>(pixelsToScroll);
+		while (frame.scrollOffset >= params.gridSpacing)
+			frame.scrollOffset -= params.gridSpacing;
+		frame.lastRefresh += static_cast<bigtime_t>(pixelsToScroll) * timeStep;
+	}
+
+	// New columns (at least the last one), and the one before them that
+	// the lines have to connect to
+	int32 firstX = steps - 1 - redrawWidth;
+	int32 startI = std::max((int32)0, firstX - 1);
+	int32 count = steps - startI;
+
+	_SampleLayers(params, frame.lastRefresh
+		- static_cast<bigtime_t>(steps - 1 - startI) * timeStep, count,
+		fTops.data(), stride, fValues.data());
+
+	// For the very last pixel, use 'now' for maximum smoothness
+	float newest[kMaxLayers];
+	float newestValues[kMaxLayers];
+	_SampleLayers(params, now, 1, newest, 1, newestValues);
+	for (int32 k = 0; k < layers; k++) {
+		fTops[k * stride + count - 1] = newest[k];
+		fValues[k * stride + count - 1] = newestValues[k];
+	}
+	_StoreColumns(frame, layers, startI, count, fValues.data(), stride);
+
+	draw.firstX = startI;
+	draw.count = count;
+	draw.from = firstX;
+
+	// Without scrolling, the newest column may still look the same
+	_LayersToY(params, 1, max, newest, 1);
+	bool changed = pixelsToScroll > 0;
+	for (int32 k = 0; k < layers; k++) {
+		changed |= newest[k] != frame.lastTops[k];
+		frame.lastTops[k] = newest[k];
+	}
+	if (!changed)
+		draw.from = steps;
+
+	return true;
+}
+
+
+/*!	Draws the columns sampled into the frame, which doesn't need the
+	metric anymore. Returns false if they couldn't be drawn.
+*/
+bool
+StackedGraphView::_DrawColumns(const render_params& params,
+	frame_state& frame, const column_draw& draw)
+{
+	int32 drawn = draw.firstX + draw.count - draw.from;
+	if (drawn <= 0)
+		return true;
+
+	int32 layers = params.layerCount;
+	_LayersToY(params, draw.count, draw.max, fTops.data(), draw.stride);
+
+	int32 skip = draw.from - draw.firstX;
+	const float* tops[kMaxLayers];
+	float previousTops[kMaxLayers];
+	for (int32 k = 0; k < layers; k++) {
+		const float* layer = fTops.data() + k * draw.stride;
+		tops[k] = layer + skip;
+		previousTops[k] = skip > 0 ? layer[skip - 1] : NAN;
+	}
+
+	frame.rasterizer.SetGrid(4, params.gridSpacing, frame.scrollOffset);
+	if (frame.rasterizer.DrawStackedColumns(draw.from, drawn, tops,
+			skip > 0 ? previousTops : NULL) != B_OK) {
+		// The ring has already moved on
+		frame.generation = 0;
+		return false;
+	}
+
+	return true;
+}
+
+
+/*!	Fills tops with the tops of count columns, step apart from start, for
+	every layer with all those below it added. Layer k starts at tops + k
+	* stride. If values isn't NULL, it gets the values of the layers
+	themselves in the same way. The metric has to be locked.
+*/
+/*static*/ void
+StackedGraphView::_SampleLayers(const render_params& params,
+	bigtime_t start, int32 count, float* tops, size_t stride, float* values)
+{
+	const DataHistory<float>* history = params.history;
+	bigtime_t step = params.resolution;
+
+	// When zoomed out, the peak within each pixel, like the envelope of the
+	// other graphs
+	int32 level = history->LevelFor(step);
+	for (int32 k = 0; k < params.layerCount; k++) {
+		float* layer = tops + k * stride;
+		int32 field = params.fields[k];
+
+		if (level >= 0) {
+			int32 searchIndex = 0;
+			for (int32 j = 0; j < count; j++) {
+				bigtime_t time = start + j * step;
+				float low, high;
+				if (!history->EnvelopeAt(level, time - step + 1, time + 1,
+						low, high, &searchIndex, field)) {
+					high = history->ValueAt(time, NULL, field);
+				}
+				layer[j] = high;
+			}
+		} else
+			history->ResampleRange(start, step, count, layer, field);
+
+		if (values != NULL)
+			memcpy(values + k * stride, layer, count * sizeof(float));
+
+		if (k > 0) {
+			const float* below = layer - stride;
+			for (int32 j = 0; j < count; j++)
+				layer[j] += below[j];
+		}
+	}
+}
+
+
+/*!	Turns the tops of count columns, laid out as by _SampleLayers(), into
+	y coordinates.
+*/
+/*static*/ void
+StackedGraphView::_LayersToY(const render_params& params, int32 count,
+	float max, float* tops, size_t stride)
+{
+	float height = static_cast<float>(params.height - 1);
+	for (int32 k = 0; k < params.layerCount; k++) {
+		float* layer = tops + k * stride;
+		for (int32 j = 0; j < count; j++)
+			layer[j] = ActivityGraphView::ValueToY(layer[j], 0, max, height);
+	}
+}
+
+
+/*!	Keeps the values of the image columns [x, x + count) of every layer
+	with the frame, in the buffer columns that show them.
+*/
+/*static*/ void
+StackedGraphView::_StoreColumns(frame_state& frame, int32 layers, int32 x,
+	int32 count, const float* values, size_t stride)
+{
+	int32 width = frame.width;
+	if (frame.values.size() < static_cast<size_t>(width) * layers)
+		return;
+
+	for (int32 k = 0; k < layers; k++) {
+		float* ring = frame.values.data() + static_cast<size_t>(k) * width;
+		const float* layer = values + k * stride;
+		int32 column = (frame.rasterizer.Origin() + x) % width;
+		for (int32 j = 0; j < count; j++) {
+			ring[column] = layer[j];
+			if (++column == width)
+				column = 0;
+		}
+	}
+}
+
+
+/*static*/ float
+StackedGraphView::_ScaleMax(const render_params& params)
+{
+	if (params.manualScale)
+		return params.manualMax;
+
+	if (params.scaleField >= 0)
+		return params.history->MaximumValue(params.scaleField);
+
+	float max = 0;
+	for (int32 k = 0; k < params.layerCount; k++)
+		max += params.history->MaximumValue(params.fields[k]);
+	return max;
+}
+
+
+void
+StackedGraphView::_DrawCrosshair()
+{
+	// Placed by the frame on screen, which may still be from before a
+	// zoom or resize
+	BRect bounds = Bounds();
+	float x;
+	float values[kMaxLayers];
+	float max;
+	if (fCrosshairTime == kNoCrosshairTime || fHistory == NULL
+		|| fLayerCount == 0
+		|| !_FrameCrosshairAt(fCrosshairTime, x, values, max)) {
+		return;
+	}
+
+	// From the top layer down, as they are shown; the horizontal line is
+	// at the top of the stack
+	BString label;
+	float total = 0;
+	for (int32 k = fLayerCount - 1; k >= 0; k--) {
+		total += values[k];
+
+		BString value, part;
+		_FormatValue(value, values[k]);
+		part.SetToFormat(B_TRANSLATE("%s: %s"), fLabels[k].String(),
+			value.String());
+		if (!label.IsEmpty())
+			label << ", ";
+		label << part;
+	}
+
+	float y = bounds.top + ActivityGraphView::ValueToY(total, 0, max,
+		bounds.Height());
+	GraphCrosshair::Draw(this, bounds, x, y, label.String());
+}
+
+
+/*!	Looks up the value of every layer in the column of the frame on screen
+	at x, the time it shows by the frame's own time axis, and the scale it
+	was drawn with. A frame from before a resize is stretched, like Draw()
+	shows it.
+*/
+bool
+StackedGraphView::_FrameValuesAt(float x, bigtime_t& time, float* values,
+	float& max)
+{
+	if (!fBuffers.Lock())
+		return false;
+
+	const frame_state& frame = fFrames[fBuffers.FrontIndex()];
+	int32 width = frame.width;
+	bool found = frame.generation != 0 && width > 0 && frame.resolution > 0
+		&& frame.values.size() >= static_cast<size_t>(width) * fLayerCount;
+	if (found) {
+		BRect bounds = Bounds();
+		int32 column = static_cast<int32>((x - bounds.left) * width
+			/ (bounds.Width() + 1));
+		column = std::min(std::max(column, (int32)0), width - 1);
+
+		time = frame.lastRefresh - static_cast<bigtime_t>(width - 1 - column)
+			* frame.resolution;
+		column = (frame.rasterizer.Origin() + column) % width;
+
+		for (int32 k = 0; k < fLayerCount; k++)
+			values[k] = frame.values[static_cast<size_t>(k) * width + column];
+		max = frame.lastMax;
+	}
+
+	fBuffers.Unlock();
+	return found;
+}
+
+
+/*!	Looks up the column of the frame on screen that shows time, by the
+	frame's own time axis, where it is in the view, and the value of every
+	layer in it and the scale it was drawn with.
+*/
+bool
+StackedGraphView::_FrameCrosshairAt(bigtime_t time, float& x, float* values,
+	float& max)
+{
+	if (!fBuffers.Lock())
+		return false;
+
+	const frame_state& frame = fFrames[fBuffers.FrontIndex()];
+	int32 width = frame.width;
+	bool found = frame.generation != 0 && width > 0 && frame.resolution > 0
+		&& frame.values.size() >= static_cast<size_t>(width) * fLayerCount;
+	if (found) {
+		// Anything within the newest column still belongs to it
+		int64 column = width - 1
+			- (frame.lastRefresh - time) / frame.resolution;
+		found = column >= 0 && column < width;
+		if (found) {
+			BRect bounds = Bounds();
+			x = floorf(bounds.left + (column + 0.5f)
+				* (bounds.Width() + 1) / width) + 0.5f;
+
+			int32 index = (frame.rasterizer.Origin()
+				+ static_cast<int32>(column)) % width;
+			for (int32 k = 0; k < fLayerCount; k++) {
+				values[k] = frame.values[static_cast<size_t>(k) * width
+					+ index];
+			}
+			max = frame.lastMax;
+		}
+	}
+
+	fBuffers.Unlock();
+	return found;
+}
+
+
+void
+StackedGraphView::_FormatValue(BString& text, float value) const
+{
+	if (fFormatter != NULL)
+		fFormatter(text, value);
+	else {
+		text.Truncate(0);
+		text << value;
+	}
+}
@@ -0,0 +1,179 @@
+#ifndef STACKEDGRAPHVIEW_H
+#define STACKEDGRAPHVIEW_H
+
+#include <String.h>
+#include <View.h>
+#include <vector>
+#include "ActivityGraphView.h"
+#include "DataHistory.h"
+#include "GraphRasterizer.h"
+#include "GraphRenderer.h"
+#include "MetricRegistry.h"
+#include "SeqLock.h"
+
+class BBitmap;
+
+// Shows several fields of a metric stacked on top of each other, like the
+// memory that is used and cached, or the traffic received and sent. The
+// tops of all layers are added up once per column, and every layer is
+// filled in the same pass over the bitmap, so a stack costs little more
+// than one ActivityGraphView instead of one per layer.
+//
+// Like the ActivityGraphView, it is rendered on the GraphRenderer's thread,
+// scrolls by moving the origin of a ring of columns, and only draws the
+// columns that came in since a buffer was last rendered into.
+class StackedGraphView : public BView, public GraphRenderClient {
+public:
+						StackedGraphView(const char* name);
+	virtual				~StackedGraphView();
+
+	virtual void		AttachedToWindow();
+	virtual void		DetachedFromWindow();
+	virtual void		MessageReceived(BMessage* message);
+	virtual void		FrameResized(float width, float height);
+	virtual void		Draw(BRect updateRect);
+	virtual void		MouseMoved(BPoint where, uint32 transit,
+							const BMessage* dragMessage);
+	virtual bool		GetToolTipAt(BPoint point, BToolTip** _tip);
+
+	virtual void		RenderFrame();
+
+			// Redraws whenever the metric is published. Its fields are
+			// stacked in the order the layers are added, from the bottom up.
+			void		SetMetric(metric_id metric);
+			status_t	AddLayer(int32 field, const char* label,
+							color_which color);
+			int32		CountLayers() const { return fLayerCount; }
+
+			// The graph always starts at 0. It goes up to max, or to the
+			// highest value in the history of the scale field, which should
+			// be the total of all layers; without one, the highest values
+			// of all layers are added up.
+			void		SetManualScale(float max);
+			void		SetScaleField(int32 field);
+			void		SetValueFormatter(value_formatter formatter);
+
+private:
+	enum {
+		kMaxLayers = 4,
+		kQuantileCount = 3
+	};
+
+	// What the render thread needs from the view, handed over with the
+	// frame buffers locked
+	struct render_params {
+		metric_id		metric;
+		DataHistory<float>*	history;
+		int32			layerCount;
+		int32			fields[kMaxLayers];
+		uint32			fills[kMaxLayers];
+		bigtime_t		resolution;
+		bool			manualScale;
+		float			manualMax;
+		int32			scaleField;
+		int32			width;
+		int32			height;
+		float			gridSpacing;
+		uint32			background;
+		uint32			grid;
+		// Changes whenever the frames have to be drawn from scratch
+		uint32			generation;
+	};
+
+	// What is in one of the frame buffers, so that the next frame rendered
+	// into it only has to draw what changed since
+	struct frame_state {
+		GraphRasterizer	rasterizer;
+		// 0 until something has been drawn
+		uint32			generation;
+		int32			width;
+		int32			height;
+		// The time between columns, and that of the newest one
+		bigtime_t		resolution;
+		bigtime_t		lastRefresh;
+		float			scrollOffset;
+		float			lastMax;
+		// The newest column of every layer
+		float			lastTops[kMaxLayers];
+		// The value of every layer's columns, one layer after the other,
+		// each in the same ring as the bitmap, so that the window thread
+		// can look them up without locking the metric
+		std::vector<float> values;
+	};
+
+	// The columns sampled into fTops with the metric locked, which are
+	// drawn once it is unlocked again
+	struct column_draw {
+		// The image column of the first one sampled, and how many
+		int32			firstX;
+		int32			count;
+		// The first one drawn, the one before it is only there for the
+		// lines to connect to
+		int32			from;
+		float			max;
+		size_t			stride;
+	};
+
+	// What the tooltips show of the whole history, published by the
+	// render thread whenever it looks at the metric
+	struct history_readout {
+		bigtime_t		end;
+		float			quantiles[kMaxLayers][kQuantileCount];
+	};
+
+			void		_RequestFrame();
+			void		_UpdateRenderParams();
+			void		_DrawCrosshair();
+			bool		_FrameValuesAt(float x, bigtime_t& time,
+							float* values, float& max);
+			bool		_FrameCrosshairAt(bigtime_t time, float& x,
+							float* values, float& max);
+			void		_UpdateReadout(const render_params& params);
+			bool		_NeedsFrame(const render_params& params) const;
+			bool		_SampleFrame(const render_params& params,
+							frame_state& frame, column_draw& draw);
+			bool		_DrawColumns(const render_params& params,
+							frame_state& frame, const column_draw& draw);
+	static	void		_SampleLayers(const render_params& params,
+							bigtime_t start, int32 count, float* tops,
+							size_t stride, float* values = NULL);
+	static	void		_LayersToY(const render_params& params,
+							int32 count, float max, float* tops,
+							size_t stride);
+	static	void		_StoreColumns(frame_state& frame, int32 layers,
+							int32 x, int32 count, const float* values,
+							size_t stride);
+	static	float		_ScaleMax(const render_params& params);
+			void		_FormatValue(BString& text, float value) const;
+
+private:
+	metric_id			fMetric;
+	DataHistory<float>*	fHistory;
+	value_formatter		fFormatter;
+	bigtime_t			fResolution;
+
+	int32				fLayerCount;
+	int32				fFields[kMaxLayers];
+	BString				fLabels[kMaxLayers];
+	color_which			fColors[kMaxLayers];
+
+	bool				fManualScale;
+	float				fManualMax;
+	int32				fScaleField;
+	// Set when a frame was skipped while hidden
+	bool				fFrameMissed;
+	bigtime_t			fCrosshairTime;
+
+	GraphFrameBuffers	fBuffers;
+	render_params		fParams;
+	// Only touched by the render thread, apart from the front one that is
+	// read by Draw() with the buffers locked
+	frame_state			fFrames[2];
+	SeqLock<history_readout> fReadout;
+	// The tops and values of every layer's columns, one layer after the
+	// other, for the render thread
+	std::vector<float>	fTops;
+	std::vector<float>	fValues;
+};
+
+#endif // STACKEDGRAPHVIEW_H
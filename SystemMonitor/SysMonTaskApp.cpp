@@ -22,6 +22,9 @@
 #include "ProcessView.h"
 #include "SystemTab.h"
 #include "PerformanceView.h"
+#include "PreferencesWindow.h"
+#include "SamplingScheduler.h"
+#include "SamplingSettings.h"
 
 const uint32 MSG_ABOUT_REQUESTED = 'abou';
 
@@ -70,9 +73,7 @@ private:
 
 #include "PerformanceView.h"
 
-const uint32 MSG_REFRESH_SPEED_HIGH = 'rfsH';
-const uint32 MSG_REFRESH_SPEED_NORMAL = 'rfsN';
-const uint32 MSG_REFRESH_SPEED_LOW = 'rfsL';
+const uint32 MSG_SHOW_PREFERENCES = 'pref';
 
 class MainWindow : public BWindow {
 public:
@@ -84,6 +85,7 @@ public:
 	void LoadSettings();
 
 private:
+	void _ApplySamplingSettings();
 
 	BTabView* fMainTabView;
 
@@ -92,6 +94,9 @@ private:
 	SystemTab* fSystemTab;
 
 	BMessenger fAboutWindow;
+	BMessenger fPreferencesWindow;
+
+	SamplingSettings fSamplingSettings;
 };
 
 MainWindow::MainWindow(BRect frame)
@@ -108,12 +113,8 @@ MainWindow::MainWindow(BRect frame)
 	menuBar->AddItem(appMenu);
 
 	BMenu* viewMenu = new BMenu(B_TRANSLATE("View"));
-	BMenu* speedMenu = new BMenu(B_TRANSLATE("Refresh Speed"));
-	speedMenu->AddItem(new BMenuItem(B_TRANSLATE("High (0.5s)"), new BMessage(MSG_REFRESH_SPEED_HIGH)));
-	speedMenu->AddItem(new BMenuItem(B_TRANSLATE("Normal (1s)"), new BMessage(MSG_REFRESH_SPEED_NORMAL)));
-	speedMenu->AddItem(new BMenuItem(B_TRANSLATE("Low (2s)"), new BMessage(MSG_REFRESH_SPEED_LOW)));
-	speedMenu->SetRadioMode(true);
-	viewMenu->AddItem(speedMenu);
+	viewMenu->AddItem(new BMenuItem(B_TRANSLATE("Sampling intervals" B_UTF8_ELLIPSIS),
+		new BMessage(MSG_SHOW_PREFERENCES), ','));
 	menuBar->AddItem(viewMenu);
 
 	// Create the three main views
@@ -144,7 +145,8 @@ MainWindow::MainWindow(BRect frame)
 	// Configure window
 	SetSizeLimits(800, B_SIZE_UNLIMITED, 600, B_SIZE_UNLIMITED);
 
-	// Set pulse rate for real-time updates
+	// Sampling is done by the scheduler; the pulse only refreshes a few
+	// labels
 	SetPulseRate(1000000); // 1 second pulse
 
 	// Center window on screen
@@ -176,20 +178,35 @@ void MainWindow::MessageReceived(BMessage* message) {
 			}
 			break;
 
-		case MSG_REFRESH_SPEED_HIGH:
-			SetPulseRate(500000);
-			if (fProcessView) fProcessView->SetRefreshInterval(500000);
-			if (fPerformanceView) fPerformanceView->SetRefreshInterval(500000);
-			break;
-		case MSG_REFRESH_SPEED_NORMAL:
-			SetPulseRate(1000000);
-			if (fProcessView) fProcessView->SetRefreshInterval(1000000);
-			if (fPerformanceView) fPerformanceView->SetRefreshInterval(1000000);
+		case MSG_SHOW_PREFERENCES:
+			{
+				if (fPreferencesWindow.IsValid()) {
+					BWindow* window;
+					if (fPreferencesWindow.Target(&window) == B_OK && window != NULL) {
+						window->Activate(true);
+						break;
+					}
+				}
+
+				// What each source has cost so far, for the estimate
+				bigtime_t costs[kSamplingSourceCount] = {};
+				if (fPerformanceView)
+					fPerformanceView->GetSampleCosts(costs);
+				costs[kProcessSampling]
+					= SamplingScheduler::Default().AverageCost(fProcessView);
+				if (fSystemTab)
+					costs[kSummarySampling] = fSystemTab->SampleCost();
+
+				PreferencesWindow* preferences = new PreferencesWindow(
+					fSamplingSettings, costs, BMessenger(this));
+				preferences->Show();
+				fPreferencesWindow = BMessenger(preferences);
+			}
 			break;
-		case MSG_REFRESH_SPEED_LOW:
-			SetPulseRate(2000000);
-			if (fProcessView) fProcessView->SetRefreshInterval(2000000);
-			if (fPerformanceView) fPerformanceView->SetRefreshInterval(2000000);
+
+		case kMsgSamplingSettingsChanged:
+			fSamplingSettings.LoadState(*message);
+			_ApplySamplingSettings();
 			break;
 
 		default:
@@ -211,7 +228,7 @@ void MainWindow::SaveSettings() {
 				fPerformanceView->SaveState(settings);
 
 			settings.AddRect("window_frame", Frame());
-			settings.AddInt64("pulse_rate", PulseRate());
+			fSamplingSettings.SaveState(settings);
 
 			if (fMainTabView)
 				settings.AddInt32("active_tab", fMainTabView->Selection());
@@ -240,12 +257,7 @@ void MainWindow::LoadSettings() {
 				if (fPerformanceView)
 					fPerformanceView->LoadState(settings);
 
-				bigtime_t rate;
-				if (settings.FindInt64("pulse_rate", &rate) == B_OK) {
-					SetPulseRate(rate);
-					if (fProcessView) fProcessView->SetRefreshInterval(rate);
-					if (fPerformanceView) fPerformanceView->SetRefreshInterval(rate);
-				}
+				fSamplingSettings.LoadState(settings);
 
 				int32 activeTab;
 				if (fMainTabView && settings.FindInt32("active_tab", &activeTab) == B_OK) {
@@ -255,22 +267,16 @@ void MainWindow::LoadSettings() {
 		}
 	}
 
-	// Update Menu Selection based on current PulseRate
-	bigtime_t rate = PulseRate();
-	uint32 command = MSG_REFRESH_SPEED_NORMAL;
-	if (rate <= 500000) command = MSG_REFRESH_SPEED_HIGH;
-	else if (rate >= 2000000) command = MSG_REFRESH_SPEED_LOW;
-
-	// Fallback to searching all children if KeyMenuBar is not yet set
-	BMenuBar* menuBar = KeyMenuBar();
-	if (!menuBar) {
-		menuBar = dynamic_cast<BMenuBar*>(FindView("MenuBar"));
-	}
+	_ApplySamplingSettings();
+}
 
-	if (menuBar) {
-		BMenuItem* item = menuBar->FindItem(command);
-		if (item) item->SetMarked(true);
-	}
+void MainWindow::_ApplySamplingSettings() {
+	if (fPerformanceView)
+		fPerformanceView->SetSamplingSettings(fSamplingSettings);
+	if (fProcessView)
+		fProcessView->SetRefreshInterval(fSamplingSettings.Interval(kProcessSampling));
+	if (fSystemTab)
+		fSystemTab->SetRefreshInterval(fSamplingSettings.Interval(kSummarySampling));
 }
 
 SysMonTaskApp::SysMonTaskApp()
@@ -1,5 +1,6 @@
 #include "SystemDetailsView.h"
 #include "Utils.h"
+#include "SystemInfoCache.h"
 
 #include <cstdio>
 #include <time.h>
@@ -155,7 +156,7 @@ void SystemDetailsView::Pulse()
 		return;
 
 	system_info sysInfo;
-	get_system_info(&sysInfo);
+	SystemInfoCache::Default().GetSystemInfo(sysInfo);
 
 	fMemUsageView->SetText(_GetRamUsage(&sysInfo));
 	fSwapUsageView->SetText(_GetSwapUsage(&sysInfo));
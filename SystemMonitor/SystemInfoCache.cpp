@@ -0,0 +1,124 @@
+#include "SystemInfoCache.h"
+
+#include <Autolock.h>
+
+#include <string.h>
+#include <new>
+
+#include "SamplingScheduler.h"
+
+
+SystemInfoCache::SystemInfoCache()
+	:
+	fLock("system info cache"),
+	fSystemInfoTime(-1),
+	fCPUInfoTime(-1),
+	fCPUInfoReadTime(0),
+	fKernelCalls(0),
+	fKernelCallsAvoided(0)
+{
+	memset(&fSystemInfo, 0, sizeof(fSystemInfo));
+}
+
+
+/*static*/ SystemInfoCache&
+SystemInfoCache::Default()
+{
+	static SystemInfoCache sDefault;
+	return sDefault;
+}
+
+
+status_t
+SystemInfoCache::GetSystemInfo(system_info& info, bigtime_t now)
+{
+	// Only the time of a tick keeps the snapshots on the tick grid; stamped
+	// any later, the next tick would still take it for its own
+	bool onTick = now >= 0;
+	if (!onTick)
+		now = system_time();
+
+	BAutolock locker(fLock);
+
+	if (!_IsFresh(fSystemInfoTime, now)) {
+		fKernelCalls++;
+		status_t status = get_system_info(&fSystemInfo);
+		if (status != B_OK) {
+			fSystemInfoTime = -1;
+			return status;
+		}
+		if (onTick)
+			fSystemInfoTime = now;
+	} else
+		fKernelCallsAvoided++;
+
+	info = fSystemInfo;
+	return B_OK;
+}
+
+
+status_t
+SystemInfoCache::GetCPUInfo(cpu_info* infos, uint32 count, bigtime_t now,
+	bigtime_t* readTime)
+{
+	if (infos == NULL || count == 0)
+		return B_BAD_VALUE;
+	// Only the time of a tick keeps the snapshots on the tick grid; stamped
+	// any later, the next tick would still take it for its own
+	bool onTick = now >= 0;
+	if (!onTick)
+		now = system_time();
+
+	BAutolock locker(fLock);
+
+	if (count > fCPUInfos.size()) {
+		// Only happens the first time; the CPU count doesn't change
+		try {
+			fCPUInfos.resize(count);
+		} catch (const std::bad_alloc&) {
+			return B_NO_MEMORY;
+		}
+		fCPUInfoTime = -1;
+	}
+
+	if (!_IsFresh(fCPUInfoTime, now)) {
+		fKernelCalls++;
+		status_t status = get_cpu_info(0, fCPUInfos.size(), fCPUInfos.data());
+		if (status != B_OK) {
+			fCPUInfoTime = -1;
+			return status;
+		}
+		fCPUInfoReadTime = system_time();
+		if (onTick)
+			fCPUInfoTime = now;
+	} else
+		fKernelCallsAvoided++;
+
+	memcpy(infos, fCPUInfos.data(), count * sizeof(cpu_info));
+	if (readTime != NULL)
+		*readTime = fCPUInfoReadTime;
+	return B_OK;
+}
+
+
+int64
+SystemInfoCache::KernelCalls() const
+{
+	BAutolock locker(fLock);
+	return fKernelCalls;
+}
+
+
+int64
+SystemInfoCache::KernelCallsAvoided() const
+{
+	BAutolock locker(fLock);
+	return fKernelCallsAvoided;
+}
+
+
+/*static*/ bool
+SystemInfoCache::_IsFresh(bigtime_t snapshotTime, bigtime_t now)
+{
+	return snapshotTime >= 0 && now - snapshotTime < kSamplingTick;
+}
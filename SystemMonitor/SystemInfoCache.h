@@ -0,0 +1,50 @@
+#ifndef SYSTEMINFOCACHE_H
+#define SYSTEMINFOCACHE_H
+
+#include <Locker.h>
+#include <OS.h>
+#include <vector>
+
+
+// Shares one system_info and one set of cpu_info between everything that
+// samples on the same scheduler tick. Collectors with related intervals
+// fire on the same ticks, so without this each of them would ask the
+// kernel for the same data.
+class SystemInfoCache {
+public:
+	static	SystemInfoCache& Default();
+
+			// A snapshot taken less than one tick before now is reused. Pass
+			// the time given to SampleCollector::Collect(), or nothing
+			// outside of the scheduler; such a call may reuse the snapshot
+			// of the current tick, but never makes the next one reuse its
+			// own.
+			status_t	GetSystemInfo(system_info& info, bigtime_t now = -1);
+			// readTime is set to when the kernel was actually asked,
+			// which is what the active times have to be divided by.
+			status_t	GetCPUInfo(cpu_info* infos, uint32 count,
+							bigtime_t now = -1, bigtime_t* readTime = NULL);
+
+			int64		KernelCalls() const;
+			int64		KernelCallsAvoided() const;
+
+private:
+							SystemInfoCache();
+
+	static	bool		_IsFresh(bigtime_t snapshotTime, bigtime_t now);
+
+private:
+	mutable BLocker		fLock;
+
+	system_info			fSystemInfo;
+	bigtime_t			fSystemInfoTime;
+
+	std::vector<cpu_info> fCPUInfos;
+	bigtime_t			fCPUInfoTime;
+	bigtime_t			fCPUInfoReadTime;
+
+	int64				fKernelCalls;
+	int64				fKernelCallsAvoided;
+};
+
+#endif // SYSTEMINFOCACHE_H
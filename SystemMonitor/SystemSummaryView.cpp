@@ -1,5 +1,6 @@
 #include "SystemSummaryView.h"
 #include "Utils.h"
+#include "SystemInfoCache.h"
 #include <kernel/OS.h>
 #include <stdio.h>
 #include <time.h>
@@ -26,6 +27,8 @@
 #include <NetworkRoster.h>
 #include <NetworkInterface.h>
 #include <NetworkAddress.h>
+#include <NetworkNotifications.h>
+#include <NodeMonitor.h>
 #include <Locale.h>
 
 #undef B_TRANSLATION_CONTEXT
@@ -35,13 +38,58 @@
 
 static const uint32 kMsgUpdateInfo = 'UPDT';
 
+static const bigtime_t kForever = B_INFINITE_TIMEOUT;
+static const bigtime_t kMinute = 60000000LL;
+
+// How long each field stays valid before it is loaded again; 0 means on
+// every refresh. Most of them never change while we are running. Packages
+// and the IP address are reloaded when a node or network monitor message
+// says they changed, the lifetime is only a fallback.
+struct summary_field_info {
+	const char*	name;
+	bigtime_t	lifetime;
+};
+
+static const summary_field_info kSummaryFields[] = {
+	{ "user_host",	kMinute },
+	{ "os",			kForever },
+	{ "kernel",		kForever },
+	{ "uptime",		0 },
+	{ "packages",	10 * kMinute },
+	{ "shell",		kForever },
+	{ "display",	5000000 },
+	{ "de",			kForever },
+	{ "wm",			kForever },
+	{ "font",		10000000 },
+	{ "cpu",		kForever },
+	{ "gpu",		kForever },
+	{ "memory",		0 },
+	{ "swap",		0 },
+	{ "disk",		10000000 },
+	{ "ip",			10 * kMinute },
+	{ "battery",	30000000 },
+	{ "locale",		kForever }
+};
+
+static const char* const kPackageDirectories[] = {
+	"/boot/system/packages",
+	"/boot/home/config/packages"
+};
+
 SystemSummaryView::SystemSummaryView()
 	: BView("SystemSummaryView", B_WILL_DRAW | B_PULSE_NEEDED),
 	  fLogoTextView(NULL),
 	  fInfoTextView(NULL),
-	  fLoadThread(-1),
-	  fThreadRunning(false)
+	  fRefreshInterval(1000000),
+	  fCollecting(false),
+	  fInvalidFields(0)
 {
+	static_assert(sizeof(kSummaryFields) / sizeof(kSummaryFields[0])
+		== kSummaryFieldCount, "kSummaryFields doesn't match summary_field");
+
+	for (int32 i = 0; i < kSummaryFieldCount; i++)
+		fFieldTimes[i] = -1;
+
 	SetViewUIColor(B_PANEL_BACKGROUND_COLOR);
 	CreateLayout();
 }
@@ -49,9 +97,7 @@ SystemSummaryView::SystemSummaryView()
 SystemSummaryView::~SystemSummaryView()
 {
 	// Child views are automatically deleted
-	if (fLoadThread >= 0) {
-		wait_for_thread(fLoadThread, NULL);
-	}
+	SamplingScheduler::Default().RemoveCollector(this);
 }
 
 void SystemSummaryView::CreateLayout()
@@ -90,38 +136,44 @@ void SystemSummaryView::CreateLayout()
 void SystemSummaryView::AttachedToWindow()
 {
 	BView::AttachedToWindow();
-	_StartLoadThread();
+
+	_StartWatching();
+
+	fCollecting = !IsHidden();
+	SamplingScheduler& scheduler = SamplingScheduler::Default();
+	// Some fields read files and volumes, away from CPU and memory sampling
+	scheduler.AddCollector(this, fRefreshInterval, fCollecting,
+		kSamplingLaneSlow);
+	scheduler.Trigger(this);
+}
+
+void SystemSummaryView::DetachedFromWindow()
+{
+	_StopWatching();
+	SamplingScheduler::Default().RemoveCollector(this);
+	BView::DetachedFromWindow();
 }
 
 void SystemSummaryView::Show()
 {
 	BView::Show();
-	_StartLoadThread();
+	SamplingScheduler::Default().Trigger(this);
 }
 
-void SystemSummaryView::Pulse()
+void SystemSummaryView::SetRefreshInterval(bigtime_t interval)
 {
-	if (!IsHidden()) {
-		_StartLoadThread();
-	}
+	fRefreshInterval = interval;
+	SamplingScheduler::Default().SetInterval(this, interval);
 }
 
-void SystemSummaryView::_StartLoadThread()
+void SystemSummaryView::Pulse()
 {
-	// Use atomic flag: prevents a new thread if one is already running,
-	// even if the previous thread's ID has been recycled.
-	bool expected = false;
-	if (!fThreadRunning.compare_exchange_strong(expected, true))
-		return;
-
-	BMessenger* messenger = new BMessenger(this);
-	fLoadThread = spawn_thread(_LoadDataThread, "sysinfo_loader",
-		B_NORMAL_PRIORITY, messenger);
-	if (fLoadThread >= 0) {
-		resume_thread(fLoadThread);
-	} else {
-		delete messenger;
-		fThreadRunning = false;
+	// Hiding a parent doesn't call Hide() here, so keep the collector in
+	// sync with the actual visibility.
+	bool visible = !IsHidden();
+	if (visible != fCollecting) {
+		fCollecting = visible;
+		SamplingScheduler::Default().SetEnabled(this, visible);
 	}
 }
 
@@ -129,9 +181,6 @@ void SystemSummaryView::MessageReceived(BMessage* message)
 {
 	switch (message->what) {
 		case kMsgUpdateInfo: {
-			fLoadThread = -1;
-			fThreadRunning = false;
-
 			// Set Logo (ASCII Art)
 			// Color Palette from Haiku: Yellow/Gold for leaf, Blue for stem?
 			// Fastfetch Haiku Logo:
@@ -347,119 +396,202 @@ void SystemSummaryView::MessageReceived(BMessage* message)
 
 			break;
 		}
+		case B_NODE_MONITOR:
+			// Only the package directories are watched
+			_InvalidateField(kPackagesField);
+			break;
+		case B_NETWORK_MONITOR:
+			_InvalidateField(kIPField);
+			break;
 		default:
 			BView::MessageReceived(message);
 	}
 }
 
-int32 SystemSummaryView::_LoadDataThread(void* data) {
-	BMessenger* messenger = static_cast<BMessenger*>(data);
-	if (!messenger) return B_BAD_VALUE;
+void SystemSummaryView::Collect(bigtime_t now) {
+	uint32 invalidFields = fInvalidFields.exchange(0);
 
 	BMessage reply(kMsgUpdateInfo);
-	system_info sysInfo;
-
-	// 1. User@Host
-	struct passwd* pw = getpwuid(getuid());
-	char hostname[256];
-	if (gethostname(hostname, sizeof(hostname)) != 0)
-		strcpy(hostname, B_TRANSLATE("unknown"));
-
-	BString userHost;
-	userHost << (pw && pw->pw_name ? pw->pw_name : "user") << "@" << hostname;
-	reply.AddString("user_host", userHost);
-
-	// 2. OS
-	reply.AddString("os", GetOSVersion());
-
-	// 3. Kernel
-	struct utsname u;
-	uname(&u);
-	BString kernel;
-	kernel << u.sysname << " " << u.release;
-	reply.AddString("kernel", kernel);
-
-	// 4. Uptime
-	reply.AddString("uptime", ::FormatUptime(system_time()));
-
-	// 5. Packages
-	BString packages;
-	GetPackageCount(packages);
-	reply.AddString("packages", packages);
-
-	// 6. Shell
-	const char* shellEnv = getenv("SHELL");
-	BString shell = shellEnv ? shellEnv : "/bin/sh";
-	BPath shellPath(shell.String());
-	if (shellPath.InitCheck() == B_OK) shell = shellPath.Leaf();
-	reply.AddString("shell", shell);
-
-	// 7. Display
-	reply.AddString("display", GetDisplayInfo());
-
-	// 8. DE / WM
-	reply.AddString("de", B_TRANSLATE("Application Kit"));
-	reply.AddString("wm", B_TRANSLATE("Application Server"));
-
-	// 9. Font
-	font_family family;
-	font_style style;
-	be_plain_font->GetFamilyAndStyle(&family, &style);
-	BString font;
-	font << family << " " << style << " (" << static_cast<int>(be_plain_font->Size()) << "pt)";
-	reply.AddString("font", font);
-
-	// 10. CPU
-	reply.AddString("cpu", ::GetCPUBrandString());
-
-	// 11. GPU
-	reply.AddString("gpu", GetGPUInfo());
-
-	// 12. Memory
-	uint64 used, total, physical;
-	GetMemoryUsage(used, total, physical);
-	if (total > 0 && get_system_info(&sysInfo) == B_OK) {
-		uint64 cached = GetCachedMemoryBytes(sysInfo);
-
-		BString cachedStr;
-		::FormatBytes(cachedStr, cached);
-
-		BString memStr;
-		int percent = static_cast<int>(100.0 * used / total);
-		BString usedStr, totalStr;
-		::FormatBytes(usedStr, used);
-		::FormatBytes(totalStr, total);
-		memStr.SetToFormat(B_TRANSLATE("%s / %s (%d%%), Cached: %s"),
-			usedStr.String(), totalStr.String(), percent, cachedStr.String());
-		reply.AddString("memory", memStr);
-
-		uint64 swapUsed, swapTotal;
-		::GetSwapUsage(swapUsed, swapTotal);
-
-		BString swapStr;
-		BString swapUsedStr, swapTotalStr;
-		::FormatBytes(swapUsedStr, swapUsed);
-		::FormatBytes(swapTotalStr, swapTotal);
-		int swapPercent = swapTotal > 0 ? static_cast<int>(100.0 * swapUsed / swapTotal) : 0;
-		swapStr.SetToFormat(B_TRANSLATE("%s / %s (%d%%)"),
-			swapUsedStr.String(), swapTotalStr.String(), swapPercent);
-		reply.AddString("swap", swapStr);
+	for (int32 i = 0; i < kSummaryFieldCount; i++) {
+		const summary_field_info& info = kSummaryFields[i];
+		if (fFieldTimes[i] < 0 || (invalidFields & (1UL << i)) != 0
+			|| now - fFieldTimes[i] >= info.lifetime) {
+			fFieldValues[i] = _LoadField(static_cast<summary_field>(i), now);
+			fFieldTimes[i] = now;
+		}
+
+		if (!fFieldValues[i].IsEmpty())
+			reply.AddString(info.name, fFieldValues[i]);
 	}
 
-	// 13. Disk (Root volume)
-	reply.AddString("disk", GetRootDiskUsage());
+	// Never block on the window, it might be waiting for the scheduler
+	BMessenger(this).SendMessage(&reply, (BHandler*)NULL, 0);
+}
 
-	// 14. IP
-	reply.AddString("ip", GetLocalIPAddress());
+BString SystemSummaryView::_LoadField(summary_field field, bigtime_t now)
+{
+	BString value;
+
+	switch (field) {
+		case kUserHostField:
+		{
+			struct passwd* pw = getpwuid(getuid());
+			char hostname[256];
+			if (gethostname(hostname, sizeof(hostname)) != 0)
+				strcpy(hostname, B_TRANSLATE("unknown"));
+
+			value << (pw && pw->pw_name ? pw->pw_name : "user") << "@"
+				<< hostname;
+			break;
+		}
+
+		case kOSField:
+			value = GetOSVersion();
+			break;
+
+		case kKernelField:
+		{
+			struct utsname u;
+			uname(&u);
+			value << u.sysname << " " << u.release;
+			break;
+		}
 
-	// 15. Battery
-	reply.AddString("battery", GetBatteryCapacity());
+		case kUptimeField:
+			value = ::FormatUptime(now);
+			break;
 
-	// 16. Locale
-	reply.AddString("locale", GetLocale());
+		case kPackagesField:
+			GetPackageCount(value);
+			break;
 
-	messenger->SendMessage(&reply);
+		case kShellField:
+		{
+			const char* shellEnv = getenv("SHELL");
+			value = shellEnv ? shellEnv : "/bin/sh";
+			BPath shellPath(value.String());
+			if (shellPath.InitCheck() == B_OK)
+				value = shellPath.Leaf();
+			break;
+		}
+
+		case kDisplayField:
+			value = GetDisplayInfo();
+			break;
+
+		case kDesktopField:
+			value = B_TRANSLATE("Application Kit");
+			break;
+
+		case kWindowManagerField:
+			value = B_TRANSLATE("Application Server");
+			break;
+
+		case kFontField:
+		{
+			font_family family;
+			font_style style;
+			be_plain_font->GetFamilyAndStyle(&family, &style);
+			value << family << " " << style << " ("
+				<< static_cast<int>(be_plain_font->Size()) << "pt)";
+			break;
+		}
 
-	delete messenger;
-	return B_OK;
+		case kCPUField:
+			value = ::GetCPUBrandString();
+			break;
+
+		case kGPUField:
+			value = GetGPUInfo();
+			break;
+
+		case kMemoryField:
+		{
+			uint64 used, total, physical;
+			GetMemoryUsage(used, total, physical, now);
+
+			system_info sysInfo;
+			if (total == 0
+				|| SystemInfoCache::Default().GetSystemInfo(sysInfo, now)
+					!= B_OK) {
+				break;
+			}
+
+			BString cachedStr;
+			::FormatBytes(cachedStr, GetCachedMemoryBytes(sysInfo));
+
+			int percent = static_cast<int>(100.0 * used / total);
+			BString usedStr, totalStr;
+			::FormatBytes(usedStr, used);
+			::FormatBytes(totalStr, total);
+			value.SetToFormat(B_TRANSLATE("%s / %s (%d%%), Cached: %s"),
+				usedStr.String(), totalStr.String(), percent, cachedStr.String());
+			break;
+		}
+
+		case kSwapField:
+		{
+			uint64 swapUsed, swapTotal;
+			::GetSwapUsage(swapUsed, swapTotal, now);
+
+			BString swapUsedStr, swapTotalStr;
+			::FormatBytes(swapUsedStr, swapUsed);
+			::FormatBytes(swapTotalStr, swapTotal);
+			int swapPercent = swapTotal > 0
+				? static_cast<int>(100.0 * swapUsed / swapTotal) : 0;
+			value.SetToFormat(B_TRANSLATE("%s / %s (%d%%)"),
+				swapUsedStr.String(), swapTotalStr.String(), swapPercent);
+			break;
+		}
+
+		case kDiskField:
+			value = GetRootDiskUsage();
+			break;
+
+		case kIPField:
+			value = GetLocalIPAddress();
+			break;
+
+		case kBatteryField:
+			value = GetBatteryCapacity();
+			break;
+
+		case kLocaleField:
+			value = GetLocale();
+			break;
+
+		default:
+			break;
+	}
+
+	return value;
+}
+
+void SystemSummaryView::_InvalidateField(summary_field field)
+{
+	fInvalidFields.fetch_or(1UL << field);
+
+	// Show the new value right away rather than on the next refresh
+	if (fCollecting)
+		SamplingScheduler::Default().Trigger(this);
+}
+
+void SystemSummaryView::_StartWatching()
+{
+	for (size_t i = 0; i < sizeof(kPackageDirectories)
+			/ sizeof(kPackageDirectories[0]); i++) {
+		BDirectory directory(kPackageDirectories[i]);
+		node_ref nodeRef;
+		if (directory.GetNodeRef(&nodeRef) == B_OK)
+			watch_node(&nodeRef, B_WATCH_DIRECTORY, BMessenger(this));
+	}
+
+	BNetworkRoster::Default().StartWatching(BMessenger(this),
+		B_WATCH_NETWORK_INTERFACE_CHANGES | B_WATCH_NETWORK_LINK_CHANGES);
+}
+
+void SystemSummaryView::_StopWatching()
+{
+	stop_watching(BMessenger(this));
+	BNetworkRoster::Default().StopWatching(BMessenger(this));
 }
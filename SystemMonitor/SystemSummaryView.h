@@ -6,31 +6,71 @@
 #include <String.h>
 #include <kernel/OS.h>
 #include <Messenger.h>
+
 #include <atomic>
 
+#include "SamplingScheduler.h"
+
 class BBox;
 class BTextView;
 class BScrollView;
 
-class SystemSummaryView : public BView {
+class SystemSummaryView : public BView, public SampleCollector {
 public:
 	SystemSummaryView();
 	virtual ~SystemSummaryView();
 
 	virtual void AttachedToWindow();
+	virtual void DetachedFromWindow();
 	virtual void MessageReceived(BMessage* message);
 	virtual void Show();
 	virtual void Pulse();
 
+	virtual void Collect(bigtime_t now);
+
+	void SetRefreshInterval(bigtime_t interval);
+
 private:
+	// Keep in sync with kSummaryFields
+	enum summary_field {
+		kUserHostField = 0,
+		kOSField,
+		kKernelField,
+		kUptimeField,
+		kPackagesField,
+		kShellField,
+		kDisplayField,
+		kDesktopField,
+		kWindowManagerField,
+		kFontField,
+		kCPUField,
+		kGPUField,
+		kMemoryField,
+		kSwapField,
+		kDiskField,
+		kIPField,
+		kBatteryField,
+		kLocaleField,
+		kSummaryFieldCount
+	};
+
 	void CreateLayout();
-	void _StartLoadThread();
-	static int32 _LoadDataThread(void* data);
+	void _StartWatching();
+	void _StopWatching();
+	void _InvalidateField(summary_field field);
+	BString _LoadField(summary_field field, bigtime_t now);
 
 	BTextView* fLogoTextView;
 	BTextView* fInfoTextView;
-	thread_id  fLoadThread;
-	std::atomic<bool> fThreadRunning;
+	bigtime_t  fRefreshInterval;
+	bool       fCollecting;
+
+	// Only used by Collect()
+	BString    fFieldValues[kSummaryFieldCount];
+	bigtime_t  fFieldTimes[kSummaryFieldCount];
+
+	// One bit per field that a notification asked to reload
+	std::atomic<uint32> fInvalidFields;
 };
 
 #endif // SYSTEM_SUMMARY_VIEW_H
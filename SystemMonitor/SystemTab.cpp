@@ -1,6 +1,7 @@
 #include "SystemTab.h"
 #include "SystemSummaryView.h"
 #include "SystemDetailsView.h"
+#include "SamplingScheduler.h"
 
 #include <TabView.h>
 #include <LayoutBuilder.h>
@@ -10,13 +11,15 @@
 #define B_TRANSLATION_CONTEXT "SystemTab"
 
 SystemTab::SystemTab()
-	: BView("SystemTab", B_WILL_DRAW)
+	: BView("SystemTab", B_WILL_DRAW),
+	  fSummaryView(NULL)
 {
 	SetViewUIColor(B_PANEL_BACKGROUND_COLOR);
 
 	BTabView* tabView = new BTabView("system_tab_view");
 
-	tabView->AddTab(new SystemSummaryView());
+	fSummaryView = new SystemSummaryView();
+	tabView->AddTab(fSummaryView);
 	tabView->TabAt(0)->SetLabel(B_TRANSLATE("Summary"));
 
 	tabView->AddTab(new SystemDetailsView());
@@ -30,3 +33,13 @@ SystemTab::SystemTab()
 SystemTab::~SystemTab()
 {
 }
+
+void SystemTab::SetRefreshInterval(bigtime_t interval)
+{
+	fSummaryView->SetRefreshInterval(interval);
+}
+
+bigtime_t SystemTab::SampleCost() const
+{
+	return SamplingScheduler::Default().AverageCost(fSummaryView);
+}
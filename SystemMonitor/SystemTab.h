@@ -3,10 +3,18 @@
 
 #include <View.h>
 
+class SystemSummaryView;
+
 class SystemTab : public BView {
 public:
 	SystemTab();
 	virtual ~SystemTab();
+
+	void SetRefreshInterval(bigtime_t interval);
+	bigtime_t SampleCost() const;
+
+private:
+	SystemSummaryView* fSummaryView;
 };
 
 #endif // SYSTEM_TAB_H
@@ -23,6 +23,8 @@
 #include <Messenger.h>
 #include <Window.h>
 
+#include "SystemInfoCache.h"
+
 #if defined(__x86_64__) || defined(__i386__)
 #include <cpuid.h>
 #endif
@@ -97,9 +99,10 @@ uint64 BytesToMiB(uint64 bytes) {
 	return (bytes + 1048575) / 1048576;
 }
 
-void GetMemoryUsage(uint64& used, uint64& total, uint64& physical) {
+void GetMemoryUsage(uint64& used, uint64& total, uint64& physical,
+	bigtime_t now) {
 	system_info info;
-	if (get_system_info(&info) == B_OK) {
+	if (SystemInfoCache::Default().GetSystemInfo(info, now) == B_OK) {
 		total = static_cast<uint64>(info.max_pages) * B_PAGE_SIZE;
 		used = static_cast<uint64>(info.used_pages) * B_PAGE_SIZE;
 		physical = static_cast<uint64>(info.max_pages + info.ignored_pages) * B_PAGE_SIZE;
@@ -110,9 +113,9 @@ void GetMemoryUsage(uint64& used, uint64& total, uint64& physical) {
 	}
 }
 
-void GetSwapUsage(uint64& used, uint64& total) {
+void GetSwapUsage(uint64& used, uint64& total, bigtime_t now) {
 	system_info info;
-	if (get_system_info(&info) == B_OK) {
+	if (SystemInfoCache::Default().GetSystemInfo(info, now) == B_OK) {
 		total = static_cast<uint64>(info.max_swap_pages) * B_PAGE_SIZE;
 		used = static_cast<uint64>(info.used_swap_pages) * B_PAGE_SIZE;
 	} else {
@@ -161,6 +164,29 @@ BString FormatSpeed(uint64 bytesDelta, bigtime_t microSecondsDelta)
 	return str;
 }
 
+void FormatGraphPercent(BString& out, float percent)
+{
+	out.SetToFormat("%.1f%%", percent);
+}
+
+void FormatGraphRate(BString& out, float bytesPerSecond)
+{
+	FormatBytes(out, static_cast<double>(bytesPerSecond));
+	out << "/s";
+}
+
+void FormatTimeAgo(BString& out, bigtime_t ago)
+{
+	if (ago < 1000000)
+		out = B_TRANSLATE("now");
+	else if (ago < 120 * 1000000LL)
+		out.SetToFormat(B_TRANSLATE("%" B_PRId64 " s ago"), ago / 1000000);
+	else if (ago < 2 * 3600 * 1000000LL)
+		out.SetToFormat(B_TRANSLATE("%" B_PRId64 " min ago"), ago / 60000000);
+	else
+		out.SetToFormat(B_TRANSLATE("%" B_PRId64 " h ago"), ago / 3600000000LL);
+}
+
 float GetScaleFactor(const BFont* font) {
 	if (!font) return 1.0f;
 	float scale = font->Size() / 12.0f;
@@ -281,34 +307,29 @@ BString GetGPUInfo()
 	return BString(B_TRANSLATE("Unknown"));
 }
 
+// Walks the package directories every time; callers cache the result and
+// reload it when the directories change.
 void GetPackageCount(BString& out)
 {
-	static int sSysPkgs = -1;
-	static int sUserPkgs = -1;
-	static bigtime_t sLastCheck = 0;
-	bigtime_t now = system_time();
-
-	if (sSysPkgs == -1 || now - sLastCheck > 10000000LL) { // Every 10 seconds
-		auto countPackages = [](const char* path) -> int {
-			BDirectory dir(path);
-			if (dir.InitCheck() != B_OK) return 0;
-			int count = 0;
-			BEntry entry;
-			while (dir.GetNextEntry(&entry) == B_OK) {
-				BPath p;
-				entry.GetPath(&p);
-				if (p.InitCheck() == B_OK) {
-					BString name(p.Leaf());
-					if (name.EndsWith(".hpkg")) count++;
-				}
-			}
-			return count;
-		};
-		sSysPkgs = countPackages("/boot/system/packages");
-		sUserPkgs = countPackages("/boot/home/config/packages");
-		sLastCheck = now;
-	}
-	out.SetToFormat(B_TRANSLATE("%d (hpkg-system), %d (hpkg-user)"), sSysPkgs, sUserPkgs);
+	auto countPackages = [](const char* path) -> int {
+		BDirectory dir(path);
+		if (dir.InitCheck() != B_OK) return 0;
+		int count = 0;
+		BEntry entry;
+		char name[B_FILE_NAME_LENGTH];
+		while (dir.GetNextEntry(&entry) == B_OK) {
+			if (entry.GetName(name) != B_OK)
+				continue;
+			size_t length = strlen(name);
+			if (length >= 5 && strcmp(name + length - 5, ".hpkg") == 0)
+				count++;
+		}
+		return count;
+	};
+	int systemPackages = countPackages("/boot/system/packages");
+	int userPackages = countPackages("/boot/home/config/packages");
+	out.SetToFormat(B_TRANSLATE("%d (hpkg-system), %d (hpkg-user)"),
+		systemPackages, userPackages);
 }
 
 BString GetLocalIPAddress()
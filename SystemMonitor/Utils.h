@@ -26,14 +26,22 @@ void FormatBytes(BString& out, uint64 bytes, int precision = 2);
 void FormatBytes(BString& out, double bytes, int precision = 2);
 uint64 BytesToMiB(uint64 bytes);
 void UpdateHeaderWidths(const std::vector<ClickableHeaderView*>& headers, std::initializer_list<float> widths);
-void GetMemoryUsage(uint64& used, uint64& total, uint64& physical);
-void GetSwapUsage(uint64& used, uint64& total);
+// Collectors pass the time of their tick, see SystemInfoCache
+void GetMemoryUsage(uint64& used, uint64& total, uint64& physical,
+	bigtime_t now = -1);
+void GetSwapUsage(uint64& used, uint64& total, bigtime_t now = -1);
 uint64 GetCachedMemoryBytes(const system_info& sysInfo);
 BString FormatHertz(uint64 hertz);
 BString FormatUptime(bigtime_t uptimeMicros);
 BString FormatSpeed(uint64 bytesDelta, bigtime_t microSecondsDelta);
 float GetScaleFactor(const BFont* font);
 
+// Formatters for graph values (see ActivityGraphView::SetValueFormatter())
+void FormatGraphPercent(BString& out, float percent);
+void FormatGraphRate(BString& out, float bytesPerSecond);
+// "now", "5 s ago", ... for graph tooltips
+void FormatTimeAgo(BString& out, bigtime_t ago);
+
 uint64 GetCpuFrequency();
 BString GetCPUBrandString();
 
@@ -0,0 +1,152 @@
+#include <iostream>
+#include <chrono>
+#include <cstdint>
+
+// Mock OS.h functionality for standalone testing if not available
+#ifndef _OS_H
+#ifndef B_OK
+#define B_OK 0
+#endif
+#ifndef B_NO_MEMORY
+#define B_NO_MEMORY -1
+#endif
+typedef int32_t status_t;
+typedef int32_t int32;
+typedef uint32_t uint32;
+typedef int64_t int64;
+typedef long long bigtime_t;
+#endif
+
+#include "../CircularBuffer.h"
+
+// The previous implementation: modulo indexing on every access
+template<typename Type>
+class ModuloBuffer {
+public:
+    ModuloBuffer(uint32 size) : fFirst(0), fIn(0), fSize(size), fBuffer(new Type[size]) {}
+    ~ModuloBuffer() { delete[] fBuffer; }
+
+    uint32 CountItems() const { return fIn; }
+
+    Type* ItemAt(uint32 index) const
+    {
+        if (index >= fIn)
+            return NULL;
+        return &fBuffer[(fFirst + index) % fSize];
+    }
+
+    void AddItem(const Type& item)
+    {
+        uint32 index;
+        if (fIn < fSize) {
+            index = (fFirst + fIn) % fSize;
+            fIn++;
+        } else {
+            index = fFirst;
+            fFirst = (fFirst + 1) % fSize;
+        }
+        fBuffer[index] = item;
+    }
+
+private:
+    uint32 fFirst;
+    uint32 fIn;
+    uint32 fSize;
+    Type* fBuffer;
+};
+
+struct sample {
+    bigtime_t time;
+    int64 value;
+};
+
+template<typename Buffer>
+static int64 sumItemAt(const Buffer& buffer)
+{
+    int64 sum = 0;
+    uint32 count = buffer.CountItems();
+    for (uint32 i = 0; i < count; i++)
+        sum += buffer.ItemAt(i)->value;
+    return sum;
+}
+
+static int64 sumSpans(const CircularBuffer<sample>& buffer)
+{
+    sample* first;
+    sample* second;
+    uint32 firstCount, secondCount;
+    buffer.Spans(first, firstCount, second, secondCount);
+
+    int64 sum = 0;
+    for (uint32 i = 0; i < firstCount; i++)
+        sum += first[i].value;
+    for (uint32 i = 0; i < secondCount; i++)
+        sum += second[i].value;
+    return sum;
+}
+
+static double elapsed(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - start).count() / 1000.0;
+}
+
+// Item throughput of the old modulo buffer against the masked one, for a
+// per-second history of ten minutes and one of a day.
+int main() {
+    const uint32 sizes[] = { 600, 86400 };
+    const int passes = 200;
+
+    for (uint32 size : sizes) {
+        ModuloBuffer<sample> modulo(size);
+        CircularBuffer<sample> masked(size);
+        // Wrap around a few times so the spans are split
+        const uint32 adds = size * 3 + size / 3;
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        for (int p = 0; p < passes; p++) {
+            for (uint32 i = 0; i < adds; i++) {
+                sample item = { (bigtime_t)i, (int64)(i ^ p) };
+                modulo.AddItem(item);
+            }
+        }
+        double moduloAdd = elapsed(t0);
+
+        t0 = std::chrono::high_resolution_clock::now();
+        for (int p = 0; p < passes; p++) {
+            for (uint32 i = 0; i < adds; i++) {
+                sample item = { (bigtime_t)i, (int64)(i ^ p) };
+                masked.AddItem(item);
+            }
+        }
+        double maskedAdd = elapsed(t0);
+
+        int64 check1 = 0, check2 = 0, check3 = 0;
+        t0 = std::chrono::high_resolution_clock::now();
+        for (int p = 0; p < passes; p++)
+            check1 += sumItemAt(modulo);
+        double moduloRead = elapsed(t0);
+
+        t0 = std::chrono::high_resolution_clock::now();
+        for (int p = 0; p < passes; p++)
+            check2 += sumItemAt(masked);
+        double maskedRead = elapsed(t0);
+
+        t0 = std::chrono::high_resolution_clock::now();
+        for (int p = 0; p < passes; p++)
+            check3 += sumSpans(masked);
+        double spansRead = elapsed(t0);
+
+        std::cout << "Size " << size << ": AddItem modulo " << moduloAdd
+                  << " ms, masked " << maskedAdd << " ms; read modulo "
+                  << moduloRead << " ms, masked " << maskedRead
+                  << " ms, Spans " << spansRead << " ms" << std::endl;
+
+        if (check1 != check2 || check2 != check3) {
+            std::cout << "Mismatch!" << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
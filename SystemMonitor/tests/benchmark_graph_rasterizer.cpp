@@ -0,0 +1,177 @@
+#include <iostream>
+#include <chrono>
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// Mock OS.h functionality for standalone testing if not available
+#ifndef _OS_H
+#ifndef B_OK
+#define B_OK 0
+#endif
+#ifndef B_NO_MEMORY
+#define B_NO_MEMORY -1
+#endif
+#ifndef B_BAD_VALUE
+#define B_BAD_VALUE -2
+#endif
+typedef int32_t status_t;
+typedef uint8_t uint8;
+typedef int32_t int32;
+typedef uint32_t uint32;
+#endif
+
+#include "../GraphRasterizer.cpp"
+
+// A per core graph on a 64 CPU machine, redrawn from scratch every frame
+static const int32 kGraphs = 64;
+static const int32 kWidth = 200;
+static const int32 kHeight = 80;
+static const int kFrames = 200;
+
+// Column by column, deciding and blending every pixel on its own; about
+// what drawing the fill polygon and grid pixel by pixel costs
+static void DrawNaive(uint32* bits, const float* tops, uint32 background,
+    uint32 grid, uint32 fill)
+{
+    for (int32 x = 0; x < kWidth; x++) {
+        int32 fillStart = static_cast<int32>(ceilf(tops[x]));
+        for (int32 y = 0; y < kHeight; y++) {
+            bool isGrid = x % 60 == 0 || y == 20 || y == 40 || y == 59;
+            uint32 under = isGrid ? grid : background;
+            bits[y * kWidth + x] = y >= fillStart
+                ? GraphRasterizer::Blend(under, fill, 100) : under;
+        }
+    }
+}
+
+// The rasterizer's row select, without SIMD
+static void DrawScalar(uint32* bits, const float* tops,
+    const std::vector<uint32>& background, const std::vector<uint32>& fill,
+    std::vector<int32>& fillStart)
+{
+    for (int32 x = 0; x < kWidth; x++)
+        fillStart[x] = static_cast<int32>(ceilf(tops[x]));
+    for (int32 y = 0; y < kHeight; y++) {
+        GraphRasterizer::SelectRowScalar(bits + y * kWidth, background.data(),
+            fill.data(), fillStart.data(), y, kWidth);
+    }
+}
+
+int main() {
+    uint32 background = GraphRasterizer::MakePixel(216, 216, 216);
+    uint32 grid = GraphRasterizer::MakePixel(190, 190, 190);
+    uint32 fill = GraphRasterizer::MakePixel(80, 133, 229);
+
+    std::vector<std::vector<float> > tops(kGraphs, std::vector<float>(kWidth));
+    for (int32 g = 0; g < kGraphs; g++) {
+        for (int32 x = 0; x < kWidth; x++) {
+            tops[g][x] = kHeight / 2
+                + sinf((x + g * 7) * 0.05f) * (kHeight / 2 - 2);
+        }
+    }
+
+    std::vector<uint32> bits(kWidth * kHeight);
+    uint32 checksum = 0;
+
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int frame = 0; frame < kFrames; frame++) {
+            for (int32 g = 0; g < kGraphs; g++) {
+                DrawNaive(bits.data(), tops[g].data(), background, grid, fill);
+                checksum += bits[frame % bits.size()];
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "Per pixel: "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()
+                  << " us" << std::endl;
+    }
+
+    {
+        std::vector<uint32> backgroundRow(kWidth, background);
+        std::vector<uint32> fillRow(kWidth,
+            GraphRasterizer::Blend(background, fill, 100));
+        std::vector<int32> fillStart(kWidth);
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int frame = 0; frame < kFrames; frame++) {
+            for (int32 g = 0; g < kGraphs; g++) {
+                DrawScalar(bits.data(), tops[g].data(), backgroundRow, fillRow,
+                    fillStart);
+                checksum += bits[frame % bits.size()];
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "Row select (scalar): "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()
+                  << " us" << std::endl;
+    }
+
+    {
+        GraphRasterizer rasterizer;
+        rasterizer.SetTarget(bits.data(), kWidth * sizeof(uint32), kWidth,
+            kHeight);
+        rasterizer.SetColors(background, grid, fill, 100, fill);
+        rasterizer.SetGrid(4, 60.0f, 0.0f);
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int frame = 0; frame < kFrames; frame++) {
+            for (int32 g = 0; g < kGraphs; g++) {
+                rasterizer.DrawColumns(0, kWidth, tops[g].data(),
+                    tops[g].data(), NAN);
+                checksum += bits[frame % bits.size()];
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "GraphRasterizer (with line): "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()
+                  << " us" << std::endl;
+    }
+
+    std::cout << "(" << kGraphs << " graphs of " << kWidth << "x" << kHeight
+              << ", " << kFrames << " frames, checksum " << checksum << ")"
+              << std::endl;
+
+    // One tick of a wide graph: scroll by a column and draw the new one
+    {
+        const int32 kWideWidth = 2000;
+        const int kTicks = 20000;
+        std::vector<uint32> wideBits(kWideWidth * kHeight);
+        std::vector<float> wideTops(kWideWidth, kHeight / 2);
+        GraphRasterizer rasterizer;
+        rasterizer.SetTarget(wideBits.data(), kWideWidth * sizeof(uint32),
+            kWideWidth, kHeight);
+        rasterizer.SetColors(background, grid, fill, 100, fill);
+        rasterizer.DrawColumns(0, kWideWidth, wideTops.data(), wideTops.data(),
+            NAN);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int tick = 0; tick < kTicks; tick++) {
+            // Shifting every row, as CopyBits does
+            for (int32 y = 0; y < kHeight; y++) {
+                uint32* row = wideBits.data() + y * kWideWidth;
+                memmove(row, row + 1, (kWideWidth - 1) * sizeof(uint32));
+            }
+            rasterizer.DrawColumns(kWideWidth - 1, 1, wideTops.data(),
+                wideTops.data(), wideTops[0]);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "Tick, shifting the image: "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()
+                  << " us" << std::endl;
+
+        start = std::chrono::high_resolution_clock::now();
+        for (int tick = 0; tick < kTicks; tick++) {
+            rasterizer.Scroll(1);
+            rasterizer.DrawColumns(kWideWidth - 1, 1, wideTops.data(),
+                wideTops.data(), wideTops[0]);
+        }
+        end = std::chrono::high_resolution_clock::now();
+        std::cout << "Tick, ring of columns: "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()
+                  << " us" << std::endl;
+        std::cout << "(" << kTicks << " ticks of a " << kWideWidth << "x"
+                  << kHeight << " graph)" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+
+// Mock OS.h functionality for standalone testing if not available
+#ifndef _OS_H
+#ifndef B_OK
+#define B_OK 0
+#endif
+#ifndef B_NO_MEMORY
+#define B_NO_MEMORY -1
+#endif
+typedef int32_t status_t;
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef int32_t int32;
+typedef uint32_t uint32;
+typedef int64_t int64;
+typedef uint64_t uint64;
+typedef long long bigtime_t;
+#endif
+
+#include "../DataHistory.cpp"
+#include "../CompressedHistory.cpp"
+#include "../QuantileSketch.cpp"
+
+// Compares the per-pixel ValueAt() path used by ActivityGraphView with
+// DataHistory::ResampleRange() for a 4K wide graph at several zoom levels.
+int main() {
+    const bigtime_t interval = 1000000;
+    const int samples = 600;
+    const int width = 3840;
+    const int frames = 200;
+
+    DataHistory<int64> history(samples * interval, interval);
+    srand(1);
+    for (int i = 0; i < samples; i++)
+        history.AddValue(i * interval + rand() % 1000, rand() % 1000);
+
+    const bigtime_t now = samples * interval;
+    const bigtime_t resolutions[] = { 10000, 100000, 250000, 1000000 };
+
+    std::vector<float> resampled(width);
+    std::vector<int64> perPixel(width);
+
+    for (bigtime_t resolution : resolutions) {
+        const bigtime_t start = now - (width - 1) * resolution;
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        for (int f = 0; f < frames; f++) {
+            int32 searchIndex = 0;
+            for (int i = 0; i < width; i++)
+                perPixel[i] = history.ValueAt(start + i * resolution, &searchIndex);
+        }
+        auto t1 = std::chrono::high_resolution_clock::now();
+        for (int f = 0; f < frames; f++)
+            history.ResampleRange(start, resolution, width, resampled.data());
+        auto t2 = std::chrono::high_resolution_clock::now();
+
+        double maxError = 0;
+        for (int i = 0; i < width; i++)
+            maxError = std::max(maxError, std::fabs(resampled[i] - (double)perPixel[i]));
+
+        double baseline = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()
+            / 1000.0 / frames;
+        double batch = std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count()
+            / 1000.0 / frames;
+
+        std::cout << "Resolution " << resolution << " us/px: ValueAt "
+                  << baseline << " us/frame, ResampleRange " << batch
+                  << " us/frame (" << baseline / batch << "x), max error "
+                  << maxError << std::endl;
+
+        // ValueAt() truncates to integers
+        if (maxError > 1.0) {
+            std::cout << "Mismatch!" << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -2,6 +2,9 @@
 #include <cassert>
 #include <string.h>
 #include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
 
 // Mock OS.h functionality for standalone testing if not available
 #ifndef _OS_H
@@ -19,6 +22,35 @@ typedef long long bigtime_t;
 
 #include "../CircularBuffer.h"
 
+// Counts live instances, and has no default constructor
+struct Tracked {
+    static int sLive;
+    int value;
+
+    explicit Tracked(int value) : value(value) { sLive++; }
+    Tracked(const Tracked& other) : value(other.value) { sLive++; }
+    ~Tracked() { sLive--; }
+    Tracked& operator=(const Tracked& other) { value = other.value; return *this; }
+};
+
+int Tracked::sLive = 0;
+
+template<typename Buffer>
+static int sumSpans(const Buffer& buffer) {
+    int* first;
+    int* second;
+    uint32 firstCount, secondCount;
+    buffer.Spans(first, firstCount, second, secondCount);
+    assert(firstCount + secondCount == buffer.CountItems());
+
+    int sum = 0;
+    for (uint32 i = 0; i < firstCount; i++)
+        sum += first[i];
+    for (uint32 i = 0; i < secondCount; i++)
+        sum += second[i];
+    return sum;
+}
+
 int main() {
     printf("Testing CircularBuffer...\n");
 
@@ -92,6 +124,108 @@ int main() {
     assert(buffer.IsEmpty());
     assert(buffer.CountItems() == 0);
 
+    // Test Spans: items in order, split where they wrap around
+    CircularBuffer<int> spans(8);
+    for (int i = 0; i < 6; i++)
+        spans.AddItem(i);
+    int* first;
+    int* second;
+    uint32 firstCount, secondCount;
+    spans.Spans(first, firstCount, second, secondCount);
+    assert(firstCount == 6 && secondCount == 0);
+    for (int i = 6; i < 12; i++)
+        spans.AddItem(i);
+    spans.Spans(first, firstCount, second, secondCount);
+    assert(firstCount == 4 && secondCount == 4);
+    assert(first[0] == 4 && first[3] == 7);
+    assert(second[0] == 8 && second[3] == 11);
+    assert(sumSpans(spans) == 4 + 5 + 6 + 7 + 8 + 9 + 10 + 11);
+
+    // Test a size that is not a power of two keeps its capacity
+    CircularBuffer<int> odd(5);
+    for (int i = 0; i < 13; i++) {
+        odd.AddItem(i);
+        int expected = 0;
+        for (int j = i < 5 ? 0 : i - 4; j <= i; j++)
+            expected += j;
+        assert(sumSpans(odd) == expected);
+    }
+    assert(odd.CountItems() == 5);
+    assert(*odd.ItemAt(0) == 8);
+    assert(*odd.ItemAt(4) == 12);
+
+    // Test types without a default constructor are constructed and
+    // destroyed exactly once
+    {
+        CircularBuffer<Tracked> tracked(3);
+        assert(Tracked::sLive == 0);
+        for (int i = 0; i < 5; i++)
+            tracked.EmplaceItem(i);
+        assert(Tracked::sLive == 3);
+        assert(tracked.ItemAt(0)->value == 2);
+
+        CircularBuffer<Tracked> copy(tracked);
+        assert(Tracked::sLive == 6);
+        copy.SetSize(2);
+        assert(Tracked::sLive == 5);
+        assert(copy.ItemAt(0)->value == 3);
+        copy.SetSize(16);
+        assert(Tracked::sLive == 5);
+        assert(copy.ItemAt(1)->value == 4);
+
+        tracked.MakeEmpty();
+        assert(Tracked::sLive == 2);
+    }
+    assert(Tracked::sLive == 0);
+
+    // Test move-only types survive a resize and a move
+    CircularBuffer<std::unique_ptr<int> > owned(4);
+    for (int i = 0; i < 6; i++)
+        owned.EmplaceItem(new int(i));
+    assert(owned.SetSize(9) == B_OK);
+    assert(owned.CountItems() == 4);
+    assert(**owned.ItemAt(0) == 2);
+    assert(**owned.ItemAt(3) == 5);
+    owned.AddItem(std::unique_ptr<int>(new int(6)));
+
+    // Moves can't throw, so containers of buffers move them when growing
+    static_assert(std::is_nothrow_move_constructible<
+        CircularBuffer<std::unique_ptr<int> > >::value, "");
+    static_assert(std::is_nothrow_move_assignable<
+        CircularBuffer<std::unique_ptr<int> > >::value, "");
+
+    CircularBuffer<std::unique_ptr<int> > moved(std::move(owned));
+    assert(owned.CountItems() == 0 && owned.Size() == 0);
+    assert(moved.CountItems() == 5);
+    assert(**moved.ItemAt(4) == 6);
+
+    // Test FixedCircularBuffer
+    {
+        FixedCircularBuffer<int, 4> fixed;
+        assert(fixed.Size() == 4);
+        assert(fixed.IsEmpty());
+        for (int i = 0; i < 7; i++)
+            fixed.AddItem(i);
+        assert(fixed.CountItems() == 4);
+        assert(*fixed.ItemAt(0) == 3);
+        assert(*fixed.ItemAt(3) == 6);
+        assert(fixed.ItemAt(4) == NULL);
+        assert(sumSpans(fixed) == 3 + 4 + 5 + 6);
+
+        FixedCircularBuffer<int, 4> fixedCopy(fixed);
+        fixed.MakeEmpty();
+        assert(fixedCopy.CountItems() == 4);
+        assert(*fixedCopy.ItemAt(0) == 3);
+
+        FixedCircularBuffer<Tracked, 2> fixedTracked;
+        fixedTracked.EmplaceItem(1);
+        fixedTracked.EmplaceItem(2);
+        fixedTracked.EmplaceItem(3);
+        assert(Tracked::sLive == 2);
+        assert(fixedTracked.ItemAt(0)->value == 2);
+    }
+    assert(Tracked::sLive == 0);
+
     printf("All tests passed!\n");
     return 0;
 }
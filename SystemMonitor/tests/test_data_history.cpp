@@ -0,0 +1,336 @@
+#include <cstdio>
+#include <cassert>
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+
+// Mock OS.h functionality for standalone testing if not available
+#ifndef _OS_H
+#ifndef B_OK
+#define B_OK 0
+#endif
+#ifndef B_NO_MEMORY
+#define B_NO_MEMORY -1
+#endif
+typedef int32_t status_t;
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef int32_t int32;
+typedef uint32_t uint32;
+typedef int64_t int64;
+typedef uint64_t uint64;
+typedef long long bigtime_t;
+#endif
+
+#include "../DataHistory.cpp"
+#include "../CompressedHistory.cpp"
+#include "../QuantileSketch.cpp"
+
+// Count heap allocations to prove AddValue() doesn't allocate
+static size_t sAllocations = 0;
+
+void* operator new(size_t size) {
+    sAllocations++;
+    void* pointer = malloc(size);
+    if (pointer == NULL)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    sAllocations++;
+    return malloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    sAllocations++;
+    return malloc(size);
+}
+
+void operator delete(void* pointer) noexcept { free(pointer); }
+void operator delete[](void* pointer) noexcept { free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { free(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { free(pointer); }
+
+static const bigtime_t kInterval = 1000000;
+static const int kSamples = 600;
+
+static int64 sampleValue(int i) {
+    // A flat line with a few one-sample spikes
+    if (i == 123 || i == 377)
+        return 1000;
+    if (i == 250)
+        return -1000;
+    return (i * 7) % 50;
+}
+
+static bool bruteForce(bigtime_t from, bigtime_t to, int64& min, int64& max) {
+    bool found = false;
+    for (int i = 0; i < kSamples; i++) {
+        bigtime_t time = i * kInterval;
+        if (time < from || time >= to)
+            continue;
+        int64 value = sampleValue(i);
+        if (!found || value < min) min = value;
+        if (!found || value > max) max = value;
+        found = true;
+    }
+    return found;
+}
+
+int main() {
+    printf("Testing DataHistory...\n");
+
+    DataHistory<int64> history(kSamples * kInterval, kInterval);
+    for (int i = 0; i < kSamples; i++)
+        history.AddValue(i * kInterval, sampleValue(i));
+
+    assert(history.MaximumValue() == 1000);
+    assert(history.MinimumValue() == -1000);
+    assert(history.CountLevels() > 5);
+
+    // Point sampling when zoomed in
+    assert(history.LevelFor(kInterval) == -1);
+    assert(history.LevelFor(2 * kInterval) == 1);
+    assert(history.LevelFor(5 * kInterval) == 2);
+    assert(history.LevelFor(1000 * kInterval) == history.CountLevels() - 1);
+
+    // Spikes must survive at every level, whatever the pixel width
+    for (int32 level = 0; level < history.CountLevels(); level++) {
+        for (bigtime_t width = 2 * kInterval; width <= 64 * kInterval; width *= 2) {
+            int32 hint = 0;
+            bool sawHigh = false, sawLow = false;
+            for (bigtime_t from = 0; from < kSamples * kInterval; from += width) {
+                int64 min, max;
+                if (!history.EnvelopeAt(level, from, from + width, min, max, &hint))
+                    continue;
+                sawHigh |= max == 1000;
+                sawLow |= min == -1000;
+            }
+            assert(sawHigh && sawLow);
+        }
+    }
+
+    // The raw level is exact, coarser levels may only widen the envelope
+    srand(42);
+    for (int k = 0; k < 1000; k++) {
+        bigtime_t from = (rand() % kSamples) * kInterval + rand() % kInterval;
+        bigtime_t to = from + (rand() % 64 + 1) * kInterval;
+        int64 expectedMin = 0, expectedMax = 0;
+        bool expected = bruteForce(from, to, expectedMin, expectedMax);
+
+        int64 min = 0, max = 0;
+        assert(history.EnvelopeAt(0, from, to, min, max) == expected);
+        if (expected) {
+            assert(min == expectedMin && max == expectedMax);
+        }
+
+        for (int32 level = 1; level < history.CountLevels(); level++) {
+            if (!history.EnvelopeAt(level, from, to, min, max))
+                continue;
+            assert(!expected || (min <= expectedMin && max >= expectedMax));
+        }
+    }
+
+    // Once the buffer has wrapped around, the raw values lie in two runs of
+    // its storage, and are still all looked at
+    {
+        DataHistory<int64> wrapped(100 * kInterval, kInterval);
+        for (int i = 0; i < 250; i++)
+            wrapped.AddValue(i * kInterval, sampleValue(i));
+
+        bigtime_t start = wrapped.Start();
+        for (int k = 0; k < 1000; k++) {
+            bigtime_t from = start + rand() % (100 * kInterval);
+            bigtime_t to = from + (rand() % 64 + 1) * kInterval;
+
+            int64 expectedMin = 0, expectedMax = 0;
+            bool expected = false;
+            for (int i = 0; i < 250; i++) {
+                bigtime_t time = i * kInterval;
+                if (time < start || time < from || time >= to)
+                    continue;
+                int64 value = sampleValue(i);
+                if (!expected || value < expectedMin) expectedMin = value;
+                if (!expected || value > expectedMax) expectedMax = value;
+                expected = true;
+            }
+
+            int64 min = 0, max = 0;
+            assert(wrapped.EnvelopeAt(0, from, to, min, max) == expected);
+            if (expected)
+                assert(min == expectedMin && max == expectedMax);
+        }
+    }
+
+    // Batch resampling matches point sampling, including before the first
+    // and after the last sample
+    {
+        const int32 count = 500;
+        const bigtime_t step = kInterval * 3 / 2;
+        float values[count];
+        history.ResampleRange(-10 * kInterval, step, count, values);
+        int32 hint = 0;
+        for (int32 j = 0; j < count; j++) {
+            int64 expected = history.ValueAt(-10 * kInterval + j * step, &hint);
+            assert(values[j] - expected > -1.0f && values[j] - expected < 1.0f);
+        }
+    }
+
+    // The newest samples are covered before their bucket is complete
+    history.AddValue(kSamples * kInterval, 5000);
+    int64 min, max;
+    assert(history.EnvelopeAt(history.CountLevels() - 1,
+        (kSamples - 1) * kInterval, (kSamples + 1) * kInterval, min, max));
+    assert(max == 5000);
+
+    // Changing the refresh interval rebuilds the pyramid
+    history.SetRefreshInterval(kInterval / 2);
+    assert(history.LevelFor(kInterval) == 1);
+    assert(history.EnvelopeAt(3, 0, (kSamples + 1) * kInterval, min, max));
+    assert(max == 5000 && min == -1000);
+
+    // Samples leaving the buffer are archived until the retention expires
+    {
+        const int32 bufferSamples = 100;
+        const int32 total = 20000;
+        DataHistory<int64> archived(bufferSamples * kInterval, kInterval);
+        archived.SetRetention(10000 * kInterval);
+        assert(archived.Retention() == 10000 * kInterval);
+
+        for (int32 i = 0; i < total; i++) {
+            // Some jitter on the timestamps, as with real pulses
+            archived.AddValue(i * kInterval + (i % 3) * 100, sampleValue(i % kSamples) * 1000 + i);
+        }
+
+        // Only whole blocks are discarded
+        assert(archived.Start() <= (total - 10000) * kInterval);
+        assert(archived.Start() > (total - 12000) * kInterval);
+
+        for (int32 i = total - 9000; i < total; i += 7) {
+            bigtime_t time = i * kInterval + (i % 3) * 100;
+            assert(archived.ValueAt(time) == sampleValue(i % kSamples) * 1000 + i);
+        }
+
+        int64 min, max;
+        bigtime_t from = (total - 5000) * kInterval;
+        bigtime_t to = (total - 50) * kInterval;
+        assert(archived.EnvelopeAt(3, from, to, min, max));
+        int64 expectedMin = 0, expectedMax = 0;
+        for (int32 i = total - 5000; i < total - 50; i++) {
+            int64 value = sampleValue(i % kSamples) * 1000 + i;
+            if (i == total - 5000 || value < expectedMin) expectedMin = value;
+            if (i == total - 5000 || value > expectedMax) expectedMax = value;
+        }
+        assert(min <= expectedMin && max >= expectedMax);
+        assert(archived.EnvelopeAt(0, from, to, min, max));
+        assert(min == expectedMin && max == expectedMax);
+
+        // Much smaller than a time and a value per sample
+        CompressedHistory store(0);
+        for (int32 i = 0; i < 86400; i++)
+            store.AddValue(i * kInterval + (i % 3) * 100, 500 + i % 17);
+        assert(store.CountSamples() == 86400);
+        assert(store.MemoryUsage() < 86400 * (sizeof(bigtime_t) + sizeof(int64)) / 4);
+        assert(store.ValueAt(4321 * kInterval + 100) == 500 + 4321 % 17);
+    }
+
+    // Sliding min/max match a brute force scan, and don't allocate once the
+    // history is warmed up
+    {
+        DataHistory<int64> window(100 * kInterval, kInterval);
+        std::vector<int64> values;
+        bigtime_t time = 0;
+        srand(3);
+
+        for (int i = 0; i < 500; i++, time += kInterval)
+            window.AddValue(time, rand() % 1000);
+
+        for (int round = 0; round < 3; round++) {
+            // Check the last "capacity" values; the buffer size changes
+            // with the refresh interval.
+            size_t capacity = round == 1 ? 200 : (round == 2 ? 50 : 100);
+            values.assign(capacity, 0);
+
+            size_t before = sAllocations;
+            for (int i = 0; i < 20000; i++, time += kInterval) {
+                int64 value = rand() % 1000 - (i % 500 == 0 ? 5000 : 0);
+                window.AddValue(time, value);
+                values[i % capacity] = value;
+
+                if (i >= (int)capacity) {
+                    int64 min = values[0], max = values[0];
+                    for (size_t k = 1; k < capacity; k++) {
+                        if (values[k] < min) min = values[k];
+                        if (values[k] > max) max = values[k];
+                    }
+                    assert(window.MinimumValue() == min);
+                    assert(window.MaximumValue() == max);
+                }
+            }
+            assert(sAllocations == before);
+
+            if (round == 0)
+                window.SetRefreshInterval(kInterval / 2);
+            else if (round == 1)
+                window.SetRefreshInterval(kInterval * 2);
+        }
+    }
+
+    // Several float fields share one timestamp column
+    {
+        DataHistory<float> fields(100 * kInterval, kInterval, 2);
+        assert(fields.InitCheck() == B_OK);
+        assert(fields.CountFields() == 2);
+        fields.SetRetention(1000 * kInterval);
+
+        for (int i = 0; i < 400; i++) {
+            float values[2] = { 0.25f * (i % 400), 100.0f - 0.25f * (i % 400) };
+            fields.AddValues(i * kInterval, values);
+        }
+
+        // Fractions survive, and each field is tracked on its own
+        assert(fields.ValueAt(399 * kInterval, NULL, 0) == 99.75f);
+        assert(fields.ValueAt(399 * kInterval, NULL, 1) == 0.25f);
+        float interpolated = fields.ValueAt(398 * kInterval + kInterval / 2, NULL, 1);
+        assert(interpolated > 0.374f && interpolated < 0.376f);
+        assert(fields.MaximumValue(0) == 99.75f && fields.MinimumValue(0) == 75.0f);
+        assert(fields.MaximumValue(1) == 25.0f && fields.MinimumValue(1) == 0.25f);
+
+        float p50 = fields.Quantile(0.5f, 0);
+        assert(p50 > 45.0f && p50 < 55.0f);
+
+        // The histogram covers every value between the extremes
+        uint32 bins[8];
+        float low, high;
+        fields.GetHistogram(bins, 8, low, high, 0);
+        assert(low < 0.01f && high > 94.0f);
+        uint32 binned = 0;
+        for (int i = 0; i < 8; i++)
+            binned += bins[i];
+        assert(binned == 400);
+
+        // Archived samples keep their fractions to three decimals
+        float archived = fields.ValueAt(101 * kInterval, NULL, 0);
+        assert(archived > 25.24f && archived < 25.26f);
+
+        float min, max;
+        assert(fields.EnvelopeAt(0, 10 * kInterval, 390 * kInterval, min, max, NULL, 1));
+        assert(min > 2.74f && min < 2.76f && max > 97.49f && max < 97.51f);
+
+        float resampled[4];
+        fields.ResampleRange(396 * kInterval, kInterval, 4, resampled, 1);
+        assert(resampled[0] == 1.0f && resampled[3] == 0.25f);
+
+        // Invalid fields are empty rather than out of bounds
+        assert(fields.ValueAt(0, NULL, 2) == 0);
+        assert(!fields.EnvelopeAt(0, 0, kInterval, min, max, NULL, -1));
+    }
+
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,435 @@
+#include <cstdio>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+// Mock OS.h functionality for standalone testing if not available
+#ifndef _OS_H
+#ifndef B_OK
+#define B_OK 0
+#endif
+#ifndef B_NO_MEMORY
+#define B_NO_MEMORY -1
+#endif
+#ifndef B_BAD_VALUE
+#define B_BAD_VALUE -2
+#endif
+typedef int32_t status_t;
+typedef uint8_t uint8;
+typedef int32_t int32;
+typedef uint32_t uint32;
+#endif
+
+#include "../GraphRasterizer.cpp"
+
+static const int32 kWidth = 37;
+static const int32 kHeight = 20;
+// Rows are padded like a BBitmap's
+static const int32 kStride = 40;
+static const uint32 kPadding = 0x12345678;
+
+static uint32 kBackground;
+static uint32 kGrid;
+static uint32 kFill;
+static uint32 kLine;
+
+static uint32 pixelAt(const std::vector<uint32>& bits, int32 x, int32 y) {
+    return bits[y * kStride + x];
+}
+
+// The image starts at the rasterizer's origin and wraps around
+static uint32 imagePixelAt(const GraphRasterizer& rasterizer,
+    const std::vector<uint32>& bits, int32 x, int32 y) {
+    return pixelAt(bits, (rasterizer.Origin() + x) % kWidth, y);
+}
+
+static void testBlend() {
+    uint32 black = GraphRasterizer::MakePixel(0, 0, 0);
+    uint32 white = GraphRasterizer::MakePixel(255, 255, 255);
+    assert(white == 0xffffffff);
+    assert(GraphRasterizer::MakePixel(1, 2, 3) == 0xff010203);
+
+    assert(GraphRasterizer::Blend(black, white, 0) == black);
+    assert(GraphRasterizer::Blend(black, white, 255) == white);
+    assert(GraphRasterizer::Blend(black, white, 128) == 0xff808080);
+    // Channels don't bleed into each other
+    assert(GraphRasterizer::Blend(GraphRasterizer::MakePixel(255, 0, 0),
+        GraphRasterizer::MakePixel(0, 0, 255), 255) == 0xff0000ff);
+}
+
+static void testSelectRowMatchesScalar() {
+    srand(42);
+    const int32 kCount = 67;
+    std::vector<uint32> background(kCount), fill(kCount);
+    std::vector<int32> fillStart(kCount);
+    for (int32 x = 0; x < kCount; x++) {
+        background[x] = static_cast<uint32>(rand());
+        fill[x] = static_cast<uint32>(rand());
+        fillStart[x] = rand() % 30 - 5;
+    }
+
+    for (int32 count = 0; count <= kCount; count++) {
+        for (int32 y = -2; y < 30; y += 3) {
+            std::vector<uint32> simd(kCount + 1, kPadding);
+            std::vector<uint32> scalar(kCount + 1, kPadding);
+            GraphRasterizer::SelectRow(simd.data(), background.data(),
+                fill.data(), fillStart.data(), y, count);
+            GraphRasterizer::SelectRowScalar(scalar.data(), background.data(),
+                fill.data(), fillStart.data(), y, count);
+            assert(simd == scalar);
+            assert(simd[count] == kPadding);
+            for (int32 x = 0; x < count; x++) {
+                assert(simd[x] == (fillStart[x] <= y ? fill[x]
+                    : background[x]));
+            }
+        }
+    }
+}
+
+static void setUp(GraphRasterizer& rasterizer, std::vector<uint32>& bits) {
+    bits.assign(kStride * kHeight, kPadding);
+    rasterizer.SetTarget(bits.data(), kStride * sizeof(uint32), kWidth,
+        kHeight);
+    rasterizer.SetColors(kBackground, kGrid, kFill, 100, kLine);
+    rasterizer.SetGrid(4, 10.0f, 0.0f);
+    rasterizer.SetLineWidth(1.0f);
+}
+
+static void testFlatLine() {
+    GraphRasterizer rasterizer;
+    std::vector<uint32> bits;
+    setUp(rasterizer, bits);
+
+    std::vector<float> tops(kWidth, 7.0f);
+    assert(rasterizer.DrawColumns(0, kWidth, tops.data(), tops.data(), NAN)
+        == B_OK);
+
+    uint32 fillOverBackground = GraphRasterizer::Blend(kBackground, kFill, 100);
+    uint32 fillOverGrid = GraphRasterizer::Blend(kGrid, kFill, 100);
+
+    // Horizontal grid lines at a quarter, half and three quarters of 19
+    bool gridRow[kHeight] = {};
+    gridRow[5] = gridRow[10] = gridRow[14] = true;
+
+    for (int32 y = 0; y < kHeight; y++) {
+        for (int32 x = 0; x < kWidth; x++) {
+            bool grid = gridRow[y] || x % 10 == 0;
+            uint32 pixel = pixelAt(bits, x, y);
+            if (y == 7)
+                assert(pixel == kLine);
+            else if (y < 7)
+                assert(pixel == (grid ? kGrid : kBackground));
+            else
+                assert(pixel == (grid ? fillOverGrid : fillOverBackground));
+        }
+        // The padding is never touched
+        for (int32 x = kWidth; x < kStride; x++)
+            assert(pixelAt(bits, x, y) == kPadding);
+    }
+}
+
+static void testAntialiasing() {
+    GraphRasterizer rasterizer;
+    std::vector<uint32> bits;
+    setUp(rasterizer, bits);
+
+    // Half way between two rows, the line covers half of each
+    std::vector<float> tops(kWidth, 2.5f);
+    rasterizer.DrawColumns(0, kWidth, tops.data(), tops.data(), NAN);
+
+    uint32 fillOverBackground = GraphRasterizer::Blend(kBackground, kFill, 100);
+    assert(pixelAt(bits, 3, 2) == GraphRasterizer::Blend(kBackground, kLine,
+        128));
+    assert(pixelAt(bits, 3, 3) == GraphRasterizer::Blend(fillOverBackground,
+        kLine, 128));
+    assert(pixelAt(bits, 3, 1) == kBackground);
+    assert(pixelAt(bits, 3, 4) == fillOverBackground);
+}
+
+static void testSteps() {
+    GraphRasterizer rasterizer;
+    std::vector<uint32> bits;
+    setUp(rasterizer, bits);
+
+    // A jump from 2 to 16 is joined by a vertical line, half in each column
+    std::vector<float> tops(kWidth, 2.0f);
+    for (int32 x = 20; x < kWidth; x++)
+        tops[x] = 16.0f;
+    std::vector<float> lows(tops);
+    // An envelope reaching down in one column
+    lows[30] = 18.0f;
+    rasterizer.DrawColumns(0, kWidth, tops.data(), lows.data(), NAN);
+
+    for (int32 y = 2; y <= 9; y++)
+        assert(pixelAt(bits, 19, y) == kLine);
+    for (int32 y = 9; y <= 16; y++)
+        assert(pixelAt(bits, 20, y) == kLine);
+    assert(pixelAt(bits, 21, 15) != kLine);
+    assert(pixelAt(bits, 21, 16) == kLine);
+    for (int32 y = 10; y <= 15; y++)
+        assert(pixelAt(bits, 18, y) != kLine);
+    for (int32 y = 16; y <= 18; y++)
+        assert(pixelAt(bits, 30, y) == kLine);
+    assert(pixelAt(bits, 31, 18) != kLine);
+}
+
+static void testPartialAndScroll() {
+    GraphRasterizer rasterizer;
+    std::vector<uint32> bits;
+    setUp(rasterizer, bits);
+
+    std::vector<float> tops(kWidth);
+    for (int32 x = 0; x < kWidth; x++)
+        tops[x] = static_cast<float>(x % kHeight);
+    rasterizer.DrawColumns(0, kWidth, tops.data(), tops.data(), NAN);
+    std::vector<uint32> full(bits);
+
+    // Scrolling only moves the origin
+    rasterizer.Scroll(3);
+    assert(rasterizer.Origin() == 3);
+    assert(bits == full);
+    for (int32 y = 0; y < kHeight; y++) {
+        for (int32 x = 0; x < kWidth - 3; x++)
+            assert(imagePixelAt(rasterizer, bits, x, y)
+                == pixelAt(full, x + 3, y));
+    }
+
+    // Drawing the new columns wraps around the end of the buffer, and with
+    // the grid shifted by the same amount the result is the same as a full
+    // redraw of the shifted data
+    std::vector<float> shifted(kWidth);
+    for (int32 x = 0; x < kWidth; x++)
+        shifted[x] = static_cast<float>((x + 3) % kHeight);
+    rasterizer.SetGrid(4, 10.0f, 3.0f);
+    rasterizer.DrawColumns(kWidth - 4, 4, shifted.data() + kWidth - 4,
+        shifted.data() + kWidth - 4, shifted[kWidth - 5]);
+
+    GraphRasterizer reference;
+    std::vector<uint32> referenceBits;
+    setUp(reference, referenceBits);
+    reference.SetGrid(4, 10.0f, 3.0f);
+    reference.DrawColumns(0, kWidth, shifted.data(), shifted.data(), NAN);
+    for (int32 y = 0; y < kHeight; y++) {
+        // Column 0 still has the line reaching to the one scrolled out
+        for (int32 x = 1; x < kWidth; x++) {
+            assert(imagePixelAt(rasterizer, bits, x, y)
+                == pixelAt(referenceBits, x, y));
+        }
+    }
+
+    // The origin wraps around too
+    rasterizer.Scroll(kWidth - 1);
+    assert(rasterizer.Origin() == 2);
+    rasterizer.Scroll(kWidth * 2);
+    assert(rasterizer.Origin() == 2);
+
+    // Scrolling back moves it the other way, and wraps around as well
+    rasterizer.Scroll(-5);
+    assert(rasterizer.Origin() == kWidth - 3);
+    rasterizer.Scroll(-kWidth * 3 + 4);
+    assert(rasterizer.Origin() == 1);
+
+    // Columns outside the target are clipped
+    rasterizer.DrawColumns(-5, 10, tops.data(), tops.data(), NAN);
+    rasterizer.DrawColumns(kWidth - 2, 10, tops.data(), tops.data(), NAN);
+    for (int32 y = 0; y < kHeight; y++) {
+        for (int32 x = kWidth; x < kStride; x++)
+            assert(pixelAt(bits, x, y) == kPadding);
+    }
+}
+
+static void testScrollBack() {
+    GraphRasterizer rasterizer;
+    std::vector<uint32> bits;
+    setUp(rasterizer, bits);
+
+    std::vector<float> tops(kWidth + 5);
+    for (size_t x = 0; x < tops.size(); x++)
+        tops[x] = static_cast<float>((x * 5) % kHeight);
+    rasterizer.SetGrid(4, 10.0f, 5.0f);
+    rasterizer.DrawColumns(0, kWidth, tops.data() + 5, tops.data() + 5, NAN);
+
+    // Panning back by 5 brings in columns on the left, wrapping around the
+    // start of the buffer. The first old column is drawn again, as its line
+    // now connects to a new neighbour, and still to the old one after it.
+    rasterizer.Scroll(-5);
+    assert(rasterizer.Origin() == kWidth - 5);
+    rasterizer.SetGrid(4, 10.0f, 0.0f);
+    rasterizer.DrawColumns(0, 6, tops.data(), tops.data(), NAN, tops[6]);
+
+    GraphRasterizer reference;
+    std::vector<uint32> referenceBits;
+    setUp(reference, referenceBits);
+    reference.DrawColumns(0, kWidth, tops.data(), tops.data(), NAN);
+    for (int32 y = 0; y < kHeight; y++) {
+        for (int32 x = 0; x < kWidth; x++) {
+            assert(imagePixelAt(rasterizer, bits, x, y)
+                == pixelAt(referenceBits, x, y));
+        }
+        for (int32 x = kWidth; x < kStride; x++)
+            assert(pixelAt(bits, x, y) == kPadding);
+    }
+}
+
+static void testOutOfRange() {
+    GraphRasterizer rasterizer;
+    std::vector<uint32> bits;
+    setUp(rasterizer, bits);
+
+    std::vector<float> tops(kWidth);
+    for (int32 x = 0; x < kWidth; x++)
+        tops[x] = x % 3 == 0 ? NAN : (x % 3 == 1 ? -1e9f : 1e9f);
+    rasterizer.DrawColumns(0, kWidth, tops.data(), tops.data(), NAN);
+
+    // Above the graph everything is filled, below nothing is
+    uint32 fillOverBackground = GraphRasterizer::Blend(kBackground, kFill, 100);
+    assert(pixelAt(bits, 4, 18) == fillOverBackground);
+    assert(pixelAt(bits, 5, 1) == kBackground);
+    for (int32 y = 0; y < kHeight; y++) {
+        for (int32 x = kWidth; x < kStride; x++)
+            assert(pixelAt(bits, x, y) == kPadding);
+    }
+
+    // Nothing to draw into
+    GraphRasterizer empty;
+    assert(empty.DrawColumns(0, kWidth, tops.data(), tops.data(), NAN)
+        == B_OK);
+}
+
+static void testStackedLayers() {
+    GraphRasterizer rasterizer;
+    std::vector<uint32> bits;
+    setUp(rasterizer, bits);
+
+    uint32 kUpper = GraphRasterizer::MakePixel(229, 80, 80);
+    uint32 fills[2] = { kFill, kUpper };
+    assert(rasterizer.SetLayers(2, fills, fills) == B_OK);
+    assert(rasterizer.CountLayers() == 2);
+
+    // The bottom layer reaches up to 12, the one on top of it up to 6
+    std::vector<float> lower(kWidth, 12.0f), upper(kWidth, 6.0f);
+    const float* tops[2] = { lower.data(), upper.data() };
+    assert(rasterizer.DrawStackedColumns(0, kWidth, tops, NULL) == B_OK);
+
+    bool gridRow[kHeight] = {};
+    gridRow[5] = gridRow[10] = gridRow[14] = true;
+
+    for (int32 y = 0; y < kHeight; y++) {
+        for (int32 x = 0; x < kWidth; x++) {
+            bool grid = gridRow[y] || x % 10 == 0;
+            uint32 under = grid ? kGrid : kBackground;
+            uint32 pixel = pixelAt(bits, x, y);
+            if (y == 6)
+                assert(pixel == kUpper);
+            else if (y == 12)
+                assert(pixel == kFill);
+            else if (y < 6)
+                assert(pixel == under);
+            else if (y < 12)
+                assert(pixel == GraphRasterizer::Blend(under, kUpper, 100));
+            else
+                assert(pixel == GraphRasterizer::Blend(under, kFill, 100));
+        }
+        for (int32 x = kWidth; x < kStride; x++)
+            assert(pixelAt(bits, x, y) == kPadding);
+    }
+
+    assert(rasterizer.SetLayers(1, NULL, NULL) == B_BAD_VALUE);
+}
+
+static void testSingleLayerMatchesColumns() {
+    std::vector<float> tops(kWidth);
+    for (int32 x = 0; x < kWidth; x++)
+        tops[x] = static_cast<float>((x * 5) % kHeight) + 0.3f;
+
+    GraphRasterizer columns;
+    std::vector<uint32> columnBits;
+    setUp(columns, columnBits);
+    columns.DrawColumns(0, kWidth, tops.data(), tops.data(), NAN);
+
+    GraphRasterizer stacked;
+    std::vector<uint32> stackedBits;
+    setUp(stacked, stackedBits);
+    assert(stacked.SetLayers(1, &kFill, &kLine) == B_OK);
+    const float* layers[1] = { tops.data() };
+    stacked.DrawStackedColumns(0, kWidth, layers, NULL);
+
+    assert(columnBits == stackedBits);
+}
+
+static void testStackedPartialAndScroll() {
+    uint32 kUpper = GraphRasterizer::MakePixel(229, 80, 80);
+    uint32 fills[2] = { kFill, kUpper };
+
+    // Layer values that shift by one column per step
+    std::vector<float> lower(kWidth + 3), upper(kWidth + 3);
+    for (int32 x = 0; x < kWidth + 3; x++) {
+        lower[x] = static_cast<float>(10 + x % 9);
+        upper[x] = lower[x] - static_cast<float>(x % 7);
+    }
+
+    GraphRasterizer rasterizer;
+    std::vector<uint32> bits;
+    setUp(rasterizer, bits);
+    rasterizer.SetLayers(2, fills, fills);
+    const float* tops[2] = { lower.data(), upper.data() };
+    rasterizer.DrawStackedColumns(0, kWidth, tops, NULL);
+
+    // Three new columns wrap around the end of the buffer
+    rasterizer.Scroll(3);
+    rasterizer.SetGrid(4, 10.0f, 3.0f);
+    const float* newTops[2] = { lower.data() + kWidth, upper.data() + kWidth };
+    float previousTops[2] = { lower[kWidth - 1], upper[kWidth - 1] };
+    rasterizer.DrawStackedColumns(kWidth - 3, 3, newTops, previousTops);
+
+    GraphRasterizer reference;
+    std::vector<uint32> referenceBits;
+    setUp(reference, referenceBits);
+    reference.SetLayers(2, fills, fills);
+    reference.SetGrid(4, 10.0f, 3.0f);
+    const float* shifted[2] = { lower.data() + 3, upper.data() + 3 };
+    reference.DrawStackedColumns(0, kWidth, shifted, NULL);
+
+    for (int32 y = 0; y < kHeight; y++) {
+        // Column 0 still has the lines reaching to the one scrolled out
+        for (int32 x = 1; x < kWidth; x++) {
+            assert(imagePixelAt(rasterizer, bits, x, y)
+                == pixelAt(referenceBits, x, y));
+        }
+        for (int32 x = kWidth; x < kStride; x++)
+            assert(pixelAt(bits, x, y) == kPadding);
+    }
+
+    // Clipped on both ends
+    rasterizer.DrawStackedColumns(-2, kWidth + 4, tops, previousTops);
+    for (int32 y = 0; y < kHeight; y++) {
+        for (int32 x = kWidth; x < kStride; x++)
+            assert(pixelAt(bits, x, y) == kPadding);
+    }
+}
+
+int main() {
+    printf("Testing GraphRasterizer...\n");
+
+    kBackground = GraphRasterizer::MakePixel(216, 216, 216);
+    kGrid = GraphRasterizer::MakePixel(190, 190, 190);
+    kFill = GraphRasterizer::MakePixel(80, 133, 229);
+    kLine = kFill;
+
+    testBlend();
+    testSelectRowMatchesScalar();
+    testFlatLine();
+    testAntialiasing();
+    testSteps();
+    testPartialAndScroll();
+    testScrollBack();
+    testOutOfRange();
+    testStackedLayers();
+    testSingleLayerMatchesColumns();
+    testStackedPartialAndScroll();
+
+    printf("GraphRasterizer tests passed.\n");
+    return 0;
+}
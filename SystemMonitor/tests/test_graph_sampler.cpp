@@ -0,0 +1,124 @@
+#include <cstdio>
+#include <cassert>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+
+// Mock OS.h functionality for standalone testing if not available
+#ifndef _OS_H
+#ifndef B_OK
+#define B_OK 0
+#endif
+#ifndef B_NO_MEMORY
+#define B_NO_MEMORY -1
+#endif
+typedef int32_t status_t;
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef int32_t int32;
+typedef uint32_t uint32;
+typedef int64_t int64;
+typedef uint64_t uint64;
+typedef long long bigtime_t;
+#endif
+
+#include "../DataHistory.cpp"
+#include "../CompressedHistory.cpp"
+#include "../QuantileSketch.cpp"
+#include "../GraphSampler.cpp"
+#include "../GraphTileCache.cpp"
+
+static const bigtime_t kInterval = 1000000;
+static const bigtime_t kFirst = 1000 * kInterval;
+static const int kSamples = 200;
+static const int32 kWidth = 100;
+
+struct sampler_state {
+    const DataHistory<float>* history;
+};
+
+// The same path as the graph's tile sampler
+static void sampleTile(void* cookie, bigtime_t start, bigtime_t step,
+    int32 count, float* lows, float* highs) {
+    sampler_state* state = static_cast<sampler_state*>(cookie);
+    GraphSampler::SampleValues(state->history, 0, start, step, count, lows,
+        highs);
+}
+
+// Fetches the kWidth columns of step that end at end, like an inspected
+// graph does, and returns how many of them are from before the history
+static int32 inspect(GraphTileCache& cache, const DataHistory<float>& history,
+    bigtime_t step, bigtime_t end, std::vector<float>& lows,
+    std::vector<float>& highs) {
+    sampler_state state = { &history };
+    int64 lastColumn = end / step;
+    cache.GetColumns(step, lastColumn - (kWidth - 1), kWidth,
+        history.Start() / step + 2, history.End() / step - 2, sampleTile,
+        &state, lows.data(), highs.data());
+
+    int32 empty = 0;
+    for (int32 j = 0; j < kWidth; j++) {
+        bool missing = std::isnan(lows[j]);
+        assert(missing == std::isnan(highs[j]));
+        bigtime_t time = (lastColumn - (kWidth - 1) + j) * step;
+        assert(missing == (time < history.Start()));
+        if (missing)
+            empty++;
+    }
+    return empty;
+}
+
+int main() {
+    printf("Testing GraphSampler...\n");
+
+    // Values between 50 and 59, far from 0
+    DataHistory<float> history(kSamples * kInterval, kInterval);
+    for (int i = 0; i < kSamples; i++)
+        history.AddValue(kFirst + i * kInterval, 50.0f + i % 10);
+    assert(history.Start() == kFirst);
+
+    std::vector<float> lows(kWidth), highs(kWidth);
+    float min, max;
+
+    // Panned back past the start of the history, zoomed in: the columns
+    // before it are empty, and the scale is that of what is there
+    GraphTileCache cache;
+    int32 empty = inspect(cache, history, kInterval, kFirst + 20 * kInterval,
+        lows, highs);
+    assert(empty == kWidth - 21);
+    assert(GraphSampler::GetEnvelope(lows.data(), highs.data(), kWidth, min,
+        max));
+    assert(min == 50.0f && max == 59.0f);
+
+    // The same zoomed out, through the level of detail envelopes
+    bigtime_t step = 4 * kInterval;
+    assert(history.LevelFor(step) >= 0);
+    empty = inspect(cache, history, step, kFirst + 40 * step, lows, highs);
+    assert(empty > 0 && empty < kWidth);
+    assert(GraphSampler::GetEnvelope(lows.data(), highs.data(), kWidth, min,
+        max));
+    assert(min == 50.0f && max == 59.0f);
+
+    // Panned so far back that nothing is shown
+    empty = inspect(cache, history, kInterval, kFirst - kInterval, lows,
+        highs);
+    assert(empty == kWidth);
+    assert(!GraphSampler::GetEnvelope(lows.data(), highs.data(), kWidth, min,
+        max));
+
+    // Columns within the history are unchanged
+    GraphSampler::SampleValues(&history, 0, kFirst, kInterval, kWidth,
+        lows.data(), highs.data());
+    for (int32 j = 0; j < kWidth; j++)
+        assert(lows[j] == 50.0f + j % 10 && highs[j] == lows[j]);
+
+    // An empty history still shows 0
+    DataHistory<float> none(kSamples * kInterval, kInterval);
+    GraphSampler::SampleValues(&none, 0, kFirst, kInterval, kWidth,
+        lows.data(), highs.data());
+    for (int32 j = 0; j < kWidth; j++)
+        assert(lows[j] == 0 && highs[j] == 0);
+
+    printf("GraphSampler tests passed.\n");
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include <cstdio>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+// Mock OS.h functionality for standalone testing if not available
+#ifndef _OS_H
+typedef int32_t int32;
+typedef uint32_t uint32;
+typedef int64_t int64;
+typedef int64_t bigtime_t;
+#endif
+
+#include "../GraphTileCache.cpp"
+
+static const int32 kTile = GraphTileCache::kTileWidth;
+
+struct sampler_state {
+    int64 sampledColumns;
+    int32 calls;
+    // Added to every value, to tell apart what was cached from fresh samples
+    float bias;
+};
+
+// Column c has the envelope [-c, c] plus the bias
+static void sampleColumns(void* cookie, bigtime_t start, bigtime_t step,
+    int32 count, float* lows, float* highs) {
+    sampler_state* state = static_cast<sampler_state*>(cookie);
+    state->sampledColumns += count;
+    state->calls++;
+
+    assert(start % step == 0);
+    int64 first = start / step;
+    for (int32 j = 0; j < count; j++) {
+        lows[j] = static_cast<float>(-(first + j)) + state->bias;
+        highs[j] = static_cast<float>(first + j) + state->bias;
+    }
+}
+
+static void getColumns(GraphTileCache& cache, sampler_state& state,
+    bigtime_t step, int64 first, int32 count, int64 oldestStable,
+    int64 newestStable, float bias = 0) {
+    std::vector<float> lows(count + 1, 12345.0f), highs(count + 1, 12345.0f);
+    state.bias = bias;
+    cache.GetColumns(step, first, count, oldestStable, newestStable,
+        sampleColumns, &state, lows.data(), highs.data());
+
+    for (int32 j = 0; j < count; j++) {
+        int64 column = first + j;
+        bool stable = column >= oldestStable && column <= newestStable;
+        // Columns in stable tiles may come from the cache, the others
+        // have just been sampled
+        if (!stable) {
+            assert(lows[j] == static_cast<float>(-column) + bias);
+            assert(highs[j] == static_cast<float>(column) + bias);
+        } else
+            assert(highs[j] - lows[j] == static_cast<float>(2 * column));
+    }
+    // Nothing is written past the end
+    assert(lows[count] == 12345.0f && highs[count] == 12345.0f);
+}
+
+static void testColumns() {
+    GraphTileCache cache;
+    sampler_state state = { 0, 0, 0 };
+
+    // Across tile boundaries, also left of column 0
+    getColumns(cache, state, 1000, -300, 900, -100000, 100000);
+    getColumns(cache, state, 1000, 17, 5, -100000, 100000);
+    getColumns(cache, state, 1000, 3 * kTile - 1, 2, -100000, 100000);
+    // The columns [-512, 1024) are cached
+    assert(cache.CountTiles() == 6);
+}
+
+static void testReuse() {
+    GraphTileCache cache;
+    sampler_state state = { 0, 0, 0 };
+
+    getColumns(cache, state, 1000, 800, 600, 0, 100000);
+    // The three tiles touched are sampled whole
+    assert(state.sampledColumns == 3 * kTile);
+
+    // Looking at the same range again samples nothing
+    state.sampledColumns = 0;
+    getColumns(cache, state, 1000, 800, 600, 0, 100000, 7);
+    assert(state.sampledColumns == 0);
+
+    // Panning back by a little only needs the tile that comes into view
+    getColumns(cache, state, 1000, 800 - 100, 600, 0, 100000, 7);
+    assert(state.sampledColumns == kTile);
+    getColumns(cache, state, 1000, 800 - 50, 600, 0, 100000, 7);
+    assert(state.sampledColumns == kTile);
+}
+
+static void testUnstable() {
+    GraphTileCache cache;
+    sampler_state state = { 0, 0, 0 };
+
+    // The newest columns are still changing, so the tile with them isn't
+    // kept; neither is the one with the oldest, that may be dropped soon
+    getColumns(cache, state, 1000, 0, 4 * kTile, 10, 3 * kTile + 20);
+    assert(cache.CountTiles() == 2);
+
+    state.sampledColumns = 0;
+    getColumns(cache, state, 1000, 0, 4 * kTile, 10, 3 * kTile + 20, 3);
+    assert(state.sampledColumns == 2 * kTile);
+
+    // Once they settle, they are kept too
+    getColumns(cache, state, 1000, 0, 4 * kTile, 0, 4 * kTile, 5);
+    assert(cache.CountTiles() == 4);
+    state.sampledColumns = 0;
+    getColumns(cache, state, 1000, 0, 4 * kTile, 0, 4 * kTile, 6);
+    assert(state.sampledColumns == 0);
+}
+
+static void testSteps() {
+    GraphTileCache cache;
+    sampler_state state = { 0, 0, 0 };
+
+    getColumns(cache, state, 1000, 0, kTile, 0, 100000);
+    getColumns(cache, state, 2000, 0, kTile, 0, 100000, 1);
+    assert(cache.CountTiles() == 2);
+    assert(state.sampledColumns == 2 * kTile);
+
+    // Zooming back finds the tiles of the old step
+    getColumns(cache, state, 1000, 0, kTile, 0, 100000, 2);
+    assert(state.sampledColumns == 2 * kTile);
+
+    cache.Clear();
+    assert(cache.CountTiles() == 0);
+    getColumns(cache, state, 1000, 0, kTile, 0, 100000, 3);
+    assert(state.sampledColumns == 3 * kTile);
+}
+
+static void testEviction() {
+    GraphTileCache cache(2);
+    sampler_state state = { 0, 0, 0 };
+
+    getColumns(cache, state, 1000, 0, 1, 0, 100000);
+    getColumns(cache, state, 1000, kTile, 1, 0, 100000);
+    // Tile 0 is used again, so tile 1 is the least recently used one
+    getColumns(cache, state, 1000, 0, 1, 0, 100000);
+    assert(state.sampledColumns == 2 * kTile);
+
+    getColumns(cache, state, 1000, 2 * kTile, 1, 0, 100000);
+    assert(cache.CountTiles() == 2);
+    assert(state.sampledColumns == 3 * kTile);
+
+    getColumns(cache, state, 1000, 0, 1, 0, 100000);
+    assert(state.sampledColumns == 3 * kTile);
+    getColumns(cache, state, 1000, kTile, 1, 0, 100000);
+    assert(state.sampledColumns == 4 * kTile);
+}
+
+int main() {
+    printf("Testing GraphTileCache...\n");
+
+    testColumns();
+    testReuse();
+    testUnstable();
+    testSteps();
+    testEviction();
+
+    printf("GraphTileCache tests passed.\n");
+    return 0;
+}
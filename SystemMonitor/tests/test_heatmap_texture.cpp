@@ -0,0 +1,201 @@
+#include <cstdio>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+// Mock OS.h functionality for standalone testing if not available
+#ifndef _OS_H
+#ifndef B_OK
+#define B_OK 0
+#endif
+#ifndef B_NO_MEMORY
+#define B_NO_MEMORY -1
+#endif
+#ifndef B_BAD_VALUE
+#define B_BAD_VALUE -2
+#endif
+typedef int32_t status_t;
+typedef uint8_t uint8;
+typedef int32_t int32;
+typedef uint32_t uint32;
+#endif
+
+#include "../GraphRasterizer.cpp"
+#include "../HeatmapTexture.cpp"
+
+static const int32 kWidth = 13;
+static const int32 kRows = 9;
+// Rows are padded like a BBitmap's
+static const int32 kStride = 16;
+static const uint32 kPadding = 0x12345678;
+
+static uint32 kLow;
+static uint32 kHigh;
+
+static uint32 pixelAt(const std::vector<uint32>& bits, int32 x, int32 row) {
+    return bits[row * kStride + x];
+}
+
+// The image starts at the texture's origin and wraps around
+static uint32 imagePixelAt(const HeatmapTexture& texture,
+    const std::vector<uint32>& bits, int32 x, int32 row) {
+    return pixelAt(bits, (texture.Origin() + x) % kWidth, row);
+}
+
+static void checkPadding(const std::vector<uint32>& bits) {
+    for (int32 row = 0; row < kRows; row++) {
+        for (int32 x = kWidth; x < kStride; x++)
+            assert(pixelAt(bits, x, row) == kPadding);
+    }
+}
+
+static void setUp(HeatmapTexture& texture, std::vector<uint32>& bits) {
+    bits.assign(kStride * kRows, kPadding);
+    texture.SetTarget(bits.data(), kStride * sizeof(uint32), kWidth, kRows);
+    texture.SetPalette(kLow, kHigh, 0, 100);
+}
+
+static void testPalette() {
+    HeatmapTexture texture;
+    texture.SetPalette(kLow, kHigh, 0, 100);
+
+    assert(texture.PixelFor(0) == kLow);
+    assert(texture.PixelFor(100) == kHigh);
+    assert(texture.PixelFor(50) == GraphRasterizer::Blend(kLow, kHigh, 128));
+    // Out of range and missing values are clamped
+    assert(texture.PixelFor(-5) == kLow);
+    assert(texture.PixelFor(1e9f) == kHigh);
+    assert(texture.PixelFor(NAN) == kLow);
+
+    // Red only fades towards the high end
+    uint32 previous = texture.PixelFor(0);
+    for (int32 value = 1; value <= 100; value++) {
+        uint32 pixel = texture.PixelFor(static_cast<float>(value));
+        assert(((pixel >> 16) & 0xff) <= ((previous >> 16) & 0xff));
+        previous = pixel;
+    }
+
+    // An empty range doesn't divide by zero
+    texture.SetPalette(kLow, kHigh, 5, 5);
+    assert(texture.PixelFor(5) == kLow);
+}
+
+static void testColumnsAndScroll() {
+    HeatmapTexture texture;
+    std::vector<uint32> bits;
+    setUp(texture, bits);
+
+    // Row r at column x has the value (x * 7 + r * 3) % 101
+    std::vector<float> column(kRows);
+    for (int32 x = 0; x < kWidth; x++) {
+        for (int32 row = 0; row < kRows; row++)
+            column[row] = static_cast<float>((x * 7 + row * 3) % 101);
+        texture.DrawColumn(x, column.data());
+    }
+    for (int32 row = 0; row < kRows; row++) {
+        for (int32 x = 0; x < kWidth; x++) {
+            assert(pixelAt(bits, x, row) == texture.PixelFor(
+                static_cast<float>((x * 7 + row * 3) % 101)));
+        }
+    }
+    checkPadding(bits);
+
+    // Scrolling only moves the origin, and a new column wraps around
+    std::vector<uint32> before(bits);
+    texture.Scroll(kWidth + 4);
+    assert(texture.Origin() == 4);
+    assert(bits == before);
+
+    for (int32 x = kWidth - 4; x < kWidth; x++) {
+        for (int32 row = 0; row < kRows; row++)
+            column[row] = static_cast<float>(((x + 4) * 7 + row * 3) % 101);
+        texture.DrawColumn(x, column.data());
+    }
+    for (int32 row = 0; row < kRows; row++) {
+        for (int32 x = 0; x < kWidth; x++) {
+            assert(imagePixelAt(texture, bits, x, row) == texture.PixelFor(
+                static_cast<float>(((x + 4) * 7 + row * 3) % 101)));
+        }
+    }
+    checkPadding(bits);
+
+    // Columns outside the image are ignored
+    texture.DrawColumn(-1, column.data());
+    texture.DrawColumn(kWidth, column.data());
+    checkPadding(bits);
+}
+
+static void testRows() {
+    HeatmapTexture texture;
+    std::vector<uint32> bits;
+    setUp(texture, bits);
+    texture.Scroll(5);
+
+    std::vector<float> values(kWidth + 10);
+    for (size_t x = 0; x < values.size(); x++)
+        values[x] = static_cast<float>(x * 9 % 100);
+
+    // A whole row, and one clipped on both ends
+    texture.DrawRow(2, 0, kWidth, values.data());
+    texture.DrawRow(3, -4, kWidth + 10, values.data());
+    for (int32 x = 0; x < kWidth; x++) {
+        assert(imagePixelAt(texture, bits, x, 2) == texture.PixelFor(values[x]));
+        assert(imagePixelAt(texture, bits, x, 3)
+            == texture.PixelFor(values[x + 4]));
+    }
+    // Other rows are untouched
+    for (int32 x = 0; x < kWidth; x++)
+        assert(pixelAt(bits, x, 4) == kPadding);
+    checkPadding(bits);
+
+    texture.DrawRow(kRows, 0, kWidth, values.data());
+    texture.DrawRow(-1, 0, kWidth, values.data());
+    checkPadding(bits);
+}
+
+static void testPermuteRows() {
+    srand(7);
+    for (int round = 0; round < 50; round++) {
+        HeatmapTexture texture;
+        std::vector<uint32> bits;
+        setUp(texture, bits);
+
+        // Every pixel is unique
+        for (int32 row = 0; row < kRows; row++) {
+            for (int32 x = 0; x < kWidth; x++)
+                bits[row * kStride + x] = static_cast<uint32>(row * 1000 + x);
+        }
+        std::vector<uint32> before(bits);
+
+        std::vector<int32> order(kRows);
+        for (int32 row = 0; row < kRows; row++)
+            order[row] = row;
+        for (int32 row = kRows - 1; row > 0; row--)
+            std::swap(order[row], order[rand() % (row + 1)]);
+
+        assert(texture.PermuteRows(order.data()) == B_OK);
+        for (int32 row = 0; row < kRows; row++) {
+            for (int32 x = 0; x < kWidth; x++)
+                assert(pixelAt(bits, x, row) == pixelAt(before, x, order[row]));
+        }
+        checkPadding(bits);
+    }
+}
+
+int main() {
+    printf("Testing HeatmapTexture...\n");
+
+    kLow = GraphRasterizer::MakePixel(216, 216, 216);
+    kHigh = GraphRasterizer::MakePixel(80, 133, 229);
+
+    testPalette();
+    testColumnsAndScroll();
+    testRows();
+    testPermuteRows();
+
+    printf("HeatmapTexture tests passed.\n");
+    return 0;
+}
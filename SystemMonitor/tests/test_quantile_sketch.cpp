@@ -0,0 +1,96 @@
+#include <cstdio>
+#include <cassert>
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+// Mock OS.h functionality for standalone testing if not available
+#ifndef _OS_H
+typedef int32_t int32;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef int64_t int64;
+typedef long long bigtime_t;
+#endif
+
+#include "../QuantileSketch.cpp"
+
+static const bigtime_t kSecond = 1000000;
+
+static bool closeTo(int64 value, int64 expected) {
+    // Log buckets are within 5% (10% wide)
+    int64 diff = value > expected ? value - expected : expected - value;
+    return diff <= 1 || diff <= expected / 20;
+}
+
+int main() {
+    printf("Testing QuantileSketch...\n");
+
+    QuantileSketch sketch(3600 * kSecond);
+    assert(sketch.Quantile(0.5f) == 0);
+
+    // Small values are exact
+    for (int i = 0; i < 10; i++)
+        sketch.AddValue(i * kSecond, i);
+    assert(sketch.CountValues() == 10);
+    assert(sketch.Quantile(0.0f) == 0);
+    assert(sketch.Quantile(0.5f) == 4);
+    assert(sketch.Quantile(1.0f) == 9);
+
+    // Compare against exact quantiles over a wide range
+    sketch.MakeEmpty();
+    srand(7);
+    std::vector<int64> values;
+    for (int i = 0; i < 3000; i++) {
+        int64 value = rand() % 1000000;
+        if (i % 100 == 0)
+            value = 50000000; // rare spikes
+        values.push_back(value);
+        sketch.AddValue(i * kSecond, value);
+    }
+    std::sort(values.begin(), values.end());
+    const float quantiles[] = { 0.1f, 0.5f, 0.9f, 0.95f, 0.99f };
+    for (float q : quantiles) {
+        int64 expected = values[(size_t)(q * values.size() + 0.5f) - 1];
+        assert(closeTo(sketch.Quantile(q), expected));
+    }
+    assert(closeTo(sketch.Quantile(1.0f), 50000000));
+
+    // Values leave the window slot by slot
+    QuantileSketch window(60 * kSecond);
+    for (int i = 0; i < 60; i++)
+        window.AddValue(i * kSecond, 1000);
+    assert(closeTo(window.Quantile(0.5f), 1000));
+    for (int i = 60; i < 120; i++)
+        window.AddValue(i * kSecond, 10);
+    assert(window.Quantile(0.5f) == 10);
+    assert(window.CountValues() <= 62);
+
+    // A long pause expires everything
+    window.AddValue(1000 * kSecond, 3);
+    assert(window.CountValues() == 1);
+    assert(window.Quantile(0.99f) == 3);
+
+    // Times from before a reboot are negative, and keep working past 0
+    QuantileSketch restored(60 * kSecond);
+    for (int i = -90; i < 0; i++)
+        restored.AddValue(i * kSecond, 1000);
+    assert(restored.CountValues() <= 62);
+    for (int i = 0; i < 60; i++)
+        restored.AddValue(i * kSecond, 10);
+    assert(restored.Quantile(0.5f) == 10);
+    assert(restored.CountValues() <= 62);
+
+    // Histogram keeps the counts
+    uint32 bins[10];
+    sketch.GetHistogram(bins, 10, 0, 1000000);
+    uint32 total = 0;
+    for (int i = 0; i < 10; i++)
+        total += bins[i];
+    assert(total == sketch.CountValues());
+    assert(bins[9] >= 30);
+
+    printf("All tests passed!\n");
+    return 0;
+}
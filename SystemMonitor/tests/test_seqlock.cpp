@@ -0,0 +1,123 @@
+#include <cstdio>
+#include <cassert>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Mock OS.h functionality for standalone testing if not available
+#ifndef _OS_H
+typedef int32_t int32;
+typedef uint32_t uint32;
+typedef int64_t int64;
+typedef uint64_t uint64;
+typedef long long bigtime_t;
+#endif
+
+#include "../SeqLock.h"
+
+// Not a multiple of the word size, and every field carries the same value
+// so a torn read is easy to spot
+struct Snapshot {
+    bigtime_t time;
+    float values[5];
+    int32 count;
+    uint32 flags;
+    char tag;
+};
+
+static Snapshot makeSnapshot(int32 n) {
+    Snapshot snapshot;
+    snapshot.time = n;
+    for (int i = 0; i < 5; i++)
+        snapshot.values[i] = static_cast<float>(n);
+    snapshot.count = n;
+    snapshot.flags = static_cast<uint32>(n);
+    snapshot.tag = static_cast<char>(n & 0x7f);
+    return snapshot;
+}
+
+static bool isConsistent(const Snapshot& snapshot) {
+    int32 n = snapshot.count;
+    if (snapshot.time != n || snapshot.flags != static_cast<uint32>(n)
+        || snapshot.tag != static_cast<char>(n & 0x7f)) {
+        return false;
+    }
+    for (int i = 0; i < 5; i++) {
+        if (snapshot.values[i] != static_cast<float>(n))
+            return false;
+    }
+    return true;
+}
+
+int main() {
+    printf("Testing SeqLock...\n");
+
+    // A fresh lock reads as zero
+    SeqLock<Snapshot> lock;
+    Snapshot snapshot;
+    uint32 sequence = lock.Read(snapshot);
+    assert(sequence == 0);
+    assert(snapshot.count == 0 && snapshot.time == 0);
+
+    // Writes are visible, and bump the sequence
+    lock.Write(makeSnapshot(7));
+    uint32 next = lock.Read(snapshot);
+    assert(next != sequence);
+    assert(next == lock.Sequence());
+    assert(snapshot.count == 7 && isConsistent(snapshot));
+
+    // Reading again without a write returns the same sequence
+    assert(lock.Read(snapshot) == next);
+
+    // One writer and a reader racing it never see a torn value, and the
+    // values only move forward. Both start together, and the writer keeps
+    // going until the reader is done, so the reads overlap the writes. Both
+    // hand over the CPU now and then, so they interleave on a single CPU,
+    // too.
+    const int32 kReads = 200000;
+    const int32 kMinOverlapping = 200;
+    std::atomic<bool> start(false);
+    std::atomic<bool> done(false);
+    std::atomic<int32> written(7);
+    std::thread writer([&]() {
+        while (!start)
+            std::this_thread::yield();
+        for (int32 i = 8; !done; i++) {
+            lock.Write(makeSnapshot(i));
+            written = i;
+            if (i % 256 == 0)
+                std::this_thread::sleep_for(std::chrono::microseconds(1));
+        }
+    });
+
+    start = true;
+    int32 last = 7;
+    int32 overlapping = 0;
+    uint32 lastSequence = lock.Sequence();
+    for (int32 reads = 0; reads < kReads; reads++) {
+        uint32 readSequence = lock.Read(snapshot);
+        assert(isConsistent(snapshot));
+        assert(snapshot.count >= last);
+        last = snapshot.count;
+
+        // A write came in since the last read
+        if (readSequence != lastSequence)
+            overlapping++;
+        lastSequence = readSequence;
+
+        if (reads % 256 == 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(1));
+    }
+    done = true;
+    writer.join();
+
+    assert(overlapping >= kMinOverlapping);
+
+    lock.Read(snapshot);
+    assert(snapshot.count == written);
+
+    printf("SeqLock tests passed (%d of %d reads overlapped writes).\n",
+        (int)overlapping, (int)kReads);
+    return 0;
+}